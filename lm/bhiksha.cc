@@ -5,6 +5,7 @@
 #include "util/file.hh"
 #include "util/exception.hh"
 
+#include <algorithm>
 #include <limits>
 
 namespace lm {
@@ -89,6 +90,52 @@ void ArrayBhiksha::FinishedLoading(const Config &config) {
   *(head_write++) = config.pointer_bhiksha_bits;
 }
 
+const uint8_t kEliasFanoBhikshaVersion = 0;
+
+void EliasFanoBhiksha::UpdateConfigFromBinary(const BinaryFormat &file, uint64_t offset, Config &/*config*/) {
+  uint8_t version;
+  file.ReadForConfig(&version, 1, offset);
+  if (version != kEliasFanoBhikshaVersion) UTIL_THROW(FormatLoadException, "This file has Elias-Fano pointer compression version " << (unsigned) version << " but the code expects version " << (unsigned)kEliasFanoBhikshaVersion);
+}
+
+namespace {
+
+// The usual choice floor(log2(max_next / max_offset)) minimizes the total size.
+uint8_t EliasFanoLowBits(uint64_t max_offset, uint64_t max_next) {
+  uint64_t ratio = max_next / max_offset;
+  return ratio ? util::RequiredBits(ratio) - 1 : 0;
+}
+
+uint64_t SampleCount(uint64_t max_offset, uint64_t sample) {
+  return (max_offset + sample - 1) / sample;
+}
+
+// One set bit per entry plus the largest high value.
+uint64_t UpperWordCount(uint64_t max_offset, uint64_t max_next) {
+  return (max_offset + (max_next >> EliasFanoLowBits(max_offset, max_next)) + 1 + 63) / 64;
+}
+
+} // namespace
+
+uint64_t EliasFanoBhiksha::Size(uint64_t max_offset, uint64_t max_next, const Config &/*config*/) {
+  return sizeof(uint64_t) * (1 /* header */ + SampleCount(max_offset, kSelectSample) + UpperWordCount(max_offset, max_next)) + 7 /* 8-byte alignment */;
+}
+
+uint8_t EliasFanoBhiksha::InlineBits(uint64_t max_offset, uint64_t max_next, const Config &/*config*/) {
+  return EliasFanoLowBits(max_offset, max_next);
+}
+
+EliasFanoBhiksha::EliasFanoBhiksha(void *base, uint64_t max_offset, uint64_t max_next, const Config &/*config*/)
+  : low_(util::BitsMask::ByBits(EliasFanoLowBits(max_offset, max_next))),
+    word_count_(UpperWordCount(max_offset, max_next)),
+    samples_(reinterpret_cast<uint64_t*>(AlignTo8(base)) + 1 /* 8-byte header */),
+    words_(samples_ + SampleCount(max_offset, kSelectSample)),
+    original_base_(base) {}
+
+void EliasFanoBhiksha::FinishedLoading(const Config &/*config*/) {
+  *reinterpret_cast<uint8_t*>(original_base_) = kEliasFanoBhikshaVersion;
+}
+
 } // namespace trie
 } // namespace ngram
 } // namespace lm
@@ -8,6 +8,15 @@
  *  }
  *
  *  Currently only used for next pointers.
+ *
+ *  EliasFanoBhiksha instead uses the Elias-Fano encoding from
+ *  @inproceedings{vigna2013quasi,
+ *   author={Sebastiano Vigna},
+ *   year={2013},
+ *   title={Quasi-Succinct Indices},
+ *   booktitle={Proceedings of the Sixth ACM International Conference on Web Search and Data Mining},
+ *   pages={83--92},
+ *   }
  */
 
 #ifndef LM_BHIKSHA_H
@@ -115,6 +124,76 @@ class ArrayBhiksha {
     void *original_base_;
 };
 
+/* Elias-Fano coding of next pointers.  The low bits of each pointer are stored
+ * inline like ArrayBhiksha.  The high bits are stored in unary: pointer i with
+ * high bits h sets bit h + i of a bit vector, which costs about two bits per
+ * entry.  Compared to ArrayBhiksha's 64 bits per high value, more bits move
+ * out of the entries, so the trie is smaller.  Lookups have to select the
+ * index-th set bit, which is done from a sample every kSelectSample entries
+ * and is slower than a binary search over an array.
+ */
+class EliasFanoBhiksha {
+  public:
+    static const ModelType kModelTypeAdd = kEliasFanoAdd;
+
+    static void UpdateConfigFromBinary(const BinaryFormat &file, uint64_t offset, Config &config);
+
+    static uint64_t Size(uint64_t max_offset, uint64_t max_next, const Config &config);
+
+    static uint8_t InlineBits(uint64_t max_offset, uint64_t max_next, const Config &config);
+
+    EliasFanoBhiksha(void *base, uint64_t max_offset, uint64_t max_next, const Config &config);
+
+    void ReadNext(const void *base, uint64_t bit_offset, uint64_t index, uint8_t total_bits, NodeRange &out) const {
+      // Find the index-th set bit starting from the last sample before it.
+      uint64_t position = samples_[index / kSelectSample];
+      const uint64_t *word = words_ + (position >> 6);
+      uint64_t bits = *word & (~static_cast<uint64_t>(0) << (position & 63));
+      for (uint64_t skip = index % kSelectSample; ; bits = *++word) {
+        unsigned count = util::PopCount64(bits);
+        if (skip < count) {
+          for (; skip; --skip) bits &= bits - 1;
+          break;
+        }
+        skip -= count;
+      }
+      out.begin = ((static_cast<uint64_t>(word - words_) * 64 + util::LowestBit64(bits) - index) << low_.bits) |
+        util::ReadInt57(base, bit_offset, low_.bits, low_.mask);
+      // The next set bit belongs to index + 1.
+      bits &= bits - 1;
+      while (!bits) bits = *++word;
+      out.end = ((static_cast<uint64_t>(word - words_) * 64 + util::LowestBit64(bits) - index - 1) << low_.bits) |
+        util::ReadInt57(base, bit_offset + total_bits, low_.bits, low_.mask);
+      assert(out.end >= out.begin);
+    }
+
+    void WriteNext(void *base, uint64_t bit_offset, uint64_t index, uint64_t value) {
+      // The same memory is used to load, so it can only be cleared when building.
+      if (!index) std::fill(words_, words_ + word_count_, 0);
+      uint64_t position = (value >> low_.bits) + index;
+      if (!(index % kSelectSample)) samples_[index / kSelectSample] = position;
+      words_[position >> 6] |= static_cast<uint64_t>(1) << (position & 63);
+      util::WriteInt57(base, bit_offset, low_.bits, value & low_.mask);
+    }
+
+    void FinishedLoading(const Config &config);
+
+    uint8_t InlineBits() const { return low_.bits; }
+
+  private:
+    static const uint64_t kSelectSample = 256;
+
+    const util::BitsMask low_;
+
+    const uint64_t word_count_;
+
+    // Position of every kSelectSample-th set bit.
+    uint64_t *const samples_;
+    uint64_t *const words_;
+
+    void *original_base_;
+};
+
 } // namespace trie
 } // namespace ngram
 } // namespace lm
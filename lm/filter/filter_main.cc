@@ -3,6 +3,7 @@
 #include "lm/filter/phrase.hh"
 #ifndef NTHREAD
 #include "lm/filter/thread.hh"
+#include "util/ring_queue.hh"
 #endif
 #include "lm/filter/vocab.hh"
 #include "lm/filter/wrapper.hh"
@@ -21,7 +22,7 @@ namespace {
 
 void DisplayHelp(const char *name) {
   std::cerr
-    << "Usage: " << name << " mode [context] [phrase] [raw|arpa] [threads:m] [batch_size:m] (vocab|model):input_file output_file\n\n"
+    << "Usage: " << name << " mode [context] [phrase] [raw|arpa] [threads:m] [batch_size:m] [lockfree] [writers:m] [mapped] (vocab|model):input_file output_file\n\n"
     "copy mode just copies, but makes the format nicer for e.g. irstlm's broken\n"
     "    parser.\n"
     "single mode treats the entire input as a single sentence.\n"
@@ -42,7 +43,11 @@ void DisplayHelp(const char *name) {
 #ifndef NTHREAD
     "threads:m sets m threads (default: conccurrency detected by boost)\n"
     "batch_size:m sets the batch size for threading.  Expect memory usage from this\n"
-    "    of 2*threads*batch_size n-grams.\n\n"
+    "    of 2*threads*batch_size n-grams.\n"
+    "lockfree passes batches between threads with lock-free queues that spin instead\n"
+    "    of sleeping.  Faster with small batches if there are spare cores.\n"
+    "writers:m splits the output files of multiple mode among m writer threads\n"
+    "    (default 1).  Helps when there are many sentences and threads.\n\n"
 #else
     "This binary was compiled with -DNTHREAD, disabling threading.  If you wanted\n"
     "    threading, compile without this flag against Boost >=1.42.0.\n\n"
@@ -50,6 +55,9 @@ void DisplayHelp(const char *name) {
     "There are two inputs: vocabulary and model.  Either may be given as a file\n"
     "    while the other is on stdin.  Specify the type given as a file using\n"
     "    vocab: or model: before the file name.  \n\n"
+    "mapped means the vocabulary file is the binary output of phrase_table_vocab,\n"
+    "    which is mmapped instead of loaded.  It works with multiple or union mode\n"
+    "    and requires vocab: before the file name.\n\n"
     "For ARPA format, the output must be seekable.  For raw format, it can be a\n"
     "    stream i.e. /dev/stdout\n";
 }
@@ -62,8 +70,11 @@ struct Config {
 #ifndef NTHREAD
   batch_size(25000),
   threads(boost::thread::hardware_concurrency()),
+  lock_free(false),
+  writers(1),
 #endif
   phrase(false),
+  mapped(false),
   context(false),
   format(FORMAT_ARPA)
   {
@@ -75,19 +86,37 @@ struct Config {
 #ifndef NTHREAD
   size_t batch_size;
   size_t threads;
+  bool lock_free;
+  size_t writers;
 #endif
   bool phrase;
+  bool mapped;
   bool context;
   FilterMode mode;
   Format format;
 };
 
+template <class Format, class Filter, class Output> void RunUnthreadedFilter(util::FilePiece &in_lm, Filter &filter, Output &output) {
+  Format::RunFilter(in_lm, filter, output);
+}
+
+#ifndef NTHREAD
+// Writer threads only help alongside filter threads.
+template <class Format, class Filter, class Multiple> void RunUnthreadedFilter(util::FilePiece &in_lm, Filter &filter, ParallelMultiple<Multiple> &output) {
+  Format::RunFilter(in_lm, filter, output.Underlying());
+}
+#endif
+
 template <class Format, class Filter, class OutputBuffer, class Output> void RunThreadedFilter(const Config &config, util::FilePiece &in_lm, Filter &filter, Output &output) {
 #ifndef NTHREAD
   if (config.threads == 1) {
 #endif
-    Format::RunFilter(in_lm, filter, output);
+    RunUnthreadedFilter<Format>(in_lm, filter, output);
 #ifndef NTHREAD
+  } else if (config.lock_free) {
+    typedef Controller<Filter, OutputBuffer, Output, util::MPMCQueue> Threaded;
+    Threaded threading(config.batch_size, config.threads * 2, config.threads, filter, output);
+    Format::RunFilter(in_lm, threading, output);
   } else {
     typedef Controller<Filter, OutputBuffer, Output> Threaded;
     Threaded threading(config.batch_size, config.threads * 2, config.threads, filter, output);
@@ -105,6 +134,18 @@ template <class Format, class Filter, class OutputBuffer, class Output> void Run
   }
 }
 
+template <class Format, class Filter> void RunMultipleFilter(const Config &config, util::FilePiece &in_lm, const Filter &filter, typename Format::Multiple &out) {
+#ifndef NTHREAD
+  if (config.threads > 1 && config.writers > 1) {
+    typedef ParallelMultiple<typename Format::Multiple> Parallel;
+    Parallel parallel(out, config.writers);
+    RunContextFilter<Format, Filter, MultipleOutputBuffer, Parallel>(config, in_lm, filter, parallel);
+    return;
+  }
+#endif
+  RunContextFilter<Format, Filter, MultipleOutputBuffer, typename Format::Multiple>(config, in_lm, filter, out);
+}
+
 template <class Format, class Binary> void DispatchBinaryFilter(const Config &config, util::FilePiece &in_lm, const Binary &binary, typename Format::Output &out) {
   typedef BinaryFilter<Binary> Filter;
   RunContextFilter<Format, Filter, BinaryOutputBuffer, typename Format::Output>(config, in_lm, Filter(binary), out);
@@ -116,12 +157,12 @@ template <class Format> void DispatchFilterModes(const Config &config, std::istr
       typedef phrase::Multiple Filter;
       phrase::Substrings substrings;
       typename Format::Multiple out(out_name, phrase::ReadMultiple(in_vocab, substrings));
-      RunContextFilter<Format, Filter, MultipleOutputBuffer, typename Format::Multiple>(config, in_lm, Filter(substrings), out);
+      RunMultipleFilter<Format, Filter>(config, in_lm, Filter(substrings), out);
     } else {
       typedef vocab::Multiple Filter;
-      boost::unordered_map<std::string, std::vector<unsigned int> > words;
+      Filter::Words words;
       typename Format::Multiple out(out_name, vocab::ReadMultiple(in_vocab, words));
-      RunContextFilter<Format, Filter, MultipleOutputBuffer, typename Format::Multiple>(config, in_lm, Filter(words), out);
+      RunMultipleFilter<Format, Filter>(config, in_lm, Filter(words), out);
     }
     return;
   }
@@ -154,6 +195,17 @@ template <class Format> void DispatchFilterModes(const Config &config, std::istr
   }
 }
 
+template <class Format> void DispatchMappedModes(const Config &config, const char *in_vocab, util::FilePiece &in_lm, const char *out_name) {
+  vocab::MappedWords words(in_vocab);
+  if (config.mode == MODE_MULTIPLE) {
+    typename Format::Multiple out(out_name, words.Sentences());
+    RunMultipleFilter<Format, vocab::MappedMultiple>(config, in_lm, vocab::MappedMultiple(words), out);
+  } else {
+    typename Format::Output out(out_name);
+    DispatchBinaryFilter<Format, vocab::MappedUnion>(config, in_lm, vocab::MappedUnion(words), out);
+  }
+}
+
 } // namespace
 } // namespace lm
 
@@ -198,7 +250,17 @@ int main(int argc, char *argv[]) {
           std::cerr << "Batch size must be at least one and should probably be >= 5000" << std::endl;
           if (!config.batch_size) return 1;
         }
+      } else if (!std::strcmp(str, "lockfree")) {
+        config.lock_free = true;
+      } else if (!std::strncmp(str, "writers:", 8)) {
+        config.writers = boost::lexical_cast<size_t>(str + 8);
+        if (!config.writers) {
+          std::cerr << "Specify at least one writer." << std::endl;
+          return 1;
+        }
 #endif
+      } else if (!std::strcmp(str, "mapped")) {
+        config.mapped = true;
       } else {
         lm::DisplayHelp(argv[0]);
         return 1;
@@ -228,6 +290,20 @@ int main(int argc, char *argv[]) {
     } else {
       std::cerr << "Assuming that " << cmd_input << " is a model file" << std::endl;
     }
+    if (config.mapped) {
+      if (cmd_is_model || config.phrase || (config.mode != lm::MODE_UNION && config.mode != lm::MODE_MULTIPLE)) {
+        std::cerr << "A mapped vocabulary works in multiple or union mode without phrase, and must be given with vocab:." << std::endl;
+        return 1;
+      }
+      util::FilePiece model(0, NULL, &std::cerr);
+      if (config.format == lm::FORMAT_ARPA) {
+        lm::DispatchMappedModes<lm::ARPAFormat>(config, cmd_input, model, argv[argc - 1]);
+      } else if (config.format == lm::FORMAT_COUNT) {
+        lm::DispatchMappedModes<lm::CountFormat>(config, cmd_input, model, argv[argc - 1]);
+      }
+      return 0;
+    }
+
     std::ifstream cmd_file;
     std::istream *vocab;
     if (cmd_is_model) {
@@ -45,6 +45,12 @@ template <class Single> class MultipleOutput {
       files_[offset].AddNGram(begin, end, line);
     }
 
+    // Add to outputs shard, shard + shards, shard + 2 * shards, ...
+    void ShardAddNGram(size_t shard, size_t shards, const StringPiece &line) {
+      for (size_t i = shard; i < files_.size(); i += shards)
+        files_[i].AddNGram(line);
+    }
+
   protected:
     Singles files_;
 };
@@ -129,6 +135,8 @@ struct CountFormat {
   template <class Filter, class Out> static void RunFilter(util::FilePiece &in, Filter &filter, Out &output) {
     DispatchInput<Filter, Out> dispatcher(filter, output);
     ReadCount(in, dispatcher);
+    // Write out the last batch when threaded.
+    filter.Flush();
   }
 };
 
@@ -195,6 +203,8 @@ class BinaryOutputBuffer {
     std::vector<StringPiece> lines_;
 };
 
+template <class Multiple> class ParallelMultiple;
+
 class MultipleOutputBuffer {
   public:
     MultipleOutputBuffer() : last_(NULL) {}
@@ -232,6 +242,23 @@ class MultipleOutputBuffer {
       annotated_.clear();
     }
 
+    // Hand the whole batch to the writer threads.  Defined in thread.hh.
+    template <class Multiple> void Flush(ParallelMultiple<Multiple> &output);
+
+    // Write only the lines bound for outputs whose index is shard modulo shards.
+    // Writer threads call this concurrently with different shards.
+    template <class Output> void FlushShard(Output &output, size_t shard, size_t shards) const {
+      for (std::vector<Annotated>::const_iterator i = annotated_.begin(); i != annotated_.end(); ++i) {
+        if (i->systems.empty()) {
+          output.ShardAddNGram(shard, shards, i->line);
+        } else {
+          for (std::vector<size_t>::const_iterator j = i->systems.begin(); j != i->systems.end(); ++j) {
+            if (*j % shards == shard) output.SingleAddNGram(*j, i->line);
+          }
+        }
+      }
+    }
+
   private:
     struct Annotated {
       // If this is empty, send to all systems.
@@ -1,3 +1,5 @@
+#include "lm/filter/vocab.hh"
+#include "util/file.hh"
 #include "util/file_stream.hh"
 #include "util/file_piece.hh"
 #include "util/murmur_hash.hh"
@@ -77,6 +79,18 @@ class TargetWords {
       }
     }
 
+    // Write the binary form read by lm::vocab::MappedWords.
+    void WriteMapped(int fd) const {
+      lm::vocab::MappedWordsBuilder builder;
+      builder.SetSentences(vocab_.size());
+      for (std::size_t i = 0; i < vocab_.size(); ++i) {
+        for (boost::unordered_set<const char *>::const_iterator j = vocab_[i].begin(); j != vocab_[i].end(); ++j) {
+          builder.Add(i, *j);
+        }
+      }
+      builder.Write(fd);
+    }
+
   private:
     InternString intern_;
 
@@ -136,8 +150,11 @@ class Input {
 } // namespace
 
 int main(int argc, char *argv[]) {
-  if (argc != 2) {
-    std::cerr << "Expected source text on the command line" << std::endl;
+  if (argc != 2 && argc != 3) {
+    std::cerr << "Expected source text on the command line, optionally followed by a\n"
+      "file name.  Given a file name, the vocabularies are written there in the\n"
+      "binary format that filter can mmap with the mapped option instead of being\n"
+      "printed as text." << std::endl;
     return 1;
   }
   Input input(7);
@@ -161,5 +178,10 @@ int main(int argc, char *argv[]) {
       source.remove_suffix(1);
     targets.Add(input.Matches(source), *++it);
   }
-  targets.Print();
+  if (argc == 3) {
+    util::scoped_fd out(util::CreateOrThrow(argv[2]));
+    targets.WriteMapped(out.get());
+  } else {
+    targets.Print();
+  }
 }
@@ -1,8 +1,11 @@
 #ifndef LM_FILTER_THREAD_H
 #define LM_FILTER_THREAD_H
 
+#include "lm/filter/format.hh"
+#include "util/pcqueue.hh"
 #include "util/thread_pool.hh"
 
+#include <boost/ptr_container/ptr_vector.hpp>
 #include <boost/utility/in_place_factory.hpp>
 
 #include <deque>
@@ -47,11 +50,11 @@ template <class OutputBuffer> class ThreadBatch {
     uint64_t sequence_;
 };
 
-template <class Batch, class Filter> class FilterWorker {
+template <class Batch, class Filter, template <class> class Queue = util::PCQueue> class FilterWorker {
   public:
     typedef Batch *Request;
 
-    FilterWorker(const Filter &filter, util::PCQueue<Request> &done) : filter_(filter), done_(done) {}
+    FilterWorker(const Filter &filter, Queue<Request> &done) : filter_(filter), done_(done) {}
 
     void operator()(Request request) {
       request->CallFilter(filter_);
@@ -61,15 +64,15 @@ template <class Batch, class Filter> class FilterWorker {
   private:
     Filter filter_;
 
-    util::PCQueue<Request> &done_;
+    Queue<Request> &done_;
 };
 
 // There should only be one OutputWorker.
-template <class Batch, class Output> class OutputWorker {
+template <class Batch, class Output, template <class> class Queue = util::PCQueue> class OutputWorker {
   public:
     typedef Batch *Request;
 
-    OutputWorker(Output &output, util::PCQueue<Request> &done) : output_(output), done_(done), base_sequence_(0) {}
+    OutputWorker(Output &output, Queue<Request> &done) : output_(output), done_(done), base_sequence_(0) {}
 
     void operator()(Request request) {
       assert(request->Sequence() >= base_sequence_);
@@ -90,14 +93,16 @@ template <class Batch, class Output> class OutputWorker {
   private:
     Output &output_;
 
-    util::PCQueue<Request> &done_;
+    Queue<Request> &done_;
 
     std::deque<Request> ordering_;
 
     uint64_t base_sequence_;
 };
 
-template <class Filter, class OutputBuffer, class RealOutput> class Controller : boost::noncopyable {
+// Queue is util::PCQueue or a lock-free queue from util/ring_queue.hh that
+// supports multiple producers and consumers (util::MPMCQueue).
+template <class Filter, class OutputBuffer, class RealOutput, template <class> class Queue = util::PCQueue> class Controller : boost::noncopyable {
   private:
     typedef ThreadBatch<OutputBuffer> Batch;
 
@@ -153,15 +158,82 @@ template <class Filter, class OutputBuffer, class RealOutput> class Controller :
 
     std::vector<Batch> batches_;
 
-    util::PCQueue<Batch*> to_read_;
+    Queue<Batch*> to_read_;
     std::stack<Batch*> local_read_;
-    util::ThreadPool<OutputWorker<Batch, RealOutput> > output_;
-    util::ThreadPool<FilterWorker<Batch, Filter> > filter_;
+    util::ThreadPool<OutputWorker<Batch, RealOutput, Queue>, Queue<Batch*> > output_;
+    util::ThreadPool<FilterWorker<Batch, Filter, Queue>, Queue<Batch*> > filter_;
 
     uint64_t sequence_;
     InputBuffer *input_;
 };
 
+template <class Multiple> class ShardWriter {
+  public:
+    typedef const MultipleOutputBuffer *Request;
+
+    ShardWriter(Multiple &output, size_t shard, size_t shards, util::PCQueue<size_t> &done)
+      : output_(output), shard_(shard), shards_(shards), done_(done) {}
+
+    void operator()(Request request) {
+      request->FlushShard(output_, shard_, shards_);
+      done_.Produce(shard_);
+    }
+
+  private:
+    Multiple &output_;
+    const size_t shard_, shards_;
+    util::PCQueue<size_t> &done_;
+};
+
+/* In multiple mode every n-gram may go to many files, so with enough filter
+ * threads the single OutputWorker becomes the bottleneck.  This splits the
+ * files among writer threads: writer i owns files i, i + writers, i + 2 *
+ * writers, ...  A batch is written by all writers before it is recycled, so
+ * each file still receives n-grams in order.  Use as the RealOutput of a
+ * Controller with MultipleOutputBuffer.
+ */
+template <class Multiple> class ParallelMultiple : boost::noncopyable {
+  public:
+    ParallelMultiple(Multiple &output, size_t writers) : output_(output), done_(writers) {
+      writers_.reserve(writers);
+      for (size_t i = 0; i < writers; ++i) {
+        writers_.push_back(new Pool(1, 1, boost::in_place(boost::ref(output), i, writers, boost::ref(done_)), NULL));
+      }
+    }
+
+    // Called by the OutputWorker.
+    void Write(const MultipleOutputBuffer &buffer) {
+      for (typename boost::ptr_vector<Pool>::iterator i = writers_.begin(); i != writers_.end(); ++i) {
+        i->Produce(&buffer);
+      }
+      for (size_t i = 0; i < writers_.size(); ++i) {
+        done_.Consume();
+      }
+    }
+
+    Multiple &Underlying() { return output_; }
+
+    // The rest happens between batches, when the writers are idle.
+    void ReserveForCounts(std::streampos reserve) { output_.ReserveForCounts(reserve); }
+    void BeginLength(unsigned int length) { output_.BeginLength(length); }
+    void EndLength(unsigned int length) { output_.EndLength(length); }
+    void Finish() { output_.Finish(); }
+
+  private:
+    typedef util::ThreadPool<ShardWriter<Multiple> > Pool;
+
+    Multiple &output_;
+
+    util::PCQueue<size_t> done_;
+
+    boost::ptr_vector<Pool> writers_;
+};
+
+template <class Multiple> void MultipleOutputBuffer::Flush(ParallelMultiple<Multiple> &output) {
+  output.Write(*this);
+  annotated_.clear();
+}
+
 } // namespace lm
 
 #endif // LM_FILTER_THREAD_H
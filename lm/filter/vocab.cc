@@ -1,9 +1,16 @@
 #include "lm/filter/vocab.hh"
 
+#include "util/exception.hh"
+#include "util/file.hh"
+#include "util/murmur_hash.hh"
+#include "util/sorted_uniform.hh"
+
+#include <algorithm>
 #include <istream>
 #include <iostream>
 
 #include <cctype>
+#include <cstring>
 
 namespace lm {
 namespace vocab {
@@ -31,7 +38,7 @@ bool IsLineEnd(std::istream &in) {
 
 // Read space separated words in enter separated lines.  These lines can be
 // very long, so don't read an entire line at a time.
-unsigned int ReadMultiple(std::istream &in, boost::unordered_map<std::string, std::vector<unsigned int> > &out) {
+unsigned int ReadMultiple(std::istream &in, MultipleWords &out) {
   in.exceptions(std::istream::badbit);
   unsigned int sentence = 0;
   bool used_id = false;
@@ -49,5 +56,74 @@ unsigned int ReadMultiple(std::istream &in, boost::unordered_map<std::string, st
   return sentence + used_id;
 }
 
+namespace {
+const char kMappedMagic[8] = {'v', 'o', 'c', 'a', 'b', 'i', 'd', 'x'};
+
+uint64_t HashWord(const StringPiece &word) {
+  return util::MurmurHash64A(word.data(), word.size());
+}
+} // namespace
+
+MappedWords::MappedWords(const char *file, util::LoadMethod load_method) : file_(util::OpenReadOrThrow(file)) {
+  uint64_t size = util::SizeOrThrow(file_.get());
+  UTIL_THROW_IF(size < sizeof(MappedHeader), util::Exception, "File " << file << " is too small to be a mapped vocabulary.");
+  util::MapRead(load_method, file_.get(), 0, size, mem_);
+  const MappedHeader *header = reinterpret_cast<const MappedHeader*>(mem_.get());
+  UTIL_THROW_IF(memcmp(header->magic, kMappedMagic, sizeof(kMappedMagic)), util::Exception, "File " << file << " is not a mapped vocabulary.  Create one with phrase_table_vocab.");
+  UTIL_THROW_IF(size != sizeof(MappedHeader) + sizeof(uint64_t) * (2 * header->word_count + 1) + sizeof(unsigned int) * header->posting_count,
+      util::Exception, "Mapped vocabulary " << file << " has the wrong size for its header.  Was it truncated?");
+  sentences_ = header->sentences;
+  hashes_ = reinterpret_cast<const uint64_t*>(header + 1);
+  hashes_end_ = hashes_ + header->word_count;
+  offsets_ = hashes_end_;
+  postings_ = reinterpret_cast<const unsigned int*>(offsets_ + header->word_count + 1);
+}
+
+bool MappedWords::Find(const StringPiece &word, boost::iterator_range<const unsigned int*> &out) const {
+  const uint64_t *found;
+  if (!util::SortedUniformFind<const uint64_t*, util::IdentityAccessor<uint64_t>, util::Pivot64>(util::IdentityAccessor<uint64_t>(), hashes_, hashes_end_, HashWord(word), found))
+    return false;
+  const uint64_t *offset = offsets_ + (found - hashes_);
+  out = boost::iterator_range<const unsigned int*>(postings_ + *offset, postings_ + *(offset + 1));
+  return true;
+}
+
+void MappedWordsBuilder::Add(unsigned int sentence, const StringPiece &word) {
+  std::vector<unsigned int> &posting = postings_[HashWord(word)];
+  if (posting.empty() || (posting.back() != sentence))
+    posting.push_back(sentence);
+  sentences_ = std::max(sentences_, sentence + 1);
+}
+
+void MappedWordsBuilder::Write(int fd) const {
+  std::vector<uint64_t> hashes;
+  hashes.reserve(postings_.size());
+  for (boost::unordered_map<uint64_t, std::vector<unsigned int> >::const_iterator i = postings_.begin(); i != postings_.end(); ++i) {
+    hashes.push_back(i->first);
+  }
+  std::sort(hashes.begin(), hashes.end());
+
+  std::vector<uint64_t> offsets;
+  offsets.reserve(hashes.size() + 1);
+  offsets.push_back(0);
+  for (std::vector<uint64_t>::const_iterator i = hashes.begin(); i != hashes.end(); ++i) {
+    offsets.push_back(offsets.back() + postings_.find(*i)->second.size());
+  }
+
+  MappedHeader header;
+  memcpy(header.magic, kMappedMagic, sizeof(kMappedMagic));
+  header.sentences = sentences_;
+  header.word_count = hashes.size();
+  header.posting_count = offsets.back();
+  util::WriteOrThrow(fd, &header, sizeof(header));
+  if (!hashes.empty())
+    util::WriteOrThrow(fd, &hashes[0], sizeof(uint64_t) * hashes.size());
+  util::WriteOrThrow(fd, &offsets[0], sizeof(uint64_t) * offsets.size());
+  for (std::vector<uint64_t>::const_iterator i = hashes.begin(); i != hashes.end(); ++i) {
+    const std::vector<unsigned int> &posting = postings_.find(*i)->second;
+    util::WriteOrThrow(fd, &posting[0], sizeof(unsigned int) * posting.size());
+  }
+}
+
 } // namespace vocab
 } // namespace lm
@@ -3,6 +3,8 @@
 
 // Vocabulary-based filters for language models.
 
+#include "util/file.hh"
+#include "util/mmap.hh"
 #include "util/multi_intersection.hh"
 #include "util/string_piece.hh"
 #include "util/string_piece_hash.hh"
@@ -16,13 +18,85 @@
 #include <string>
 #include <vector>
 
+#include <stdint.h>
+
 namespace lm {
 namespace vocab {
 
+typedef boost::unordered_map<std::string, std::vector<unsigned int> > MultipleWords;
+
 void ReadSingle(std::istream &in, boost::unordered_set<std::string> &out);
 
 // Read one sentence vocabulary per line.  Return the number of sentences.
-unsigned int ReadMultiple(std::istream &in, boost::unordered_map<std::string, std::vector<unsigned int> > &out);
+unsigned int ReadMultiple(std::istream &in, MultipleWords &out);
+
+/* Binary form of the one-vocabulary-per-sentence input that is mmapped instead
+ * of read into a hash table, so loading takes no time and the pages are shared
+ * between processes.  phrase_table_vocab writes it.  Words are identified by
+ * 64-bit hash.  If two words collide, their sentence lists are merged and the
+ * filter is slightly more permissive.
+ *
+ * Layout: MappedHeader, then the sorted word hashes, then word_count + 1
+ * offsets into the postings, then the postings: for each word, the increasing
+ * ids of sentences that contain it.
+ */
+struct MappedHeader {
+  char magic[8];
+  uint64_t sentences;
+  uint64_t word_count;
+  uint64_t posting_count;
+};
+
+class MappedWords : boost::noncopyable {
+  public:
+    explicit MappedWords(const char *file, util::LoadMethod load_method = util::POPULATE_OR_READ);
+
+    unsigned int Sentences() const { return sentences_; }
+
+    // Sets out to the ids of sentences containing word.
+    bool Find(const StringPiece &word, boost::iterator_range<const unsigned int*> &out) const;
+
+  private:
+    util::scoped_fd file_;
+    util::scoped_memory mem_;
+
+    const uint64_t *hashes_, *hashes_end_;
+    const uint64_t *offsets_;
+    const unsigned int *postings_;
+
+    unsigned int sentences_;
+};
+
+// Accumulates the input of MappedWords.
+class MappedWordsBuilder {
+  public:
+    MappedWordsBuilder() : sentences_(0) {}
+
+    // Sentences must be added in non-decreasing order.
+    void Add(unsigned int sentence, const StringPiece &word);
+
+    // Declare the number of sentences, including any trailing empty ones.
+    void SetSentences(unsigned int sentences) { sentences_ = sentences; }
+
+    void Write(int fd) const;
+
+  private:
+    boost::unordered_map<uint64_t, std::vector<unsigned int> > postings_;
+
+    unsigned int sentences_;
+};
+
+// Lookup used by the filters below, for either form of the vocabulary.
+inline bool FindSentences(const MultipleWords &words, const StringPiece &word, boost::iterator_range<const unsigned int*> &out) {
+  MultipleWords::const_iterator found(FindStringPiece(words, word));
+  if (found == words.end()) return false;
+  out = boost::iterator_range<const unsigned int*>(&*found->second.begin(), &*found->second.begin() + found->second.size());
+  return true;
+}
+
+inline bool FindSentences(const MappedWords &words, const StringPiece &word, boost::iterator_range<const unsigned int*> &out) {
+  return words.Find(word, out);
+}
 
 /* Is this a special tag like <s> or <UNK>?  This actually includes anything
  * surrounded with < and >, which most tokenizers separate for real words, so
@@ -52,20 +126,21 @@ class Single {
     const Words &vocab_;
 };
 
-class Union {
+// WordsT is MultipleWords or MappedWords.
+template <class WordsT> class BasicUnion {
   public:
-    typedef boost::unordered_map<std::string, std::vector<unsigned int> > Words;
+    typedef WordsT Words;
 
-    explicit Union(const Words &vocabs) : vocabs_(vocabs) {}
+    explicit BasicUnion(const Words &vocabs) : vocabs_(vocabs) {}
 
     template <class Iterator> bool PassNGram(const Iterator &begin, const Iterator &end) {
       sets_.clear();
 
+      boost::iterator_range<const unsigned int*> found;
       for (Iterator i(begin); i != end; ++i) {
         if (IsTag(*i)) continue;
-        Words::const_iterator found(FindStringPiece(vocabs_, *i));
-        if (vocabs_.end() == found) return false;
-        sets_.push_back(boost::iterator_range<const unsigned int*>(&*found->second.begin(), &*found->second.end()));
+        if (!FindSentences(vocabs_, *i, found)) return false;
+        sets_.push_back(found);
       }
       return (sets_.empty() || util::FirstIntersection(sets_));
     }
@@ -76,11 +151,14 @@ class Union {
     std::vector<boost::iterator_range<const unsigned int*> > sets_;
 };
 
-class Multiple {
+typedef BasicUnion<MultipleWords> Union;
+typedef BasicUnion<MappedWords> MappedUnion;
+
+template <class WordsT> class BasicMultiple {
   public:
-    typedef boost::unordered_map<std::string, std::vector<unsigned int> > Words;
+    typedef WordsT Words;
 
-    Multiple(const Words &vocabs) : vocabs_(vocabs) {}
+    BasicMultiple(const Words &vocabs) : vocabs_(vocabs) {}
 
   private:
     // Callback from AllIntersection that does AddNGram.
@@ -100,11 +178,11 @@ class Multiple {
   public:
     template <class Iterator, class Output> void AddNGram(const Iterator &begin, const Iterator &end, const StringPiece &line, Output &output) {
       sets_.clear();
+      boost::iterator_range<const unsigned int*> found;
       for (Iterator i(begin); i != end; ++i) {
         if (IsTag(*i)) continue;
-        Words::const_iterator found(FindStringPiece(vocabs_, *i));
-        if (vocabs_.end() == found) return;
-        sets_.push_back(boost::iterator_range<const unsigned int*>(&*found->second.begin(), &*found->second.end()));
+        if (!FindSentences(vocabs_, *i, found)) return;
+        sets_.push_back(found);
       }
       if (sets_.empty()) {
         output.AddNGram(line);
@@ -127,6 +205,9 @@ class Multiple {
     std::vector<boost::iterator_range<const unsigned int*> > sets_;
 };
 
+typedef BasicMultiple<MultipleWords> Multiple;
+typedef BasicMultiple<MappedWords> MappedMultiple;
+
 } // namespace vocab
 } // namespace lm
 
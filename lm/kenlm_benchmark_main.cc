@@ -75,10 +75,9 @@ template <class Model, class Width> void DispatchFunction(const Model &model, bo
   }
 }
 
-template <class Model> void DispatchWidth(const char *file, bool query) {
+template <class Model> void DispatchWidth(const char *file, bool query, util::LoadMethod load_method) {
   lm::ngram::Config config;
-  config.load_method = util::READ;
-  std::cerr << "Using load_method = READ." << std::endl;
+  config.load_method = load_method;
   Model model(file, config);
   lm::WordIndex bound = model.GetVocabulary().Bound();
   if (bound <= 256) {
@@ -92,28 +91,34 @@ template <class Model> void DispatchWidth(const char *file, bool query) {
   }
 }
 
-void Dispatch(const char *file, bool query) {
+void Dispatch(const char *file, bool query, util::LoadMethod load_method) {
   using namespace lm::ngram;
   lm::ngram::ModelType model_type;
   if (lm::ngram::RecognizeBinary(file, model_type)) {
     switch(model_type) {
       case PROBING:
-        DispatchWidth<lm::ngram::ProbingModel>(file, query);
+        DispatchWidth<lm::ngram::ProbingModel>(file, query, load_method);
         break;
       case REST_PROBING:
-        DispatchWidth<lm::ngram::RestProbingModel>(file, query);
+        DispatchWidth<lm::ngram::RestProbingModel>(file, query, load_method);
         break;
       case TRIE:
-        DispatchWidth<lm::ngram::TrieModel>(file, query);
+        DispatchWidth<lm::ngram::TrieModel>(file, query, load_method);
         break;
       case QUANT_TRIE:
-        DispatchWidth<lm::ngram::QuantTrieModel>(file, query);
+        DispatchWidth<lm::ngram::QuantTrieModel>(file, query, load_method);
         break;
       case ARRAY_TRIE:
-        DispatchWidth<lm::ngram::ArrayTrieModel>(file, query);
+        DispatchWidth<lm::ngram::ArrayTrieModel>(file, query, load_method);
         break;
       case QUANT_ARRAY_TRIE:
-        DispatchWidth<lm::ngram::QuantArrayTrieModel>(file, query);
+        DispatchWidth<lm::ngram::QuantArrayTrieModel>(file, query, load_method);
+        break;
+      case EF_TRIE:
+        DispatchWidth<lm::ngram::EliasFanoTrieModel>(file, query, load_method);
+        break;
+      case QUANT_EF_TRIE:
+        DispatchWidth<lm::ngram::QuantEliasFanoTrieModel>(file, query, load_method);
         break;
       default:
         UTIL_THROW(util::Exception, "Unrecognized kenlm model type " << model_type);
@@ -123,10 +128,30 @@ void Dispatch(const char *file, bool query) {
   }
 }
 
+bool ParseLoadMethod(const char *name, util::LoadMethod &out) {
+  if (!strcmp(name, "lazy")) {
+    out = util::LAZY;
+  } else if (!strcmp(name, "populate")) {
+    out = util::POPULATE_OR_READ;
+  } else if (!strcmp(name, "read")) {
+    out = util::READ;
+  } else if (!strcmp(name, "parallel")) {
+    out = util::PARALLEL_READ;
+  } else if (!strcmp(name, "huge")) {
+    out = util::HUGE_READ;
+  } else if (!strcmp(name, "interleave")) {
+    out = util::INTERLEAVE_READ;
+  } else {
+    return false;
+  }
+  return true;
+}
+
 } // namespace
 
 int main(int argc, char *argv[]) {
-  if (argc != 3 || (strcmp(argv[1], "vocab") && strcmp(argv[1], "query"))) {
+  util::LoadMethod load_method = util::READ;
+  if ((argc != 3 && argc != 4) || (strcmp(argv[1], "vocab") && strcmp(argv[1], "query")) || (argc == 4 && !ParseLoadMethod(argv[3], load_method))) {
     std::cerr
       << "Benchmark program for KenLM.  Intended usage:\n"
       << "#Convert text to vocabulary ids offline.  These ids are tied to a model.\n"
@@ -134,9 +159,13 @@ int main(int argc, char *argv[]) {
       << "#Ensure files are in RAM.\n"
       << "cat $text.vocab $model >/dev/null\n"
       << "#Timed query against the model.\n"
-      << argv[0] << " query $model <$text.vocab\n";
+      << argv[0] << " query $model [load] <$text.vocab\n"
+      << "#load is one of lazy, populate, read (default), parallel, huge, or\n"
+      << "#interleave.  Run once per method to compare lookup throughput, e.g.\n"
+      << "for l in read huge interleave; do " << argv[0] << " query $model $l <$text.vocab; done\n";
     return 1;
   }
-  Dispatch(argv[2], !strcmp(argv[1], "query"));
+  std::cerr << "Using load method " << (argc == 4 ? argv[3] : "read") << "." << std::endl;
+  Dispatch(argv[2], !strcmp(argv[1], "query"), load_method);
   return 0;
 }
@@ -384,6 +384,12 @@ BOOST_AUTO_TEST_CASE(ArrayQuantTrieAll) {
 BOOST_AUTO_TEST_CASE(ArrayTrieAll) {
   Everything<ArrayTrieModel>();
 }
+BOOST_AUTO_TEST_CASE(EliasFanoTrieAll) {
+  Everything<EliasFanoTrieModel>();
+}
+BOOST_AUTO_TEST_CASE(QuantEliasFanoTrieAll) {
+  Everything<QuantEliasFanoTrieModel>();
+}
 
 BOOST_AUTO_TEST_CASE(RestProbing) {
   Config config;
@@ -40,7 +40,7 @@ void ComplainAboutARPA(const Config &config, ModelType model_type) {
   if (config.arpa_complain == Config::ALL) {
     *config.messages << "Loading the LM will be faster if you build a binary file." << std::endl;
   } else if (config.arpa_complain == Config::EXPENSIVE &&
-             (model_type == TRIE || model_type == QUANT_TRIE || model_type == ARRAY_TRIE || model_type == QUANT_ARRAY_TRIE)) {
+             (model_type == TRIE || model_type == QUANT_TRIE || model_type == ARRAY_TRIE || model_type == QUANT_ARRAY_TRIE || model_type == EF_TRIE || model_type == QUANT_EF_TRIE)) {
     *config.messages << "Building " << kModelNames[model_type] << " from ARPA is expensive.  Save time by building a binary format." << std::endl;
   }
 }
@@ -322,6 +322,8 @@ template class GenericModel<trie::TrieSearch<DontQuantize, trie::DontBhiksha>, S
 template class GenericModel<trie::TrieSearch<DontQuantize, trie::ArrayBhiksha>, SortedVocabulary>;
 template class GenericModel<trie::TrieSearch<SeparatelyQuantize, trie::DontBhiksha>, SortedVocabulary>;
 template class GenericModel<trie::TrieSearch<SeparatelyQuantize, trie::ArrayBhiksha>, SortedVocabulary>;
+template class GenericModel<trie::TrieSearch<DontQuantize, trie::EliasFanoBhiksha>, SortedVocabulary>;
+template class GenericModel<trie::TrieSearch<SeparatelyQuantize, trie::EliasFanoBhiksha>, SortedVocabulary>;
 
 } // namespace detail
 
@@ -340,6 +342,10 @@ base::Model *LoadVirtual(const char *file_name, const Config &config, ModelType
       return new ArrayTrieModel(file_name, config);
     case QUANT_ARRAY_TRIE:
       return new QuantArrayTrieModel(file_name, config);
+    case EF_TRIE:
+      return new EliasFanoTrieModel(file_name, config);
+    case QUANT_EF_TRIE:
+      return new QuantEliasFanoTrieModel(file_name, config);
     default:
       UTIL_THROW(FormatLoadException, "Confused by model type " << model_type);
   }
@@ -359,6 +359,12 @@ BOOST_AUTO_TEST_CASE(bhiksha_trie) {
 BOOST_AUTO_TEST_CASE(quant_bhiksha_trie) {
   LoadingTest<QuantArrayTrieModel>();
 }
+BOOST_AUTO_TEST_CASE(elias_fano_trie) {
+  LoadingTest<EliasFanoTrieModel>();
+}
+BOOST_AUTO_TEST_CASE(quant_elias_fano_trie) {
+  LoadingTest<QuantEliasFanoTrieModel>();
+}
 
 template <class ModelT> void BinaryTest(Config::WriteMethod write_method) {
   Config config;
@@ -430,6 +436,12 @@ BOOST_AUTO_TEST_CASE(write_and_read_array_trie) {
 BOOST_AUTO_TEST_CASE(write_and_read_quant_array_trie) {
   BinaryTest<QuantArrayTrieModel>();
 }
+BOOST_AUTO_TEST_CASE(write_and_read_elias_fano_trie) {
+  BinaryTest<EliasFanoTrieModel>();
+}
+BOOST_AUTO_TEST_CASE(write_and_read_quant_elias_fano_trie) {
+  BinaryTest<QuantEliasFanoTrieModel>();
+}
 
 BOOST_AUTO_TEST_CASE(rest_max) {
   Config config;
@@ -20,17 +20,45 @@ namespace ngram {
 
 namespace {
 
+typedef std::vector<float>::iterator Iter;
+
+// Put the values at each boundary in their sorted positions.  Which values land
+// in each bin then matches a full sort, at a cost of O(n log bins).
+void SelectBoundaries(Iter begin, Iter end, const Iter *bound_begin, const Iter *bound_end) {
+  while (bound_begin != bound_end && end - begin > 1) {
+    const Iter *mid = bound_begin + (bound_end - bound_begin) / 2;
+    std::nth_element(begin, *mid, end);
+    SelectBoundaries(begin, *mid, bound_begin, mid);
+    begin = *mid + 1;
+    bound_begin = mid + 1;
+    // Boundaries at the pivot are already in place.
+    while (bound_begin != bound_end && *bound_begin < begin) ++bound_begin;
+  }
+}
+
 void MakeBins(std::vector<float> &values, float *centers, uint32_t bins) {
-  std::sort(values.begin(), values.end());
-  std::vector<float>::const_iterator start = values.begin(), finish;
-  for (uint32_t i = 0; i < bins; ++i, ++centers, start = finish) {
-    finish = values.begin() + ((values.size() * static_cast<uint64_t>(i + 1)) / bins);
+  std::vector<Iter> bounds;
+  bounds.reserve(bins);
+  for (uint32_t i = 0; i < bins; ++i) {
+    bounds.push_back(values.begin() + ((values.size() * static_cast<uint64_t>(i + 1)) / bins));
+  }
+  // The last bound is the end, which needs no selection.
+  if (!bounds.empty()) SelectBoundaries(values.begin(), values.end(), &*bounds.begin(), &*bounds.begin() + bounds.size() - 1);
+
+  Iter start = values.begin();
+  for (uint32_t i = 0; i < bins; ++i, ++centers) {
+    Iter finish = bounds[i];
     if (finish == start) {
       // zero length bucket.
       *centers = i ? *(centers - 1) : -std::numeric_limits<float>::infinity();
     } else {
+      // Sum in sorted order, as after a full sort, so that rounding and
+      // hence the centers come out the same.  Sorting the bins separately
+      // costs O(n log(n / bins)).
+      std::sort(start, finish);
       *centers = std::accumulate(start, finish, 0.0) / static_cast<float>(finish - start);
     }
+    start = finish;
   }
 }
 
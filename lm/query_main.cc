@@ -14,8 +14,9 @@ void Usage(const char *name) {
     "-b: Do not buffer output.\n"
     "-n: Do not wrap the input in <s> and </s>.\n"
     "-v summary|sentence|word: Level of verbosity\n"
-    "-l lazy|populate|read|parallel: Load lazily, with populate, or malloc+read\n"
-    "The default loading method is populate on Linux and read on others.\n";
+    "-l lazy|populate|read|parallel|huge|interleave: Load lazily, with populate, or malloc+read\n"
+    "The default loading method is populate on Linux and read on others.\n"
+    "huge reads into reserved hugetlb pages; interleave spreads pages across NUMA nodes.\n";
   exit(1);
 }
 
@@ -57,6 +58,10 @@ int main(int argc, char *argv[]) {
           config.load_method = util::READ;
         } else if (!strcmp(optarg, "parallel")) {
           config.load_method = util::PARALLEL_READ;
+        } else if (!strcmp(optarg, "huge")) {
+          config.load_method = util::HUGE_READ;
+        } else if (!strcmp(optarg, "interleave")) {
+          config.load_method = util::INTERLEAVE_READ;
         } else {
           Usage(argv[0]);
         }
@@ -93,6 +98,12 @@ int main(int argc, char *argv[]) {
         case QUANT_ARRAY_TRIE:
           Query<QuantArrayTrieModel>(file, config, sentence_context, printer);
           break;
+        case EF_TRIE:
+          Query<EliasFanoTrieModel>(file, config, sentence_context, printer);
+          break;
+        case QUANT_EF_TRIE:
+          Query<QuantEliasFanoTrieModel>(file, config, sentence_context, printer);
+          break;
         default:
           std::cerr << "Unrecognized kenlm model type " << model_type << std::endl;
           abort();
@@ -125,6 +125,7 @@ util::BitAddress BitPackedLongest::Find(WordIndex word, const NodeRange &range)
 
 template class BitPackedMiddle<DontBhiksha>;
 template class BitPackedMiddle<ArrayBhiksha>;
+template class BitPackedMiddle<EliasFanoBhiksha>;
 
 } // namespace trie
 } // namespace ngram
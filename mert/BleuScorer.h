@@ -42,6 +42,11 @@ public:
     return 2 * kBleuNgramOrder + 1;
   }
 
+  // Hypotheses are only looked up in the reference n-gram counts.
+  virtual bool concurrentPrepareStats() const {
+    return !hasFilter();
+  }
+
   void CalcBleuStats(const Reference& ref, const std::string& text, ScoreStats& entry) const;
 
   int CalcReferenceLength(const Reference& ref, std::size_t length) const;
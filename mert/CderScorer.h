@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include "EditDistance.h"
 #include "Types.h"
 #include "StatisticsBasedScorer.h"
 
@@ -36,8 +37,10 @@ private:
 
   typedef std::vector<int> sent_t;
   std::vector<std::vector<sent_t> > m_ref_sentences;
+  // WER only: the references as bit-parallel patterns
+  std::vector<std::vector<LevenshteinMatcher> > m_ref_matchers;
 
-  void computeCD(const sent_t& cand, const sent_t& ref,
+  void computeCD(std::size_t rid, std::size_t sid, const sent_t& cand,
                  std::vector<ScoreStatsType>& stats) const;
 
   // no copying allowed
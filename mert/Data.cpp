@@ -10,6 +10,8 @@
 #include <cmath>
 #include <fstream>
 
+#include <boost/unordered_map.hpp>
+
 #include "Data.h"
 #include "Scorer.h"
 #include "ScorerFactory.h"
@@ -17,6 +19,7 @@
 #include "util/exception.hh"
 
 #include "util/file_piece.hh"
+#include "util/murmur_hash.hh"
 #include "util/random.hh"
 #include "util/tokenize_piece.hh"
 #include "util/string_piece.hh"
@@ -46,89 +49,74 @@ Data::Data(Scorer* scorer, const string& sparse_weights_file)
   }
 }
 
+namespace
+{
+
+// Candidates are duplicates if their dense features and score statistics
+// are equal, so only those go into the key.
+size_t CandidateKey(const FeatureStats& features, const ScoreStats& scores)
+{
+  uint64_t key = util::MurmurHashNative(features.getArray(), features.size() * sizeof(FeatureStatsType));
+  return util::MurmurHashNative(scores.getArray(), scores.size() * sizeof(ScoreStatsType), key);
+}
+
+} // namespace
+
 //ADDED BY TS
-// TODO: This is too long; consider creating additional functions to
-// reduce the lines of this function.
 void Data::removeDuplicates()
 {
   size_t nSentences = m_feature_data->size();
   assert(m_score_data->size() == nSentences);
 
   for (size_t s = 0; s < nSentences; s++) {
-    FeatureArray& feat_array =  m_feature_data->get(s);
-    ScoreArray& score_array =  m_score_data->get(s);
-
-    assert(feat_array.size() == score_array.size());
-
-    //serves as a hash-map:
-    map<double, vector<size_t> > lookup;
-
-    size_t end_pos = feat_array.size() - 1;
-
-    size_t nRemoved = 0;
-
-    for (size_t k = 0; k <= end_pos; k++) {
-      const FeatureStats& cur_feats = feat_array.get(k);
-      double sum = 0.0;
-      for (size_t l = 0; l < cur_feats.size(); l++)
-        sum += cur_feats.get(l);
-
-      if (lookup.find(sum) != lookup.end()) {
-
-        //cerr << "hit" << endl;
-        vector<size_t>& cur_list = lookup[sum];
-
-        // TODO: Make sure this is correct because we have already used 'l'.
-        // If this does not impact on the removing duplicates, it is better
-        // to change
-        size_t l = 0;
-        for (l = 0; l < cur_list.size(); l++) {
-          size_t j = cur_list[l];
-
-          if (cur_feats == feat_array.get(j)
-              && score_array.get(k) == score_array.get(j)) {
-            if (k < end_pos) {
-              feat_array.swap(k,end_pos);
-              score_array.swap(k,end_pos);
-              k--;
-            }
-            end_pos--;
-            nRemoved++;
-            break;
-          }
-        }
-        if (l == lookup[sum].size())
-          cur_list.push_back(k);
-      } else {
-        lookup[sum].push_back(k);
-      }
-      // for (size_t j=0; j < k; j++) {
+    RemoveDuplicates(m_feature_data->get(s), m_score_data->get(s));
+  }
+}
+//END_ADDED
+
+size_t Data::RemoveDuplicates(FeatureArray& feat_array, ScoreArray& score_array)
+{
+  assert(feat_array.size() == score_array.size());
+  if (feat_array.size() == 0) return 0;
 
-      // 	if (feat_array.get(k) == feat_array.get(j)
-      // 	    && score_array.get(k) == score_array.get(j)) {
+  // Candidates seen so far, by hashed key
+  boost::unordered_map<size_t, vector<size_t> > lookup;
 
-      // 	  if (k < end_pos) {
+  size_t end_pos = feat_array.size() - 1;
 
-      // 	    feat_array.swap(k,end_pos);
-      // 	    score_array.swap(k,end_pos);
+  size_t nRemoved = 0;
 
-      // 	    k--;
-      // 	  }
+  for (size_t k = 0; k <= end_pos; k++) {
+    const FeatureStats& cur_feats = feat_array.get(k);
+    vector<size_t>& cur_list = lookup[CandidateKey(cur_feats, score_array.get(k))];
 
-      //          end_pos--;
-      // 	  nRemoved++;
-      //          break;
-      // 	}
-      // }
-    } // end for k
+    size_t l = 0;
+    for (l = 0; l < cur_list.size(); l++) {
+      size_t j = cur_list[l];
 
-    if (nRemoved > 0) {
-      feat_array.resize(end_pos+1);
-      score_array.resize(end_pos+1);
+      if (cur_feats == feat_array.get(j)
+          && score_array.get(k) == score_array.get(j)) {
+        // Move the duplicate to the end, to be cut off below
+        if (k < end_pos) {
+          feat_array.swap(k,end_pos);
+          score_array.swap(k,end_pos);
+          k--;
+        }
+        end_pos--;
+        nRemoved++;
+        break;
+      }
     }
+    if (l == cur_list.size())
+      cur_list.push_back(k);
+  } // end for k
+
+  if (nRemoved > 0) {
+    feat_array.resize(end_pos+1);
+    score_array.resize(end_pos+1);
   }
+  return nRemoved;
 }
-//END_ADDED
 
 void Data::load(const std::string &featfile, const std::string &scorefile)
 {
@@ -142,7 +130,7 @@ void Data::loadNBest(const string &file, bool oneBest)
   util::FilePiece in(file.c_str());
 
   ScoreStats scoreentry;
-  string sentence, feature_str, alignment;
+  string sentence, feature_str;
   int sentence_index;
 
   while (true) {
@@ -152,33 +140,8 @@ void Data::loadNBest(const string &file, bool oneBest)
       // adding statistics for error measures
       scoreentry.clear();
 
-      util::TokenIter<util::MultiCharacter> it(line, util::MultiCharacter("|||"));
-
-      sentence_index = ParseInt(*it);
+      sentence_index = ParseNBestLine(line, m_scorer->useAlignment(), &sentence, &feature_str);
       if (oneBest && m_score_data->exists(sentence_index)) continue;
-      ++it;
-      sentence = it->as_string();
-      ++it;
-      feature_str = it->as_string();
-      ++it;
-
-      if (it) {
-        ++it;                             // skip model score.
-
-        if (it) {
-          alignment = it->as_string(); //fifth field (if present) is either phrase or word alignment
-          ++it;
-          if (it) {
-            alignment = it->as_string(); //sixth field (if present) is word alignment
-          }
-        }
-      }
-      //TODO check alignment exists if scorers need it
-
-      if (m_scorer->useAlignment()) {
-        sentence += "|||";
-        sentence += alignment;
-      }
       m_scorer->prepareStats(sentence_index, sentence, scoreentry);
 
       m_score_data->add(scoreentry, sentence_index);
@@ -195,6 +158,39 @@ void Data::loadNBest(const string &file, bool oneBest)
   }
 }
 
+int Data::ParseNBestLine(const StringPiece& line, bool withAlignment,
+                         string* sentence, string* feature_str)
+{
+  string alignment;
+  util::TokenIter<util::MultiCharacter> it(line, util::MultiCharacter("|||"));
+
+  int sentence_index = ParseInt(*it);
+  ++it;
+  *sentence = it->as_string();
+  ++it;
+  *feature_str = it->as_string();
+  ++it;
+
+  if (it) {
+    ++it;                             // skip model score.
+
+    if (it) {
+      alignment = it->as_string(); //fifth field (if present) is either phrase or word alignment
+      ++it;
+      if (it) {
+        alignment = it->as_string(); //sixth field (if present) is word alignment
+      }
+    }
+  }
+  //TODO check alignment exists if scorers need it
+
+  if (withAlignment) {
+    *sentence += "|||";
+    *sentence += alignment;
+  }
+  return sentence_index;
+}
+
 void Data::save(const std::string &featfile, const std::string &scorefile, bool bin)
 {
   if (bin)
@@ -207,6 +203,11 @@ void Data::save(const std::string &featfile, const std::string &scorefile, bool
 }
 
 void Data::InitFeatureMap(const string& str)
+{
+  m_feature_data->setFeatureMap(FeatureNames(str));
+}
+
+string Data::FeatureNames(const string& str)
 {
   string buf = str;
   string substr;
@@ -232,15 +233,21 @@ void Data::InitFeatureMap(const string& str)
       tmp_name = substr.substr(0, substr.size() - 1);
     }
   }
-  m_feature_data->setFeatureMap(features);
+  return features;
 }
 
 void Data::AddFeatures(const string& str,
                        int sentence_index)
+{
+  FeatureStats feature_entry;
+  ParseFeatures(str, feature_entry);
+  m_feature_data->add(feature_entry, sentence_index);
+}
+
+void Data::ParseFeatures(const string& str, FeatureStats& feature_entry)
 {
   string buf = str;
   string substr;
-  FeatureStats feature_entry;
   feature_entry.reset();
 
   while (!buf.empty()) {
@@ -256,7 +263,6 @@ void Data::AddFeatures(const string& str,
       feature_entry.addSparse(name, atof(substr.c_str()));
     }
   }
-  m_feature_data->add(feature_entry, sentence_index);
 }
 
 void Data::createShards(size_t shard_count, float shard_size, const string& scorerconfig,
@@ -15,6 +15,7 @@
 #include "Util.h"
 #include "FeatureData.h"
 #include "ScoreData.h"
+#include "util/string_piece.hh"
 
 namespace MosesTuning
 {
@@ -77,6 +78,20 @@ public:
   void removeDuplicates();
   //END_ADDED
 
+  /**
+   * Remove the candidates of one sentence whose dense features and score
+   * statistics repeat an earlier one. Returns the number removed.
+   */
+  static std::size_t RemoveDuplicates(FeatureArray& features, ScoreArray& scores);
+
+  /**
+   * Split an n-best line into its sentence index (returned), hypothesis and
+   * feature string. With alignment, the alignment field is appended to the
+   * hypothesis after "|||".
+   */
+  static int ParseNBestLine(const StringPiece& line, bool withAlignment,
+                            std::string* sentence, std::string* feature_str);
+
   inline bool existsFeatureNames() const {
     return m_feature_data->existsFeatureNames();
   }
@@ -100,8 +115,11 @@ public:
 
   // Helper functions for loadnbest();
   void InitFeatureMap(const std::string& str);
+  /** Names of the dense features in an n-best feature string, as "lm_0 tm_0 ... " */
+  static std::string FeatureNames(const std::string& str);
   void AddFeatures(const std::string& str,
                    int sentence_index);
+  static void ParseFeatures(const std::string& str, FeatureStats& entry);
 };
 
 }
@@ -0,0 +1,42 @@
+#include "EditDistance.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace MosesTuning
+{
+
+size_t CderDistance(const vector<int>& cand, const vector<int>& ref, bool allowLongJumps)
+{
+  const size_t I = cand.size() + 1; // Number of inter-words positions in candidate sentence
+
+  // row[i] stores cost of cheapest path from (0,0) to (i,l) in CDER aligment grid.
+  vector<int> row(I), next(I);
+  for (size_t i = 0; i < I; ++i) row[i] = allowLongJumps ? min<int>(i, 1) : i;
+
+  for (size_t l = 0; l < ref.size(); ++l) {
+    const int word = ref[l];
+    // Insertions and substitutions only look at the previous row, so this
+    // loop has no carried dependency and can be vectorized.
+    next[0] = row[0] + 1;
+    for (size_t i = 1; i < I; ++i) {
+      next[i] = min(row[i] + 1, row[i - 1] + (cand[i - 1] == word ? 0 : 1));
+    }
+    // Deletions
+    for (size_t i = 1; i < I; ++i) {
+      next[i] = min(next[i], next[i - 1] + 1);
+    }
+    if (allowLongJumps) {
+      // Cost of LongJumps is the same for all in the row
+      const int jump = 1 + *min_element(next.begin(), next.end());
+      for (size_t i = 0; i < I; ++i) {
+        next[i] = min(next[i], jump);
+      }
+    }
+    row.swap(next);
+  }
+  return row[I - 1];
+}
+
+}
@@ -0,0 +1,27 @@
+#ifndef MERT_EDIT_DISTANCE_H_
+#define MERT_EDIT_DISTANCE_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "util/levenshtein.hh"
+
+namespace MosesTuning
+{
+
+/**
+ * Levenshtein distance between a reference and any number of candidates,
+ * over word ids.
+ */
+typedef util::LevenshteinMatcher<int> LevenshteinMatcher;
+
+/**
+ * Cover disjoint distance of Leusch et al. (2006) from the candidate to the
+ * reference, or the word error rate if long jumps are not allowed.
+ */
+std::size_t CderDistance(const std::vector<int>& cand, const std::vector<int>& ref,
+                         bool allowLongJumps);
+
+}
+
+#endif  // MERT_EDIT_DISTANCE_H_
@@ -0,0 +1,67 @@
+#include "EditDistance.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#define BOOST_TEST_MODULE MertEditDistance
+#include <boost/test/unit_test.hpp>
+
+using namespace MosesTuning;
+
+namespace
+{
+
+std::size_t SimpleLevenshtein(const std::vector<int>& a, const std::vector<int>& b)
+{
+  std::vector<std::size_t> row(b.size() + 1), next(b.size() + 1);
+  for (std::size_t j = 0; j <= b.size(); ++j) row[j] = j;
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    next[0] = i + 1;
+    for (std::size_t j = 0; j < b.size(); ++j) {
+      next[j + 1] = std::min(std::min(row[j + 1], next[j]) + 1, row[j] + (a[i] == b[j] ? 0 : 1));
+    }
+    row.swap(next);
+  }
+  return row[b.size()];
+}
+
+std::vector<int> RandomSentence(std::size_t length, int vocabulary)
+{
+  std::vector<int> sentence(length);
+  for (std::size_t i = 0; i < length; ++i) sentence[i] = std::rand() % vocabulary;
+  return sentence;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(wer_random)
+{
+  std::srand(1234);
+  const std::size_t lengths[] = {1, 7, 63, 64, 65, 130, 200};
+  for (std::size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i) {
+    for (std::size_t j = 0; j < sizeof(lengths) / sizeof(lengths[0]); ++j) {
+      for (int vocabulary = 2; vocabulary <= 50; vocabulary *= 5) {
+        std::vector<int> pattern = RandomSentence(lengths[i], vocabulary);
+        std::vector<int> text = RandomSentence(lengths[j], vocabulary);
+        BOOST_CHECK_EQUAL(CderDistance(text, pattern, false),
+                          SimpleLevenshtein(pattern, text));
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(cder_long_jumps)
+{
+  // Swapping two blocks costs three long jumps: to the second block, back
+  // to the first one, and to the end of the candidate.
+  int cand[] = {4, 5, 1, 2, 3};
+  int ref[] = {1, 2, 3, 4, 5};
+  std::vector<int> c(cand, cand + 5), r(ref, ref + 5);
+  BOOST_CHECK_EQUAL(CderDistance(c, r, true), 3);
+  BOOST_CHECK_EQUAL(CderDistance(c, r, false), 4);
+  BOOST_CHECK_EQUAL(CderDistance(r, r, true), 0);
+  // Candidate words that are not covered cost one jump in total, missing
+  // reference words one each.
+  BOOST_CHECK_EQUAL(CderDistance(c, std::vector<int>(), true), 1);
+  BOOST_CHECK_EQUAL(CderDistance(std::vector<int>(), r, true), 5);
+}
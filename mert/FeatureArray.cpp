@@ -72,11 +72,12 @@ void FeatureArray::save(bool bin)
   save(&cout, bin);
 }
 
-void FeatureArray::loadbin(istream* is, size_t n)
+void FeatureArray::loadbin(istream* is, const SparseVector& sparseWeights, size_t n)
 {
-  FeatureStats entry(m_num_features);
   for (size_t i = 0 ; i < n; i++) {
-    entry.loadbin(is);
+    // Fresh each time: merging sparse features appends to the dense ones.
+    FeatureStats entry(m_num_features);
+    entry.loadbin(is, sparseWeights);
     add(entry);
   }
 }
@@ -109,6 +110,9 @@ void FeatureArray::load(istream* is, const SparseVector& sparseWeights)
       binmode = false;
     } else if ((loc = stringBuf.find(FEATURES_BIN_BEGIN)) == 0) {
       binmode = true;
+    } else if (stringBuf.find("FEATURES_BIN_BEGIN_0") == 0) {
+      TRACE_ERR("ERROR: FeatureArray::load(): binary features of version 0 are no longer supported, run the extractor again");
+      return;
     } else {
       TRACE_ERR("ERROR: FeatureArray::load(): Wrong header");
       return;
@@ -124,7 +128,7 @@ void FeatureArray::load(istream* is, const SparseVector& sparseWeights)
   }
 
   if (binmode) {
-    loadbin(is, number_of_entries);
+    loadbin(is, sparseWeights, number_of_entries);
   } else {
     loadtxt(is, sparseWeights, number_of_entries);
   }
@@ -19,8 +19,9 @@ namespace MosesTuning
 
 const char FEATURES_TXT_BEGIN[] = "FEATURES_TXT_BEGIN_0";
 const char FEATURES_TXT_END[] = "FEATURES_TXT_END_0";
-const char FEATURES_BIN_BEGIN[] = "FEATURES_BIN_BEGIN_0";
-const char FEATURES_BIN_END[] = "FEATURES_BIN_END_0";
+// Version 1 of the binary format also stores the sparse features.
+const char FEATURES_BIN_BEGIN[] = "FEATURES_BIN_BEGIN_1";
+const char FEATURES_BIN_END[] = "FEATURES_BIN_END_1";
 
 class FeatureArray
 {
@@ -96,7 +97,7 @@ public:
   void save(bool bin=false);
 
   void loadtxt(std::istream* is, const SparseVector& sparseWeights, std::size_t n);
-  void loadbin(std::istream* is, std::size_t n);
+  void loadbin(std::istream* is, const SparseVector& sparseWeights, std::size_t n);
   void load(std::istream* is, const SparseVector& sparseWeights);
 
   bool check_consistency() const;
@@ -18,6 +18,9 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
 #include <iostream>
 #include <sstream>
+
+#include <stdint.h>
+
 #include <boost/functional/hash.hpp>
 
 #include "util/file_piece.hh"
@@ -55,6 +58,11 @@ float ParseFloat(const StringPiece& str)
   return value;
 }
 
+void ReadBinary(FilePiece& in, void* to, size_t size)
+{
+  in.Read(to, size);
+}
+
 bool operator==(FeatureDataItem const& item1, FeatureDataItem const& item2)
 {
   return item1.dense==item1.dense && item1.sparse==item1.sparse;
@@ -84,7 +92,8 @@ void FeatureDataIterator::readNext()
   m_next.clear();
   try {
     StringPiece marker = m_in->ReadDelimited();
-    if (marker != StringPiece(FEATURES_TXT_BEGIN)) {
+    const bool binary = (marker == StringPiece(FEATURES_BIN_BEGIN));
+    if (!binary && marker != StringPiece(FEATURES_TXT_BEGIN)) {
       throw FileFormatException(m_in->FileName(), marker.as_string());
     }
     // size_t sentenceId =
@@ -93,8 +102,12 @@ void FeatureDataIterator::readNext()
     size_t length = m_in->ReadULong();
     m_in->ReadLine(); //discard rest of line
     for (size_t i = 0; i < count; ++i) {
-      StringPiece line = m_in->ReadLine();
       m_next.push_back(FeatureDataItem());
+      if (binary) {
+        readBinaryItem(length, m_next.back());
+        continue;
+      }
+      StringPiece line = m_in->ReadLine();
       for (TokenIter<AnyCharacter, true> token(line, AnyCharacter(" \t")); token; ++token) {
         TokenIter<AnyCharacterLast,false> value(*token,AnyCharacterLast("="));
         if (!value) throw FileFormatException(m_in->FileName(), line.as_string());
@@ -116,7 +129,7 @@ void FeatureDataIterator::readNext()
       }
     }
     StringPiece line = m_in->ReadLine();
-    if (line != StringPiece(FEATURES_TXT_END)) {
+    if (line != StringPiece(binary ? FEATURES_BIN_END : FEATURES_TXT_END)) {
       throw FileFormatException(m_in->FileName(), line.as_string());
     }
   } catch (EndOfFileException &e) {
@@ -124,6 +137,25 @@ void FeatureDataIterator::readNext()
   }
 }
 
+// The layout written by FeatureStats::savebin
+void FeatureDataIterator::readBinaryItem(size_t length, FeatureDataItem& item)
+{
+  item.dense.resize(length);
+  if (length) ReadBinary(*m_in, &item.dense[0], length * sizeof(float));
+  uint32_t sparseCount;
+  ReadBinary(*m_in, &sparseCount, sizeof(sparseCount));
+  string name;
+  for (uint32_t j = 0; j < sparseCount; ++j) {
+    uint32_t nameLength;
+    ReadBinary(*m_in, &nameLength, sizeof(nameLength));
+    name.resize(nameLength);
+    if (nameLength) ReadBinary(*m_in, &name[0], nameLength);
+    float value;
+    ReadBinary(*m_in, &value, sizeof(value));
+    item.sparse.set(name, value);
+  }
+}
+
 void FeatureDataIterator::increment()
 {
   readNext();
@@ -61,6 +61,9 @@ int ParseInt(const StringPiece& str );
 /** Assumes a delimiter, so only apply to tokens */
 float ParseFloat(const StringPiece& str);
 
+/** Copies raw bytes, for the binary feature and score blocks */
+void ReadBinary(util::FilePiece& in, void* to, std::size_t size);
+
 
 class FeatureDataItem
 {
@@ -95,6 +98,7 @@ private:
   const std::vector<FeatureDataItem>& dereference() const;
 
   void readNext();
+  void readBinaryItem(std::size_t length, FeatureDataItem& item);
 
   boost::shared_ptr<util::FilePiece> m_in;
   std::vector<FeatureDataItem> m_next;
@@ -1,3 +1,4 @@
+#include "FeatureArray.h"
 #include "FeatureData.h"
 
 #define BOOST_TEST_MODULE FeatureData
@@ -43,3 +44,33 @@ BOOST_AUTO_TEST_CASE(set_feature_map)
   BOOST_CHECK_EQUAL(feature_data.getFeatureIndex("w_0"), (std::size_t)cnt);
   BOOST_CHECK_EQUAL(feature_data.getFeatureName(cnt).c_str(), "w_0");
 }
+
+BOOST_AUTO_TEST_CASE(binary_round_trip)
+{
+  FeatureArray array;
+  array.setIndex(3);
+  array.NumberOfFeatures(2);
+  array.Features("lm_0 tm_0 ");
+
+  FeatureStats entry;
+  entry.add(0.5);
+  entry.add(-1.25);
+  entry.addSparse("sp_a=", 2.0);
+  entry.addSparse("sp_b=", 0.0);
+  array.add(entry);
+
+  std::stringstream stream;
+  array.save(&stream, true);
+  FeatureArray loaded;
+  loaded.load(&stream, SparseVector());
+
+  BOOST_REQUIRE_EQUAL(loaded.size(), (std::size_t)1);
+  BOOST_CHECK_EQUAL(loaded.getIndex(), 3);
+  const FeatureStats& got = loaded.get(0);
+  BOOST_REQUIRE_EQUAL(got.size(), (std::size_t)2);
+  BOOST_CHECK_EQUAL(got.get(0), 0.5);
+  BOOST_CHECK_EQUAL(got.get(1), -1.25);
+  // As through the text format: the '=' is dropped, and so are zeros.
+  BOOST_CHECK_EQUAL(got.getSparse().size(), (std::size_t)1);
+  BOOST_CHECK_EQUAL(got.getSparse().get("sp_a"), 2.0);
+}
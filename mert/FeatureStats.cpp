@@ -12,6 +12,8 @@
 #include <cmath>
 #include <stdexcept>
 
+#include <stdint.h>
+
 #include <boost/functional/hash.hpp>
 
 #include "util/murmur_hash.hh"
@@ -267,6 +269,17 @@ void FeatureStats::set(string &theString, const SparseVector& sparseWeights )
     }
   }
 
+  mergeSparse(sparseWeights);
+  /*
+  cerr << "FS: ";
+  for (size_t i = 0; i < entries_; ++i) {
+    cerr << array_[i] << " ";
+  }
+  cerr << endl;*/
+}
+
+void FeatureStats::mergeSparse(const SparseVector& sparseWeights)
+{
   if (sparseWeights.size()) {
     //Merge the sparse features
     FeatureStatsType merged = inner_product(sparseWeights, m_map);
@@ -280,18 +293,26 @@ void FeatureStats::set(string &theString, const SparseVector& sparseWeights )
     */
     m_map.clear();
   }
-  /*
-  cerr << "FS: ";
-  for (size_t i = 0; i < entries_; ++i) {
-    cerr << array_[i] << " ";
-  }
-  cerr << endl;*/
 }
 
-void FeatureStats::loadbin(istream* is)
+void FeatureStats::loadbin(istream* is, const SparseVector& sparseWeights)
 {
+  m_map.clear();
   is->read(reinterpret_cast<char*>(m_array),
            static_cast<streamsize>(GetArraySizeWithBytes()));
+  uint32_t count = 0;
+  is->read(reinterpret_cast<char*>(&count), sizeof(count));
+  string name;
+  for (uint32_t i = 0; i < count; ++i) {
+    uint32_t length = 0;
+    is->read(reinterpret_cast<char*>(&length), sizeof(length));
+    name.resize(length);
+    if (length) is->read(&name[0], length);
+    FeatureStatsType value;
+    is->read(reinterpret_cast<char*>(&value), sizeof(value));
+    addSparse(name, value);
+  }
+  mergeSparse(sparseWeights);
 }
 
 void FeatureStats::loadtxt(istream* is, const SparseVector& sparseWeights)
@@ -322,6 +343,25 @@ void FeatureStats::savebin(ostream* os)
 {
   os->write(reinterpret_cast<char*>(m_array),
             static_cast<streamsize>(GetArraySizeWithBytes()));
+  // Same features and names as a round trip through the text format, which
+  // drops values near zero and splits name and value at the last '='.
+  vector<pair<string, FeatureStatsType> > sparse;
+  const vector<size_t> feats = m_map.feats();
+  for (size_t i = 0; i < feats.size(); ++i) {
+    const FeatureStatsType value = m_map.get(feats[i]);
+    if (abs(value) < 0.00001) continue;
+    string name = SparseVector::decode(feats[i]);
+    if (EndsWith(name, "=")) name.erase(name.size() - 1);
+    sparse.push_back(make_pair(name, value));
+  }
+  const uint32_t count = sparse.size();
+  os->write(reinterpret_cast<const char*>(&count), sizeof(count));
+  for (size_t i = 0; i < sparse.size(); ++i) {
+    const uint32_t length = sparse[i].first.size();
+    os->write(reinterpret_cast<const char*>(&length), sizeof(length));
+    os->write(sparse[i].first.data(), length);
+    os->write(reinterpret_cast<const char*>(&sparse[i].second), sizeof(sparse[i].second));
+  }
 }
 
 ostream& operator<<(ostream& o, const FeatureStats& e)
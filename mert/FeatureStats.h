@@ -119,6 +119,12 @@ public:
 
   void set(std::string &theString, const SparseVector& sparseWeights);
 
+  /**
+   * If there are sparse weights, replace the sparse features by a single
+   * dense feature holding their weighted sum.
+   */
+  void mergeSparse(const SparseVector& sparseWeights);
+
   inline std::size_t bytes() const {
     return GetArraySizeWithBytes();
   }
@@ -141,7 +147,7 @@ public:
   void savetxt();
 
   void loadtxt(std::istream* is, const SparseVector& sparseWeights);
-  void loadbin(std::istream* is);
+  void loadbin(std::istream* is, const SparseVector& sparseWeights);
 
   /**
    * Write the whole object to a stream.
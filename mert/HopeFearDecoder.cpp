@@ -152,13 +152,14 @@ NbestHopeFearDecoder::NbestHopeFearDecoder(
   bool  no_shuffle,
   bool safe_hope,
   Scorer* scorer
-) : safe_hope_(safe_hope)
+) : randomAccess_(NULL), safe_hope_(safe_hope)
 {
   scorer_ = scorer;
   if (streaming) {
     train_.reset(new StreamingHypPackEnumerator(featureFiles, scoreFiles));
   } else {
-    train_.reset(new RandomAccessHypPackEnumerator(featureFiles, scoreFiles, no_shuffle));
+    randomAccess_ = new RandomAccessHypPackEnumerator(featureFiles, scoreFiles, no_shuffle);
+    train_.reset(randomAccess_);
   }
 }
 
@@ -183,6 +184,61 @@ void NbestHopeFearDecoder::HopeFear(
   const MiraWeightVector& wv,
   HopeFearData* hopeFear
 )
+{
+  HopeFear(*train_, backgroundBleu, wv, hopeFear);
+}
+
+namespace
+{
+
+// One n-best list, seen through the accessors of HypPackEnumerator
+class HypList
+{
+public:
+  HypList(const vector<MiraFeatureVector>& features, const vector<ScoreDataItem>& scores)
+    : m_features(features), m_scores(scores) {}
+
+  size_t cur_size() const {
+    return m_features.size();
+  }
+  const MiraFeatureVector& featuresAt(size_t i) const {
+    return m_features[i];
+  }
+  const ScoreDataItem& scoresAt(size_t i) const {
+    return m_scores[i];
+  }
+
+private:
+  const vector<MiraFeatureVector>& m_features;
+  const vector<ScoreDataItem>& m_scores;
+};
+
+}
+
+size_t NbestHopeFearDecoder::NumSentences() const
+{
+  UTIL_THROW_IF(!randomAccess_, util::Exception, "Random access to n-best lists is not available when streaming");
+  return randomAccess_->num_lists();
+}
+
+void NbestHopeFearDecoder::HopeFearAt(
+  size_t position,
+  const std::vector<ValType>& backgroundBleu,
+  const MiraWeightVector& wv,
+  HopeFearData* hopeFear
+) const
+{
+  UTIL_THROW_IF(!randomAccess_, util::Exception, "Random access to n-best lists is not available when streaming");
+  HypList hyps(randomAccess_->featuresOfList(position), randomAccess_->scoresOfList(position));
+  HopeFear(hyps, backgroundBleu, wv, hopeFear);
+}
+
+template <class Hyps> void NbestHopeFearDecoder::HopeFear(
+  Hyps& hyps,
+  const std::vector<ValType>& backgroundBleu,
+  const MiraWeightVector& wv,
+  HopeFearData* hopeFear
+) const
 {
 
 
@@ -192,10 +248,10 @@ void NbestHopeFearDecoder::HopeFear(
   ValType hope_score=0, fear_score=0, model_score=0;
   for(size_t safe_loop=0; safe_loop<2; safe_loop++) {
     ValType hope_bleu=0, hope_model=0;
-    for(size_t i=0; i< train_->cur_size(); i++) {
-      const MiraFeatureVector& vec=train_->featuresAt(i);
+    for(size_t i=0; i< hyps.cur_size(); i++) {
+      const MiraFeatureVector& vec=hyps.featuresAt(i);
       ValType score = wv.score(vec);
-      ValType bleu = scorer_->calculateSentenceLevelBackgroundScore(train_->scoresAt(i),backgroundBleu);
+      ValType bleu = scorer_->calculateSentenceLevelBackgroundScore(hyps.scoresAt(i),backgroundBleu);
       // Hope
       if(i==0 || (hope_scale*score + bleu) > hope_score) {
         hope_score = hope_scale*score + bleu;
@@ -221,16 +277,16 @@ void NbestHopeFearDecoder::HopeFear(
       hope_scale = abs(hope_bleu) / abs(hope_model);
     else break;
   }
-  hopeFear->modelFeatures = train_->featuresAt(model_index);
-  hopeFear->hopeFeatures = train_->featuresAt(hope_index);
-  hopeFear->fearFeatures = train_->featuresAt(fear_index);
+  hopeFear->modelFeatures = hyps.featuresAt(model_index);
+  hopeFear->hopeFeatures = hyps.featuresAt(hope_index);
+  hopeFear->fearFeatures = hyps.featuresAt(fear_index);
 
-  hopeFear->hopeStats = train_->scoresAt(hope_index);
+  hopeFear->hopeStats = hyps.scoresAt(hope_index);
   hopeFear->hopeBleu = scorer_->calculateSentenceLevelBackgroundScore(hopeFear->hopeStats, backgroundBleu);
-  const vector<float>& fear_stats = train_->scoresAt(fear_index);
+  const vector<float>& fear_stats = hyps.scoresAt(fear_index);
   hopeFear->fearBleu = scorer_->calculateSentenceLevelBackgroundScore(fear_stats, backgroundBleu);
 
-  hopeFear->modelStats = train_->scoresAt(model_index);
+  hopeFear->modelStats = hyps.scoresAt(model_index);
   hopeFear->hopeFearEqual = (hope_index == fear_index);
 }
 
@@ -287,10 +343,7 @@ HypergraphHopeFearDecoder::HypergraphHopeFearDecoder
     //  cerr << "Reading " << hgpath.filename() << endl;
     Graph graph(vocab_);
     size_t id = boost::lexical_cast<size_t>(hgpath.stem().string());
-    util::scoped_fd fd(util::OpenReadOrThrow(hgpath.string().c_str()));
-    //util::FilePiece file(di->path().string().c_str());
-    util::FilePiece file(fd.release());
-    ReadGraph(file,graph);
+    ReadGraph(hgpath.string(),graph);
 
     //cerr << "ref length " << references_.Length(id) << endl;
     size_t edgeCount = hg_pruning * references_.Length(id);
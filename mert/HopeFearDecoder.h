@@ -116,8 +116,32 @@ public:
 
   virtual void MaxModel(const AvgWeightVector& wv, std::vector<ValType>* stats);
 
+  /** Number of n-best lists. Only for the in-memory (not streaming) version */
+  std::size_t NumSentences() const;
+
+  /**
+    * Like HopeFear, for the list at the given position in the order of the
+    * current epoch. Does not move the cursor, so several threads can call it
+    * at once.
+    **/
+  void HopeFearAt(
+    std::size_t position,
+    const std::vector<ValType>& backgroundBleu,
+    const MiraWeightVector& wv,
+    HopeFearData* hopeFear
+  ) const;
+
 private:
+  template <class Hyps> void HopeFear(
+    Hyps& hyps,
+    const std::vector<ValType>& backgroundBleu,
+    const MiraWeightVector& wv,
+    HopeFearData* hopeFear
+  ) const;
+
   boost::scoped_ptr<HypPackEnumerator> train_;
+  // Same object as train_ when not streaming, otherwise NULL
+  RandomAccessHypPackEnumerator* randomAccess_;
   bool safe_hope_;
 
 };
@@ -95,6 +95,18 @@ public:
   virtual const MiraFeatureVector& featuresAt(std::size_t i);
   virtual const ScoreDataItem& scoresAt(std::size_t i);
 
+  // Random access to the lists in the order of the current epoch, which
+  // does not move the cursor.
+  std::size_t num_lists() const {
+    return m_indexes.size();
+  }
+  const std::vector<MiraFeatureVector>& featuresOfList(std::size_t position) const {
+    return m_features[m_indexes[position]];
+  }
+  const std::vector<ScoreDataItem>& scoresOfList(std::size_t position) const {
+    return m_scores[m_indexes[position]];
+  }
+
 private:
   bool m_no_shuffle;
   std::size_t m_cur_index;
@@ -16,12 +16,15 @@ You should have received a copy of the GNU Lesser General Public
 License along with this library; if not, write to the Free Software
 Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 ***********************************************************************/
+#include <cstring>
 #include <iostream>
 #include <set>
 
 #include <boost/lexical_cast.hpp>
 
 #include "util/double-conversion/double-conversion.h"
+#include "util/file.hh"
+#include "util/mmap.hh"
 #include "util/string_piece.hh"
 #include "util/tokenize_piece.hh"
 
@@ -320,4 +323,204 @@ void ReadGraph(util::FilePiece &from, Graph &graph)
   }
 }
 
+const char kBinaryGraphMagic[8] = {'M', 'O', 'S', 'E', 'S', 'H', 'G', '1'};
+
+namespace
+{
+
+//! Bounds checked reads of the arrays of a binary hypergraph
+class BinaryCursor
+{
+public:
+  BinaryCursor(const char *data, size_t size) : current_(data), end_(data + size) {}
+
+  template <class T> const T *Array(size_t count) {
+    UTIL_THROW_IF(count > static_cast<size_t>(end_ - current_) / sizeof(T),
+                  HypergraphException, "Binary hypergraph is truncated");
+    const T *ret = reinterpret_cast<const T*>(current_);
+    current_ += count * sizeof(T);
+    return ret;
+  }
+
+  bool AtEnd() const {
+    return current_ == end_;
+  }
+
+private:
+  const char *current_;
+  const char *end_;
+};
+
+void CheckOffsets(const uint32_t *offsets, size_t count, size_t limit, const char *what)
+{
+  UTIL_THROW_IF(offsets[0] != 0 || offsets[count] != limit, HypergraphException,
+                "Binary hypergraph has bad " << what << " offsets");
+  for (size_t i = 0; i < count; ++i) {
+    UTIL_THROW_IF(offsets[i] > offsets[i + 1], HypergraphException,
+                  "Binary hypergraph has bad " << what << " offsets");
+  }
+}
+
+template <class T> void WriteArray(ostream &out, const vector<T> &array)
+{
+  if (!array.empty()) {
+    out.write(reinterpret_cast<const char*>(&array[0]), array.size() * sizeof(T));
+  }
+}
+
+}
+
+void ReadBinaryGraph(const char *data, std::size_t size, Graph &graph)
+{
+  BinaryCursor cursor(data, size);
+  UTIL_THROW_IF(memcmp(cursor.Array<char>(sizeof(kBinaryGraphMagic)), kBinaryGraphMagic, sizeof(kBinaryGraphMagic)),
+                HypergraphException, "Not a binary hypergraph");
+  const uint32_t *counts = cursor.Array<uint32_t>(6);
+  const size_t vertices = counts[0];
+  const size_t edges = counts[1];
+  const size_t symbols = counts[2];
+  const size_t features = counts[3];
+  const size_t strings = counts[4];
+  const uint32_t *vertexEdges = cursor.Array<uint32_t>(vertices + 1);
+  const uint32_t *sourceCovered = cursor.Array<uint32_t>(vertices);
+  const uint32_t *edgeSymbols = cursor.Array<uint32_t>(edges + 1);
+  const uint32_t *edgeFeatures = cursor.Array<uint32_t>(edges + 1);
+  const uint32_t *symbolIds = cursor.Array<uint32_t>(symbols);
+  const uint32_t *featureNames = cursor.Array<uint32_t>(features);
+  const float *featureValues = cursor.Array<float>(features);
+  const uint32_t *stringOffsets = cursor.Array<uint32_t>(strings + 1);
+  const char *stringData = cursor.Array<char>(counts[5]);
+  UTIL_THROW_IF(!cursor.AtEnd(), HypergraphException, "Binary hypergraph has trailing data");
+  CheckOffsets(vertexEdges, vertices, edges, "edge");
+  CheckOffsets(edgeSymbols, edges, symbols, "symbol");
+  CheckOffsets(edgeFeatures, edges, features, "feature");
+  CheckOffsets(stringOffsets, strings, counts[5], "string");
+
+  // Strings are interned in the vocabulary or as feature names on first use
+  vector<const Vocab::Entry*> words(strings, static_cast<const Vocab::Entry*>(NULL));
+  const size_t kNoFeature = static_cast<size_t>(-1);
+  vector<size_t> featureIds(strings, kNoFeature);
+
+  graph.SetCounts(vertices, edges);
+  for (size_t v = 0; v < vertices; ++v) {
+    Vertex* vertex = graph.NewVertex();
+    vertex->SetSourceCovered(sourceCovered[v]);
+    for (size_t e = vertexEdges[v]; e < vertexEdges[v + 1]; ++e) {
+      Edge* edge = graph.NewEdge();
+      for (size_t i = edgeSymbols[e]; i < edgeSymbols[e + 1]; ++i) {
+        const uint32_t symbol = symbolIds[i];
+        if (symbol & kBinaryChild) {
+          const size_t child = symbol & ~kBinaryChild;
+          UTIL_THROW_IF(child >= graph.VertexSize(), HypergraphException, "Reference to vertex " << child << " but we only have " << graph.VertexSize() << " vertices.  Is the file in bottom-up format?");
+          edge->AddWord(NULL);
+          edge->AddChild(child);
+        } else {
+          UTIL_THROW_IF(symbol >= strings, HypergraphException, "Bad word id " << symbol);
+          if (!words[symbol]) {
+            words[symbol] = &graph.MutableVocab().FindOrAdd(
+                              StringPiece(stringData + stringOffsets[symbol], stringOffsets[symbol + 1] - stringOffsets[symbol]));
+          }
+          edge->AddWord(words[symbol]);
+        }
+      }
+      for (size_t i = edgeFeatures[e]; i < edgeFeatures[e + 1]; ++i) {
+        const uint32_t name = featureNames[i];
+        UTIL_THROW_IF(name >= strings, HypergraphException, "Bad feature name id " << name);
+        if (featureIds[name] == kNoFeature) {
+          featureIds[name] = SparseVector::encode(
+                               string(stringData + stringOffsets[name], stringOffsets[name + 1] - stringOffsets[name]));
+        }
+        edge->AddFeature(featureIds[name], featureValues[i]);
+      }
+      vertex->AddEdge(edge);
+    }
+  }
+}
+
+void ReadGraph(const std::string &filename, Graph &graph)
+{
+  util::scoped_fd fd(util::OpenReadOrThrow(filename.c_str()));
+  const uint64_t size = util::SizeFile(fd.get());
+  char magic[sizeof(kBinaryGraphMagic)];
+  if (size != util::kBadSize && size >= sizeof(magic)) {
+    util::ErsatzPRead(fd.get(), magic, sizeof(magic), 0);
+    if (!memcmp(magic, kBinaryGraphMagic, sizeof(magic))) {
+      util::scoped_memory memory;
+      util::MapRead(util::LAZY, fd.get(), 0, size, memory);
+      ReadBinaryGraph(static_cast<const char*>(memory.get()), size, graph);
+      return;
+    }
+  }
+  util::FilePiece file(fd.release());
+  ReadGraph(file, graph);
+}
+
+void WriteBinaryGraph(const Graph &graph, std::ostream &out)
+{
+  vector<uint32_t> vertexEdges(1, 0), sourceCovered, edgeSymbols(1, 0), edgeFeatures(1, 0);
+  vector<uint32_t> symbols, featureNames, stringOffsets(1, 0);
+  vector<float> featureValues;
+  string strings;
+  boost::unordered_map<const char*, uint32_t> wordIds;
+  boost::unordered_map<size_t, uint32_t> featureIds;
+
+  for (size_t v = 0; v < graph.VertexSize(); ++v) {
+    const Vertex &vertex = graph.GetVertex(v);
+    sourceCovered.push_back(vertex.SourceCovered());
+    for (size_t e = 0; e < vertex.GetIncoming().size(); ++e) {
+      const Edge &edge = *vertex.GetIncoming()[e];
+      size_t child = 0;
+      for (size_t i = 0; i < edge.Words().size(); ++i) {
+        const Vocab::Entry *word = edge.Words()[i];
+        if (!word) {
+          symbols.push_back(kBinaryChild | edge.Children()[child++]);
+          continue;
+        }
+        pair<boost::unordered_map<const char*, uint32_t>::iterator, bool> inserted =
+          wordIds.insert(make_pair(word->first, static_cast<uint32_t>(stringOffsets.size() - 1)));
+        if (inserted.second) {
+          strings += word->first;
+          stringOffsets.push_back(strings.size());
+        }
+        symbols.push_back(inserted.first->second);
+      }
+      const SparseVector &features = *edge.Features();
+      const vector<size_t> ids = features.feats();
+      for (size_t i = 0; i < ids.size(); ++i) {
+        pair<boost::unordered_map<size_t, uint32_t>::iterator, bool> inserted =
+          featureIds.insert(make_pair(ids[i], static_cast<uint32_t>(stringOffsets.size() - 1)));
+        if (inserted.second) {
+          strings += SparseVector::decode(ids[i]);
+          stringOffsets.push_back(strings.size());
+        }
+        featureNames.push_back(inserted.first->second);
+        featureValues.push_back(features.get(ids[i]));
+      }
+      edgeSymbols.push_back(symbols.size());
+      edgeFeatures.push_back(featureNames.size());
+    }
+    vertexEdges.push_back(edgeSymbols.size() - 1);
+  }
+
+  const uint32_t counts[6] = {
+    static_cast<uint32_t>(sourceCovered.size()),
+    static_cast<uint32_t>(edgeSymbols.size() - 1),
+    static_cast<uint32_t>(symbols.size()),
+    static_cast<uint32_t>(featureNames.size()),
+    static_cast<uint32_t>(stringOffsets.size() - 1),
+    static_cast<uint32_t>(strings.size())
+  };
+  out.write(kBinaryGraphMagic, sizeof(kBinaryGraphMagic));
+  out.write(reinterpret_cast<const char*>(counts), sizeof(counts));
+  WriteArray(out, vertexEdges);
+  WriteArray(out, sourceCovered);
+  WriteArray(out, edgeSymbols);
+  WriteArray(out, edgeFeatures);
+  WriteArray(out, symbols);
+  WriteArray(out, featureNames);
+  WriteArray(out, featureValues);
+  WriteArray(out, stringOffsets);
+  out.write(strings.data(), strings.size());
+}
+
 };
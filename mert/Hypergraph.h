@@ -20,7 +20,9 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef MERT_HYPERGRAPH_H
 #define MERT_HYPERGRAPH_H
 
+#include <ostream>
 #include <string>
+#include <stdint.h>
 
 #include <boost/noncopyable.hpp>
 #include <boost/scoped_array.hpp>
@@ -152,6 +154,10 @@ public:
     features_->set(name.as_string(),value);
   }
 
+  void AddFeature(size_t id, FeatureStatsType value) {
+    features_->set(id,value);
+  }
+
 
   const WordVec &Words() const {
     return words_;
@@ -272,6 +278,29 @@ public:
 
 void ReadGraph(util::FilePiece &from, Graph &graph);
 
+/**
+ * Reads the hypergraph in the named file, which is either in the text format
+ * above (possibly compressed), or in the binary format written by Moses'
+ * BinaryHypergraphWriter, which is mapped rather than parsed.
+**/
+void ReadGraph(const std::string &filename, Graph &graph);
+
+/**
+ * Binary format: the magic "MOSESHG1", then the counts of vertices V, edges
+ * E, target symbols S, feature values F, strings N and string bytes B as
+ * uint32, then uint32 first edge of each vertex [V+1], uint32 source covered
+ * [V], uint32 first symbol of each edge [E+1], uint32 first feature [E+1],
+ * uint32 symbols [S] (string id, or kBinaryChild | vertex for a
+ * non-terminal), uint32 feature name ids [F], float feature values [F],
+ * uint32 string offsets [N+1] and the string bytes [B], in native byte order.
+**/
+const uint32_t kBinaryChild = 0x80000000;
+extern const char kBinaryGraphMagic[8];
+
+void ReadBinaryGraph(const char *data, std::size_t size, Graph &graph);
+
+void WriteBinaryGraph(const Graph &graph, std::ostream &out);
+
 
 };
 
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <sstream>
 
 #define BOOST_TEST_MODULE MertForestRescore
 #include <boost/test/unit_test.hpp>
@@ -149,3 +150,65 @@ BOOST_AUTO_TEST_CASE(prune)
 
 
 }
+
+BOOST_AUTO_TEST_CASE(binary_round_trip)
+{
+  Vocab vocab;
+  Graph graph(vocab);
+  graph.SetCounts(3,4);
+
+  Edge* e0 = graph.NewEdge();
+  e0->AddWord(&vocab.FindOrAdd("<s>"));
+  Vertex* v0 = graph.NewVertex();
+  v0->AddEdge(e0);
+
+  Edge* e1 = graph.NewEdge();
+  e1->AddWord(NULL);
+  e1->AddChild(0);
+  e1->AddWord(&vocab.FindOrAdd("a"));
+  e1->AddWord(&vocab.FindOrAdd("b"));
+  e1->AddFeature("foo",1.5);
+  e1->AddFeature("bar",-2);
+  Edge* e2 = graph.NewEdge();
+  e2->AddWord(NULL);
+  e2->AddChild(0);
+  e2->AddWord(&vocab.FindOrAdd("a"));
+  e2->AddFeature("bar",0.25);
+  Vertex* v1 = graph.NewVertex();
+  v1->AddEdge(e1);
+  v1->AddEdge(e2);
+  v1->SetSourceCovered(2);
+
+  Edge* e3 = graph.NewEdge();
+  e3->AddWord(NULL);
+  e3->AddChild(1);
+  e3->AddWord(&vocab.FindOrAdd("</s>"));
+  Vertex* v2 = graph.NewVertex();
+  v2->AddEdge(e3);
+  v2->SetSourceCovered(2);
+
+  ostringstream out;
+  WriteBinaryGraph(graph, out);
+  const string binary = out.str();
+
+  Graph read(vocab);
+  ReadBinaryGraph(binary.data(), binary.size(), read);
+  BOOST_REQUIRE_EQUAL(3, read.VertexSize());
+  BOOST_REQUIRE_EQUAL(4, read.EdgeSize());
+  for (size_t v = 0; v < graph.VertexSize(); ++v) {
+    const Vertex& expected = graph.GetVertex(v);
+    const Vertex& actual = read.GetVertex(v);
+    BOOST_CHECK_EQUAL(expected.SourceCovered(), actual.SourceCovered());
+    BOOST_REQUIRE_EQUAL(expected.GetIncoming().size(), actual.GetIncoming().size());
+    for (size_t e = 0; e < expected.GetIncoming().size(); ++e) {
+      const Edge* expectedEdge = expected.GetIncoming()[e];
+      const Edge* actualEdge = actual.GetIncoming()[e];
+      BOOST_CHECK(expectedEdge->Words() == actualEdge->Words());
+      BOOST_CHECK(expectedEdge->Children() == actualEdge->Children());
+      BOOST_CHECK(*expectedEdge->Features() == *actualEdge->Features());
+    }
+  }
+
+  Graph truncated(vocab);
+  BOOST_CHECK_THROW(ReadBinaryGraph(binary.data(), binary.size() - 1, truncated), HypergraphException);
+}
@@ -1,5 +1,6 @@
 #include "MiraWeightVector.h"
 
+#include <algorithm>
 #include <cmath>
 
 using namespace std;
@@ -74,6 +75,39 @@ AvgWeightVector MiraWeightVector::avg()
   return AvgWeightVector(*this);
 }
 
+/**
+ * Replace this vector by the mean of copies of it trained on separate shards
+ * \param shards Copies of this vector after training, in shard order
+ */
+void MiraWeightVector::mix(vector<MiraWeightVector>& shards)
+{
+  if (shards.empty()) return;
+  fixTotals();
+  const vector<ValType> startTotals(m_totals);
+  const size_t startUpdates = m_numUpdates;
+  size_t size = m_weights.size();
+  for (size_t s = 0; s < shards.size(); ++s) {
+    shards[s].fixTotals();
+    size = max(size, shards[s].m_weights.size());
+  }
+  m_weights.assign(size, 0.0);
+  m_totals.assign(size, 0.0);
+  m_lastUpdated.assign(size, 0);
+  copy(startTotals.begin(), startTotals.end(), m_totals.begin());
+  // Summed in shard order, so the result does not depend on which thread
+  // finished first
+  for (size_t s = 0; s < shards.size(); ++s) {
+    const MiraWeightVector& shard = shards[s];
+    for (size_t i = 0; i < shard.m_weights.size(); ++i) {
+      m_weights[i] += shard.m_weights[i] / shards.size();
+      const ValType start = i < startTotals.size() ? startTotals[i] : 0.0;
+      m_totals[i] += shard.m_totals[i] - start;
+    }
+    m_numUpdates += shard.m_numUpdates - startUpdates;
+  }
+  m_lastUpdated.assign(size, m_numUpdates);
+}
+
 /**
  * Updates a weight and lazily updates its total
  */
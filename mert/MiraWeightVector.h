@@ -63,6 +63,14 @@ public:
    */
   AvgWeightVector avg();
 
+  /**
+   * Replace this vector by the mean of copies of it that were each trained
+   * on a separate shard. The running totals cover every update of every
+   * shard, as if the shards had been visited one after another.
+   * \param shards Copies of this vector after training, in shard order
+   */
+  void mix(std::vector<MiraWeightVector>& shards);
+
   /**
     * Convert to sparse vector, interpreting all features as sparse. Only used by hgmira.
    **/
@@ -9,8 +9,15 @@
 #include <iostream>
 #include <stdint.h>
 
+#ifdef WITH_THREADS
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#endif
+
 #include "Point.h"
 #include "Util.h"
+#include "moses/ThreadPool.h"
 
 using namespace std;
 
@@ -37,9 +44,69 @@ inline float intersect(float m1, float b1, float m2, float b2)
 namespace MosesTuning
 {
 
+#ifdef WITH_THREADS
+namespace
+{
+
+/**
+ * Counts down the envelope jobs of one line search.
+ */
+class Countdown
+{
+public:
+  explicit Countdown(unsigned int count) : m_count(count) {}
+
+  void Done() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    if (--m_count == 0) m_finished.notify_all();
+  }
+
+  void Wait() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (m_count > 0) m_finished.wait(lock);
+  }
+
+private:
+  unsigned int m_count;
+  boost::mutex m_mutex;
+  boost::condition_variable m_finished;
+};
+
+} // namespace
+
+/**
+ * Envelopes of every step-th sentence, for the pool of an Optimizer.
+ */
+class Optimizer::EnvelopeTask : public Moses::Task
+{
+public:
+  EnvelopeTask(const Optimizer& optimizer, const Point& origin, const Point& direction,
+               unsigned int first, unsigned int step,
+               vector<Envelope>& envelopes, string& error, Countdown& countdown)
+    : m_optimizer(optimizer), m_origin(origin), m_direction(direction),
+      m_first(first), m_step(step), m_envelopes(envelopes), m_error(error),
+      m_countdown(countdown) {}
+
+  void Run() {
+    m_optimizer.ComputeEnvelopes(m_origin, m_direction, m_first, m_step, m_envelopes, m_error);
+    m_countdown.Done();
+  }
+
+private:
+  const Optimizer& m_optimizer;
+  const Point& m_origin;
+  const Point& m_direction;
+  unsigned int m_first;
+  unsigned int m_step;
+  vector<Envelope>& m_envelopes;
+  string& m_error;
+  Countdown& m_countdown;
+};
+#endif
+
 
 Optimizer::Optimizer(unsigned Pd, const vector<unsigned>& i2O, const vector<bool>& pos, const vector<parameter_t>& start, unsigned int nrandom)
-  : m_scorer(NULL), m_feature_data(), m_num_random_directions(nrandom), m_positive(pos)
+  : m_scorer(NULL), m_feature_data(), m_num_random_directions(nrandom), m_threads(1), m_positive(pos)
 {
   // Warning: the init vector is a full set of parameters, of dimension m_pdim!
   Point::m_pdim = Pd;
@@ -63,6 +130,15 @@ Optimizer::Optimizer(unsigned Pd, const vector<unsigned>& i2O, const vector<bool
 
 Optimizer::~Optimizer() {}
 
+void Optimizer::SetThreads(unsigned int threads)
+{
+  m_threads = threads ? threads : 1;
+#ifdef WITH_THREADS
+  // The thread of the line search takes one share of the envelopes itself.
+  m_pool.reset(m_threads > 1 ? new Moses::ThreadPool(m_threads - 1) : NULL);
+#endif
+}
+
 statscore_t Optimizer::GetStatScore(const Point& param) const
 {
   vector<unsigned> bests;
@@ -90,6 +166,99 @@ map<float,diff_t >::iterator AddThreshold(map<float,diff_t >& thresholdmap, floa
   return it;
 }
 
+void Optimizer::ComputeEnvelope(unsigned int S, const Point& origin, const Point& direction, Envelope& envelope) const
+{
+  // First, we determine the translation with the best feature score
+  // for each sentence and each value of x.
+  //cerr << "Sentence " << S << endl;
+  multimap<float, unsigned> gradient;
+  vector<float> f0;
+  f0.resize(m_feature_data->get(S).size());
+  for (unsigned j = 0; j < m_feature_data->get(S).size(); j++) {
+    // gradient of the feature function for this particular target sentence
+    gradient.insert(pair<float, unsigned>(direction * (m_feature_data->get(S,j)), j));
+    // compute the feature function at the origin point
+    f0[j] = origin * m_feature_data->get(S, j);
+  }
+  // Now let's compute the 1best for each value of x.
+
+  //    vector<pair<float,unsigned> > onebest;
+
+
+  multimap<float,unsigned>::iterator gradientit = gradient.begin();
+  multimap<float,unsigned>::iterator highest_f0 = gradient.begin();
+
+  float smallest = gradientit->first;//smallest gradient
+  // Several candidates can have the lowest slope (e.g., for word penalty where the gradient is an integer).
+
+  gradientit++;
+  while (gradientit != gradient.end() && gradientit->first == smallest) {
+    //   cerr<<"ni"<<gradientit->second<<endl;;
+    //cerr<<"fos"<<f0[gradientit->second]<<" "<<f0[index]<<" "<<index<<endl;
+    if (f0[gradientit->second] > f0[highest_f0->second])
+      highest_f0 = gradientit;//the highest line is the one with he highest f0
+    gradientit++;
+  }
+
+  gradientit = highest_f0;
+  envelope.first1best = highest_f0->second;
+  envelope.changes.clear();
+
+  // Now we look for the intersections points indicating a change of 1 best.
+  // We use the fact that the function is convex, which means that the gradient can only go up.
+  while (gradientit != gradient.end()) {
+    map<float,unsigned>::iterator leftmost = gradientit;
+    float m = gradientit->first;
+    float b = f0[gradientit->second];
+    multimap<float,unsigned>::iterator gradientit2 = gradientit;
+    gradientit2++;
+    float leftmostx = MAX_FLOAT;
+    for (; gradientit2 != gradient.end(); gradientit2++) {
+      //cerr<<"--"<<d++<<' '<<gradientit2->first<<' '<<gradientit2->second<<endl;
+      // Look for all candidate with a gradient bigger than the current one, and
+      // find the one with the leftmost intersection.
+      float curintersect;
+      if (m != gradientit2->first) {
+        curintersect = intersect(m, b, gradientit2->first, f0[gradientit2->second]);
+        //cerr << "curintersect: " << curintersect << " leftmostx: " << leftmostx << endl;
+        if (curintersect<=leftmostx) {
+          // We have found an intersection to the left of the leftmost we had so far.
+          // We might have curintersect==leftmostx for example is 2 candidates are the same
+          // in that case its better its better to update leftmost to gradientit2 to avoid some recomputing later.
+          leftmostx = curintersect;
+          leftmost = gradientit2; // this is the new reference
+        }
+      }
+    }
+    if (leftmost == gradientit) {
+      // We didn't find any more intersections.
+      // The rightmost bestindex is the one with the highest slope.
+
+      // They should be equal but there might be.
+      UTIL_THROW_IF(abs(leftmost->first-gradient.rbegin()->first) >= 0.0001,
+                    util::Exception, "Error");
+      // A small difference due to rounding error
+      break;
+    }
+    // We have found the next intersection!
+    envelope.changes.push_back(pair<float,unsigned>(leftmostx, leftmost->second));
+    gradientit = leftmost;
+  } // while (gradientit!=gradient.end()){
+}
+
+void Optimizer::ComputeEnvelopes(const Point& origin, const Point& direction,
+                                 unsigned int first, unsigned int step,
+                                 vector<Envelope>& envelopes, string& error) const
+{
+  try {
+    for (unsigned int S = first; S < size(); S += step) {
+      ComputeEnvelope(S, origin, direction, envelopes[S]);
+    }
+  } catch (const std::exception& e) {
+    error = e.what();
+  }
+}
+
 statscore_t Optimizer::LineOptimize(const Point& origin, const Point& direction, Point& bestpoint) const
 {
   // We are looking for the best Point on the line y=Origin+x*direction
@@ -97,85 +266,40 @@ statscore_t Optimizer::LineOptimize(const Point& origin, const Point& direction,
   //typedef pair<unsigned,unsigned> diff;//first the sentence that changes, second is the new 1best for this sentence
   //list<threshold> thresholdlist;
 
+  // The upper envelope of each sentence does not depend on the others, so
+  // they are computed on several threads. They are merged below in sentence
+  // order, which keeps the thresholds the same as with one thread.
+  vector<Envelope> envelopes(size());
+  vector<string> errors(m_threads);
+#ifdef WITH_THREADS
+  if (m_pool && size() > 1) {
+    Countdown countdown(m_threads - 1);
+    for (unsigned int t = 1; t < m_threads; ++t) {
+      boost::shared_ptr<Moses::Task> task(new EnvelopeTask(*this, origin, direction, t, m_threads,
+                                          envelopes, errors[t], countdown));
+      m_pool->Submit(task);
+    }
+    ComputeEnvelopes(origin, direction, 0, m_threads, envelopes, errors[0]);
+    countdown.Wait();
+  } else
+#endif
+  {
+    ComputeEnvelopes(origin, direction, 0, 1, envelopes, errors[0]);
+  }
+  for (size_t t = 0; t < errors.size(); ++t) {
+    UTIL_THROW_IF(!errors[t].empty(), util::Exception, errors[t]);
+  }
+
   map<float,diff_t> thresholdmap;
   thresholdmap[MIN_FLOAT] = diff_t();
   vector<unsigned> first1best;       // the vector of nbests for x=-inf
   for (unsigned int S = 0; S < size(); S++) {
     map<float,diff_t >::iterator previnserted = thresholdmap.begin();
-    // First, we determine the translation with the best feature score
-    // for each sentence and each value of x.
-    //cerr << "Sentence " << S << endl;
-    multimap<float, unsigned> gradient;
-    vector<float> f0;
-    f0.resize(m_feature_data->get(S).size());
-    for (unsigned j = 0; j < m_feature_data->get(S).size(); j++) {
-      // gradient of the feature function for this particular target sentence
-      gradient.insert(pair<float, unsigned>(direction * (m_feature_data->get(S,j)), j));
-      // compute the feature function at the origin point
-      f0[j] = origin * m_feature_data->get(S, j);
-    }
-    // Now let's compute the 1best for each value of x.
-
-    //    vector<pair<float,unsigned> > onebest;
-
-
-    multimap<float,unsigned>::iterator gradientit = gradient.begin();
-    multimap<float,unsigned>::iterator highest_f0 = gradient.begin();
-
-    float smallest = gradientit->first;//smallest gradient
-    // Several candidates can have the lowest slope (e.g., for word penalty where the gradient is an integer).
-
-    gradientit++;
-    while (gradientit != gradient.end() && gradientit->first == smallest) {
-      //   cerr<<"ni"<<gradientit->second<<endl;;
-      //cerr<<"fos"<<f0[gradientit->second]<<" "<<f0[index]<<" "<<index<<endl;
-      if (f0[gradientit->second] > f0[highest_f0->second])
-        highest_f0 = gradientit;//the highest line is the one with he highest f0
-      gradientit++;
-    }
-
-    gradientit = highest_f0;
-    first1best.push_back(highest_f0->second);
-
-    // Now we look for the intersections points indicating a change of 1 best.
-    // We use the fact that the function is convex, which means that the gradient can only go up.
-    while (gradientit != gradient.end()) {
-      map<float,unsigned>::iterator leftmost = gradientit;
-      float m = gradientit->first;
-      float b = f0[gradientit->second];
-      multimap<float,unsigned>::iterator gradientit2 = gradientit;
-      gradientit2++;
-      float leftmostx = MAX_FLOAT;
-      for (; gradientit2 != gradient.end(); gradientit2++) {
-        //cerr<<"--"<<d++<<' '<<gradientit2->first<<' '<<gradientit2->second<<endl;
-        // Look for all candidate with a gradient bigger than the current one, and
-        // find the one with the leftmost intersection.
-        float curintersect;
-        if (m != gradientit2->first) {
-          curintersect = intersect(m, b, gradientit2->first, f0[gradientit2->second]);
-          //cerr << "curintersect: " << curintersect << " leftmostx: " << leftmostx << endl;
-          if (curintersect<=leftmostx) {
-            // We have found an intersection to the left of the leftmost we had so far.
-            // We might have curintersect==leftmostx for example is 2 candidates are the same
-            // in that case its better its better to update leftmost to gradientit2 to avoid some recomputing later.
-            leftmostx = curintersect;
-            leftmost = gradientit2; // this is the new reference
-          }
-        }
-      }
-      if (leftmost == gradientit) {
-        // We didn't find any more intersections.
-        // The rightmost bestindex is the one with the highest slope.
-
-        // They should be equal but there might be.
-        UTIL_THROW_IF(abs(leftmost->first-gradient.rbegin()->first) >= 0.0001,
-                      util::Exception, "Error");
-        // A small difference due to rounding error
-        break;
-      }
-      // We have found the next intersection!
-
-      pair<unsigned,unsigned> newd(S, leftmost->second);//new onebest for Sentence S is leftmost->second
+    first1best.push_back(envelopes[S].first1best);
+    const vector<pair<float,unsigned> >& changes = envelopes[S].changes;
+    for (size_t c = 0; c < changes.size(); ++c) {
+      const float leftmostx = changes[c].first;
+      pair<unsigned,unsigned> newd(S, changes[c].second);//new onebest for Sentence S is changes[c].second
 
       if (leftmostx-previnserted->first < min_int) {
         // Require that the intersection Point be at least min_int to the right of the previous
@@ -221,8 +345,7 @@ statscore_t Optimizer::LineOptimize(const Point& origin, const Point& direction,
       } else { //normal insertion process
         previnserted = AddThreshold(thresholdmap, leftmostx, newd);
       }
-      gradientit = leftmost;
-    } // while (gradientit!=gradient.end()){
+    }
   }   // loop on S
 
   // Now the thresholdlist is up to date: it contains a list of all the parameter_ts where
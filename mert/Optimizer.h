@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <string>
+#include <boost/scoped_ptr.hpp>
 #include "Data.h"
 #include "FeatureData.h"
 #include "Scorer.h"
@@ -10,6 +11,11 @@
 
 static const float kMaxFloat = std::numeric_limits<float>::max();
 
+namespace Moses
+{
+class ThreadPool;
+}
+
 namespace MosesTuning
 {
 
@@ -25,9 +31,34 @@ protected:
   Scorer *m_scorer;      // no accessor for them only child can use them
   FeatureDataHandle m_feature_data;  // no accessor for them only child can use them
   unsigned int m_num_random_directions;
+  unsigned int m_threads;
 
   const std::vector<bool>& m_positive;
 
+#ifdef WITH_THREADS
+  class EnvelopeTask;
+
+  // Computes envelopes for all line searches of this optimizer, which may
+  // run concurrently for several starting points.
+  boost::scoped_ptr<Moses::ThreadPool> m_pool;
+#endif
+
+  /**
+   * The 1-best of a sentence at x=-inf, and each point along the line where
+   * its 1-best changes, with the new 1-best.
+   */
+  struct Envelope {
+    unsigned first1best;
+    std::vector<std::pair<float, unsigned> > changes;
+  };
+
+  void ComputeEnvelope(unsigned int S, const Point& origin, const Point& direction, Envelope& envelope) const;
+
+  /** Envelopes of sentences first, first+step, ... Reports a failure in error. */
+  void ComputeEnvelopes(const Point& origin, const Point& direction,
+                        unsigned int first, unsigned int step,
+                        std::vector<Envelope>& envelopes, std::string& error) const;
+
 public:
   Optimizer(unsigned Pd, const std::vector<unsigned>& i2O, const std::vector<bool>& positive, const std::vector<parameter_t>& start, unsigned int nrandom);
 
@@ -37,6 +68,10 @@ public:
   void SetFeatureData(FeatureDataHandle feature_data) {
     m_feature_data = feature_data;
   }
+  /**
+   * Number of threads computing the sentence envelopes in each line search.
+   */
+  void SetThreads(unsigned int threads);
   virtual ~Optimizer();
 
   unsigned size() const {
@@ -46,7 +46,8 @@ void ScoreDataIterator::readNext()
   m_next.clear();
   try {
     StringPiece marker = m_in->ReadDelimited();
-    if (marker != StringPiece(SCORES_TXT_BEGIN)) {
+    const bool binary = (marker == StringPiece(SCORES_BIN_BEGIN));
+    if (!binary && marker != StringPiece(SCORES_TXT_BEGIN)) {
       throw FileFormatException(m_in->FileName(), marker.as_string());
     }
     // size_t sentenceId =
@@ -55,8 +56,14 @@ void ScoreDataIterator::readNext()
     size_t length = m_in->ReadULong();
     m_in->ReadLine(); //ignore rest of line
     for (size_t i = 0; i < count; ++i) {
-      StringPiece line = m_in->ReadLine();
       m_next.push_back(ScoreDataItem());
+      if (binary) {
+        // The layout written by ScoreStats::savebin
+        m_next.back().resize(length);
+        if (length) ReadBinary(*m_in, &m_next.back()[0], length * sizeof(float));
+        continue;
+      }
+      StringPiece line = m_in->ReadLine();
       for (TokenIter<AnyCharacter, true> token(line,AnyCharacter(" \t")); token; ++token) {
         float value = ParseFloat(*token);
         m_next.back().push_back(value);
@@ -66,7 +73,7 @@ void ScoreDataIterator::readNext()
       }
     }
     StringPiece line = m_in->ReadLine();
-    if (line != StringPiece(SCORES_TXT_END)) {
+    if (line != StringPiece(binary ? SCORES_BIN_END : SCORES_TXT_END)) {
       throw FileFormatException(m_in->FileName(), line.as_string());
     }
   } catch (EndOfFileException& e) {
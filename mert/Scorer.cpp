@@ -182,6 +182,15 @@ string Scorer::applyFilter(const string& sentence) const
   return sentence;
 }
 
+bool Scorer::hasFilter() const
+{
+#if defined(__GLIBCXX__) || defined(__GLIBCPP__)
+  return m_filter != NULL;
+#else
+  return false;
+#endif
+}
+
 float Scorer::score(const candidates_t& candidates) const
 {
   diffs_t diffs;
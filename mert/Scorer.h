@@ -130,6 +130,15 @@ public:
     return false;
   };
 
+  /**
+   * Whether prepareStats() may be called from several threads at once, after
+   * the references are loaded. The scorer must not change the vocabulary or
+   * any other state while scoring a hypothesis.
+   */
+  virtual bool concurrentPrepareStats() const {
+    return false;
+  }
+
   /**
    * Set the factors, which should be used for this metric
    */
@@ -193,6 +202,12 @@ protected:
    */
   void TokenizeAndEncodeTesting(const std::string& line, std::vector<int>& encoded) const;
 
+  /**
+   * Whether a unix filter preprocesses the sentences. The filter is a single
+   * child process, so it cannot be shared between threads.
+   */
+  bool hasFilter() const;
+
   /**
    * Every inherited scorer should call this function for each sentence
    */
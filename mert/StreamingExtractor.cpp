@@ -0,0 +1,382 @@
+/*
+ *  StreamingExtractor.cpp
+ *  mert - Minimum Error Rate Training
+ *
+ *  Extracts feature and score data one sentence at a time.
+ */
+
+#include "StreamingExtractor.h"
+
+#include <deque>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "Data.h"
+#include "FeatureArray.h"
+#include "FeatureDataIterator.h"
+#include "FileStream.h"
+#include "ScoreArray.h"
+#include "Scorer.h"
+#include "Util.h"
+
+#include "moses/ThreadPool.h"
+#include "util/file_piece.hh"
+#include "util/tokenize_piece.hh"
+
+using namespace std;
+
+namespace MosesTuning
+{
+
+#ifdef WITH_THREADS
+namespace
+{
+// Held while a scorer that is not thread safe scores a hypothesis
+boost::mutex scorerMutex;
+}
+#endif
+
+/**
+ * Reads the n-best lines of one file, a sentence at a time.
+ */
+class StreamingExtractor::NBestReader
+{
+public:
+  explicit NBestReader(const string& file)
+    : m_in(file.c_str()), m_file(file), m_done(false), m_next(0) {
+    Advance();
+  }
+
+  bool Done() const {
+    return m_done;
+  }
+
+  /** Index of the next sentence */
+  int Next() const {
+    return m_next;
+  }
+
+  void ReadSentence(vector<string>& lines) {
+    const int sentence = m_next;
+    while (!m_done && m_next == sentence) {
+      lines.push_back(m_line);
+      Advance();
+    }
+    if (!m_done && m_next < sentence) {
+      throw runtime_error("Error: sentences are not in increasing order in n-best file " + m_file);
+    }
+  }
+
+private:
+  void Advance() {
+    try {
+      StringPiece line;
+      do {
+        line = m_in.ReadLine();
+      } while (line.empty());
+      m_line.assign(line.data(), line.size());
+      util::TokenIter<util::MultiCharacter> it(line, util::MultiCharacter("|||"));
+      m_next = ParseInt(*it);
+    } catch (const util::EndOfFileException&) {
+      m_done = true;
+    }
+  }
+
+  util::FilePiece m_in;
+  string m_file;
+  bool m_done;
+  int m_next;
+  string m_line;
+};
+
+/**
+ * Reads the feature and score blocks of a previous iteration, a sentence at
+ * a time.
+ */
+class StreamingExtractor::PreviousReader
+{
+public:
+  PreviousReader(const string& featureFile, const string& scoreFile)
+    : m_featureIn(featureFile), m_scoreIn(scoreFile), m_file(featureFile) {
+    if (!m_featureIn) {
+      throw runtime_error("Unable to open feature file: " + featureFile);
+    }
+    if (!m_scoreIn) {
+      throw runtime_error("Unable to open score file: " + scoreFile);
+    }
+    Advance();
+  }
+
+  bool Done() const {
+    return m_features.size() == 0;
+  }
+
+  int Next() const {
+    return m_features.getIndex();
+  }
+
+  const FeatureArray& Features() const {
+    return m_features;
+  }
+
+  /** Append the next sentence's candidates */
+  void ReadSentence(FeatureArray& features, ScoreArray& scores) {
+    const int sentence = Next();
+    features.merge(m_features);
+    scores.merge(m_scores);
+    Advance();
+    if (!Done() && Next() < sentence) {
+      throw runtime_error("Error: sentences are not in increasing order in " + m_file);
+    }
+  }
+
+private:
+  void Advance() {
+    m_features.clear();
+    m_scores.clear();
+    m_features.load(&m_featureIn, SparseVector());
+    m_scores.load(&m_scoreIn);
+    if (m_features.getIndex() != m_scores.getIndex() || m_features.size() != m_scores.size()) {
+      throw runtime_error("Error: feature and score data do not match in " + m_file);
+    }
+  }
+
+  inputfilestream m_featureIn;
+  inputfilestream m_scoreIn;
+  string m_file;
+  FeatureArray m_features;
+  ScoreArray m_scores;
+};
+
+/**
+ * Consecutive sentences, scored on one thread and rendered as feature and
+ * score blocks until they are written out in input order.
+ */
+class StreamingExtractor::Chunk : public Moses::WaitableTask
+{
+public:
+  Chunk(Scorer* scorer, bool allowDuplicates, bool bin, bool lockScorer)
+    : m_scorer(scorer), m_allowDuplicates(allowDuplicates), m_bin(bin),
+      m_lockScorer(lockScorer) {}
+
+  struct Sentence {
+    FeatureArray features;
+    ScoreArray scores;
+    vector<string> lines;
+  };
+
+  /**
+   * A new sentence, to be filled in by the caller. The caller also parses
+   * the features of the n-best lines, since sparse feature names are given
+   * ids in a table shared by all threads, in the order they are first seen.
+   */
+  Sentence& Add(int index, size_t numFeatures, const string& featureNames) {
+    m_sentences.push_back(Sentence());
+    Sentence& sentence = m_sentences.back();
+    sentence.features.setIndex(index);
+    sentence.features.NumberOfFeatures(numFeatures);
+    sentence.features.Features(featureNames);
+    sentence.scores.setIndex(index);
+    sentence.scores.NumberOfScores(m_scorer->NumberOfScores());
+    return sentence;
+  }
+
+  size_t Size() const {
+    return m_sentences.size();
+  }
+
+  void Write(ostream& featureOut, ostream& scoreOut) const {
+    featureOut << m_featureOut;
+    scoreOut << m_scoreOut;
+  }
+
+protected:
+  virtual void DoRun();
+
+private:
+  void Score(int index, const string& text, ScoreStats& entry);
+
+  Scorer* m_scorer;
+  bool m_allowDuplicates;
+  bool m_bin;
+  bool m_lockScorer;
+  deque<Sentence> m_sentences;
+  string m_featureOut;
+  string m_scoreOut;
+};
+
+void StreamingExtractor::Chunk::Score(int index, const string& text, ScoreStats& entry)
+{
+#ifdef WITH_THREADS
+  if (m_lockScorer) {
+    boost::mutex::scoped_lock lock(scorerMutex);
+    m_scorer->prepareStats(index, text, entry);
+    return;
+  }
+#endif
+  m_scorer->prepareStats(index, text, entry);
+}
+
+void StreamingExtractor::Chunk::DoRun()
+{
+  ostringstream featureOut;
+  ostringstream scoreOut;
+  string text, featureString;
+  const bool withAlignment = m_scorer->useAlignment();
+  for (; !m_sentences.empty(); m_sentences.pop_front()) {
+    Sentence& sentence = m_sentences.front();
+    for (size_t i = 0; i < sentence.lines.size(); ++i) {
+      const int index = Data::ParseNBestLine(sentence.lines[i], withAlignment, &text, &featureString);
+      ScoreStats scoreEntry;
+      Score(index, text, scoreEntry);
+      sentence.scores.add(scoreEntry);
+    }
+    if (!m_allowDuplicates) {
+      Data::RemoveDuplicates(sentence.features, sentence.scores);
+    }
+    sentence.features.save(&featureOut, m_bin);
+    sentence.scores.save(&scoreOut, m_scorer->getName(), m_bin);
+  }
+  m_featureOut = featureOut.str();
+  m_scoreOut = scoreOut.str();
+}
+
+StreamingExtractor::StreamingExtractor(Scorer* scorer, size_t threads, bool allowDuplicates)
+  : m_scorer(scorer), m_threads(threads ? threads : 1), m_allowDuplicates(allowDuplicates) {}
+
+void StreamingExtractor::Extract(const vector<string>& nbestFiles,
+                                 const vector<string>& prevFeatureFiles,
+                                 const vector<string>& prevScoreFiles,
+                                 const string& featureFile,
+                                 const string& scoreFile,
+                                 bool bin)
+{
+  vector<boost::shared_ptr<PreviousReader> > previous;
+  for (size_t i = 0; i < prevFeatureFiles.size(); ++i) {
+    previous.push_back(boost::shared_ptr<PreviousReader>(
+                         new PreviousReader(prevFeatureFiles[i], prevScoreFiles[i])));
+  }
+  vector<boost::shared_ptr<NBestReader> > nbests;
+  for (size_t i = 0; i < nbestFiles.size(); ++i) {
+    nbests.push_back(boost::shared_ptr<NBestReader>(new NBestReader(nbestFiles[i])));
+  }
+
+  // The feature names come from previous data if there is any, as in Data.
+  size_t numFeatures = 0;
+  string featureNames;
+  for (size_t i = 0; i < previous.size() && featureNames.empty(); ++i) {
+    if (!previous[i]->Done()) {
+      numFeatures = previous[i]->Features().NumberOfFeatures();
+      featureNames = previous[i]->Features().Features();
+    }
+  }
+
+  ofstream featureOut(featureFile.c_str());
+  ofstream scoreOut(scoreFile.c_str());
+  if (!featureOut || !scoreOut) {
+    throw runtime_error("Unable to open " + featureFile + " or " + scoreFile);
+  }
+
+  bool lockScorer = false;
+#ifdef WITH_THREADS
+  boost::scoped_ptr<Moses::ThreadPool> pool;
+  if (m_threads > 1) {
+    pool.reset(new Moses::ThreadPool(m_threads));
+    // The other scorers are shared by taking turns.
+    lockScorer = !m_scorer->concurrentPrepareStats();
+  }
+  Moses::ThreadPool* chunkPool = pool.get();
+#else
+  Moses::ThreadPool* chunkPool = NULL;
+#endif
+  // Limit the number of sentences held in memory.
+  Moses::OrderedPipeline<Chunk> chunks(
+    chunkPool, 2 * m_threads,
+    boost::bind(&Chunk::Write, _1, boost::ref(featureOut), boost::ref(scoreOut)));
+
+  const size_t chunkSize = 20;
+  const bool withAlignment = m_scorer->useAlignment();
+  boost::shared_ptr<Chunk> chunk;
+  vector<string> lines;
+  string text, featureString;
+  while (true) {
+    // The next sentence is the lowest index any input has left.
+    bool end = true;
+    int index = 0;
+    for (size_t i = 0; i < previous.size(); ++i) {
+      if (!previous[i]->Done() && (end || previous[i]->Next() < index)) {
+        index = previous[i]->Next();
+        end = false;
+      }
+    }
+    for (size_t i = 0; i < nbests.size(); ++i) {
+      if (!nbests[i]->Done() && (end || nbests[i]->Next() < index)) {
+        index = nbests[i]->Next();
+        end = false;
+      }
+    }
+
+    if (!end) {
+      if (!chunk) {
+        chunk.reset(new Chunk(m_scorer, m_allowDuplicates, bin, lockScorer));
+      }
+      if (featureNames.empty()) {
+        for (size_t i = 0; i < nbests.size() && featureNames.empty(); ++i) {
+          if (!nbests[i]->Done() && nbests[i]->Next() == index) {
+            lines.clear();
+            nbests[i]->ReadSentence(lines);
+            Data::ParseNBestLine(lines[0], false, &text, &featureString);
+            featureNames = Data::FeatureNames(featureString);
+            vector<string> names;
+            Tokenize(featureNames.c_str(), ' ', &names);
+            numFeatures = names.size();
+          }
+        }
+      } else {
+        lines.clear();
+      }
+      Chunk::Sentence& sentence = chunk->Add(index, numFeatures, featureNames);
+      for (size_t i = 0; i < previous.size(); ++i) {
+        if (!previous[i]->Done() && previous[i]->Next() == index) {
+          previous[i]->ReadSentence(sentence.features, sentence.scores);
+        }
+      }
+      // lines may already hold this sentence from the first n-best file
+      sentence.lines.swap(lines);
+      for (size_t i = 0; i < nbests.size(); ++i) {
+        if (!nbests[i]->Done() && nbests[i]->Next() == index) {
+          nbests[i]->ReadSentence(sentence.lines);
+        }
+      }
+      for (size_t i = 0; i < sentence.lines.size(); ++i) {
+        Data::ParseNBestLine(sentence.lines[i], withAlignment, &text, &featureString);
+        FeatureStats featureEntry;
+        Data::ParseFeatures(featureString, featureEntry);
+        sentence.features.add(featureEntry);
+      }
+    }
+
+    if (chunk && (end || chunk->Size() == chunkSize)) {
+      chunks.Submit(chunk);
+      chunk.reset();
+    }
+
+    if (end) {
+      break;
+    }
+  }
+
+  chunks.Finish();
+#ifdef WITH_THREADS
+  if (pool) {
+    pool->Stop(true);
+  }
+#endif
+}
+
+}
@@ -0,0 +1,57 @@
+/*
+ *  StreamingExtractor.h
+ *  mert - Minimum Error Rate Training
+ *
+ *  Extracts feature and score data one sentence at a time.
+ */
+
+#ifndef MERT_STREAMING_EXTRACTOR_H_
+#define MERT_STREAMING_EXTRACTOR_H_
+
+#include <string>
+#include <vector>
+
+namespace MosesTuning
+{
+
+class Scorer;
+
+/**
+ * Extracts features and score statistics without holding the whole n-best
+ * set in memory, unlike Data. Each n-best file, and each pair of previous
+ * feature and score files, must list its sentences in increasing order.
+ *
+ * Consecutive sentences are grouped into chunks, which are scored and
+ * deduplicated on a thread pool, then written in input order as one feature
+ * block and one score block per sentence.
+ */
+class StreamingExtractor
+{
+public:
+  /**
+   * \param scorer with its references already loaded
+   * \param threads size of the thread pool, 1 to work on the calling thread
+   * \param allowDuplicates keep candidates that repeat an earlier one
+   */
+  StreamingExtractor(Scorer* scorer, std::size_t threads, bool allowDuplicates);
+
+  void Extract(const std::vector<std::string>& nbestFiles,
+               const std::vector<std::string>& prevFeatureFiles,
+               const std::vector<std::string>& prevScoreFiles,
+               const std::string& featureFile,
+               const std::string& scoreFile,
+               bool bin);
+
+private:
+  class Chunk;
+  class NBestReader;
+  class PreviousReader;
+
+  Scorer* m_scorer;
+  std::size_t m_threads;
+  bool m_allowDuplicates;
+};
+
+}
+
+#endif  // MERT_STREAMING_EXTRACTOR_H_
@@ -43,28 +43,11 @@ namespace TERCPPNS_HashMapSpace
  */
 int hashMapInfos::trouve ( long searchKey )
 {
-  long foundKey;
-//       vector<infosHasher>::const_iterator l_hasher=m_hasher.begin();
-  for ( vector<infosHasher>:: iterator l_hasher=m_hasher.begin() ; l_hasher!=m_hasher.end() ; l_hasher++ ) {
-    foundKey= ( *l_hasher ).getHashKey();
-    if ( searchKey == foundKey ) {
-      return 1;
-    }
-  }
-  return 0;
+  return m_index.find ( searchKey ) != m_index.end() ? 1 : 0;
 }
 int hashMapInfos::trouve ( string key )
 {
-  long searchKey=hashValue ( key );
-  long foundKey;;
-//       vector<infosHasher>::const_iterator l_hasher=m_hasher.begin();
-  for ( vector<infosHasher>:: iterator l_hasher=m_hasher.begin() ; l_hasher!=m_hasher.end() ; l_hasher++ ) {
-    foundKey= ( *l_hasher ).getHashKey();
-    if ( searchKey == foundKey ) {
-      return 1;
-    }
-  }
-  return 0;
+  return trouve ( hashValue ( key ) );
 }
 
 /**
@@ -74,8 +57,8 @@ int hashMapInfos::trouve ( string key )
  */
 long hashMapInfos::hashValue ( string key )
 {
-  locale loc;                 // the "C" locale
-  const collate<char>& coll = use_facet<collate<char> >(loc);
+  static const locale loc;                 // the "C" locale
+  static const collate<char>& coll = use_facet<collate<char> >(loc);
   return coll.hash(key.data(),key.data()+key.length());
 // 	boost::hash<string> hasher;
 //         return hasher ( key );
@@ -87,12 +70,10 @@ long hashMapInfos::hashValue ( string key )
  */
 void hashMapInfos::addHasher ( string key, vector<int>  value )
 {
-  if ( trouve ( hashValue ( key ) ) ==0 ) {
-//         cerr << "ICI1" <<endl;
-    infosHasher H ( hashValue ( key ),key,value );
-//         cerr <<" "<< hashValue ( key )<<" "<< key<<" "<<value <<endl;
-//         cerr << "ICI2" <<endl;
-
+  long searchKey=hashValue ( key );
+  if ( trouve ( searchKey ) ==0 ) {
+    infosHasher H ( searchKey,key,value );
+    m_index[searchKey] = m_hasher.size();
     m_hasher.push_back ( H );
   }
 }
@@ -102,14 +83,9 @@ void hashMapInfos::addValue ( string key, vector<int>  value )
 }
 infosHasher hashMapInfos::getHasher ( string key )
 {
-  long searchKey=hashValue ( key );
-  long foundKey;
-//       vector<infosHasher>::const_iterator l_hasher=m_hasher.begin();
-  for ( vector<infosHasher>:: iterator l_hasher=m_hasher.begin() ; l_hasher!=m_hasher.end() ; l_hasher++ ) {
-    foundKey= ( *l_hasher ).getHashKey();
-    if ( searchKey == foundKey ) {
-      return ( *l_hasher );
-    }
+  boost::unordered_map<long, size_t>::const_iterator found = m_index.find ( hashValue ( key ) );
+  if ( found != m_index.end() ) {
+    return m_hasher[found->second];
   }
   vector<int> temp;
   infosHasher defaut(0,"",temp);
@@ -117,18 +93,11 @@ infosHasher hashMapInfos::getHasher ( string key )
 }
 vector<int> hashMapInfos::getValue ( string key )
 {
-  long searchKey=hashValue ( key );
-  long foundKey;
-  vector<int> retour;
-//       vector<infosHasher>::const_iterator l_hasher=m_hasher.begin();
-  for ( vector<infosHasher>:: iterator l_hasher=m_hasher.begin() ; l_hasher!=m_hasher.end() ; l_hasher++ ) {
-    foundKey= ( *l_hasher ).getHashKey();
-    if ( searchKey == foundKey ) {
-//         cerr <<"value found : " << key<<"|"<< ( *l_hasher ).getValue()<<endl;
-      return ( *l_hasher ).getValue();
-    }
+  boost::unordered_map<long, size_t>::const_iterator found = m_index.find ( hashValue ( key ) );
+  if ( found != m_index.end() ) {
+    return m_hasher[found->second].getValue();
   }
-  return retour;
+  return vector<int>();
 }
 //     string hashMapInfos::searchValue ( string value )
 //     {
@@ -151,15 +120,9 @@ vector<int> hashMapInfos::getValue ( string key )
 
 void hashMapInfos::setValue ( string key , vector<int>  value )
 {
-  long searchKey=hashValue ( key );
-  long foundKey;
-//       vector<infosHasher>::const_iterator l_hasher=m_hasher.begin();
-  for ( vector<infosHasher>:: iterator l_hasher=m_hasher.begin() ; l_hasher!=m_hasher.end() ; l_hasher++ ) {
-    foundKey= ( *l_hasher ).getHashKey();
-    if ( searchKey == foundKey ) {
-      ( *l_hasher ).setValue ( value );
-//           return ( *l_hasher ).getValue();
-    }
+  boost::unordered_map<long, size_t>::const_iterator found = m_index.find ( hashValue ( key ) );
+  if ( found != m_index.end() ) {
+    m_hasher[found->second].setValue ( value );
   }
 }
 string hashMapInfos::toString ()
@@ -24,6 +24,7 @@ Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #ifndef __HASHMAPINFOS_H__
 #define __HASHMAPINFOS_H__
 #include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
 #include "infosHasher.h"
 #include <vector>
 #include <string>
@@ -38,6 +39,8 @@ class hashMapInfos
 {
 private:
   vector<infosHasher> m_hasher;
+  // Position of each hash key in m_hasher, so lookups do not scan it
+  boost::unordered_map<long, size_t> m_index;
 
 public:
 //     ~hashMap();
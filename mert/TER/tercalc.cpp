@@ -51,6 +51,7 @@ terCalc::terCalc()
   TAILLE_BEAM = 10;
   DIST_MAX_PERMUT = 25;
   PRINT_DEBUG = false;
+  PRUNE_SHIFTS = true;
   hypSpans.clear();
   refSpans.clear();
   CALL_TER_ALIGN=0;
@@ -165,10 +166,13 @@ terAlignment terCalc::minimizeDistanceEdition ( vector< string >& hyp, vector< s
   hyp_size=( int ) hyp.size();
   double cost, icost, dcost;
   double score;
-  delete(S);
-  delete(P);
-  S = new vector < vector < double > >(ref_size+1, std::vector<double>(hyp_size+1,-1.0));
-  P = new vector < vector < char > >(ref_size+1, std::vector<char>(hyp_size+1,'0'));
+  // Reuse the rows of the previous call, this runs for every candidate shift
+  S->resize(ref_size+1);
+  P->resize(ref_size+1);
+  for ( i = 0; i <= ref_size; i++ ) {
+    S->at(i).assign(hyp_size+1,-1.0);
+    P->at(i).assign(hyp_size+1,'0');
+  }
 
 
 
@@ -329,10 +333,13 @@ void terCalc::minimizeDistanceEdition ( vector< string >& hyp, vector< string >&
   hyp_size=( int ) hyp.size();
   double cost, icost, dcost;
   double score;
-  delete(S);
-  delete(P);
-  S = new vector < vector < double > >(ref_size+1, std::vector<double>(hyp_size+1,-1.0));
-  P = new vector < vector < char > >(ref_size+1, std::vector<char>(hyp_size+1,'0'));
+  // Reuse the rows of the previous call, this runs for every candidate shift
+  S->resize(ref_size+1);
+  P->resize(ref_size+1);
+  for ( i = 0; i <= ref_size; i++ ) {
+    S->at(i).assign(hyp_size+1,-1.0);
+    P->at(i).assign(hyp_size+1,'0');
+  }
 
   NBR_BS_APPELS++;
 // 	cerr << "Appels : " << NBR_BS_APPELS << endl;
@@ -477,6 +484,14 @@ void terCalc::minimizeDistanceEdition ( vector< string >& hyp, vector< string >&
 
 terAlignment terCalc::TER ( vector<string>& hyp, vector<string>& ref )
 {
+  if ( PRUNE_SHIFTS ) {
+    refWordIds.clear();
+    vector<int> refIds ( ref.size() );
+    for ( int i = 0; i < ( int ) ref.size(); i++ ) {
+      refIds[i] = refWordIds.insert ( make_pair ( ref[i], ( int ) refWordIds.size() ) ).first->second;
+    }
+    refMatcher = MosesTuning::LevenshteinMatcher ( refIds );
+  }
   hashMapInfos rloc = createConcordMots ( hyp, ref );
   terAlignment cur_align = minimizeDistanceEdition ( hyp, ref, hypSpans );
   vector<string> cur = hyp;
@@ -546,6 +561,11 @@ bestShiftStruct * terCalc::findBestShift ( vector<string>& cur, vector<string>&
   terShift * curshift = new terShift();
   alignmentStruct shiftReturns;
   terAlignment * curalign = new terAlignment() ;
+  vector<int> curIds;
+  vector<int> shiftIds;
+  if ( PRUNE_SHIFTS ) {
+    encoder ( cur, curIds );
+  }
 
 
   if ( PRINT_DEBUG ) {
@@ -596,6 +616,15 @@ bestShiftStruct * terCalc::findBestShift ( vector<string>& cur, vector<string>&
           break;
         } else {
           curshift->set(( poss_shifts->at ( i ) ).at ( s ));
+          if ( PRUNE_SHIFTS ) {
+            /* minimizeDistanceEdition never finds fewer edits than the exact
+            distance, so the gain computed below can be no larger than this */
+            permuterIds ( curIds, curshift->start, curshift->end, curshift->newloc, shiftIds );
+            double maxgain = ( cur_best_align->numEdits + cur_best_shift_cost ) - ( ( double ) refMatcher.Distance ( shiftIds ) + curshift->cost );
+            if ( ( maxgain < 0 ) || ( ( cur_best_shift_cost != 0 ) && ( maxgain == 0 ) ) ) {
+              continue;
+            }
+          }
           if ( PRINT_DEBUG ) {
             cerr << "BEGIN DEBUG : terCalc::findBestShift :" << endl;
             cerr << "cur : "<< join(" ",cur) << endl;
@@ -1033,9 +1062,85 @@ alignmentStruct terCalc::permuter ( vector< string >& words, int start, int end,
   to_return.aftershift = spans;
   return to_return;
 }
+void terCalc::encoder ( vector< string >& words, vector< int >& ids )
+{
+  ids.resize ( words.size() );
+  for ( int i = 0; i < ( int ) words.size(); i++ ) {
+    boost::unordered_map<string, int>::const_iterator it = refWordIds.find ( words[i] );
+    // Words missing from the reference match nothing, they can share an id.
+    ids[i] = ( it == refWordIds.end() ) ? -1 : it->second;
+  }
+}
+
+// Same reordering as permuter, on word ids and without spans.
+void terCalc::permuterIds ( vector< int >& words, int start, int end, int newloc, vector< int >& nwords )
+{
+  int c = 0;
+  nwords = words;
+  if (newloc >=  ( int ) words.size()) {
+    newloc =  ( int ) words.size()-1;
+  }
+  if ( newloc == -1 ) {
+    for ( int i = start; i <= end; i++ ) {
+      nwords[c++] = words[i];
+    }
+    for ( int i = 0; i <= start - 1; i++ ) {
+      nwords[c++] = words[i];
+    }
+    for ( int i = end + 1; i < ( int ) words.size(); i++ ) {
+      nwords[c++] = words[i];
+    }
+  } else if ( newloc < start ) {
+    for ( int i = 0; i < newloc; i++ ) {
+      nwords[c++] = words[i];
+    }
+    for ( int i = start; i <= end; i++ ) {
+      nwords[c++] = words[i];
+    }
+    for ( int i = newloc ; i < start ; i++ ) {
+      nwords[c++] = words[i];
+    }
+    for ( int i = end + 1; i < ( int ) words.size(); i++ ) {
+      nwords[c++] = words[i];
+    }
+  } else if ( newloc > end ) {
+    for ( int i = 0; i <= start - 1; i++ ) {
+      nwords[c++] = words[i];
+    }
+    for ( int i = end + 1; i <= newloc; i++ ) {
+      nwords[c++] = words[i];
+    }
+    for ( int i = start; i <= end; i++ ) {
+      nwords[c++] = words[i];
+    }
+    for ( int i = newloc + 1; i < ( int ) words.size(); i++ ) {
+      nwords[c++] = words[i];
+    }
+  } else {
+    // we are moving inside of ourselves
+    for ( int i = 0; i <= start - 1; i++ ) {
+      nwords[c++] = words[i];
+    }
+    for ( int i = end + 1; ( i < ( int ) words.size() ) && ( i <= ( end + ( newloc - start ) ) ); i++ ) {
+      nwords[c++] = words[i];
+    }
+    for ( int i = start; i <= end; i++ ) {
+      nwords[c++] = words[i];
+    }
+    for ( int i = ( end + ( newloc - start ) + 1 ); i < ( int ) words.size(); i++ ) {
+      nwords[c++] = words[i];
+    }
+  }
+}
+
 void terCalc::setDebugMode ( bool b )
 {
   PRINT_DEBUG = b;
 }
 
+void terCalc::setShiftPruning ( bool b )
+{
+  PRUNE_SHIFTS = b;
+}
+
 }
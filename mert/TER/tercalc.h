@@ -25,6 +25,8 @@ Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <cstdio>
 #include <cstring>
 #include <sstream>
+#include <boost/unordered_map.hpp>
+#include "../EditDistance.h"
 #include "hashMap.h"
 #include "hashMapInfos.h"
 #include "hashMapStringInfos.h"
@@ -72,6 +74,14 @@ private :
   vector<vecInt> hypSpans;
   int TAILLE_BEAM;
 
+  // Shift pruning: the ids of the reference words, and the reference as a
+  // bit-parallel pattern, set up by TER for each sentence pair.
+  bool PRUNE_SHIFTS;
+  boost::unordered_map<string, int> refWordIds;
+  MosesTuning::LevenshteinMatcher refMatcher;
+  void encoder ( vector<string>& words, vector<int>& ids );
+  void permuterIds ( vector<int>& words, int start, int end, int newloc, vector<int>& nwords );
+
 public:
   int shift_cost;
   int insert_cost;
@@ -84,6 +94,8 @@ public:
   ~terCalc();
 //             size_t* hashVec ( vector<string> s );
   void setDebugMode ( bool b );
+  // Skip the shifts whose exact edit distance already rules them out (default on)
+  void setShiftPruning ( bool b );
 //             int WERCalculation ( size_t * ref, size_t * hyp );
 //             int WERCalculation ( vector<string> ref, vector<string> hyp );
 //             int WERCalculation ( vector<int> ref, vector<int> hyp );
@@ -4,6 +4,7 @@
  * Developed during the 2nd MT marathon.
  **/
 
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -14,6 +15,7 @@
 #include "Data.h"
 #include "Scorer.h"
 #include "ScorerFactory.h"
+#include "StreamingExtractor.h"
 #include "Timer.h"
 #include "Util.h"
 
@@ -31,6 +33,9 @@ void usage()
   cerr << "\tThis is of the form NAME1:VAL1,NAME2:VAL2 etc " << endl;
   cerr << "[--reference|-r] comma separated list of reference files" << endl;
   cerr << "[--binary|-b] use binary output format (default to text )" << endl;
+  cerr << "\tBinary feature files are written in version 1 (FEATURES_BIN_BEGIN_1)," << endl;
+  cerr << "\twhich also stores the sparse features. Version 0 files from older" << endl;
+  cerr << "\textractors are no longer read: extract them again or use text files" << endl;
   cerr << "[--nbest|-n] the nbest file" << endl;
   cerr << "[--scfile|-S] the scorer data output file" << endl;
   cerr << "[--ffile|-F] the feature data output file" << endl;
@@ -39,6 +44,11 @@ void usage()
   cerr << "[--factors|-f] list of factors passed to the scorer (e.g. 0|2)" << endl;
   cerr << "[--filter|-l] filter command used to preprocess the sentences" << endl;
   cerr << "[--allow-duplicates|-d] omit the duplicate removal step" << endl;
+  cerr << "[--streaming|-m] score one sentence at a time instead of loading all data;" << endl;
+  cerr << "\tinputs must list their sentences in increasing order" << endl;
+#ifdef WITH_THREADS
+  cerr << "[--threads|-T] number of threads used with --streaming (default 1)" << endl;
+#endif
   cerr << "[-v] verbose level" << endl;
   cerr << "[--help|-h] print this message and exit" << endl;
   exit(1);
@@ -59,6 +69,10 @@ static struct option long_options[] = {
   {"verbose", required_argument, 0, 'v'},
   {"help", no_argument, 0, 'h'},
   {"allow-duplicates", no_argument, 0, 'd'},
+  {"streaming", no_argument, 0, 'm'},
+#ifdef WITH_THREADS
+  {"threads", required_argument, 0, 'T'},
+#endif
   {0, 0, 0, 0}
 };
 
@@ -76,6 +90,8 @@ struct ProgramOption {
   string prevFeatureDataFile;
   bool binmode;
   bool allowDuplicates;
+  bool streaming;
+  size_t threads;
   int verbosity;
 
   ProgramOption()
@@ -91,6 +107,8 @@ struct ProgramOption {
       prevFeatureDataFile(""),
       binmode(false),
       allowDuplicates(false),
+      streaming(false),
+      threads(1),
       verbosity(0) { }
 };
 
@@ -99,7 +117,7 @@ void ParseCommandOptions(int argc, char** argv, ProgramOption* opt)
   int c;
   int option_index;
 
-  while ((c = getopt_long(argc, argv, "s:r:f:l:n:S:F:R:E:v:hbd", long_options, &option_index)) != -1) {
+  while ((c = getopt_long(argc, argv, "s:r:f:l:n:S:F:R:E:v:T:hbdm", long_options, &option_index)) != -1) {
     switch (c) {
     case 's':
       opt->scorerType = string(optarg);
@@ -140,6 +158,14 @@ void ParseCommandOptions(int argc, char** argv, ProgramOption* opt)
     case 'd':
       opt->allowDuplicates = true;
       break;
+    case 'm':
+      opt->streaming = true;
+      break;
+#ifdef WITH_THREADS
+    case 'T':
+      opt->threads = std::max(1, atoi(optarg));
+      break;
+#endif
     default:
       usage();
     }
@@ -216,6 +242,14 @@ int main(int argc, char** argv)
 
 //    PrintUserTime("References loaded");
 
+    if (option.streaming) {
+      StreamingExtractor extractor(scorer.get(), option.threads, option.allowDuplicates);
+      extractor.Extract(nbestFiles, prevFeatureDataFiles, prevScoreDataFiles,
+                        option.featureDataFile, option.scoreDataFile, option.binmode);
+      PrintUserTime("Stopping...");
+      return EXIT_SUCCESS;
+    }
+
     Data data(scorer.get());
 
     // load old data
@@ -38,6 +38,7 @@ de recherches du Canada
 
 #include <boost/program_options.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include "util/exception.hh"
 #include "util/random.hh"
@@ -50,11 +51,157 @@ de recherches du Canada
 #include "Scorer.h"
 #include "ScorerFactory.h"
 
+#include "moses/ThreadPool.h"
+
 using namespace std;
 using namespace MosesTuning;
 
 namespace po = boost::program_options;
 
+namespace
+{
+
+struct MiraParams {
+  float c;
+  float decay;
+  bool model_bg;
+  bool verbose;
+};
+
+struct EpochCounts {
+  EpochCounts() : numExamples(0), numUpdates(0), totalLoss(0) {}
+  int numExamples;
+  int numUpdates;
+  ValType totalLoss;
+};
+
+/** The MIRA step for one hope/fear pair, also decays the background BLEU */
+void MiraUpdate(const HopeFearData& hfd, size_t sentenceIndex, const MiraParams& params,
+                MiraWeightVector* wv, vector<ValType>* bg, EpochCounts* counts)
+{
+  if (!hfd.hopeFearEqual && hfd.hopeBleu  > hfd.fearBleu) {
+    // Vector difference
+    MiraFeatureVector diff = hfd.hopeFeatures - hfd.fearFeatures;
+    // Bleu difference
+    //assert(hfd.hopeBleu + 1e-8 >= hfd.fearBleu);
+    ValType delta = hfd.hopeBleu - hfd.fearBleu;
+    // Loss and update
+    ValType diff_score = wv->score(diff);
+    ValType loss = delta - diff_score;
+    if(params.verbose) {
+      cerr << "Updating sent " << sentenceIndex << endl;
+      cerr << "Wght: " << *wv << endl;
+      cerr << "Hope: " << hfd.hopeFeatures << " BLEU:" << hfd.hopeBleu << " Score:" << wv->score(hfd.hopeFeatures) << endl;
+      cerr << "Fear: " << hfd.fearFeatures << " BLEU:" << hfd.fearBleu << " Score:" << wv->score(hfd.fearFeatures) << endl;
+      cerr << "Diff: " << diff << " BLEU:" << delta << " Score:" << diff_score << endl;
+      cerr << "Loss: " << loss <<  " Scale: " << 1 << endl;
+      cerr << endl;
+    }
+    if(loss > 0) {
+      ValType eta = min(params.c, loss / diff.sqrNorm());
+      wv->update(diff,eta);
+      counts->totalLoss+=loss;
+      counts->numUpdates++;
+    }
+    // Update BLEU statistics
+    for(size_t k=0; k<bg->size(); k++) {
+      (*bg)[k]*=params.decay;
+      if(params.model_bg)
+        (*bg)[k]+=hfd.modelStats[k];
+      else
+        (*bg)[k]+=hfd.hopeStats[k];
+    }
+  }
+  counts->numExamples++;
+}
+
+/**
+  * Runs MIRA over a contiguous slice of the epoch, with its own copy of the
+  * weights and background BLEU.
+  **/
+class MiraShardTask : public Moses::Task
+{
+public:
+  MiraShardTask(const NbestHopeFearDecoder& decoder, size_t begin, size_t end,
+                const MiraParams& params, const MiraWeightVector& wv, const vector<ValType>& bg)
+    : m_decoder(decoder), m_begin(begin), m_end(end), m_params(params), m_wv(wv), m_bg(bg) {}
+
+  virtual void Run() {
+    for (size_t i = m_begin; i < m_end; ++i) {
+      HopeFearData hfd;
+      m_decoder.HopeFearAt(i, m_bg, m_wv, &hfd);
+      MiraUpdate(hfd, i, m_params, &m_wv, &m_bg, &m_counts);
+    }
+  }
+
+  const MiraWeightVector& GetWeights() const {
+    return m_wv;
+  }
+  const vector<ValType>& GetBackground() const {
+    return m_bg;
+  }
+  const EpochCounts& GetCounts() const {
+    return m_counts;
+  }
+
+private:
+  const NbestHopeFearDecoder& m_decoder;
+  size_t m_begin;
+  size_t m_end;
+  const MiraParams& m_params;
+  MiraWeightVector m_wv;
+  vector<ValType> m_bg;
+  EpochCounts m_counts;
+};
+
+/**
+  * One epoch split over several threads. Each thread trains on its slice
+  * of the shuffled n-best lists, then the weights and background BLEU are
+  * averaged in slice order (iterative parameter mixing).
+  **/
+void ParallelEpoch(NbestHopeFearDecoder& decoder, size_t threads, const MiraParams& params,
+                   MiraWeightVector* wv, vector<ValType>* bg, EpochCounts* counts)
+{
+  decoder.reset(); // shuffles
+  const size_t numSentences = decoder.NumSentences();
+  const size_t shards = min(threads, max<size_t>(numSentences, 1));
+  vector<boost::shared_ptr<MiraShardTask> > tasks;
+  {
+#ifdef WITH_THREADS
+    Moses::ThreadPool pool(threads);
+#endif
+    for (size_t s = 0; s < shards; ++s) {
+      boost::shared_ptr<MiraShardTask> task(new MiraShardTask(
+          decoder, numSentences * s / shards, numSentences * (s + 1) / shards, params, *wv, *bg));
+      tasks.push_back(task);
+#ifdef WITH_THREADS
+      pool.Submit(task);
+#else
+      task->Run();
+#endif
+    }
+#ifdef WITH_THREADS
+    pool.Stop(true);
+#endif
+  }
+
+  vector<MiraWeightVector> weights;
+  vector<ValType> mixedBg(bg->size(), 0);
+  for (size_t s = 0; s < tasks.size(); ++s) {
+    weights.push_back(tasks[s]->GetWeights());
+    for (size_t k = 0; k < bg->size(); ++k) {
+      mixedBg[k] += tasks[s]->GetBackground()[k] / tasks.size();
+    }
+    counts->numExamples += tasks[s]->GetCounts().numExamples;
+    counts->numUpdates += tasks[s]->GetCounts().numUpdates;
+    counts->totalLoss += tasks[s]->GetCounts().totalLoss;
+  }
+  wv->mix(weights);
+  bg->swap(mixedBg);
+}
+
+}
+
 int main(int argc, char** argv)
 {
   bool help;
@@ -79,6 +226,7 @@ int main(int argc, char** argv)
   bool verbose = false; // Verbose updates
   bool safe_hope = false; // Model score cannot have more than BLEU_RATIO times more influence than BLEU
   size_t hgPruning = 50; //prune hypergraphs to have this many edges per reference word
+  size_t threads = 1; // Threads for the in-memory n-best version
 
   // Command-line processing follows pro.cpp
   po::options_description desc("Allowed options");
@@ -105,6 +253,9 @@ int main(int argc, char** argv)
   ("verbose", po::value(&verbose)->zero_tokens()->default_value(false), "Verbose updates")
   ("safe-hope", po::value(&safe_hope)->zero_tokens()->default_value(false), "Mode score's influence on hope decoding is limited")
   ("hg-prune", po::value<size_t>(&hgPruning), "Prune hypergraphs to have this many edges per reference word")
+#ifdef WITH_THREADS
+  ("threads,T", po::value<size_t>(&threads), "Split each epoch over this many threads and average their weights (n-best, not streaming)")
+#endif
   ;
 
   po::options_description cmdline_options;
@@ -121,6 +272,11 @@ int main(int argc, char** argv)
 
   cerr << "kbmira with c=" << c << " decay=" << decay << " no_shuffle=" << no_shuffle << endl;
 
+  if (threads > 1 && (type != "nbest" || streaming || streaming_out)) {
+    UTIL_THROW(util::Exception, "--threads needs in-memory n-best lists, without --streaming or --streaming-out");
+  }
+  if (threads == 0) threads = 1;
+
   if (vm.count("random-seed")) {
     cerr << "Initialising random seed to " << seed << endl;
     util::rand_init(seed);
@@ -152,62 +308,35 @@ int main(int argc, char** argv)
     UTIL_THROW(util::Exception, "Unknown batch mira type: '" << type << "'");
   }
 
+  MiraParams params;
+  params.c = c;
+  params.decay = decay;
+  params.model_bg = model_bg;
+  params.verbose = verbose;
+
   // Training loop
   if (!streaming_out)
     cerr << "Initial BLEU = " << decoder->Evaluate(wv->avg()) << endl;
   ValType bestBleu = 0;
   for(int j=0; j<n_iters; j++) {
     // MIRA train for one epoch
-    int iNumExamples = 0;
-    int iNumUpdates = 0;
-    ValType totalLoss = 0.0;
-    size_t sentenceIndex = 0;
-    for(decoder->reset(); !decoder->finished(); decoder->next()) {
-      HopeFearData hfd;
-      decoder->HopeFear(bg,*wv,&hfd);
-
-      // Update weights
-      if (!hfd.hopeFearEqual && hfd.hopeBleu  > hfd.fearBleu) {
-        // Vector difference
-        MiraFeatureVector diff = hfd.hopeFeatures - hfd.fearFeatures;
-        // Bleu difference
-        //assert(hfd.hopeBleu + 1e-8 >= hfd.fearBleu);
-        ValType delta = hfd.hopeBleu - hfd.fearBleu;
-        // Loss and update
-        ValType diff_score = wv->score(diff);
-        ValType loss = delta - diff_score;
-        if(verbose) {
-          cerr << "Updating sent " << sentenceIndex << endl;
-          cerr << "Wght: " << *wv << endl;
-          cerr << "Hope: " << hfd.hopeFeatures << " BLEU:" << hfd.hopeBleu << " Score:" << wv->score(hfd.hopeFeatures) << endl;
-          cerr << "Fear: " << hfd.fearFeatures << " BLEU:" << hfd.fearBleu << " Score:" << wv->score(hfd.fearFeatures) << endl;
-          cerr << "Diff: " << diff << " BLEU:" << delta << " Score:" << diff_score << endl;
-          cerr << "Loss: " << loss <<  " Scale: " << 1 << endl;
-          cerr << endl;
-        }
-        if(loss > 0) {
-          ValType eta = min(c, loss / diff.sqrNorm());
-          wv->update(diff,eta);
-          totalLoss+=loss;
-          iNumUpdates++;
-        }
-        // Update BLEU statistics
-        for(size_t k=0; k<bg.size(); k++) {
-          bg[k]*=decay;
-          if(model_bg)
-            bg[k]+=hfd.modelStats[k];
-          else
-            bg[k]+=hfd.hopeStats[k];
-        }
+    EpochCounts counts;
+    if (threads > 1) {
+      ParallelEpoch(dynamic_cast<NbestHopeFearDecoder&>(*decoder), threads, params, wv.get(), &bg, &counts);
+    } else {
+      size_t sentenceIndex = 0;
+      for(decoder->reset(); !decoder->finished(); decoder->next()) {
+        HopeFearData hfd;
+        decoder->HopeFear(bg,*wv,&hfd);
+        MiraUpdate(hfd, sentenceIndex, params, wv.get(), &bg, &counts);
+        ++sentenceIndex;
+        if (streaming_out)
+          cout << *wv << endl;
       }
-      iNumExamples++;
-      ++sentenceIndex;
-      if (streaming_out)
-        cout << *wv << endl;
     }
     // Training Epoch summary
-    cerr << iNumUpdates << "/" << iNumExamples << " updates"
-         << ", avg loss = " << (totalLoss / iNumExamples);
+    cerr << counts.numUpdates << "/" << counts.numExamples << " updates"
+         << ", avg loss = " << (counts.totalLoss / counts.numExamples);
 
 
     // Evaluate current average weights
@@ -2,6 +2,7 @@
  * \description This is the main for the new version of the mert algorithm developed during the 2nd MT marathon
 */
 
+#include <algorithm>
 #include <limits>
 #include <unistd.h>
 #include <cstdlib>
@@ -117,7 +118,7 @@ void usage(int ret)
   cerr<<"[--ifile|-i] the starting point data file (default init.opt)"<<endl;
   cerr<<"[--sparse-weights|-p] required for merging sparse features"<<endl;
 #ifdef WITH_THREADS
-  cerr<<"[--threads|-T] use multiple threads (default 1)"<<endl;
+  cerr<<"[--threads|-T] use multiple threads, for restarts and then within line searches (default 1)"<<endl;
 #endif
   cerr<<"[--shard-count] Split data into shards, optimize for each shard and average"<<endl;
   cerr<<"[--shard-size] Shard size as proportion of data. If 0, use non-overlapping shards"<<endl;
@@ -471,6 +472,10 @@ int main(int argc, char **argv)
     Optimizer *optimizer = OptimizerFactory::BuildOptimizer(option.pdim, to_optimize, positive, start_list[0], option.optimize_type, option.nrandom);
     optimizer->SetScorer(data_ref.getScorer());
     optimizer->SetFeatureData(data_ref.getFeatureData());
+#ifdef WITH_THREADS
+    // Threads left over by the restarts go to the line searches.
+    optimizer->SetThreads(std::max<size_t>(1, option.num_threads / (allTasks.size() * startingPoints.size())));
+#endif
     // A task for each start point
     for (size_t j = 0; j < startingPoints.size(); ++j) {
       boost::shared_ptr<OptimizationTask>
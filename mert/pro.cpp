@@ -32,11 +32,15 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include <cstdlib>
 #include <ctime>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <utility>
 
+#include <boost/bind.hpp>
 #include <boost/program_options.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include "BleuScorer.h"
 #include "FeatureDataIterator.h"
@@ -45,6 +49,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "Util.h"
 #include "util/random.hh"
 
+#include "moses/ThreadPool.h"
+
 using namespace std;
 using namespace MosesTuning;
 
@@ -102,6 +108,118 @@ static void outputSample(ostream& out, const FeatureDataItem& f1, const FeatureD
   }
 }
 
+/**
+  * Samples the training pairs of one sentence and renders them as text. The
+  * random draws are made by the caller, in sentence order, so the output
+  * does not depend on the number of threads.
+  **/
+class SentenceSampler : public Moses::WaitableTask
+{
+public:
+  SentenceSampler(unsigned int n_samples, float min_diff, float bleuSmoothing, bool smoothBP)
+    : m_n_samples(n_samples), m_min_diff(min_diff),
+      m_bleuSmoothing(bleuSmoothing), m_smoothBP(smoothBP) {}
+
+  /** The n-best list of one feature/score file pair */
+  void AddList(const vector<FeatureDataItem>& features, const vector<ScoreDataItem>& scores) {
+    m_features.push_back(features);
+    m_scores.push_back(scores);
+    for (size_t j = 0; j < features.size(); ++j) {
+      m_hypotheses.push_back(pair<size_t,size_t>(m_features.size() - 1, j));
+    }
+  }
+
+  std::size_t NumHypotheses() const {
+    return m_hypotheses.size();
+  }
+
+  void AddCandidate(size_t rand1, size_t rand2) {
+    m_candidates.push_back(pair<size_t,size_t>(rand1, rand2));
+  }
+
+  const string& GetOutput() const {
+    return m_output;
+  }
+
+protected:
+  virtual void DoRun();
+
+private:
+  const FeatureDataItem& featuresOf(const pair<size_t,size_t>& translation) const {
+    return m_features[translation.first][translation.second];
+  }
+  float bleuOf(const pair<size_t,size_t>& translation) const {
+    return smoothedSentenceBleu(m_scores[translation.first][translation.second], m_bleuSmoothing, m_smoothBP);
+  }
+
+  unsigned int m_n_samples;
+  float m_min_diff;
+  float m_bleuSmoothing;
+  bool m_smoothBP;
+
+  vector<vector<FeatureDataItem> > m_features;
+  vector<vector<ScoreDataItem> > m_scores;
+  vector<pair<size_t,size_t> > m_hypotheses;
+  vector<pair<size_t,size_t> > m_candidates;
+  string m_output;
+};
+
+void SentenceSampler::DoRun()
+{
+  //collect the candidates
+  vector<SampledPair> samples;
+  vector<float> scores;
+  for(size_t  i=0; i<m_candidates.size(); i++) {
+    pair<size_t,size_t> translation1 = m_hypotheses[m_candidates[i].first];
+    float bleu1 = bleuOf(translation1);
+
+    pair<size_t,size_t> translation2 = m_hypotheses[m_candidates[i].second];
+    float bleu2 = bleuOf(translation2);
+
+    /*
+    cerr << "t(" << translation1.first << "," << translation1.second << ") = " << bleu1 <<
+      " t(" << translation2.first << "," << translation2.second << ") = " <<
+        bleu2  << " diff = " << abs(bleu1-bleu2) << endl;
+    */
+    if (abs(bleu1-bleu2) < m_min_diff)
+      continue;
+
+    samples.push_back(SampledPair(translation1, translation2, bleu1-bleu2));
+    scores.push_back(1.0-abs(bleu1-bleu2));
+  }
+
+  float sample_threshold = -1.0;
+  if (samples.size() > m_n_samples) {
+    NTH_ELEMENT3(scores.begin(), scores.begin() + (m_n_samples-1), scores.end());
+    sample_threshold = 0.99999-scores[m_n_samples-1];
+  }
+
+  ostringstream out;
+  size_t collected = 0;
+  for (size_t i = 0; collected < m_n_samples && i < samples.size(); ++i) {
+    if (samples[i].getDiff() < sample_threshold) continue;
+    ++collected;
+    out << "1";
+    outputSample(out, featuresOf(samples[i].getTranslation1()),
+                 featuresOf(samples[i].getTranslation2()));
+    out << endl;
+    out << "0";
+    outputSample(out, featuresOf(samples[i].getTranslation2()),
+                 featuresOf(samples[i].getTranslation1()));
+    out << endl;
+  }
+  m_output = out.str();
+
+  // The input is no longer needed once the pairs are written.
+  vector<vector<FeatureDataItem> >().swap(m_features);
+  vector<vector<ScoreDataItem> >().swap(m_scores);
+}
+
+void WriteOutput(ostream* out, SentenceSampler& sampler)
+{
+  *out << sampler.GetOutput();
+}
+
 }
 
 int main(int argc, char** argv)
@@ -117,6 +235,7 @@ int main(int argc, char** argv)
   const float min_diff = 0.05;
   bool smoothBP = false;
   const float bleuSmoothing = 1.0f;
+  size_t threads = 1;
 
   po::options_description desc("Allowed options");
   desc.add_options()
@@ -126,6 +245,9 @@ int main(int argc, char** argv)
   ("random-seed,r", po::value<int>(&seed), "Seed for random number generation")
   ("output-file,o", po::value<string>(&outputFile), "Output file")
   ("smooth-brevity-penalty,b", po::value(&smoothBP)->zero_tokens()->default_value(false), "Smooth the brevity penalty, as in Nakov et al. (Coling 2012)")
+#ifdef WITH_THREADS
+  ("threads,T", po::value<size_t>(&threads), "Sample sentences on this many threads (same output for any number)")
+#endif
   ;
 
   po::options_description cmdline_options;
@@ -180,15 +302,29 @@ int main(int argc, char** argv)
     scoreDataIters.push_back(ScoreDataIterator(scoreFiles[i]));
   }
 
+#ifdef WITH_THREADS
+  boost::scoped_ptr<Moses::ThreadPool> pool;
+  if (threads > 1) {
+    pool.reset(new Moses::ThreadPool(threads));
+  }
+  Moses::ThreadPool* samplerPool = pool.get();
+#else
+  Moses::ThreadPool* samplerPool = NULL;
+#endif
+  // Limit the number of sentences held in memory.
+  Moses::OrderedPipeline<SentenceSampler> samplers(
+    samplerPool, 2 * threads, boost::bind(&WriteOutput, out, _1));
+
   //loop through nbest lists
   size_t sentenceId = 0;
   while(1) {
-    vector<pair<size_t,size_t> > hypotheses;
     //TODO: de-deuping. Collect hashes of score,feature pairs and
     //only add index if it's unique.
     if (featureDataIters[0] == FeatureDataIterator::end()) {
       break;
     }
+    boost::shared_ptr<SentenceSampler> sampler(
+      new SentenceSampler(n_samples, min_diff, bleuSmoothing, smoothBP));
     for (size_t i = 0; i < featureFiles.size(); ++i) {
       if (featureDataIters[i] == FeatureDataIterator::end()) {
         cerr << "Error: Feature file " << i << " ended prematurely" << endl;
@@ -202,59 +338,19 @@ int main(int argc, char** argv)
         cerr << "Error: For sentence " << sentenceId << " features and scores have different size" << endl;
         exit(1);
       }
-      for (size_t j = 0; j < featureDataIters[i]->size(); ++j) {
-        hypotheses.push_back(pair<size_t,size_t>(i,j));
-      }
+      sampler->AddList(*featureDataIters[i], *scoreDataIters[i]);
     }
 
-    //collect the candidates
-    vector<SampledPair> samples;
-    vector<float> scores;
-    size_t n_translations = hypotheses.size();
+    // Drawn here, in sentence order, to keep the random sequence
+    size_t n_translations = sampler->NumHypotheses();
     for(size_t  i=0; i<n_candidates; i++) {
       size_t rand1 = util::rand_excl(n_translations);
-      pair<size_t,size_t> translation1 = hypotheses[rand1];
-      float bleu1 = smoothedSentenceBleu(scoreDataIters[translation1.first]->operator[](translation1.second), bleuSmoothing, smoothBP);
-
       size_t rand2 = util::rand_excl(n_translations);
-      pair<size_t,size_t> translation2 = hypotheses[rand2];
-      float bleu2 = smoothedSentenceBleu(scoreDataIters[translation2.first]->operator[](translation2.second), bleuSmoothing, smoothBP);
-
-      /*
-      cerr << "t(" << translation1.first << "," << translation1.second << ") = " << bleu1 <<
-        " t(" << translation2.first << "," << translation2.second << ") = " <<
-          bleu2  << " diff = " << abs(bleu1-bleu2) << endl;
-      */
-      if (abs(bleu1-bleu2) < min_diff)
-        continue;
-
-      samples.push_back(SampledPair(translation1, translation2, bleu1-bleu2));
-      scores.push_back(1.0-abs(bleu1-bleu2));
+      sampler->AddCandidate(rand1, rand2);
     }
 
-    float sample_threshold = -1.0;
-    if (samples.size() > n_samples) {
-      NTH_ELEMENT3(scores.begin(), scores.begin() + (n_samples-1), scores.end());
-      sample_threshold = 0.99999-scores[n_samples-1];
-    }
+    samplers.Submit(sampler);
 
-    size_t collected = 0;
-    for (size_t i = 0; collected < n_samples && i < samples.size(); ++i) {
-      if (samples[i].getDiff() < sample_threshold) continue;
-      ++collected;
-      size_t file_id1 = samples[i].getTranslation1().first;
-      size_t hypo_id1 = samples[i].getTranslation1().second;
-      size_t file_id2 = samples[i].getTranslation2().first;
-      size_t hypo_id2 = samples[i].getTranslation2().second;
-      *out << "1";
-      outputSample(*out, featureDataIters[file_id1]->operator[](hypo_id1),
-                   featureDataIters[file_id2]->operator[](hypo_id2));
-      *out << endl;
-      *out << "0";
-      outputSample(*out, featureDataIters[file_id2]->operator[](hypo_id2),
-                   featureDataIters[file_id1]->operator[](hypo_id1));
-      *out << endl;
-    }
     //advance all iterators
     for (size_t i = 0; i < featureFiles.size(); ++i) {
       ++featureDataIters[i];
@@ -263,6 +359,13 @@ int main(int argc, char** argv)
     ++sentenceId;
   }
 
+  samplers.Finish();
+#ifdef WITH_THREADS
+  if (pool) {
+    pool->Stop(true);
+  }
+#endif
+
   outFile.close();
 
 }
@@ -0,0 +1,194 @@
+/**
+ * Times the edit distance kernels of the TER, CDER and WER scorers on an
+ * n-best list, against the implementations they replaced, and checks that
+ * both give the same number of edits for every candidate. For TER the
+ * comparison is with shift pruning turned off.
+ **/
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Data.h"
+#include "EditDistance.h"
+#include "Timer.h"
+#include "TER/tercalc.h"
+
+#include "util/tokenize_piece.hh"
+
+using namespace std;
+using namespace MosesTuning;
+using namespace TERCPPNS_TERCpp;
+
+namespace
+{
+
+typedef vector<int> sent_t;
+
+struct Candidate {
+  size_t sid;
+  sent_t words;
+};
+
+class Encoder
+{
+public:
+  void Encode(const StringPiece& line, sent_t& encoded) {
+    encoded.clear();
+    for (util::TokenIter<util::AnyCharacter, true> it(line, util::AnyCharacter(" \t")); it; ++it) {
+      map<string, int>::iterator found = m_ids.insert(make_pair(it->as_string(), static_cast<int>(m_ids.size()))).first;
+      encoded.push_back(found->second);
+    }
+  }
+
+private:
+  map<string, int> m_ids;
+};
+
+// CderScorer::computeCD before the integer kernels.
+int OriginalCD(const sent_t& cand, const sent_t& ref, bool allowLongJumps)
+{
+  int I = cand.size() + 1;
+  int L = ref.size() + 1;
+  int l = 0;
+  vector<int>* row = new vector<int>(I);
+  for (int i = 0; i < I; ++i) (*row)[i] = i;
+  if (allowLongJumps) {
+    for (int i = 1; i < I; ++i) (*row)[i] = 1;
+  }
+  while (++l < L) {
+    vector<int>* nextRow = new vector<int>(I);
+    for (int i = 0; i < I; ++i) {
+      vector<int> possibleCosts;
+      if (i > 0) {
+        possibleCosts.push_back((*nextRow)[i-1] + 1);
+        possibleCosts.push_back((*row)[i-1] + (ref[l-1] == cand[i-1] ? 0 : 1));
+      }
+      possibleCosts.push_back((*row)[i] + 1);
+      (*nextRow)[i] = *min_element(possibleCosts.begin(), possibleCosts.end());
+    }
+    if (allowLongJumps) {
+      int LJ = 1 + *min_element(nextRow->begin(), nextRow->end());
+      for (int i = 0; i < I; ++i) {
+        (*nextRow)[i] = min((*nextRow)[i], LJ);
+      }
+    }
+    delete row;
+    row = nextRow;
+  }
+  int distance = *(row->rbegin());
+  delete row;
+  return distance;
+}
+
+double Ter(const sent_t& cand, const sent_t& ref, bool pruneShifts)
+{
+  // As in TerScorer::prepareStats
+  sent_t hyp(ref), reference(cand);
+  terCalc evaluation;
+  evaluation.setDebugMode(false);
+  evaluation.setShiftPruning(pruneShifts);
+  return evaluation.TER(hyp, reference).numEdits;
+}
+
+void usage()
+{
+  cerr << "usage: scorer-benchmark TER|CDER|WER reference nbest" << endl;
+  exit(1);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  if (argc != 4) usage();
+  const string type(argv[1]);
+  if (type != "TER" && type != "CDER" && type != "WER") usage();
+
+  Encoder encoder;
+  vector<sent_t> refs;
+  ifstream refIn(argv[2]);
+  if (!refIn) {
+    cerr << "Unable to open " << argv[2] << endl;
+    return EXIT_FAILURE;
+  }
+  string line;
+  while (getline(refIn, line)) {
+    refs.push_back(sent_t());
+    encoder.Encode(line, refs.back());
+  }
+
+  vector<Candidate> candidates;
+  ifstream nbestIn(argv[3]);
+  if (!nbestIn) {
+    cerr << "Unable to open " << argv[3] << endl;
+    return EXIT_FAILURE;
+  }
+  string text, features;
+  while (getline(nbestIn, line)) {
+    if (line.empty()) continue;
+    Candidate candidate;
+    candidate.sid = Data::ParseNBestLine(line, false, &text, &features);
+    if (candidate.sid >= refs.size()) {
+      cerr << "Sentence " << candidate.sid << " has no reference" << endl;
+      return EXIT_FAILURE;
+    }
+    encoder.Encode(text, candidate.words);
+    candidates.push_back(candidate);
+  }
+  cerr << "Scoring " << candidates.size() << " candidates with " << type << endl;
+
+  vector<double> original(candidates.size()), current(candidates.size());
+  Timer timer;
+  timer.start();
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    const sent_t& ref = refs[candidates[i].sid];
+    if (type == "TER") {
+      original[i] = Ter(candidates[i].words, ref, false);
+    } else {
+      original[i] = OriginalCD(candidates[i].words, ref, type == "CDER");
+    }
+  }
+  const double originalTime = timer.get_elapsed_cpu_time();
+
+  timer.restart();
+  vector<LevenshteinMatcher> matchers;
+  if (type == "WER") {
+    for (size_t i = 0; i < refs.size(); ++i) {
+      matchers.push_back(LevenshteinMatcher(refs[i]));
+    }
+  }
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    const sent_t& ref = refs[candidates[i].sid];
+    if (type == "TER") {
+      current[i] = Ter(candidates[i].words, ref, true);
+    } else if (type == "CDER") {
+      current[i] = CderDistance(candidates[i].words, ref, true);
+    } else {
+      current[i] = matchers[candidates[i].sid].Distance(candidates[i].words);
+    }
+  }
+  const double currentTime = timer.get_elapsed_cpu_time();
+
+  size_t mismatches = 0;
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    if (original[i] != current[i]) {
+      if (mismatches++ < 10) {
+        cerr << "Candidate " << i << " of sentence " << candidates[i].sid << ": "
+             << original[i] << " edits before, " << current[i] << " now" << endl;
+      }
+    }
+  }
+
+  cout << "original: " << originalTime << "s" << endl;
+  cout << "current: " << currentTime << "s" << endl;
+  if (currentTime > 0) {
+    cout << "speedup: " << originalTime / currentTime << endl;
+  }
+  cout << "mismatches: " << mismatches << endl;
+  return mismatches ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -1,4 +1,5 @@
 #include "BaseManager.h"
+#include "HypergraphOutput.h"
 #include "StaticData.h"
 #include "moses/FF/StatelessFeatureFunction.h"
 #include "moses/FF/StatefulFeatureFunction.h"
@@ -42,6 +43,13 @@ OutputSearchGraphAsHypergraph(std::ostream& out) const
   UTIL_THROW2("Not implemented.");
 }
 
+void
+BaseManager::
+OutputSearchGraphAsBinaryHypergraph(BinaryHypergraphWriter& out) const
+{
+  UTIL_THROW2("Not implemented.");
+}
+
 void
 BaseManager::
 OutputSearchGraphAsHypergraph(std::string const& fname, size_t const precision) const
@@ -67,6 +75,21 @@ OutputSearchGraphAsHypergraph(std::string const& fname, size_t const precision)
   StaticData::Instance().GetAllWeights().Save(weightsOut);
   weightsOut.close();
 
+  if (boost::ends_with(fname, ".bin")) {
+    BinaryHypergraphWriter writer;
+    this->OutputSearchGraphAsBinaryHypergraph(writer);
+    ofstream file(fname.c_str(), ios_base::out | ios_base::binary);
+    writer.Write(file);
+    if (!file) {
+      TRACE_ERR("Cannot output hypergraph for line "
+                << this->GetSource().GetTranslationId()
+                << " because the output file " << fname
+                << " could not be written"
+                << std::endl);
+    }
+    return;
+  }
+
   boost::iostreams::filtering_ostream file;
   if (boost::ends_with(fname, ".gz"))
     file.push(boost::iostreams::gzip_compressor());
@@ -11,6 +11,7 @@ namespace Moses
 class ScoreComponentCollection;
 class FeatureFunction;
 class OutputCollector;
+class BinaryHypergraphWriter;
 
 class BaseManager
 {
@@ -66,6 +67,7 @@ public:
   // virtual void OutputSearchGraphHypergraph() const = 0;
 
   virtual void OutputSearchGraphAsHypergraph(std::ostream& out) const;
+  virtual void OutputSearchGraphAsBinaryHypergraph(BinaryHypergraphWriter& out) const;
   virtual void OutputSearchGraphAsHypergraph(std::string const& fname,
       size_t const precision) const;
   /***
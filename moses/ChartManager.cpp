@@ -298,6 +298,14 @@ OutputSearchGraphAsHypergraph(std::ostream& out) const
   WriteSearchGraph(writer);
 }
 
+void
+ChartManager::
+OutputSearchGraphAsBinaryHypergraph(BinaryHypergraphWriter& out) const
+{
+  ChartSearchGraphWriterBinaryHypergraph writer(options(), &out);
+  WriteSearchGraph(writer);
+}
+
 void ChartManager::OutputSearchGraphMoses(std::ostream &outputSearchGraphStream) const
 {
   ChartSearchGraphWriterMoses writer(options(), &outputSearchGraphStream,
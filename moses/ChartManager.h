@@ -113,6 +113,7 @@ public:
 
   /** Output in (modified) Kenneth hypergraph format */
   void OutputSearchGraphAsHypergraph(std::ostream &outputSearchGraphStream) const;
+  void OutputSearchGraphAsBinaryHypergraph(BinaryHypergraphWriter& out) const;
 
   //! debug data collected when decoding sentence
   SentenceStats& GetSentenceStats() const {
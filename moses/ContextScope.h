@@ -31,6 +31,7 @@ protected:
   typedef scratchpad_t::value_type entry_t;
   typedef scratchpad_t::const_iterator const_iter_t;
   scratchpad_t m_scratchpad;
+  std::map<void const*, size_t> m_charges; // memory estimates, see Charge()
 #ifdef WITH_THREADS
   mutable boost::shared_mutex m_lock;
 #endif
@@ -84,6 +85,42 @@ public:
     boost::unique_lock<boost::shared_mutex> lock2(other.m_lock);
 #endif
     m_scratchpad = other.m_scratchpad;
+    m_charges = other.m_charges;
+  }
+
+  // Components that keep local information in the scope report an
+  // estimate of the memory it holds, so that long-lived scopes (server
+  // sessions) can be kept within a memory budget. A new charge for the
+  // same key replaces the previous one.
+  void
+  Charge(void const* const key, size_t const bytes) {
+#ifdef WITH_THREADS
+    boost::unique_lock<boost::shared_mutex> lock(m_lock);
+#endif
+    m_charges[key] = bytes;
+  }
+
+  size_t
+  GetMemoryUsage() const {
+#ifdef WITH_THREADS
+    boost::shared_lock<boost::shared_mutex> lock(m_lock);
+#endif
+    size_t ret = 0;
+    for (std::map<void const*, size_t>::const_iterator m = m_charges.begin();
+         m != m_charges.end(); ++m)
+      ret += m->second;
+    return ret;
+  }
+
+  // Drop all local information. Only for scopes no task uses any more.
+  void
+  Clear() {
+#ifdef WITH_THREADS
+    boost::unique_lock<boost::shared_mutex> lock(m_lock);
+#endif
+    m_scratchpad.clear();
+    m_charges.clear();
+    m_context_weights.reset();
   }
 
   SPTR<std::map<std::string,float> const>
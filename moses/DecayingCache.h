@@ -0,0 +1,187 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#pragma once
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
+
+#ifdef WITH_THREADS
+#include <boost/atomic.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/locks.hpp>
+#endif
+
+namespace Moses
+{
+
+/** Ages of the entries of the dynamic cache-based models. All entries
+ *  grow one step older with each call to Decay(). Instead of updating
+ *  every entry, an entry stores its age when it was (re)inserted and the
+ *  epoch at that time; its current age follows from the number of epochs
+ *  since. Entries that were decayed beyond the maximum age have expired.
+ */
+class DecayClock
+{
+public:
+  struct Stamp {
+    unsigned int age; // age at insertion
+    int64_t epoch;    // epoch at insertion
+  };
+
+  DecayClock(unsigned int maxAge = 1000) : m_epoch(0), m_maxAge(maxAge) { }
+
+  void SetMaxAge(unsigned int age) {
+    m_maxAge = age;
+  }
+  unsigned int GetMaxAge() const {
+    return m_maxAge;
+  }
+
+  //! advance the clock by one epoch; returns the new epoch
+  int64_t Decay() {
+    return ++m_epoch;
+  }
+
+  Stamp Now(unsigned int age = 1) const {
+    Stamp ret;
+    ret.age = age;
+    ret.epoch = m_epoch;
+    return ret;
+  }
+
+  unsigned int GetAge(const Stamp &stamp) const {
+    return stamp.age + (m_epoch - stamp.epoch);
+  }
+
+  //! entries are dropped when they are decayed beyond the maximum age
+  bool IsExpired(const Stamp &stamp) const {
+    int64_t now = m_epoch;
+    return now > stamp.epoch && stamp.age + (now - stamp.epoch) > m_maxAge;
+  }
+
+protected:
+#ifdef WITH_THREADS
+  boost::atomic<int64_t> m_epoch;
+#else
+  int64_t m_epoch;
+#endif
+  unsigned int m_maxAge;
+};
+
+/** Hash map for the dynamic cache-based models, split into shards with
+ *  a reader-writer lock each. Lookups copy values out under a shared
+ *  lock of one shard, so they wait only for a writer of the same shard,
+ *  and only for as long as it takes to store or erase one value. Values
+ *  that are expensive to copy should be held by shared pointers and
+ *  replaced rather than modified.
+ */
+template<typename KEY, typename VAL, typename HASH = boost::hash<KEY> >
+class DecayingCache : public DecayClock
+{
+  typedef boost::unordered_map<KEY, VAL, HASH> map_t;
+
+  struct Shard {
+#ifdef WITH_THREADS
+    mutable boost::shared_mutex lock;
+#endif
+    map_t entries;
+  };
+  static size_t const num_shards = 16;
+
+  Shard m_shards[num_shards];
+
+  Shard &GetShard(const KEY &key) {
+    return m_shards[HASH()(key) % num_shards];
+  }
+  const Shard &GetShard(const KEY &key) const {
+    return m_shards[HASH()(key) % num_shards];
+  }
+
+public:
+  DecayingCache(unsigned int maxAge = 1000) : DecayClock(maxAge) { }
+
+  //! copy the value of /key/ to /value/; false if there is none
+  bool Find(const KEY &key, VAL &value) const {
+    const Shard &shard = GetShard(key);
+#ifdef WITH_THREADS
+    boost::shared_lock<boost::shared_mutex> lock(shard.lock);
+#endif
+    typename map_t::const_iterator it = shard.entries.find(key);
+    if (it == shard.entries.end()) return false;
+    value = it->second;
+    return true;
+  }
+
+  void Set(const KEY &key, const VAL &value) {
+    Shard &shard = GetShard(key);
+#ifdef WITH_THREADS
+    boost::unique_lock<boost::shared_mutex> lock(shard.lock);
+#endif
+    shard.entries[key] = value;
+  }
+
+  bool Erase(const KEY &key) {
+    Shard &shard = GetShard(key);
+#ifdef WITH_THREADS
+    boost::unique_lock<boost::shared_mutex> lock(shard.lock);
+#endif
+    return shard.entries.erase(key) > 0;
+  }
+
+  //! erase all entries for which pred(key, value) holds, one shard at a time
+  template<typename PRED>
+  size_t EraseIf(PRED pred) {
+    size_t ret = 0;
+    for (size_t i = 0; i < num_shards; ++i) {
+#ifdef WITH_THREADS
+      boost::unique_lock<boost::shared_mutex> lock(m_shards[i].lock);
+#endif
+      map_t &entries = m_shards[i].entries;
+      for (typename map_t::iterator it = entries.begin(); it != entries.end();) {
+        if (pred(it->first, it->second)) {
+          it = entries.erase(it);
+          ++ret;
+        } else {
+          ++it;
+        }
+      }
+    }
+    return ret;
+  }
+
+  void Clear() {
+    for (size_t i = 0; i < num_shards; ++i) {
+#ifdef WITH_THREADS
+      boost::unique_lock<boost::shared_mutex> lock(m_shards[i].lock);
+#endif
+      m_shards[i].entries.clear();
+    }
+  }
+
+  //! number of entries, including expired ones not yet erased
+  size_t Size() const {
+    size_t ret = 0;
+    for (size_t i = 0; i < num_shards; ++i) {
+#ifdef WITH_THREADS
+      boost::shared_lock<boost::shared_mutex> lock(m_shards[i].lock);
+#endif
+      ret += m_shards[i].entries.size();
+    }
+    return ret;
+  }
+
+  //! copy of all entries, e.g. for printing
+  void GetEntries(std::vector<std::pair<KEY, VAL> > &dest) const {
+    dest.clear();
+    for (size_t i = 0; i < num_shards; ++i) {
+#ifdef WITH_THREADS
+      boost::shared_lock<boost::shared_mutex> lock(m_shards[i].lock);
+#endif
+      dest.insert(dest.end(), m_shards[i].entries.begin(), m_shards[i].entries.end());
+    }
+  }
+};
+
+}
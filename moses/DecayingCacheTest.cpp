@@ -0,0 +1,126 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2015- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+#include "DecayingCache.h"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+struct IsExpired {
+  const DecayClock &clock;
+  IsExpired(const DecayClock &c) : clock(c) { }
+  bool operator()(const string &, const DecayClock::Stamp &stamp) const {
+    return clock.IsExpired(stamp);
+  }
+};
+}
+
+BOOST_AUTO_TEST_SUITE(decaying_cache)
+
+BOOST_AUTO_TEST_CASE(age)
+{
+  DecayClock clock(5);
+  DecayClock::Stamp a = clock.Now();
+  DecayClock::Stamp b = clock.Now(3);
+  BOOST_CHECK_EQUAL(clock.GetAge(a), 1);
+  BOOST_CHECK_EQUAL(clock.GetAge(b), 3);
+
+  BOOST_CHECK_EQUAL(clock.Decay(), 1);
+  BOOST_CHECK_EQUAL(clock.Decay(), 2);
+  BOOST_CHECK_EQUAL(clock.GetAge(a), 3);
+  BOOST_CHECK_EQUAL(clock.GetAge(b), 5);
+
+  // entries stamped later start from their own age
+  DecayClock::Stamp c = clock.Now(2);
+  BOOST_CHECK_EQUAL(clock.GetAge(c), 2);
+  clock.Decay();
+  BOOST_CHECK_EQUAL(clock.GetAge(c), 3);
+  BOOST_CHECK_EQUAL(clock.GetAge(a), 4);
+}
+
+// same rule as the eager aging it replaces: an entry is dropped by the
+// Decay() that takes its age beyond the maximum age
+BOOST_AUTO_TEST_CASE(expiry)
+{
+  DecayClock clock(3);
+  DecayClock::Stamp a = clock.Now(1);
+  for (unsigned int age = 1; age <= 3; ++age) {
+    BOOST_CHECK_EQUAL(clock.GetAge(a), age);
+    BOOST_CHECK(!clock.IsExpired(a));
+    clock.Decay();
+  }
+  BOOST_CHECK_EQUAL(clock.GetAge(a), 4);
+  BOOST_CHECK(clock.IsExpired(a));
+
+  // an entry inserted beyond the maximum age lives until the next Decay()
+  DecayClock::Stamp b = clock.Now(10);
+  BOOST_CHECK(!clock.IsExpired(b));
+  clock.Decay();
+  BOOST_CHECK(clock.IsExpired(b));
+
+  // raising the maximum age revives entries that were not erased yet
+  clock.SetMaxAge(100);
+  BOOST_CHECK(!clock.IsExpired(a));
+}
+
+BOOST_AUTO_TEST_CASE(cache)
+{
+  DecayingCache<string, DecayClock::Stamp> cache(2);
+  DecayClock::Stamp stamp = cache.Now();
+  BOOST_CHECK(!cache.Find("a", stamp));
+
+  cache.Set("a", cache.Now(1));
+  cache.Set("b", cache.Now(2));
+  BOOST_CHECK_EQUAL(cache.Size(), 2);
+  BOOST_REQUIRE(cache.Find("a", stamp));
+  BOOST_CHECK_EQUAL(cache.GetAge(stamp), 1);
+
+  cache.Decay();
+  BOOST_CHECK_EQUAL(cache.EraseIf(IsExpired(cache)), 1);
+  BOOST_CHECK(!cache.Find("b", stamp));
+  BOOST_REQUIRE(cache.Find("a", stamp));
+  BOOST_CHECK_EQUAL(cache.GetAge(stamp), 2);
+
+  // re-inserting an entry resets its age
+  cache.Set("a", cache.Now(1));
+  cache.Decay();
+  BOOST_CHECK_EQUAL(cache.EraseIf(IsExpired(cache)), 0);
+  BOOST_REQUIRE(cache.Find("a", stamp));
+  BOOST_CHECK_EQUAL(cache.GetAge(stamp), 2);
+
+  vector<pair<string, DecayClock::Stamp> > entries;
+  cache.GetEntries(entries);
+  BOOST_REQUIRE_EQUAL(entries.size(), 1);
+  BOOST_CHECK_EQUAL(entries[0].first, "a");
+
+  BOOST_CHECK(cache.Erase("a"));
+  BOOST_CHECK(!cache.Erase("a"));
+  cache.Set("c", cache.Now());
+  cache.Clear();
+  BOOST_CHECK_EQUAL(cache.Size(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
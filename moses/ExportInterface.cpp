@@ -159,7 +159,8 @@ int
 run_as_server()
 {
 #ifdef HAVE_XMLRPC_C
-  if (params.GetParam("daemon")) {
+  // a new server generation (see Server::reload()) is not daemonized
+  if (params.GetParam("daemon") && !getenv("MOSES_SERVER_FD")) {
     kill(getppid(),SIGALRM);
   }
   MosesServer::Server server(params);
@@ -342,7 +343,7 @@ int decoder_main(int argc, char const** argv)
     //
 #if 1
     pid_t pid;
-    if (params.GetParam("daemon")) {
+    if (params.GetParam("daemon") && !getenv("MOSES_SERVER_FD")) {
       pid = fork();
       if (pid) {
         pause();  // parent process
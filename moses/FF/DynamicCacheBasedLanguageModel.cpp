@@ -33,7 +33,7 @@ DynamicCacheBasedLanguageModel::~DynamicCacheBasedLanguageModel() {};
 void DynamicCacheBasedLanguageModel::SetPreComputedScores()
 {
 #ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> lock(m_cacheLock);
+  boost::unique_lock<boost::mutex> lock(m_updateLock);
 #endif
   precomputedScores.clear();
   for (unsigned int i=0; i<m_maxAge; i++) {
@@ -52,7 +52,7 @@ void DynamicCacheBasedLanguageModel::SetPreComputedScores()
   VERBOSE(3, "SetPreComputedScores(): lower_age:|" << m_maxAge << "| lower_score:|" << m_lower_score << "|" << std::endl);
 }
 
-float DynamicCacheBasedLanguageModel::GetPreComputedScores(const unsigned int age)
+float DynamicCacheBasedLanguageModel::GetPreComputedScores(const unsigned int age) const
 {
   VERBOSE(2, "float DynamicCacheBasedLanguageModel::GetPreComputedScores" << std::endl);
   VERBOSE(2, "age:|"<< age << "|" << std::endl);
@@ -65,6 +65,17 @@ float DynamicCacheBasedLanguageModel::GetPreComputedScores(const unsigned int ag
   }
 }
 
+// score of an n-gram: decayed by its age if it is in the cache and has
+// not expired, the lower bound otherwise
+float DynamicCacheBasedLanguageModel::GetScore(const std::string &w) const
+{
+  decaying_cache_value_t stamp;
+  if (!m_cache.Find(w, stamp) || m_cache.IsExpired(stamp)) {
+    return m_lower_score;
+  }
+  return GetPreComputedScores(m_cache.GetAge(stamp));
+}
+
 void DynamicCacheBasedLanguageModel::SetParameter(const std::string& key, const std::string& value)
 {
   VERBOSE(2, "DynamicCacheBasedLanguageModel::SetParameter key:|" << key << "| value:|" << value << "|" << std::endl);
@@ -111,7 +122,6 @@ float DynamicCacheBasedLanguageModel::Evaluate_Whole_String(const TargetPhrase&
   // and compute the decaying_score for the whole n-gram
   // and return this value
 
-  decaying_cache_t::const_iterator it;
   float score = m_lower_score;
 
   std::string w = "";
@@ -122,13 +132,9 @@ float DynamicCacheBasedLanguageModel::Evaluate_Whole_String(const TargetPhrase&
       w += " ";
     }
   }
-  it = m_cache.find(w);
 
   VERBOSE(4,"cblm::Evaluate_Whole_String: searching w:|" << w << "|" << std::endl);
-  if (it != m_cache.end()) { //found!
-    score = ((*it).second).second;
-    VERBOSE(4,"cblm::Evaluate_Whole_String: found w:|" << w << "|" << std::endl);
-  }
+  score = GetScore(w);
 
   VERBOSE(4,"cblm::Evaluate_Whole_String: returning score:|" << score << "|" << std::endl);
   return score;
@@ -140,21 +146,15 @@ float DynamicCacheBasedLanguageModel::Evaluate_All_Substrings(const TargetPhrase
   //and compute the decaying_score for all words
   //and return their sum
 
-  decaying_cache_t::const_iterator it;
   float score = 0.0;
 
   for (size_t startpos = 0 ; startpos < tp.GetSize() ; ++startpos) {
     std::string w = "";
     for (size_t endpos = startpos; endpos < tp.GetSize() ; ++endpos) {
       w += tp.GetWord(endpos).GetFactor(0)->GetString().as_string();
-      it = m_cache.find(w);
-
-      if (it != m_cache.end()) { //found!
-        score += ((*it).second).second;
-        VERBOSE(3,"cblm::Evaluate_All_Substrings: found w:|" << w << "| actual score:|" << ((*it).second).second << "| score:|" << score << "|" << std::endl);
-      } else {
-        score += m_lower_score;
-      }
+      float actual_score = GetScore(w);
+      score += actual_score;
+      VERBOSE(3,"cblm::Evaluate_All_Substrings: w:|" << w << "| actual score:|" << actual_score << "| score:|" << score << "|" << std::endl);
 
       if (endpos == startpos) {
         w += " ";
@@ -168,44 +168,53 @@ float DynamicCacheBasedLanguageModel::Evaluate_All_Substrings(const TargetPhrase
 
 void DynamicCacheBasedLanguageModel::Print() const
 {
-#ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> read_lock(m_cacheLock);
-#endif
-  decaying_cache_t::const_iterator it;
+  std::vector<std::pair<std::string, decaying_cache_value_t> > entries;
+  m_cache.GetEntries(entries);
+  // expired entries that were not erased yet are not part of the cache
+  size_t size = 0;
+  for (size_t i = 0; i < entries.size(); i++) {
+    if (!m_cache.IsExpired(entries[i].second)) {
+      entries[size++] = entries[i];
+    }
+  }
+  entries.resize(size);
   std::cout << "Content of the cache of Cache-Based Language Model" << std::endl;
-  std::cout << "Size of the cache of Cache-Based Language Model:|" << m_cache.size() << "|" << std::endl;
-  for ( it=m_cache.begin() ; it != m_cache.end(); it++ ) {
-    std::cout << "word:|" << (*it).first << "| age:|" << ((*it).second).first << "| score:|" << ((*it).second).second << "|" << std::endl;
+  std::cout << "Size of the cache of Cache-Based Language Model:|" << entries.size() << "|" << std::endl;
+  for (size_t i = 0; i < entries.size(); i++) {
+    unsigned int age = m_cache.GetAge(entries[i].second);
+    std::cout << "word:|" << entries[i].first << "| age:|" << age << "| score:|" << GetPreComputedScores(age) << "|" << std::endl;
   }
 }
 
+namespace
+{
+struct IsExpired {
+  const DecayClock &clock;
+  IsExpired(const DecayClock &c) : clock(c) { }
+  bool operator()(const std::string &w, const decaying_cache_value_t &stamp) const {
+    return clock.IsExpired(stamp);
+  }
+};
+}
+
 void DynamicCacheBasedLanguageModel::Decay()
 {
 #ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> lock(m_cacheLock);
+  boost::unique_lock<boost::mutex> lock(m_updateLock);
 #endif
-  decaying_cache_t::iterator it;
-
-  unsigned int age;
-  float score;
-  for ( it=m_cache.begin() ; it != m_cache.end(); it++ ) {
-    age=((*it).second).first + 1;
-    if (age > m_maxAge) {
-      m_cache.erase(it);
-      it--;
-    } else {
-      score = GetPreComputedScores(age);
-//      score = decaying_score(age);
-      decaying_cache_value_t p (age, score);
-      (*it).second = p;
-    }
+  // all entries age by advancing the clock of the cache; the expired ones
+  // are ignored by lookups and erased once every m_maxAge calls
+  int64_t epoch = m_cache.Decay();
+  if (epoch % std::max(m_maxAge, 1u) == 0) {
+    m_cache.EraseIf(IsExpired(m_cache));
+    VERBOSE(3,"entries left after erasing the expired ones:|" << m_cache.Size() << "|" << std::endl);
   }
 }
 
 void DynamicCacheBasedLanguageModel::Update(std::vector<std::string> words, int age)
 {
 #ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> lock(m_cacheLock);
+  boost::unique_lock<boost::mutex> lock(m_updateLock);
 #endif
   VERBOSE(3,"words.size():|" << words.size() << "|" << std::endl);
   for (size_t j=0; j<words.size(); j++) {
@@ -213,10 +222,7 @@ void DynamicCacheBasedLanguageModel::Update(std::vector<std::string> words, int
 //    VERBOSE(3,"CacheBasedLanguageModel::Update   word[" << j << "]:"<< words[j] << " age:" << age << " decaying_score(age):" << decaying_score(age) << std::endl);
 //    decaying_cache_value_t p (age,decaying_score(age));
     VERBOSE(3,"CacheBasedLanguageModel::Update   word[" << j << "]:"<< words[j] << " age:" << age << " GetPreComputedScores(age):" << GetPreComputedScores(age) << std::endl);
-    decaying_cache_value_t p (age,GetPreComputedScores(age));
-    std::pair<std::string, decaying_cache_value_t> e (words[j],p);
-    m_cache.erase(words[j]); //always erase the element (do nothing if the entry does not exist)
-    m_cache.insert(e); //insert the entry
+    m_cache.Set(words[j], m_cache.Now(age)); //insert or overwrite the entry
   }
 }
 
@@ -233,13 +239,13 @@ void DynamicCacheBasedLanguageModel::ClearEntries(std::string &entries)
 void DynamicCacheBasedLanguageModel::ClearEntries(std::vector<std::string> words)
 {
 #ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> lock(m_cacheLock);
+  boost::unique_lock<boost::mutex> lock(m_updateLock);
 #endif
   VERBOSE(3,"words.size():|" << words.size() << "|" << std::endl);
   for (size_t j=0; j<words.size(); j++) {
     words[j] = Trim(words[j]);
     VERBOSE(3,"CacheBasedLanguageModel::ClearEntries   word[" << j << "]:"<< words[j] << std::endl);
-    m_cache.erase(words[j]); //always erase the element (do nothing if the entry does not exist)
+    m_cache.Erase(words[j]); //always erase the element (do nothing if the entry does not exist)
   }
 }
 
@@ -318,9 +324,9 @@ void DynamicCacheBasedLanguageModel::Execute_Single_Command(std::string command)
 void DynamicCacheBasedLanguageModel::Clear()
 {
 #ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> lock(m_cacheLock);
+  boost::unique_lock<boost::mutex> lock(m_updateLock);
 #endif
-  m_cache.clear();
+  m_cache.Clear();
 }
 
 void DynamicCacheBasedLanguageModel::Load(AllOptions::ptr const& opts)
@@ -385,7 +391,7 @@ void DynamicCacheBasedLanguageModel::Load_Single_File(const std::string file)
 void DynamicCacheBasedLanguageModel::SetQueryType(size_t type)
 {
 #ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> read_lock(m_cacheLock);
+  boost::unique_lock<boost::mutex> lock(m_updateLock);
 #endif
 
   m_query_type = type;
@@ -401,7 +407,7 @@ void DynamicCacheBasedLanguageModel::SetQueryType(size_t type)
 void DynamicCacheBasedLanguageModel::SetScoreType(size_t type)
 {
 #ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> read_lock(m_cacheLock);
+  boost::unique_lock<boost::mutex> lock(m_updateLock);
 #endif
   m_score_type = type;
   if ( m_score_type != CBLM_SCORE_TYPE_HYPERBOLA
@@ -420,9 +426,10 @@ void DynamicCacheBasedLanguageModel::SetScoreType(size_t type)
 void DynamicCacheBasedLanguageModel::SetMaxAge(unsigned int age)
 {
 #ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> read_lock(m_cacheLock);
+  boost::unique_lock<boost::mutex> lock(m_updateLock);
 #endif
   m_maxAge = age;
+  m_cache.SetMaxAge(age);
   VERBOSE(2, "CacheBasedLanguageModel MaxAge:  " << m_maxAge << std::endl);
 };
 
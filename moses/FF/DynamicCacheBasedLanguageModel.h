@@ -4,15 +4,16 @@
 #define moses_DynamicCacheBasedLanguageModel_h
 
 #include "moses/Util.h"
+#include "moses/DecayingCache.h"
 #include "FeatureFunction.h"
 
 #ifdef WITH_THREADS
-#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/thread/locks.hpp>
 #endif
 
-typedef std::pair<int, float> decaying_cache_value_t;
-typedef std::map<std::string, decaying_cache_value_t > decaying_cache_t;
+typedef Moses::DecayClock::Stamp decaying_cache_value_t;
+typedef Moses::DecayingCache<std::string, decaying_cache_value_t> decaying_cache_t;
 
 #define CBLM_QUERY_TYPE_UNDEFINED (-1)
 #define CBLM_QUERY_TYPE_ALLSUBSTRINGS 0
@@ -38,7 +39,8 @@ class Range;
 class DynamicCacheBasedLanguageModel : public StatelessFeatureFunction
 {
   // data structure for the cache;
-  // the key is the word and the value is the decaying score
+  // the key is the word and the value is its age, from which the
+  // decaying score follows
   decaying_cache_t m_cache;
   size_t m_query_type; //way of querying the cache
   size_t m_score_type; //way of scoring entries of the cache
@@ -50,13 +52,14 @@ class DynamicCacheBasedLanguageModel : public StatelessFeatureFunction
   unsigned int m_maxAge;
 
 #ifdef WITH_THREADS
-  //multiple readers - single writer lock
-  mutable boost::shared_mutex m_cacheLock;
+  // serializes updates; lookups only lock a shard of m_cache
+  mutable boost::mutex m_updateLock;
 #endif
 
   float decaying_score(unsigned int age);
   void SetPreComputedScores();
-  float GetPreComputedScores(const unsigned int age);
+  float GetPreComputedScores(const unsigned int age) const;
+  float GetScore(const std::string &w) const;
 
   float Evaluate_Whole_String( const TargetPhrase&) const;
   float Evaluate_All_Substrings( const TargetPhrase&) const;
@@ -21,6 +21,10 @@ OSMLM* ConstructOSMLM(const char *file)
       return new KenOSM<lm::ngram::ArrayTrieModel>(file, config);
     case lm::ngram::QUANT_ARRAY_TRIE:
       return new KenOSM<lm::ngram::QuantArrayTrieModel>(file, config);
+    case lm::ngram::EF_TRIE:
+      return new KenOSM<lm::ngram::EliasFanoTrieModel>(file, config);
+    case lm::ngram::QUANT_EF_TRIE:
+      return new KenOSM<lm::ngram::QuantEliasFanoTrieModel>(file, config);
     default:
       UTIL_THROW2("Unrecognized kenlm model type " << model_type);
     }
@@ -38,6 +38,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #include "ChartManager.h"
 #include "HypergraphOutput.h"
 #include "Manager.h"
+#include "ScoreComponentCollection.h"
+#include "FF/FeatureFunction.h"
 
 using namespace std;
 
@@ -47,6 +49,122 @@ namespace Moses
 template class HypergraphOutput<Manager>;
 template class HypergraphOutput<ChartManager>;
 
+const char BinaryHypergraphWriter::kMagic[8] = {'M', 'O', 'S', 'E', 'S', 'H', 'G', '1'};
+
+BinaryHypergraphWriter::BinaryHypergraphWriter()
+{
+  m_edgeSymbols.push_back(0);
+  m_edgeFeatures.push_back(0);
+  m_stringOffsets.push_back(0);
+}
+
+uint32_t BinaryHypergraphWriter::GetStringId(const StringPiece& str)
+{
+  StringIds::const_iterator found = m_stringIds.find(str, StringHash(), StringEquals());
+  if (found != m_stringIds.end()) return found->second;
+  const uint32_t id = m_stringOffsets.size() - 1;
+  m_stringIds.insert(make_pair(str.as_string(), id));
+  m_strings.append(str.data(), str.size());
+  m_stringOffsets.push_back(m_strings.size());
+  return id;
+}
+
+void BinaryHypergraphWriter::AddVertex()
+{
+  m_vertexEdges.push_back(m_edgeSymbols.size() - 1);
+  m_sourceCovered.push_back(0);
+}
+
+void BinaryHypergraphWriter::AddWord(const StringPiece& word)
+{
+  m_symbols.push_back(GetStringId(word));
+}
+
+void BinaryHypergraphWriter::AddChild(size_t vertex)
+{
+  UTIL_THROW_IF2(vertex >= kChild, "Too many vertices for the binary hypergraph format");
+  m_symbols.push_back(kChild | vertex);
+}
+
+void BinaryHypergraphWriter::AddFeature(const StringPiece& name, float value)
+{
+  m_featureNames.push_back(GetStringId(name));
+  m_featureValues.push_back(value);
+}
+
+void BinaryHypergraphWriter::AddFeatures(const ScoreComponentCollection& scores)
+{
+  const FVector& vector = scores.GetScoresVector();
+  if (m_denseNames.empty()) {
+    // as in ScoreComponentCollection::Save
+    m_denseNames.resize(vector.coreSize());
+    std::vector<FeatureFunction*> const& all_ff = FeatureFunction::GetFeatureFunctions();
+    for (size_t f = 0; f < all_ff.size(); ++f) {
+      const FeatureFunction* ff = all_ff[f];
+      const string& name = ff->GetScoreProducerDescription();
+      const size_t components = ff->GetNumScoreComponents();
+      for (size_t k = 0; k < components; ++k) {
+        ostringstream assembled;
+        assembled << name;
+        if (components > 1) assembled << "_" << (k + 1);
+        m_denseNames.at(ff->GetIndex() + k) = GetStringId(assembled.str());
+      }
+    }
+  }
+  for (size_t i = 0; i < m_denseNames.size(); ++i) {
+    m_featureNames.push_back(m_denseNames[i]);
+    m_featureValues.push_back(vector[i]);
+  }
+  for (FVector::const_iterator i = vector.cbegin(); i != vector.cend(); ++i) {
+    AddFeature(i->first.name(), i->second);
+  }
+}
+
+void BinaryHypergraphWriter::EndEdge(size_t sourceCovered)
+{
+  UTIL_THROW_IF2(m_vertexEdges.empty(), "Hypergraph edge added before its vertex");
+  if (m_vertexEdges.back() == m_edgeSymbols.size() - 1) {
+    m_sourceCovered.back() = sourceCovered;
+  }
+  m_edgeSymbols.push_back(m_symbols.size());
+  m_edgeFeatures.push_back(m_featureNames.size());
+}
+
+namespace
+{
+template <class T> void WriteArray(std::ostream& out, const std::vector<T>& array)
+{
+  if (!array.empty()) {
+    out.write(reinterpret_cast<const char*>(&array[0]), array.size() * sizeof(T));
+  }
+}
+}
+
+void BinaryHypergraphWriter::Write(std::ostream& out) const
+{
+  std::vector<uint32_t> vertexEdges(m_vertexEdges);
+  vertexEdges.push_back(m_edgeSymbols.size() - 1);
+  uint32_t counts[6] = {
+    static_cast<uint32_t>(m_sourceCovered.size()),
+    static_cast<uint32_t>(m_edgeSymbols.size() - 1),
+    static_cast<uint32_t>(m_symbols.size()),
+    static_cast<uint32_t>(m_featureNames.size()),
+    static_cast<uint32_t>(m_stringOffsets.size() - 1),
+    static_cast<uint32_t>(m_strings.size())
+  };
+  out.write(kMagic, sizeof(kMagic));
+  out.write(reinterpret_cast<const char*>(counts), sizeof(counts));
+  WriteArray(out, vertexEdges);
+  WriteArray(out, m_sourceCovered);
+  WriteArray(out, m_edgeSymbols);
+  WriteArray(out, m_edgeFeatures);
+  WriteArray(out, m_symbols);
+  WriteArray(out, m_featureNames);
+  WriteArray(out, m_featureValues);
+  WriteArray(out, m_stringOffsets);
+  out.write(m_strings.data(), m_strings.size());
+}
+
 void
 ChartSearchGraphWriterMoses::
 WriteHypos(const ChartHypothesisCollection& hypos,
@@ -141,6 +259,58 @@ WriteHypos(const ChartHypothesisCollection& hypos,
   }
 }
 
+void
+ChartSearchGraphWriterBinaryHypergraph::
+WriteHypos(const ChartHypothesisCollection& hypos,
+           const map<unsigned, bool> &reachable) const
+{
+
+  ChartHypothesisCollection::const_iterator iter;
+  for (iter = hypos.begin() ; iter != hypos.end() ; ++iter) {
+    const ChartHypothesis* mainHypo = *iter;
+    if (!m_options->output.DontPruneSearchGraph &&
+        reachable.find(mainHypo->GetId()) == reachable.end()) {
+      //Ignore non reachable nodes
+      continue;
+    }
+    m_hypoIdToNodeId[mainHypo->GetId()] = m_out->VertexSize();
+    m_out->AddVertex();
+    vector<const ChartHypothesis*> edges;
+    edges.push_back(mainHypo);
+    const ChartArcList *arcList = (*iter)->GetArcList();
+    if (arcList) {
+      ChartArcList::const_iterator iterArc;
+      for (iterArc = arcList->begin(); iterArc != arcList->end(); ++iterArc) {
+        const ChartHypothesis* arc = *iterArc;
+        if (reachable.find(arc->GetId()) != reachable.end()) {
+          edges.push_back(arc);
+        }
+      }
+    }
+    for (vector<const ChartHypothesis*>::const_iterator ei = edges.begin();
+         ei != edges.end(); ++ei) {
+      const ChartHypothesis* hypo = *ei;
+      const TargetPhrase& target = hypo->GetCurrTargetPhrase();
+      size_t ntIndex = 0;
+      for (size_t i = 0; i < target.GetSize(); ++i) {
+        const Word& word = target.GetWord(i);
+        if (word.IsNonTerminal()) {
+          size_t hypoId = hypo->GetPrevHypos()[ntIndex++]->GetId();
+          m_out->AddChild(m_hypoIdToNodeId[hypoId]);
+        } else {
+          m_out->AddWord(word.GetFactor(0)->GetString());
+        }
+      }
+      ScoreComponentCollection scores = hypo->GetScoreBreakdown();
+      HypoList::const_iterator hi;
+      for (hi = hypo->GetPrevHypos().begin(); hi != hypo->GetPrevHypos().end(); ++hi) {
+        scores.MinusEquals((*hi)->GetScoreBreakdown());
+      }
+      m_out->AddFeatures(scores);
+      m_out->EndEdge(hypo->GetCurrSourceRange().GetNumWordsCovered());
+    }
+  }
+}
 
 } //namespace Moses
 
@@ -23,8 +23,17 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef moses_Hypergraph_Output_h
 #define moses_Hypergraph_Output_h
 
+#include <map>
 #include <ostream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include <boost/unordered_map.hpp>
+
 #include "moses/parameters/AllOptions.h"
+#include "util/murmur_hash.hh"
+#include "util/string_piece.hh"
 
 /**
 * Manage the output of hypergraphs.
@@ -34,6 +43,7 @@ namespace Moses
 {
 
 class ChartHypothesisCollection;
+class ScoreComponentCollection;
 
 template<class M>
 class HypergraphOutput
@@ -54,6 +64,81 @@ private:
 };
 
 
+/**
+ * Builds a search graph in the binary hypergraph format and writes it out in
+ * one go. This holds the same graph as the text format (vertices in
+ * topological order, each with its incoming edges), but as flat arrays with
+ * interned words and feature names and single precision feature values, so
+ * that mert can map the file instead of parsing it (see mert/Hypergraph.h).
+ *
+ * Layout, in native byte order: the magic "MOSESHG1", then the counts of
+ * vertices V, edges E, target symbols S, feature values F, strings N and
+ * string bytes B as uint32, then
+ *   uint32 first edge of each vertex [V+1], uint32 source covered [V],
+ *   uint32 first symbol of each edge [E+1], uint32 first feature [E+1],
+ *   uint32 symbols [S] (string id, or kChild | vertex for a non-terminal),
+ *   uint32 feature name ids [F], float feature values [F],
+ *   uint32 string offsets [N+1], char strings [B].
+**/
+class BinaryHypergraphWriter
+{
+public:
+  static const char kMagic[8];
+  static const uint32_t kChild = 0x80000000;
+
+  BinaryHypergraphWriter();
+
+  //! Start the next vertex. Edges added until the next call are its incoming edges.
+  void AddVertex();
+
+  void AddWord(const StringPiece& word);
+  void AddChild(size_t vertex);
+  void AddFeature(const StringPiece& name, float value);
+
+  //! Add dense and sparse scores, named as ScoreComponentCollection::Save names them.
+  void AddFeatures(const ScoreComponentCollection& scores);
+
+  //! Finish the current edge. The first edge of a vertex sets its source coverage.
+  void EndEdge(size_t sourceCovered);
+
+  size_t VertexSize() const {
+    return m_sourceCovered.size();
+  }
+
+  void Write(std::ostream& out) const;
+
+private:
+  struct StringHash : public std::unary_function<StringPiece, std::size_t> {
+    std::size_t operator()(const StringPiece& str) const {
+      return util::MurmurHashNative(str.data(), str.size());
+    }
+  };
+
+  struct StringEquals : public std::binary_function<StringPiece, StringPiece, bool> {
+    bool operator()(const StringPiece& first, const StringPiece& second) const {
+      return first == second;
+    }
+  };
+
+  uint32_t GetStringId(const StringPiece& str);
+
+  typedef boost::unordered_map<std::string, uint32_t, StringHash, StringEquals> StringIds;
+  StringIds m_stringIds;
+  std::vector<uint32_t> m_stringOffsets;
+  std::string m_strings;
+
+  std::vector<uint32_t> m_vertexEdges;
+  std::vector<uint32_t> m_sourceCovered;
+  std::vector<uint32_t> m_edgeSymbols;
+  std::vector<uint32_t> m_edgeFeatures;
+  std::vector<uint32_t> m_symbols;
+  std::vector<uint32_t> m_featureNames;
+  std::vector<float> m_featureValues;
+
+  //! string ids of the dense feature names, by score index
+  std::vector<uint32_t> m_denseNames;
+};
+
 /**
  * ABC for different types of search graph output for chart Moses.
 **/
@@ -103,5 +188,22 @@ private:
   mutable std::map<size_t,size_t> m_hypoIdToNodeId;
 };
 
+/** The same graph as ChartSearchGraphWriterHypergraph, in the binary format */
+class ChartSearchGraphWriterBinaryHypergraph : public virtual ChartSearchGraphWriter
+{
+public:
+  ChartSearchGraphWriterBinaryHypergraph(AllOptions::ptr const& opts, BinaryHypergraphWriter* out)
+    : ChartSearchGraphWriter(opts), m_out(out) { }
+  virtual void WriteHeader(size_t, size_t) const {
+    /* do nothing */
+  }
+  virtual void WriteHypos(const ChartHypothesisCollection& hypos,
+                          const std::map<unsigned, bool> &reachable) const;
+
+private:
+  BinaryHypergraphWriter* m_out;
+  mutable std::map<size_t,size_t> m_hypoIdToNodeId;
+};
+
 }
 #endif
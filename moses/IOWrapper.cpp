@@ -154,7 +154,9 @@ IOWrapper::IOWrapper(AllOptions const& opts)
   } else fmt = boost::filesystem::current_path().string() + "/hypergraph";
   if (*fmt.rbegin() != '/') fmt += "/";
   std::string extension = (p && p->size() > 1 ? p->at(1) : std::string("txt"));
-  UTIL_THROW_IF2(extension != "txt" && extension != "gz" && extension != "bz2",
+  // "bin" selects the binary format of BinaryHypergraphWriter
+  UTIL_THROW_IF2(extension != "txt" && extension != "gz" && extension != "bz2"
+                 && extension != "bin",
                  "Unknown compression type '" << extension
                  << "' for hypergraph output!");
   fmt += string("%d.") + extension;
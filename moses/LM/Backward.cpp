@@ -301,6 +301,10 @@ LanguageModel *ConstructBackwardLM(const std::string &line, const std::string &f
       return new BackwardLanguageModel<lm::ngram::ArrayTrieModel>(line, file, factorType, lazy);
     case lm::ngram::QUANT_ARRAY_TRIE:
       return new BackwardLanguageModel<lm::ngram::QuantArrayTrieModel>(line, file, factorType, lazy);
+    case lm::ngram::EF_TRIE:
+      return new BackwardLanguageModel<lm::ngram::EliasFanoTrieModel>(line, file, factorType, lazy);
+    case lm::ngram::QUANT_EF_TRIE:
+      return new BackwardLanguageModel<lm::ngram::QuantEliasFanoTrieModel>(line, file, factorType, lazy);
     default:
       UTIL_THROW2("Unrecognized kenlm model type " << model_type);
     }
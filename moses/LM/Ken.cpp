@@ -457,6 +457,10 @@ LanguageModel *ConstructKenLM(const std::string &lineOrig)
         load_method = util::READ;
       } else if (value == "parallel_read") {
         load_method = util::PARALLEL_READ;
+      } else if (value == "huge_read") {
+        load_method = util::HUGE_READ;
+      } else if (value == "interleave_read") {
+        load_method = util::INTERLEAVE_READ;
       } else {
         UTIL_THROW2("Unknown KenLM load method " << value);
       }
@@ -486,6 +490,10 @@ LanguageModel *ConstructKenLM(const std::string &line, const std::string &file,
       return new LanguageModelKen<lm::ngram::ArrayTrieModel>(line, file, factorType, load_method);
     case lm::ngram::QUANT_ARRAY_TRIE:
       return new LanguageModelKen<lm::ngram::QuantArrayTrieModel>(line, file, factorType, load_method);
+    case lm::ngram::EF_TRIE:
+      return new LanguageModelKen<lm::ngram::EliasFanoTrieModel>(line, file, factorType, load_method);
+    case lm::ngram::QUANT_EF_TRIE:
+      return new LanguageModelKen<lm::ngram::QuantEliasFanoTrieModel>(line, file, factorType, load_method);
     default:
       UTIL_THROW2("Unrecognized kenlm model type " << model_type);
     }
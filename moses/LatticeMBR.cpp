@@ -11,6 +11,15 @@
 #include "moses/StaticData.h"
 #include <algorithm>
 #include <set>
+#include <stdint.h>
+#include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
+
+#ifdef WITH_THREADS
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include "moses/ThreadPool.h"
+#endif
 
 using namespace std;
 
@@ -50,32 +59,6 @@ void extract_ngrams(const vector<Word >& sentence, map < Phrase, int >  & allngr
 
 
 
-void NgramScores::addScore(const Hypothesis* node, const Phrase& ngram, float score)
-{
-  set<Phrase>::const_iterator ngramIter = m_ngrams.find(ngram);
-  if (ngramIter == m_ngrams.end()) {
-    ngramIter = m_ngrams.insert(ngram).first;
-  }
-  map<const Phrase*,float>& ngramScores = m_scores[node];
-  map<const Phrase*,float>::iterator scoreIter = ngramScores.find(&(*ngramIter));
-  if (scoreIter == ngramScores.end()) {
-    ngramScores[&(*ngramIter)] = score;
-  } else {
-    ngramScores[&(*ngramIter)] = log_sum(score,scoreIter->second);
-  }
-}
-
-NgramScores::NodeScoreIterator NgramScores::nodeBegin(const Hypothesis* node)
-{
-  return m_scores[node].begin();
-}
-
-
-NgramScores::NodeScoreIterator NgramScores::nodeEnd(const Hypothesis* node)
-{
-  return m_scores[node].end();
-}
-
 LatticeMBRSolution::LatticeMBRSolution(const TrellisPath& path, bool isMap) :
   m_score(0.0f)
 {
@@ -130,6 +113,17 @@ void LatticeMBRSolution::CalcScore(map<Phrase, float>& finalNgramScores, const v
 }
 
 
+namespace
+{
+
+struct EstimatedScoreLess {
+  bool operator()(const pair<float, const Hypothesis*>& a, const pair<float, const Hypothesis*>& b) const {
+    return a.first < b.first;
+  }
+};
+
+}
+
 void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const Hypothesis* > > & outgoingHyps, map<const Hypothesis*, vector<Edge> >& incomingEdges,
                     const vector< float> & estimatedScores, const Hypothesis* bestHypo, size_t edgeDensity, float scale)
 {
@@ -148,27 +142,32 @@ void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const
       outgoingHyps[emptyHyp].insert(connectedHyp[i]);
   }
 
-  //sort hyps based on estimated scores - do so by copying to multimap
-  multimap<float, const Hypothesis*> sortHypsByVal;
+  //sort hyps based on estimated scores. The sort is stable and the hyps are
+  //visited from the back, so equal scores come out in reverse order of
+  //insertion, as they did from the multimap this used to be.
+  vector<pair<float, const Hypothesis*> > sortHypsByVal;
+  sortHypsByVal.reserve(estimatedScores.size() + 1);
   for (size_t i =0; i < estimatedScores.size(); ++i) {
-    sortHypsByVal.insert(make_pair(estimatedScores[i], connectedHyp[i]));
+    sortHypsByVal.push_back(make_pair(estimatedScores[i], connectedHyp[i]));
   }
+  stable_sort(sortHypsByVal.begin(), sortHypsByVal.end(), EstimatedScoreLess());
 
-  multimap<float, const Hypothesis*>::const_iterator it = --sortHypsByVal.end();
-  float bestScore = it->first;
+  float bestScore = sortHypsByVal.back().first;
   //store best score as score of hyp 0
-  sortHypsByVal.insert(make_pair(bestScore, emptyHyp));
+  sortHypsByVal.push_back(make_pair(bestScore, emptyHyp));
 
 
   IFVERBOSE(3) {
-    for (multimap<float, const Hypothesis*>::const_iterator it = --sortHypsByVal.end(); it != --sortHypsByVal.begin(); --it) {
+    for (vector<pair<float, const Hypothesis*> >::const_reverse_iterator it = sortHypsByVal.rbegin(); it != sortHypsByVal.rend(); ++it) {
       const Hypothesis* currHyp =  it->second;
       cerr << "Hyp " << currHyp->GetId() << ", estimated score: " << it->first << endl;
     }
   }
 
 
-  set <const Hypothesis*> survivingHyps; //store hyps that make the cut in this
+  //store hyps that make the cut, in the order they do
+  boost::unordered_set<const Hypothesis*> survivingHyps;
+  vector<const Hypothesis*> survivingList;
 
   VERBOSE(2, "BEST HYPO TARGET LENGTH : " << bestHypo->GetSize() << endl)
   size_t numEdgesTotal = edgeDensity * bestHypo->GetSize(); //as per Shankar, aim for (density * target length of MAP solution) arcs
@@ -177,8 +176,8 @@ void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const
 
   float prevScore = -999999;
 
-  //now iterate over multimap
-  for (multimap<float, const Hypothesis*>::const_iterator it = --sortHypsByVal.end(); it != --sortHypsByVal.begin(); --it) {
+  //now iterate from the best score down
+  for (vector<pair<float, const Hypothesis*> >::const_reverse_iterator it = sortHypsByVal.rbegin(); it != sortHypsByVal.rend(); ++it) {
     float currEstimatedScore = it->first;
     const Hypothesis* currHyp =  it->second;
 
@@ -189,7 +188,9 @@ void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const
     VERBOSE(3, "Num edges created : "<< numEdgesCreated << ", numEdges wanted " << numEdgesTotal << endl)
     VERBOSE(3, "Considering hyp " << currHyp->GetId() << ", estimated score: " << it->first << endl)
 
-    survivingHyps.insert(currHyp); //CurrHyp made the cut
+    if (survivingHyps.insert(currHyp).second) { //CurrHyp made the cut
+      survivingList.push_back(currHyp);
+    }
 
     // is its best predecessor already included ?
     if (survivingHyps.find(currHyp->GetPrevHypo()) != survivingHyps.end()) { //yes, then add an edge
@@ -232,7 +233,6 @@ void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const
           vector <Edge>& succEdges = incomingEdges[succHyp];
           Edge succWinningEdge(currHyp, succHyp, scale*(succHyp->GetScore() - currHyp->GetScore()), succHyp->GetCurrTargetPhrase());
           succEdges.push_back(succWinningEdge);
-          survivingHyps.insert(succHyp);
           ++numEdgesCreated;
         }
 
@@ -257,16 +257,13 @@ void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const
     }
   }
 
-  connectedHyp.clear();
-  for (set <const Hypothesis*>::iterator it =  survivingHyps.begin(); it != survivingHyps.end(); ++it) {
-    connectedHyp.push_back(*it);
-  }
+  connectedHyp.swap(survivingList);
 
   VERBOSE(2, "Done! Num edges created : "<< numEdgesCreated << ", numEdges wanted " << numEdgesTotal << endl)
 
   IFVERBOSE(3) {
     cerr << "Surviving hyps: " ;
-    for (set <const Hypothesis*>::iterator it =  survivingHyps.begin(); it != survivingHyps.end(); ++it) {
+    for (Lattice::const_iterator it = connectedHyp.begin(); it != connectedHyp.end(); ++it) {
       cerr << (*it)->GetId() << " ";
     }
     cerr << endl;
@@ -275,203 +272,310 @@ void pruneLatticeFB(Lattice & connectedHyp, map < const Hypothesis*, set <const
 
 }
 
-void calcNgramExpectations(Lattice & connectedHyp, map<const Hypothesis*, vector<Edge> >& incomingEdges,
-                           map<Phrase, float>& finalNgramScores, bool posteriors)
+const size_t FlatLattice::kMaxNgramOrder;
+
+void FlatLattice::Scratch::Add(uint32_t ngram, float score)
 {
+  if (nodeStamp[ngram] != node) {
+    nodeStamp[ngram] = node;
+    scores[ngram] = score;
+    touched.push_back(ngram);
+  } else {
+    scores[ngram] = log_sum(score, scores[ngram]);
+  }
+}
 
-  sort(connectedHyp.begin(),connectedHyp.end(),ascendingCoverageCmp); //sort by increasing source word cov
+FlatLattice::FlatLattice()
+  : m_wordsCovered(0), m_paths(0), m_posteriors(true)
+{
+  UTIL_THROW_IF2(bleu_order > kMaxNgramOrder, "Lattice MBR supports n-grams of up to " << kMaxNgramOrder << " words");
+  m_levels.resize(2, 0);
+  m_edgeBegin.push_back(0);
+  m_occurrenceBegin.push_back(0);
+}
 
-  /*cerr << "Lattice:" << endl;
-  for (Lattice::const_iterator i = connectedHyp.begin(); i != connectedHyp.end(); ++i) {
-      const Hypothesis* h = *i;
-      cerr << *h << endl;
-      const vector<Edge>& edges = incomingEdges[h];
-      for (size_t e = 0; e < edges.size(); ++e) {
-          cerr << edges[e];
-      }
-  }*/
+void FlatLattice::AddNode(size_t wordsCovered, bool complete)
+{
+  if (!m_complete.empty() && wordsCovered != m_wordsCovered) {
+    m_levels.push_back(m_levels.back());
+  }
+  ++m_levels.back();
+  m_wordsCovered = wordsCovered;
+  m_complete.push_back(complete);
+  m_edgeBegin.push_back(m_edgeTail.size());
+}
 
-  map<const Hypothesis*, float> forwardScore;
-  forwardScore[connectedHyp[0]] = 0.0f; //forward score of hyp 0 is 1 (or 0 in logprob space)
-  set< const Hypothesis *> finalHyps; //store completed hyps
+void FlatLattice::AddEdge(size_t tail, float score, const Phrase& words)
+{
+  // Tails cover fewer source words than heads, so the n-grams of the edges
+  // into a tail are known before the edges leaving it are reached.
+  UTIL_THROW_IF2(tail >= m_levels[m_levels.size() - 2], "Lattice edge does not come from an earlier level");
+  m_edgeTail.push_back(tail);
+  m_edgeScore.push_back(score);
+  ++m_edgeBegin.back();
+  AddOccurrences(tail, score, words);
+  m_occurrenceBegin.push_back(m_occurrences.size());
+}
 
-  NgramScores ngramScores;//ngram scores for each hyp
+uint32_t FlatLattice::GetWordId(const Word& word)
+{
+  pair<boost::unordered_map<Word, uint32_t>::iterator, bool> inserted =
+    m_wordIds.insert(make_pair(word, static_cast<uint32_t>(m_words.size())));
+  if (inserted.second) {
+    m_words.push_back(word);
+  }
+  return inserted.first->second;
+}
 
-  for (size_t i = 1; i < connectedHyp.size(); ++i) {
-    const Hypothesis* currHyp = connectedHyp[i];
-    if (currHyp->GetWordsBitmap().IsComplete()) {
-      finalHyps.insert(currHyp);
-    }
+uint32_t FlatLattice::GetNgramId(const NgramKey& key)
+{
+  pair<boost::unordered_map<NgramKey, uint32_t>::iterator, bool> inserted =
+    m_ngramIds.insert(make_pair(key, static_cast<uint32_t>(m_ngrams.size())));
+  if (inserted.second) {
+    m_ngrams.push_back(key);
+  }
+  return inserted.first->second;
+}
 
-    VERBOSE(3, "Processing hyp: " << currHyp->GetId() << ", num words cov= " << currHyp->GetWordsBitmap().GetNumWordsCovered() <<  endl)
+void FlatLattice::AddOccurrences(uint32_t tail, float score, const Phrase& words)
+{
+  const size_t length = words.GetSize();
+  m_phraseIds.resize(length);
+  for (size_t i = 0; i < length; ++i) {
+    m_phraseIds[i] = GetWordId(words.GetWord(i));
+  }
 
-    vector <Edge> & edges = incomingEdges[currHyp];
-    for (size_t e = 0; e < edges.size(); ++e) {
-      const Edge& edge = edges[e];
-      if (forwardScore.find(currHyp) == forwardScore.end()) {
-        forwardScore[currHyp] = forwardScore[edge.GetTailNode()] + edge.GetScore();
-        VERBOSE(3, "Fwd score["<<currHyp->GetId()<<"] = fwdScore["<<edge.GetTailNode()->GetId() << "] + edge Score: " << edge.GetScore() << endl)
-      } else {
-        forwardScore[currHyp] = log_sum(forwardScore[currHyp], forwardScore[edge.GetTailNode()] + edge.GetScore());
-        VERBOSE(3, "Fwd score["<<currHyp->GetId()<<"] += fwdScore["<<edge.GetTailNode()->GetId() << "] + edge Score: " << edge.GetScore() << endl)
-      }
+  //Extract the n-grams local to this edge
+  const size_t first = m_occurrences.size();
+  const uint32_t local = m_paths++;
+  NgramKey key;
+  for (size_t start = 0; start < length; ++start) {
+    key.size = 0;
+    for (size_t end = start; end < length && end < start + bleu_order; ++end) {
+      key.words[key.size++] = m_phraseIds[end];
+      m_occurrences.push_back(NgramOccurrence(GetNgramId(key), local, tail, score, 1, end + 1 == length));
     }
+  }
 
-    //Process ngrams now
-    for (size_t j =0 ; j < edges.size(); ++j) {
-      Edge& edge = edges[j];
-      const NgramHistory & incomingPhrases = edge.GetNgrams(incomingEdges);
-
-      //let's first score ngrams introduced by this edge
-      for (NgramHistory::const_iterator it = incomingPhrases.begin(); it != incomingPhrases.end(); ++it) {
-        const Phrase& ngram = it->first;
-        const PathCounts& pathCounts = it->second;
-        VERBOSE(4, "Calculating score for: " << it->first << endl)
-
-        for (PathCounts::const_iterator pathCountIt = pathCounts.begin(); pathCountIt != pathCounts.end(); ++pathCountIt) {
-          //Score of an n-gram is forward score of head node of leftmost edge + all edge scores
-          const Path&  path = pathCountIt->first;
-          //cerr << "path count for " << ngram << " is " << pathCountIt->second << endl;
-          float score = forwardScore[path[0]->GetTailNode()];
-          for (size_t i = 0; i < path.size(); ++i) {
-            score += path[i]->GetScore();
-          }
-          //if we're doing expectations, then the number of times the ngram
-          //appears on the path is relevant.
-          size_t count = posteriors ? 1 : pathCountIt->second;
-          for (size_t k = 0; k < count; ++k) {
-            ngramScores.addScore(currHyp,ngram,score);
-          }
-        }
+  //add the ngrams straddling prev and curr edge: those of the incoming
+  //edges of the tail that end at the end of their edge
+  boost::unordered_map<uint32_t, uint32_t> paths;
+  for (size_t edge = m_edgeBegin[tail]; edge < m_edgeBegin[tail + 1]; ++edge) {
+    for (size_t i = m_occurrenceBegin[edge]; i < m_occurrenceBegin[edge + 1]; ++i) {
+      const NgramOccurrence incoming = m_occurrences[i];
+      if (incoming.extendable == 0) continue;
+      const uint32_t path = paths.insert(make_pair(incoming.path, m_paths)).first->second;
+      if (path == m_paths) ++m_paths;
+      key = m_ngrams[incoming.ngram];
+      for (size_t j = 0; j < length && key.size < bleu_order; ++j) {
+        key.words[key.size++] = m_phraseIds[j];
+        m_occurrences.push_back(NgramOccurrence(GetNgramId(key), path, incoming.start, incoming.score + score,
+                                                incoming.extendable, j + 1 == length ? incoming.extendable : 0));
       }
+    }
+  }
 
-      //Now score ngrams that are just being propagated from the history
-      for (NgramScores::NodeScoreIterator it = ngramScores.nodeBegin(edge.GetTailNode());
-           it != ngramScores.nodeEnd(edge.GetTailNode()); ++it) {
-        const Phrase & currNgram = *(it->first);
-        float currNgramScore = it->second;
-        VERBOSE(4, "Calculating score for: " << currNgram << endl)
-
-        // For posteriors, don't double count ngrams
-        if (!posteriors || incomingPhrases.find(currNgram) == incomingPhrases.end()) {
-          float score = edge.GetScore() + currNgramScore;
-          ngramScores.addScore(currHyp,currNgram,score);
-        }
+  //an n-gram is counted once per path
+  if (m_occurrences.size() > first) {
+    sort(m_occurrences.begin() + first, m_occurrences.end());
+    size_t last = first;
+    for (size_t i = first + 1; i < m_occurrences.size(); ++i) {
+      if (m_occurrences[i].ngram == m_occurrences[last].ngram && m_occurrences[i].path == m_occurrences[last].path) {
+        m_occurrences[last].count += m_occurrences[i].count;
+        m_occurrences[last].extendable += m_occurrences[i].extendable;
+      } else {
+        m_occurrences[++last] = m_occurrences[i];
       }
-
     }
+    m_occurrences.erase(m_occurrences.begin() + last + 1, m_occurrences.end());
   }
+}
 
-  float Z = 9999999; //the total score of the lattice
+#ifdef WITH_THREADS
+namespace
+{
+boost::mutex scoringPoolMutex;
+ThreadPool* scoringPool = NULL;
 
-  //Done - Print out ngram posteriors for final hyps
-  for (set< const Hypothesis *>::iterator finalHyp = finalHyps.begin(); finalHyp != finalHyps.end(); ++finalHyp) {
-    const Hypothesis* hyp = *finalHyp;
+//! The pool scoring lattice levels for all sentences, with threads - 1
+//! workers as the calling thread takes a share itself. It is sized by the
+//! first lattice scored on several threads and kept until the process exits.
+ThreadPool& GetScoringPool(size_t threads)
+{
+  boost::mutex::scoped_lock lock(scoringPoolMutex);
+  if (!scoringPool) {
+    scoringPool = new ThreadPool(threads - 1);
+  }
+  return *scoringPool;
+}
+}
 
-    for (NgramScores::NodeScoreIterator it = ngramScores.nodeBegin(hyp); it != ngramScores.nodeEnd(hyp); ++it) {
-      const Phrase& ngram = *(it->first);
-      if (finalNgramScores.find(ngram) == finalNgramScores.end()) {
-        finalNgramScores[ngram] = it->second;
-      } else {
-        finalNgramScores[ngram] = log_sum(it->second,  finalNgramScores[ngram]);
-      }
-    }
+//! Every workers-th node of one level, from worker on
+class FlatLattice::LevelTask : public WaitableTask
+{
+public:
+  LevelTask(FlatLattice& lattice, size_t level, size_t worker, size_t workers, Scratch& scratch)
+    : m_lattice(lattice), m_level(level), m_worker(worker), m_workers(workers), m_scratch(scratch) {}
 
-    if (Z == 9999999) {
-      Z = forwardScore[hyp];
-    } else {
-      Z = log_sum(Z, forwardScore[hyp]);
-    }
+protected:
+  void DoRun() {
+    m_lattice.ScoreLevel(m_level, m_worker, m_workers, m_scratch);
   }
 
-  //Z *= scale;  //scale the score
+private:
+  FlatLattice& m_lattice;
+  size_t m_level;
+  size_t m_worker;
+  size_t m_workers;
+  Scratch& m_scratch;
+};
+#endif
 
-  for (map<Phrase, float>::iterator finalScoresIt = finalNgramScores.begin();  finalScoresIt != finalNgramScores.end(); ++finalScoresIt) {
-    finalScoresIt->second =  finalScoresIt->second - Z;
-    IFVERBOSE(2) {
-      VERBOSE(2,finalScoresIt->first << " [" << finalScoresIt->second << "]" << endl);
+void FlatLattice::Score(bool posteriors, size_t threads)
+{
+  m_posteriors = posteriors;
+  m_forward.assign(m_complete.size(), 0.0f); //forward score of hyp 0 is 1 (or 0 in logprob space)
+  m_nodeScores.assign(m_complete.size(), vector<pair<uint32_t, float> >());
+
+  size_t widest = 0;
+  for (size_t level = 0; level + 1 < m_levels.size(); ++level) {
+    widest = max(widest, m_levels[level + 1] - m_levels[level]);
+  }
+  threads = max<size_t>(1, min(threads, widest));
+  vector<Scratch> scratch(threads, Scratch(m_ngrams.size()));
+
+#ifdef WITH_THREADS
+  ThreadPool* pool = threads > 1 ? &GetScoringPool(threads) : NULL;
+#endif
+  for (size_t level = 0; level + 1 < m_levels.size(); ++level) {
+#ifdef WITH_THREADS
+    const size_t workers = min(threads, m_levels[level + 1] - m_levels[level]);
+    if (pool && workers > 1) {
+      vector<boost::shared_ptr<LevelTask> > tasks;
+      for (size_t worker = 1; worker < workers; ++worker) {
+        tasks.push_back(boost::shared_ptr<LevelTask>(new LevelTask(*this, level, worker, workers, scratch[worker])));
+        pool->Submit(tasks.back());
+      }
+      ScoreLevel(level, 0, workers, scratch[0]);
+      for (size_t i = 0; i < tasks.size(); ++i) {
+        tasks[i]->Wait();
+      }
+      continue;
     }
+#endif
+    ScoreLevel(level, 0, 1, scratch[0]);
   }
+}
 
+void FlatLattice::ScoreLevel(size_t level, size_t worker, size_t workers, Scratch& scratch)
+{
+  for (size_t node = m_levels[level] + worker; node < m_levels[level + 1]; node += workers) {
+    ScoreNode(node, scratch);
+  }
 }
 
-const NgramHistory& Edge::GetNgrams(map<const Hypothesis*, vector<Edge> > & incomingEdges)
+void FlatLattice::ScoreNode(size_t node, Scratch& scratch)
 {
+  const size_t begin = m_edgeBegin[node];
+  const size_t end = m_edgeBegin[node + 1];
+  for (size_t edge = begin; edge < end; ++edge) {
+    const float score = m_forward[m_edgeTail[edge]] + m_edgeScore[edge];
+    m_forward[node] = edge == begin ? score : log_sum(m_forward[node], score);
+  }
 
-  if (m_ngrams.size() > 0)
-    return m_ngrams;
+  ++scratch.node;
+  scratch.touched.clear();
+  for (size_t edge = begin; edge < end; ++edge) {
+    //let's first score ngrams introduced by this edge. Score of an n-gram
+    //is forward score of the node its path leaves from + all edge scores.
+    ++scratch.edge;
+    for (size_t i = m_occurrenceBegin[edge]; i < m_occurrenceBegin[edge + 1]; ++i) {
+      const NgramOccurrence& occurrence = m_occurrences[i];
+      scratch.edgeStamp[occurrence.ngram] = scratch.edge;
+      float score = m_forward[occurrence.start] + occurrence.score;
+      //if we're doing expectations, then the number of times the ngram
+      //appears on the path is relevant.
+      if (!m_posteriors && occurrence.count > 1) {
+        score += log(static_cast<float>(occurrence.count));
+      }
+      scratch.Add(occurrence.ngram, score);
+    }
 
-  const Phrase& currPhrase = GetWords();
-  //Extract the n-grams local to this edge
-  for (size_t start = 0; start < currPhrase.GetSize(); ++start) {
-    for (size_t end = start; end < start + bleu_order; ++end) {
-      if (end < currPhrase.GetSize()) {
-        Phrase edgeNgram(end-start+1);
-        for (size_t index = start; index <= end; ++index) {
-          edgeNgram.AddWord(currPhrase.GetWord(index));
-        }
-        //cout << "Inserting Phrase : " << edgeNgram << endl;
-        vector<const Edge*> edgeHistory;
-        edgeHistory.push_back(this);
-        storeNgramHistory(edgeNgram, edgeHistory);
-      } else {
-        break;
+    //Now score ngrams that are just being propagated from the history
+    const vector<pair<uint32_t, float> >& history = m_nodeScores[m_edgeTail[edge]];
+    for (vector<pair<uint32_t, float> >::const_iterator it = history.begin(); it != history.end(); ++it) {
+      // For posteriors, don't double count ngrams
+      if (!m_posteriors || scratch.edgeStamp[it->first] != scratch.edge) {
+        scratch.Add(it->first, m_edgeScore[edge] + it->second);
       }
     }
   }
 
-  map<const Hypothesis*, vector<Edge> >::iterator it = incomingEdges.find(m_tailNode);
-  if (it != incomingEdges.end()) { //node has incoming edges
-    vector<Edge> & inEdges = it->second;
-
-    for (vector<Edge>::iterator edge = inEdges.begin(); edge != inEdges.end(); ++edge) {//add the ngrams straddling prev and curr edge
-      const NgramHistory & edgeIncomingNgrams = edge->GetNgrams(incomingEdges);
-      for (NgramHistory::const_iterator edgeInNgramHist = edgeIncomingNgrams.begin(); edgeInNgramHist != edgeIncomingNgrams.end(); ++edgeInNgramHist) {
-        const Phrase& edgeIncomingNgram = edgeInNgramHist->first;
-        const PathCounts &  edgeIncomingNgramPaths = edgeInNgramHist->second;
-        size_t back = min(edgeIncomingNgram.GetSize(), edge->GetWordsSize());
-        const Phrase&  edgeWords = edge->GetWords();
-        IFVERBOSE(3) {
-          cerr << "Edge: "<< *edge <<endl;
-          cerr << "edgeWords: " << edgeWords << endl;
-          cerr << "edgeInNgram: " << edgeIncomingNgram << endl;
-        }
+  vector<pair<uint32_t, float> >& scores = m_nodeScores[node];
+  scores.reserve(scratch.touched.size());
+  for (vector<uint32_t>::const_iterator it = scratch.touched.begin(); it != scratch.touched.end(); ++it) {
+    scores.push_back(make_pair(*it, scratch.scores[*it]));
+  }
+}
 
-        Phrase edgeSuffix(ARRAY_SIZE_INCR);
-        Phrase ngramSuffix(ARRAY_SIZE_INCR);
-        GetPhraseSuffix(edgeWords,back,edgeSuffix);
-        GetPhraseSuffix(edgeIncomingNgram,back,ngramSuffix);
+void FlatLattice::GetFinalScores(map<Phrase, float>& finalNgramScores) const
+{
+  vector<float> scores(m_ngrams.size());
+  vector<bool> seen(m_ngrams.size(), false);
+  float Z = 0; //the total score of the lattice
+  bool complete = false;
+
+  for (size_t node = 0; node < m_complete.size(); ++node) {
+    if (!m_complete[node]) continue;
+    const vector<pair<uint32_t, float> >& nodeScores = m_nodeScores[node];
+    for (vector<pair<uint32_t, float> >::const_iterator it = nodeScores.begin(); it != nodeScores.end(); ++it) {
+      scores[it->first] = seen[it->first] ? log_sum(it->second, scores[it->first]) : it->second;
+      seen[it->first] = true;
+    }
+    Z = complete ? log_sum(Z, m_forward[node]) : m_forward[node];
+    complete = true;
+  }
 
-        if (ngramSuffix == edgeSuffix) { //we've got the suffix of previous edge
-          size_t  edgeInNgramSize =  edgeIncomingNgram.GetSize();
+  for (size_t ngram = 0; ngram < m_ngrams.size(); ++ngram) {
+    if (!seen[ngram]) continue;
+    const NgramKey& key = m_ngrams[ngram];
+    Phrase phrase(key.size);
+    for (size_t i = 0; i < key.size; ++i) {
+      phrase.AddWord(m_words[key.words[i]]);
+    }
+    finalNgramScores[phrase] = scores[ngram] - Z;
+  }
+}
 
-          for (size_t i = 0; i < GetWordsSize() && i + edgeInNgramSize < bleu_order ; ++i) {
-            Phrase newNgram(edgeIncomingNgram);
-            for (size_t j = 0; j <= i ; ++j) {
-              newNgram.AddWord(GetWords().GetWord(j));
-            }
-            VERBOSE(3, "Inserting New Phrase : " << newNgram << endl)
+void calcNgramExpectations(Lattice & connectedHyp, map<const Hypothesis*, vector<Edge> >& incomingEdges,
+                           map<Phrase, float>& finalNgramScores, bool posteriors, size_t threads)
+{
+  stable_sort(connectedHyp.begin(),connectedHyp.end(),ascendingCoverageCmp); //sort by increasing source word cov
 
-            for (PathCounts::const_iterator pathIt = edgeIncomingNgramPaths.begin(); pathIt !=  edgeIncomingNgramPaths.end(); ++pathIt) {
-              Path newNgramPath = pathIt->first;
-              newNgramPath.push_back(this);
-              storeNgramHistory(newNgram, newNgramPath, pathIt->second);
-            }
-          }
-        }
+  FlatLattice lattice;
+  boost::unordered_map<const Hypothesis*, size_t> nodeIds;
+  for (size_t i = 0; i < connectedHyp.size(); ++i) {
+    const Hypothesis* currHyp = connectedHyp[i];
+    nodeIds[currHyp] = i;
+    lattice.AddNode(currHyp->GetWordsBitmap().GetNumWordsCovered(), currHyp->GetWordsBitmap().IsComplete());
+
+    map<const Hypothesis*, vector<Edge> >::const_iterator edges = incomingEdges.find(currHyp);
+    if (edges == incomingEdges.end()) continue;
+    for (vector<Edge>::const_iterator edge = edges->second.begin(); edge != edges->second.end(); ++edge) {
+      boost::unordered_map<const Hypothesis*, size_t>::const_iterator tail = nodeIds.find(edge->GetTailNode());
+      if (tail != nodeIds.end()) {
+        lattice.AddEdge(tail->second, edge->GetScore(), edge->GetWords());
       }
     }
   }
-  return m_ngrams;
-}
 
-//Add the last lastN words of origPhrase to targetPhrase
-void Edge::GetPhraseSuffix(const Phrase&  origPhrase, size_t lastN, Phrase& targetPhrase) const
-{
-  size_t origSize = origPhrase.GetSize();
-  size_t startIndex = origSize - lastN;
-  for (size_t index = startIndex; index < origPhrase.GetSize(); ++index) {
-    targetPhrase.AddWord(origPhrase.GetWord(index));
+  lattice.Score(posteriors, threads);
+  lattice.GetFinalScores(finalNgramScores);
+
+  IFVERBOSE(2) {
+    for (map<Phrase, float>::const_iterator finalScoresIt = finalNgramScores.begin();  finalScoresIt != finalNgramScores.end(); ++finalScoresIt) {
+      VERBOSE(2,finalScoresIt->first << " [" << finalScoresIt->second << "]" << endl);
+    }
   }
 }
 
@@ -493,7 +597,7 @@ ostream& operator<< (ostream& out, const Edge& edge)
   out << "Head: " << edge.m_headNode->GetId()
       << ", Tail: " << edge.m_tailNode->GetId()
       << ", Score: " << edge.m_score
-      << ", Phrase: " << edge.m_targetPhrase << endl;
+      << ", Phrase: " << edge.m_words << endl;
   return out;
 }
 
@@ -519,7 +623,7 @@ void getLatticeMBRNBest(const Manager& manager, const TrellisPathList& nBestList
   MBR_Options  const& mbr  = manager.options()->mbr;
   pruneLatticeFB(connectedList, outgoingHyps, incomingEdges, estimatedScores,
                  manager.GetBestHypothesis(), lmbr.pruning_factor, mbr.scale);
-  calcNgramExpectations(connectedList, incomingEdges, ngramPosteriors,true);
+  calcNgramExpectations(connectedList, incomingEdges, ngramPosteriors, true, lmbr.threads);
 
   vector<float> mbrThetas = lmbr.theta;
   float p = lmbr.precision;
@@ -581,7 +685,7 @@ const TrellisPath doConsensusDecoding(const Manager& manager, const TrellisPathL
   MBR_Options  const&  mbr = manager.options()->mbr;
   pruneLatticeFB(connectedList, outgoingHyps, incomingEdges, estimatedScores,
                  manager.GetBestHypothesis(), lmbr.pruning_factor, mbr.scale);
-  calcNgramExpectations(connectedList, incomingEdges, ngramExpectations,false);
+  calcNgramExpectations(connectedList, incomingEdges, ngramExpectations, false, lmbr.threads);
 
   //expected length is sum of expected unigram counts
   //cerr << "Thread " << pthread_self() <<  " Ngram expectations size: " << ngramExpectations.size() << endl;
@@ -10,12 +10,16 @@
 #ifndef moses_cmd_LatticeMBR_h
 #define moses_cmd_LatticeMBR_h
 
+#include <algorithm>
 #include <map>
 #include <vector>
 #include <set>
+#include <stdint.h>
+#include <boost/unordered_map.hpp>
 #include "moses/Hypothesis.h"
 #include "moses/Manager.h"
 #include "moses/TrellisPathList.h"
+#include "util/murmur_hash.hh"
 
 
 
@@ -25,21 +29,17 @@ namespace Moses
 class Edge;
 
 typedef std::vector< const Moses::Hypothesis *> Lattice;
-typedef std::vector<const Edge*> Path;
-typedef std::map<Path, size_t> PathCounts;
-typedef std::map<Moses::Phrase, PathCounts > NgramHistory;
 
 class Edge
 {
   const Moses::Hypothesis* m_tailNode;
   const Moses::Hypothesis* m_headNode;
   float m_score;
-  Moses::TargetPhrase m_targetPhrase;
-  NgramHistory m_ngrams;
+  Moses::Phrase m_words;
 
 public:
-  Edge(const Moses::Hypothesis* from, const Moses::Hypothesis* to, float score, const Moses::TargetPhrase& targetPhrase) : m_tailNode(from), m_headNode(to), m_score(score), m_targetPhrase(targetPhrase) {
-    //cout << "Creating new edge from Node " << from->GetId() << ", to Node : " << to->GetId() << ", score: " << score << " phrase: " << targetPhrase << endl;
+  Edge(const Moses::Hypothesis* from, const Moses::Hypothesis* to, float score, const Moses::Phrase& words) : m_tailNode(from), m_headNode(to), m_score(score), m_words(words) {
+    //cout << "Creating new edge from Node " << from->GetId() << ", to Node : " << to->GetId() << ", score: " << score << " phrase: " << words << endl;
   }
 
   const Moses::Hypothesis* GetHeadNode() const {
@@ -55,48 +55,127 @@ public:
   }
 
   size_t GetWordsSize() const {
-    return m_targetPhrase.GetSize();
+    return m_words.GetSize();
   }
 
   const Moses::Phrase& GetWords() const {
-    return m_targetPhrase;
+    return m_words;
   }
 
   friend std::ostream& operator<< (std::ostream& out, const Edge& edge);
 
-  const NgramHistory&  GetNgrams(  std::map<const Moses::Hypothesis*, std::vector<Edge> > & incomingEdges) ;
-
   bool operator < (const Edge & compare) const;
 
-  void GetPhraseSuffix(const Moses::Phrase& origPhrase, size_t lastN, Moses::Phrase& targetPhrase) const;
-
-  void storeNgramHistory(const Moses::Phrase& phrase, Path & path, size_t count = 1) {
-    m_ngrams[phrase][path]+= count;
-  }
-
 };
 
 /**
-* Data structure to hold the ngram scores as we traverse the lattice. Maps (hypo,ngram) to score
-*/
-class NgramScores
+ * The pruned search graph in flat arrays, for computing n-gram posteriors
+ * and expectations: nodes in order of source coverage, the incoming edges of
+ * each node stored together, and words and n-grams interned to dense ids.
+ *
+ * The forward pass keeps one vector of (n-gram, score) pairs per node and
+ * accumulates into a dense array, instead of maps keyed by hypotheses and
+ * phrases. Nodes covering the same number of source words do not depend on
+ * each other, so the nodes of each such level can be scored on several
+ * threads: the calling thread and a thread pool shared by all lattices,
+ * which is created the first time a lattice is scored on several threads.
+ */
+class FlatLattice
 {
 public:
-  NgramScores() {}
+  FlatLattice();
 
-  /** logsum this score to the existing score */
-  void addScore(const Moses::Hypothesis* node, const Moses::Phrase& ngram, float score);
+  //! Add a node. Nodes are added in order of source coverage, starting with
+  //! the empty hypothesis.
+  void AddNode(size_t wordsCovered, bool complete);
 
-  /** Iterate through ngrams for selected node */
-  typedef std::map<const Moses::Phrase*, float>::const_iterator NodeScoreIterator;
-  NodeScoreIterator nodeBegin(const Moses::Hypothesis* node);
-  NodeScoreIterator nodeEnd(const Moses::Hypothesis* node);
+  //! Add an edge from an earlier node to the last node added
+  void AddEdge(size_t tail, float score, const Moses::Phrase& words);
+
+  void Score(bool posteriors, size_t threads);
+
+  //! log posteriors (or expectations) of the n-grams on complete paths
+  void GetFinalScores(std::map<Moses::Phrase, float>& finalNgramScores) const;
 
 private:
-  std::set<Moses::Phrase> m_ngrams;
-  std::map<const Moses::Hypothesis*, std::map<const Moses::Phrase*, float> > m_scores;
-};
+  static const size_t kMaxNgramOrder = 4;
+
+  //! An n-gram as interned word ids
+  struct NgramKey {
+    uint32_t words[kMaxNgramOrder];
+    uint32_t size;
+
+    bool operator==(const NgramKey& other) const {
+      return size == other.size && std::equal(words, words + size, other.words);
+    }
+
+    friend size_t hash_value(const NgramKey& key) {
+      return util::MurmurHashNative(key.words, key.size * sizeof(uint32_t), key.size);
+    }
+  };
+
+  //! The occurrences of an n-gram on one path through the lattice, stored
+  //! with the last edge of the path
+  struct NgramOccurrence {
+    uint32_t ngram;
+    uint32_t path; //!< the edges of the path, as an id
+    uint32_t start; //!< node the path leaves from
+    float score; //!< sum of the edge scores along the path
+    uint32_t count; //!< times the n-gram occurs on the path
+    uint32_t extendable; //!< how many of those end where the path ends
+
+    NgramOccurrence(uint32_t ngram, uint32_t path, uint32_t start, float score, uint32_t count, uint32_t extendable)
+      : ngram(ngram), path(path), start(start), score(score), count(count), extendable(extendable) {}
+
+    bool operator<(const NgramOccurrence& other) const {
+      return ngram < other.ngram || (ngram == other.ngram && path < other.path);
+    }
+  };
+
+  //! Per thread accumulator of the scores of one node
+  struct Scratch {
+    explicit Scratch(size_t ngrams)
+      : scores(ngrams), nodeStamp(ngrams, 0), edgeStamp(ngrams, 0), node(0), edge(0) {}
+
+    void Add(uint32_t ngram, float score);
+
+    std::vector<float> scores;
+    std::vector<size_t> nodeStamp; //!< node on which the n-gram was last scored
+    std::vector<size_t> edgeStamp; //!< edge which last introduced the n-gram
+    size_t node;
+    size_t edge;
+    std::vector<uint32_t> touched;
+  };
+
+  uint32_t GetWordId(const Moses::Word& word);
+  uint32_t GetNgramId(const NgramKey& key);
+  void AddOccurrences(uint32_t tail, float score, const Moses::Phrase& words);
+  void ScoreLevel(size_t level, size_t worker, size_t workers, Scratch& scratch);
+#ifdef WITH_THREADS
+  class LevelTask;
+#endif
+  void ScoreNode(size_t node, Scratch& scratch);
+
+  std::vector<bool> m_complete; //!< whether each node covers the whole input
+  size_t m_wordsCovered; //!< by the last node added
+  std::vector<size_t> m_levels; //!< first node of each coverage level, and the end
+  std::vector<size_t> m_edgeBegin; //!< first incoming edge of each node, and the end
+  std::vector<uint32_t> m_edgeTail;
+  std::vector<float> m_edgeScore;
+  std::vector<size_t> m_occurrenceBegin; //!< first occurrence of each edge, and the end
+  std::vector<NgramOccurrence> m_occurrences;
+  uint32_t m_paths; //!< number of path ids given out
+  std::vector<uint32_t> m_phraseIds;
+
+  boost::unordered_map<Moses::Word, uint32_t> m_wordIds;
+  std::vector<Moses::Word> m_words;
+  boost::unordered_map<NgramKey, uint32_t> m_ngramIds;
+  std::vector<NgramKey> m_ngrams;
 
+  bool m_posteriors;
+  std::vector<float> m_forward;
+  std::vector<std::vector<std::pair<uint32_t, float> > > m_nodeScores;
+};
 
 /** Holds a lattice mbr solution, and its scores */
 class LatticeMBRSolution
@@ -139,8 +218,9 @@ void pruneLatticeFB(Lattice & connectedHyp, std::map < const Moses::Hypothesis*,
 //Use the ngram scores to rerank the nbest list, return at most n solutions
 void getLatticeMBRNBest(const Moses::Manager& manager, const Moses::TrellisPathList& nBestList, std::vector<LatticeMBRSolution>& solutions, size_t n);
 //calculate expectated ngram counts, clipping at 1 (ie calculating posteriors) if posteriors==true.
+//Nodes with the same source coverage are scored on up to threads threads.
 void calcNgramExpectations(Lattice & connectedHyp, std::map<const Moses::Hypothesis*, std::vector<Edge> >& incomingEdges, std::map<Moses::Phrase,
-                           float>& finalNgramScores, bool posteriors);
+                           float>& finalNgramScores, bool posteriors, size_t threads = 1);
 void GetOutputFactors(const Moses::TrellisPath &path, std::vector <Moses::Word> &translation);
 void extract_ngrams(const std::vector<Moses::Word >& sentence, std::map < Moses::Phrase, int >  & allngrams);
 bool ascendingCoverageCmp(const Moses::Hypothesis* a, const Moses::Hypothesis* b);
@@ -0,0 +1,145 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2010 University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "FactorCollection.h"
+#include "LatticeMBR.h"
+#include "Util.h"
+
+using namespace Moses;
+using namespace std;
+
+namespace
+{
+
+Phrase MakePhrase(const string& words)
+{
+  vector<string> tokens = Tokenize(words);
+  Phrase phrase(tokens.size());
+  for (vector<string>::const_iterator token = tokens.begin(); token != tokens.end(); ++token) {
+    Word word;
+    word.SetFactor(0, FactorCollection::Instance().AddFactor(*token));
+    phrase.AddWord(word);
+  }
+  return phrase;
+}
+
+/**
+ * Two paths, each through three edges:
+ *
+ *   0 --b (0.75)--> 1 --a b a--> 3 --c--> 4
+ *   0 --x (0.25)--> 2 --a b a--> 3
+ *
+ * so "b a b a c" has probability 0.75 and "x a b a c" 0.25.
+ */
+void MakeLattice(FlatLattice& lattice)
+{
+  lattice.AddNode(0, false);
+  lattice.AddNode(1, false);
+  lattice.AddEdge(0, log(0.75f), MakePhrase("b"));
+  lattice.AddNode(1, false);
+  lattice.AddEdge(0, log(0.25f), MakePhrase("x"));
+  lattice.AddNode(4, false);
+  lattice.AddEdge(1, 0.0f, MakePhrase("a b a"));
+  lattice.AddEdge(2, 0.0f, MakePhrase("a b a"));
+  lattice.AddNode(5, true);
+  lattice.AddEdge(3, 0.0f, MakePhrase("c"));
+}
+
+float Score(const map<Phrase, float>& scores, const string& ngram)
+{
+  map<Phrase, float>::const_iterator it = scores.find(MakePhrase(ngram));
+  BOOST_REQUIRE_MESSAGE(it != scores.end(), "no score for " << ngram);
+  return exp(it->second);
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(lattice_mbr)
+
+BOOST_AUTO_TEST_CASE(ngram_posteriors)
+{
+  FlatLattice lattice;
+  MakeLattice(lattice);
+  lattice.Score(true, 1);
+  map<Phrase, float> scores;
+  lattice.GetFinalScores(scores);
+
+  BOOST_CHECK_CLOSE(Score(scores, "c"), 1.0f, 1e-3);
+  BOOST_CHECK_CLOSE(Score(scores, "a"), 1.0f, 1e-3);
+  BOOST_CHECK_CLOSE(Score(scores, "a c"), 1.0f, 1e-3);
+  BOOST_CHECK_CLOSE(Score(scores, "b a b"), 0.75f, 1e-3);
+  BOOST_CHECK_CLOSE(Score(scores, "x a b a"), 0.25f, 1e-3);
+  // As in the map based implementation, the two occurrences of "b a" on
+  // the first path are both counted.
+  BOOST_CHECK_CLOSE(Score(scores, "b a"), 1.75f, 1e-3);
+  // Only the "b a" at the end of the middle edge is extended by "c", not
+  // the one straddling the first two edges.
+  BOOST_CHECK_CLOSE(Score(scores, "b a c"), 1.0f, 1e-3);
+}
+
+BOOST_AUTO_TEST_CASE(ngram_expectations)
+{
+  FlatLattice lattice;
+  MakeLattice(lattice);
+  lattice.Score(false, 1);
+  map<Phrase, float> scores;
+  lattice.GetFinalScores(scores);
+
+  BOOST_CHECK_CLOSE(Score(scores, "c"), 1.0f, 1e-3);
+  BOOST_CHECK_CLOSE(Score(scores, "a"), 2.0f, 1e-3);
+  BOOST_CHECK_CLOSE(Score(scores, "b a"), 1.75f, 1e-3);
+  BOOST_CHECK_CLOSE(Score(scores, "b a b"), 0.75f, 1e-3);
+  BOOST_CHECK_CLOSE(Score(scores, "x a"), 0.25f, 1e-3);
+  // "a c" is extended from the last "a" of the middle edge only.
+  BOOST_CHECK_CLOSE(Score(scores, "a c"), 1.0f, 1e-3);
+  BOOST_CHECK_CLOSE(Score(scores, "b a c"), 1.0f, 1e-3);
+}
+
+BOOST_AUTO_TEST_CASE(threads)
+{
+  for (int posteriors = 0; posteriors < 2; ++posteriors) {
+    FlatLattice single;
+    MakeLattice(single);
+    single.Score(posteriors, 1);
+    map<Phrase, float> expected;
+    single.GetFinalScores(expected);
+
+    FlatLattice threaded;
+    MakeLattice(threaded);
+    threaded.Score(posteriors, 2);
+    map<Phrase, float> actual;
+    threaded.GetFinalScores(actual);
+
+    BOOST_REQUIRE_EQUAL(actual.size(), expected.size());
+    for (map<Phrase, float>::const_iterator it = expected.begin(); it != expected.end(); ++it) {
+      map<Phrase, float>::const_iterator found = actual.find(it->first);
+      BOOST_REQUIRE(found != actual.end());
+      BOOST_CHECK_CLOSE(exp(found->second), exp(it->second), 1e-3);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -838,27 +838,24 @@ OutputFeatureValuesForSLF(size_t index, bool zeros, const Hypothesis* hypo,
   return index + numScoreComps;
 }
 
-/**! Output search graph in hypergraph format of Kenneth Heafield's lazy hypergraph decoder */
+/**! Number the search graph as a hypergraph: nodes in topological order, arcs grouped by the node they end at, and a unique end node */
 void
 Manager::
-OutputSearchGraphAsHypergraph(std::ostream &outputSearchGraphStream) const
+GetSearchGraphAsHypergraph(vector<SearchGraphNode>& searchGraph,
+                           map<int,int>& mosesIDToHypergraphID,
+                           set<int>& terminalNodes,
+                           multimap<int,int>& hypergraphIDToArcs,
+                           long& endNode) const
 {
 
   VERBOSE(2,"Getting search graph to output as hypergraph for sentence " << m_source.GetTranslationId() << std::endl)
 
-  vector<SearchGraphNode> searchGraph;
   GetSearchGraph(searchGraph);
 
-
-  map<int,int> mosesIDToHypergraphID;
   // map<int,int> hypergraphIDToMosesID;
-  set<int> terminalNodes;
-  multimap<int,int> hypergraphIDToArcs;
 
   VERBOSE(2,"Gathering information about search graph to output as hypergraph for sentence " << m_source.GetTranslationId() << std::endl)
 
-  long numNodes = 0;
-  long endNode = 0;
   {
     long hypergraphHypothesisID = 0;
     for (size_t arcNumber = 0, size=searchGraph.size(); arcNumber < size; ++arcNumber) {
@@ -904,9 +901,22 @@ OutputSearchGraphAsHypergraph(std::ostream &outputSearchGraphStream) const
     // Unique end node
     endNode = hypergraphHypothesisID;
     //    mosesIDToHypergraphID[hypergraphHypothesisID] = hypergraphHypothesisID;
-    numNodes = endNode + 1;
 
   }
+}
+
+/**! Output search graph in hypergraph format of Kenneth Heafield's lazy hypergraph decoder */
+void
+Manager::
+OutputSearchGraphAsHypergraph(std::ostream &outputSearchGraphStream) const
+{
+  vector<SearchGraphNode> searchGraph;
+  map<int,int> mosesIDToHypergraphID;
+  set<int> terminalNodes;
+  multimap<int,int> hypergraphIDToArcs;
+  long endNode = 0;
+  GetSearchGraphAsHypergraph(searchGraph, mosesIDToHypergraphID, terminalNodes, hypergraphIDToArcs, endNode);
+  long numNodes = endNode + 1;
 
 
   long numArcs = searchGraph.size() + terminalNodes.size();
@@ -993,6 +1003,65 @@ OutputSearchGraphAsHypergraph(std::ostream &outputSearchGraphStream) const
 }
 
 
+/**! Output the same hypergraph in the binary format of BinaryHypergraphWriter */
+void
+Manager::
+OutputSearchGraphAsBinaryHypergraph(BinaryHypergraphWriter& out) const
+{
+  vector<SearchGraphNode> searchGraph;
+  map<int,int> mosesIDToHypergraphID;
+  set<int> terminalNodes;
+  multimap<int,int> hypergraphIDToArcs;
+  long endNode = 0;
+  GetSearchGraphAsHypergraph(searchGraph, mosesIDToHypergraphID, terminalNodes, hypergraphIDToArcs, endNode);
+
+  for (int hypergraphHypothesisID=0; hypergraphHypothesisID < endNode; hypergraphHypothesisID+=1) {
+    // Nodes without incoming arcs are not written, as in the text format
+    pair<multimap<int,int>::iterator, multimap<int,int>::iterator> range =
+      hypergraphIDToArcs.equal_range(hypergraphHypothesisID);
+    if (range.first == range.second) continue;
+    UTIL_THROW_IF2(out.VertexSize() != static_cast<size_t>(hypergraphHypothesisID),
+                   "Error while writing search lattice as hypergraph for sentence " << m_source.GetTranslationId() << ". "
+                   << "A node before " << hypergraphHypothesisID << " has no incoming arcs, which the binary hypergraph format cannot express.");
+    out.AddVertex();
+
+    for (multimap<int,int>::iterator it=range.first; it!=range.second; ++it) {
+      const Hypothesis *thisHypo = searchGraph[it->second].hypo;
+      const Hypothesis *prevHypo = thisHypo->GetPrevHypo();
+      if (prevHypo==NULL) {
+        out.AddWord("<s>");
+        out.EndEdge(0);
+      } else {
+        int startNode = mosesIDToHypergraphID[prevHypo->GetId()];
+        UTIL_THROW_IF2(
+          (startNode >= hypergraphHypothesisID),
+          "Error while writing search lattice as hypergraph for sentence" << m_source.GetTranslationId() << ". " <<
+          "The nodes must be output in topological order. The code attempted to violate this restriction."
+        );
+
+        out.AddChild(startNode);
+        const TargetPhrase &targetPhrase = thisHypo->GetCurrTargetPhrase();
+        for (size_t targetWordIndex=0; targetWordIndex<targetPhrase.GetSize(); targetWordIndex+=1) {
+          out.AddWord(targetPhrase.GetWord(targetWordIndex)[0]->GetString());
+        }
+        ScoreComponentCollection scores = thisHypo->GetScoreBreakdown();
+        scores.MinusEquals(prevHypo->GetScoreBreakdown());
+        out.AddFeatures(scores);
+        out.EndEdge(thisHypo->GetWordsBitmap().GetNumWordsCovered());
+      }
+    }
+  }
+
+  // Node and arc(s) for end of sentence </s>
+  out.AddVertex();
+  for (set<int>::iterator it=terminalNodes.begin(); it!=terminalNodes.end(); ++it) {
+    out.AddChild(*it);
+    out.AddWord("</s>");
+    out.EndEdge(GetSource().GetSize());
+  }
+}
+
+
 /**! Output search graph in HTK standard lattice format (SLF) */
 void Manager::OutputSearchGraphAsSLF(long translationId, std::ostream &outputSearchGraphStream) const
 {
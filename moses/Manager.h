@@ -108,6 +108,11 @@ private:
 
   // Helper functions to output search graph in the hypergraph format of Kenneth Heafield's lazy hypergraph decoder
   void OutputFeatureValuesForHypergraph(const Hypothesis* hypo, std::ostream &outputSearchGraphStream) const;
+  void GetSearchGraphAsHypergraph(std::vector<SearchGraphNode>& searchGraph,
+                                  std::map<int,int>& mosesIDToHypergraphID,
+                                  std::set<int>& terminalNodes,
+                                  std::multimap<int,int>& hypergraphIDToArcs,
+                                  long& endNode) const;
 
 
 protected:
@@ -178,6 +183,7 @@ public:
   void OutputSearchGraph(long translationId, std::ostream &outputSearchGraphStream) const;
   void OutputSearchGraphAsSLF(long translationId, std::ostream &outputSearchGraphStream) const;
   void OutputSearchGraphAsHypergraph(std::ostream &outputSearchGraphStream) const;
+  void OutputSearchGraphAsBinaryHypergraph(BinaryHypergraphWriter& out) const;
   void GetSearchGraph(std::vector<SearchGraphNode>& searchGraph) const;
 
   const InputType& GetSource() const;
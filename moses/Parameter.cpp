@@ -140,6 +140,7 @@ Parameter::Parameter()
   AddParam(lmbr_opts,"lmbr-thetas", "theta(s) for lattice mbr calculation");
   AddParam(mbr_opts,"lmbr-map-weight", "weight given to map solution when doing lattice MBR (default 0)");
   AddParam(mbr_opts,"lmbr-pruning-factor", "average number of nodes/word wanted in pruned lattice");
+  AddParam(mbr_opts,"lmbr-threads", "number of threads used to compute the n-gram posteriors of each lattice (default 1)");
   AddParam(mbr_opts,"lattice-hypo-set", "to use lattice as hypo set during lattice MBR");
 
   ///////////////////////////////////////////////////////////////////////////////////////
@@ -197,7 +198,7 @@ Parameter::Parameter()
 #ifdef HAVE_PROTOBUF
   AddParam(osg_opts,"output-search-graph-pb", "pb", "Write phrase lattice to protocol buffer objects in the specified path.");
 #endif
-  AddParam(osg_opts,"output-search-graph-hypergraph", "DEPRECATED! Output connected hypotheses of search into specified directory, one file per sentence, in a hypergraph format (see Kenneth Heafield's lazy hypergraph decoder). This flag is followed by 3 values: 'true (gz|txt|bz) directory-name'");
+  AddParam(osg_opts,"output-search-graph-hypergraph", "DEPRECATED! Output connected hypotheses of search into specified directory, one file per sentence, in a hypergraph format (see Kenneth Heafield's lazy hypergraph decoder). This flag is followed by 3 values: 'true (gz|txt|bz2|bin) directory-name', where bin is a binary format that mert can map instead of parsing");
 
   ///////////////////////////////////////////////////////////////////////////////////////
   // nbest-options
@@ -233,12 +234,26 @@ Parameter::Parameter()
            "Max. number of seconds the server will keep a persistent connection alive.");
   AddParam(server_opts,"server-timeout",
            "Max. number of seconds the server will wait for a client to submit a request once a connection has been established.");
+  // the request queue sits between the abyss connection threads and the decoder
+  AddParam(server_opts,"server-workers",
+           "No. of threads translating queued requests (default: value of -threads).");
+  AddParam(server_opts,"server-queue-size",
+           "Max. No. of requests waiting for a worker; further requests are refused (default 64).");
+  AddParam(server_opts,"server-time-budget",
+           "Default time budget of a request in milliseconds, queueing included (default 0 = none).");
+  AddParam(server_opts,"server-batch-size",
+           "Max. No. of short requests a worker takes from the queue at once (default 4).");
+  AddParam(server_opts,"server-batch-max-length",
+           "Max. No. of source words of a request that may be batched (default 10).");
   // session timeout and session cache size are for moses translation session handling
   // they have nothing to do with the abyss server (but relate to the moses server)
   AddParam(server_opts,"session-timeout",
            "Timeout for sessions, e.g. '2h30m' or 1d (=24h)");
-  AddParam(server_opts,"session-cache-size", string("Max. number of sessions cached.")
-           +"Least recently used session is dumped first.");
+  AddParam(server_opts,"session-cache-size", string("Max. number of sessions cached. ")
+           +"Least recently used session is dumped first (default 0 = no limit).");
+  AddParam(server_opts,"session-cache_size", "Same as session-cache-size (old spelling).");
+  AddParam(server_opts,"session-memory", string("Max. estimated memory of all sessions in MB. ")
+           +"Least recently used session is dumped first (default 0 = no limit).");
 
   po::options_description irstlm_opts("IRSTLM Options");
   AddParam(irstlm_opts,"clean-lm-cache",
@@ -485,6 +500,8 @@ bool
 Parameter::
 LoadParam(int argc, char const* xargv[])
 {
+  m_commandLine.assign(xargv, xargv + argc);
+
   // legacy parameter handling: all parameters are expected
   // to start with a single dash
   char const* argv[argc+1];
@@ -56,6 +56,7 @@ protected:
   options_description m_options;
 
   std::map<std::string, std::vector<float> >  m_weights;
+  std::vector<std::string> m_commandLine; // as given to LoadParam()
 
   std::string FindParam(const std::string &paramSwitch, int argc, char const* argv[]);
   void OverwriteParam(const std::string &paramSwitch, const std::string &paramName,
@@ -138,6 +139,11 @@ public:
     return m_setting;
   }
 
+  //! the arguments the parameters were loaded from, program name first
+  const std::vector<std::string> &GetCommandLine() const {
+    return m_commandLine;
+  }
+
   void Save(const std::string path);
 
   template<typename T>
@@ -2,7 +2,9 @@
 #include "SearchCubePruning.h"
 #include "SearchNormal.h"
 #include "InputType.h"
+#include "TranslationTask.h"
 #include "util/exception.hh"
+#include "util/usage.hh"
 
 namespace Moses
 {
@@ -15,8 +17,11 @@ Search::Search(Manager& manager)
   , m_initialTransOpt()
   , m_bitmaps(manager.GetSource().GetSize(), manager.GetSource().m_sourceCompleted)
   , interrupted_flag(0)
+  , m_deadline(0)
 {
   m_initialTransOpt.SetInputPath(m_inputPath);
+  ttasksptr ttask = manager.GetTtask();
+  if (ttask) m_deadline = ttask->GetDeadline();
 }
 
 
@@ -24,6 +29,11 @@ bool
 Search::
 out_of_time()
 {
+  if (m_deadline && util::WallTime() > m_deadline) {
+    VERBOSE(1,"Decoding is past the deadline of its task" << std::endl);
+    interrupted_flag = 1;
+    return true;
+  }
   int const& timelimit = m_options.search.timeout;
   if (!timelimit) return false;
   double elapsed_time = GetUserTime();
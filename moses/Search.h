@@ -54,6 +54,9 @@ protected:
   /** flag indicating that decoder ran out of time (see switch -time-out) */
   size_t interrupted_flag;
 
+  /** wall clock deadline of the translation task, 0 if there is none */
+  double m_deadline;
+
   bool out_of_time();
 };
 
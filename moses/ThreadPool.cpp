@@ -22,6 +22,38 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 
 #include "ThreadPool.h"
 
+namespace Moses
+{
+
+WaitableTask::WaitableTask()
+  : m_done(false)
+{
+}
+
+void WaitableTask::Run()
+{
+  DoRun();
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_mutex);
+#endif
+  m_done = true;
+#ifdef WITH_THREADS
+  m_finished.notify_all();
+#endif
+}
+
+void WaitableTask::Wait()
+{
+#ifdef WITH_THREADS
+  boost::mutex::scoped_lock lock(m_mutex);
+  while (!m_done) {
+    m_finished.wait(lock);
+  }
+#endif
+}
+
+}
+
 #ifdef WITH_THREADS
 
 using namespace std;
@@ -22,10 +22,12 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef moses_ThreadPool_h
 #define moses_ThreadPool_h
 
+#include <deque>
 #include <iostream>
 #include <queue>
 #include <vector>
 
+#include <boost/function.hpp>
 #include <boost/shared_ptr.hpp>
 
 #ifdef WITH_THREADS
@@ -56,6 +58,32 @@ public:
   virtual ~Task() {}
 };
 
+/** A task whose caller can wait for it to finish, e.g. to use its result.
+ *  Subclasses implement DoRun().
+ */
+class WaitableTask : public Task
+{
+public:
+  WaitableTask();
+
+  virtual void Run();
+
+  /**
+   * Block until Run() has finished.
+   **/
+  void Wait();
+
+protected:
+  virtual void DoRun() = 0;
+
+private:
+#ifdef WITH_THREADS
+  boost::mutex m_mutex;
+  boost::condition_variable m_finished;
+#endif
+  bool m_done;
+};
+
 #ifdef WITH_THREADS
 
 class ThreadPool
@@ -125,7 +153,61 @@ private:
   int m_id;
 };
 
+#else
+
+class ThreadPool;
+
 #endif //WITH_THREADS
 
+/** Runs tasks in a thread pool and hands them to a consumer in the order
+ *  they were submitted, for instance to write their output in input order.
+ *  At most maxPending tasks are submitted but not yet consumed: Submit()
+ *  waits for the oldest ones, which bounds the memory held by results.
+ *  Without a pool, Submit() runs the task and consumes it at once.
+ *  TaskType derives from WaitableTask.
+ */
+template <class TaskType>
+class OrderedPipeline
+{
+public:
+  typedef boost::function<void (TaskType &)> Consumer;
+
+  OrderedPipeline(ThreadPool *pool, size_t maxPending, const Consumer &consume)
+    : m_pool(pool), m_maxPending(maxPending), m_consume(consume) {}
+
+  void Submit(const boost::shared_ptr<TaskType> &task) {
+#ifdef WITH_THREADS
+    if (m_pool) {
+      m_pending.push_back(task);
+      m_pool->Submit(task);
+      while (m_pending.size() > m_maxPending) ConsumeFirst();
+      return;
+    }
+#endif
+    task->Run();
+    m_consume(*task);
+  }
+
+  /**
+   * Wait for and consume all tasks submitted so far.
+   **/
+  void Finish() {
+    while (!m_pending.empty()) ConsumeFirst();
+  }
+
+private:
+  void ConsumeFirst() {
+    boost::shared_ptr<TaskType> task = m_pending.front();
+    m_pending.pop_front();
+    task->Wait();
+    m_consume(*task);
+  }
+
+  ThreadPool *m_pool;
+  const size_t m_maxPending;
+  Consumer m_consume;
+  std::deque<boost::shared_ptr<TaskType> > m_pending;
+};
+
 } // namespace Moses
 #endif  // moses_ThreadPool_h
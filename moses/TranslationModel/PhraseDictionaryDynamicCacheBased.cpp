@@ -45,7 +45,6 @@ PhraseDictionaryDynamicCacheBased::PhraseDictionaryDynamicCacheBased(const std::
 
   m_score_type = CBTM_SCORE_TYPE_HYPERBOLA;
   m_maxAge = 1000;
-  m_entries = 0;
   m_name = "default";
   m_constant = false;
   ReadParameters();
@@ -153,19 +152,22 @@ void PhraseDictionaryDynamicCacheBased::InitializeForInput(ttasksptr const& ttas
 
 TargetPhraseCollection::shared_ptr PhraseDictionaryDynamicCacheBased::GetTargetPhraseCollection(const Phrase &source) const
 {
-#ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> read_lock(m_cacheLock);
-#endif
   TargetPhraseCollection::shared_ptr tpc;
-  cacheMap::const_iterator it = m_cacheTM.find(source);
-  if(it != m_cacheTM.end()) {
-    tpc.reset(new TargetPhraseCollection(*(it->second).first));
-
-    std::vector<const TargetPhrase*>::const_iterator it2 = tpc->begin();
-
-    while (it2 != tpc->end()) {
-      ((TargetPhrase*) *it2)->EvaluateInIsolation(source, GetFeaturesToApply());
-      it2++;
+  CacheEntryPtr entry;
+  if (m_cacheTM.Find(source, entry)) {
+    tpc.reset(new TargetPhraseCollection);
+    for (size_t tp_pos = 0; tp_pos < entry->tpc->GetSize(); tp_pos++) {
+      const DecayClock::Stamp &stamp = entry->stamps[tp_pos];
+      if (m_cacheTM.IsExpired(stamp)) {
+        continue;
+      }
+      TargetPhrase *tp_ptr = new TargetPhrase(*entry->tpc->GetTargetPhrase(tp_pos));
+      tp_ptr->GetScoreBreakdown().Assign(this, GetPreComputedScores(m_cacheTM.GetAge(stamp)));
+      tp_ptr->EvaluateInIsolation(source, GetFeaturesToApply());
+      tpc->Add(tp_ptr);
+    }
+    if (tpc->GetSize() == 0) {
+      tpc.reset();
     }
   }
   if (tpc)  {
@@ -195,7 +197,7 @@ ChartRuleLookupManager* PhraseDictionaryDynamicCacheBased::CreateRuleLookupManag
 void PhraseDictionaryDynamicCacheBased::SetScoreType(size_t type)
 {
 #ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> read_lock(m_cacheLock);
+  boost::unique_lock<boost::mutex> lock(m_updateLock);
 #endif
 
   m_score_type = type;
@@ -217,9 +219,10 @@ void PhraseDictionaryDynamicCacheBased::SetScoreType(size_t type)
 void PhraseDictionaryDynamicCacheBased::SetMaxAge(unsigned int age)
 {
 #ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> read_lock(m_cacheLock);
+  boost::unique_lock<boost::mutex> lock(m_updateLock);
 #endif
   m_maxAge = age;
+  m_cacheTM.SetMaxAge(age);
   VERBOSE(2, "PhraseDictionaryCache MaxAge:  " << m_maxAge << std::endl);
 }
 
@@ -265,7 +268,7 @@ void PhraseDictionaryDynamicCacheBased::SetPreComputedScores(const unsigned int
 {
   VERBOSE(2, "PhraseDictionaryDynamicCacheBased SetPreComputedScores:  " << m_maxAge << std::endl);
 #ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> lock(m_cacheLock);
+  boost::unique_lock<boost::mutex> lock(m_updateLock);
 #endif
   float sc;
   for (size_t i=0; i<=m_maxAge; i++) {
@@ -291,7 +294,7 @@ void PhraseDictionaryDynamicCacheBased::SetPreComputedScores(const unsigned int
   VERBOSE(3, "SetPreComputedScores(const unsigned int): lower_age:|" << m_maxAge << "| lower_score:|" << m_lower_score << "|" << std::endl);
 }
 
-Scores PhraseDictionaryDynamicCacheBased::GetPreComputedScores(const unsigned int age)
+Scores PhraseDictionaryDynamicCacheBased::GetPreComputedScores(const unsigned int age) const
 {
   if (age < m_maxAge) {
     return precomputedScores.at(age);
@@ -351,59 +354,46 @@ void PhraseDictionaryDynamicCacheBased::ClearEntries(std::string sourcePhraseStr
 
 }
 
+// copy of the target phrases of an entry that have not expired, except /skip/
+PhraseDictionaryDynamicCacheBased::CacheEntry *PhraseDictionaryDynamicCacheBased::CopyLiveEntries(const CacheEntryPtr &entry, const Phrase *skip) const
+{
+  CacheEntry *ret = new CacheEntry;
+  ret->tpc.reset(new TargetPhraseCollection);
+  if (!entry) {
+    return ret;
+  }
+  for (size_t tp_pos = 0; tp_pos < entry->tpc->GetSize(); tp_pos++) {
+    const TargetPhrase *tp_ptr = entry->tpc->GetTargetPhrase(tp_pos);
+    if (m_cacheTM.IsExpired(entry->stamps[tp_pos]) || (skip && *skip == *(const Phrase*) tp_ptr)) {
+      continue;
+    }
+    ret->tpc->Add(new TargetPhrase(*tp_ptr));
+    ret->stamps.push_back(entry->stamps[tp_pos]);
+  }
+  return ret;
+}
+
 void PhraseDictionaryDynamicCacheBased::ClearEntries(Phrase sp, Phrase tp)
 {
   VERBOSE(3,"PhraseDictionaryDynamicCacheBased::ClearEntries(Phrase sp, Phrase tp)" << std::endl);
 #ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> lock(m_cacheLock);
+  boost::unique_lock<boost::mutex> lock(m_updateLock);
 #endif
   VERBOSE(3, "PhraseDictionaryCache deleting sp:|" << sp << "| tp:|" << tp << "|" << std::endl);
 
-  cacheMap::const_iterator it = m_cacheTM.find(sp);
-  VERBOSE(3,"sp:|" << sp << "|" << std::endl);
-  if(it!=m_cacheTM.end()) {
+  CacheEntryPtr entry;
+  if (m_cacheTM.Find(sp, entry)) {
     VERBOSE(3,"sp:|" << sp << "| FOUND" << std::endl);
     // sp is found
-    // here we have to remove the target phrase from targetphrasecollection and from the TargetAgeMap
-    // and then add new entry
-
-    TargetCollectionAgePair TgtCollAgePair = it->second;
-    TargetPhraseCollection::shared_ptr  tpc = TgtCollAgePair.first;
-    AgeCollection* ac = TgtCollAgePair.second;
-    const Phrase* p_ptr = NULL;
-    TargetPhrase* tp_ptr = NULL;
-    bool found = false;
-    size_t tp_pos=0;
-    while (!found && tp_pos < tpc->GetSize()) {
-      tp_ptr = (TargetPhrase*) tpc->GetTargetPhrase(tp_pos);
-      p_ptr = (const Phrase*) tp_ptr;
-      if (tp == *p_ptr) {
-        found = true;
-        continue;
-      }
-      tp_pos++;
-    }
-    if (!found) {
-      VERBOSE(3,"tp:|" << tp << "| NOT FOUND" << std::endl);
-      //do nothing
+    // here we store a copy of the entry without the target phrase
+    boost::shared_ptr<CacheEntry> updated(CopyLiveEntries(entry, &tp));
+    if (updated->tpc->GetSize() == 0) {
+      // delete the entry from m_cacheTM in case it points to an empty TargetPhraseCollection
+      m_cacheTM.Erase(sp);
     } else {
-      VERBOSE(3,"tp:|" << tp << "| FOUND" << std::endl);
-
-      tpc->Remove(tp_pos); //delete entry in the Target Phrase Collection
-      ac->erase(ac->begin() + tp_pos); //delete entry in the Age Collection
-      m_entries--;
-      VERBOSE(3,"tpc size:|" << tpc->GetSize() << "|" << std::endl);
-      VERBOSE(3,"ac size:|" << ac->size() << "|" << std::endl);
-      VERBOSE(3,"tp:|" << tp << "| DELETED" << std::endl);
-    }
-    if (tpc->GetSize() == 0) {
-      // delete the entry from m_cacheTM in case it points to an empty TargetPhraseCollection and AgeCollection
-      ac->clear();
-      tpc.reset();
-      delete ac;
-      m_cacheTM.erase(sp);
+      m_cacheTM.Set(sp, updated);
     }
-
+    VERBOSE(3,"tp:|" << tp << "| DELETED" << std::endl);
   } else {
     VERBOSE(3,"sp:|" << sp << "| NOT FOUND" << std::endl);
     //do nothing
@@ -447,24 +437,11 @@ void PhraseDictionaryDynamicCacheBased::ClearSource(std::vector<std::string> ent
 void PhraseDictionaryDynamicCacheBased::ClearSource(Phrase sp)
 {
   VERBOSE(3,"void PhraseDictionaryDynamicCacheBased::ClearSource(Phrase sp) sp:|" << sp << "|" << std::endl);
-  cacheMap::const_iterator it = m_cacheTM.find(sp);
-  if (it != m_cacheTM.end()) {
+#ifdef WITH_THREADS
+  boost::unique_lock<boost::mutex> lock(m_updateLock);
+#endif
+  if (m_cacheTM.Erase(sp)) {
     VERBOSE(3,"found:|" << sp << "|" << std::endl);
-    //sp is found
-
-    TargetCollectionAgePair TgtCollAgePair = it->second;
-    TargetPhraseCollection::shared_ptr  tpc = TgtCollAgePair.first;
-    AgeCollection* ac = TgtCollAgePair.second;
-
-    m_entries-=tpc->GetSize(); //reduce the total amount of entries of the cache
-
-    // delete the entry from m_cacheTM in case it points to an empty TargetPhraseCollection and AgeCollection
-    ac->clear();
-    tpc.reset();
-    delete ac;
-    m_cacheTM.erase(sp);
-  } else {
-    //do nothing
   }
 }
 
@@ -547,132 +524,55 @@ void PhraseDictionaryDynamicCacheBased::Update(Phrase sp, TargetPhrase tp, int a
 {
   VERBOSE(3,"PhraseDictionaryDynamicCacheBased::Update(Phrase sp, TargetPhrase tp, int age, std::string waString)" << std::endl);
 #ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> lock(m_cacheLock);
+  boost::unique_lock<boost::mutex> lock(m_updateLock);
 #endif
   VERBOSE(3, "PhraseDictionaryCache inserting sp:|" << sp << "| tp:|" << tp << "| age:|" << age << "| word-alignment |" << waString << "|" << std::endl);
 
-  cacheMap::const_iterator it = m_cacheTM.find(sp);
-  VERBOSE(3,"sp:|" << sp << "|" << std::endl);
-  if(it!=m_cacheTM.end()) {
-    VERBOSE(3,"sp:|" << sp << "| FOUND" << std::endl);
-    // sp is found
-    // here we have to remove the target phrase from targetphrasecollection and from the TargetAgeMap
-    // and then add new entry
-
-    TargetCollectionAgePair TgtCollAgePair = it->second;
-    TargetPhraseCollection::shared_ptr  tpc = TgtCollAgePair.first;
-    AgeCollection* ac = TgtCollAgePair.second;
-//    const TargetPhrase* p_ptr = NULL;
-    const Phrase* p_ptr = NULL;
-    TargetPhrase* tp_ptr = NULL;
-    bool found = false;
-    size_t tp_pos=0;
-    while (!found && tp_pos < tpc->GetSize()) {
-      tp_ptr = (TargetPhrase*) tpc->GetTargetPhrase(tp_pos);
-      p_ptr = (const TargetPhrase*) tp_ptr;
-      if ((Phrase) tp == *p_ptr) {
-        found = true;
-        continue;
+  // a new entry, or a copy of the existing one without tp and expired
+  // target phrases, to which the new entry for tp is added
+  CacheEntryPtr entry;
+  m_cacheTM.Find(sp, entry);
+  boost::shared_ptr<CacheEntry> updated(CopyLiveEntries(entry, &tp));
+
+  std::auto_ptr<TargetPhrase> targetPhrase(new TargetPhrase(tp));
+  targetPhrase->GetScoreBreakdown().Assign(this, GetPreComputedScores(age));
+  if (!waString.empty()) targetPhrase->SetAlignmentInfo(waString);
+
+  updated->tpc->Add(targetPhrase.release());
+  updated->stamps.push_back(m_cacheTM.Now(age));
+  m_cacheTM.Set(sp, updated);
+  VERBOSE(3,"sp:|" << sp << "| tp:|" << tp << "| INSERTED" << std::endl);
+}
+
+// an entry of the cache whose target phrases have all expired
+struct PhraseDictionaryDynamicCacheBased::IsExpired {
+  const DecayClock &clock;
+  IsExpired(const DecayClock &c) : clock(c) { }
+  bool operator()(const Phrase &sp, const CacheEntryPtr &entry) const {
+    for (size_t tp_pos = 0; tp_pos < entry->stamps.size(); tp_pos++) {
+      if (!clock.IsExpired(entry->stamps[tp_pos])) {
+        return false;
       }
-      tp_pos++;
-    }
-    if (!found) {
-      VERBOSE(3,"tp:|" << tp << "| NOT FOUND" << std::endl);
-      std::auto_ptr<TargetPhrase> targetPhrase(new TargetPhrase(tp));
-
-      targetPhrase->GetScoreBreakdown().Assign(this, GetPreComputedScores(age));
-      if (!waString.empty()) targetPhrase->SetAlignmentInfo(waString);
-
-      tpc->Add(targetPhrase.release());
-
-      tp_pos = tpc->GetSize()-1;
-      ac->push_back(age);
-      m_entries++;
-      VERBOSE(3,"sp:|" << sp << "tp:|" << tp << "| INSERTED" << std::endl);
-    } else {
-      tp_ptr->GetScoreBreakdown().Assign(this, GetPreComputedScores(age));
-      if (!waString.empty()) tp_ptr->SetAlignmentInfo(waString);
-      ac->at(tp_pos) = age;
-      VERBOSE(3,"sp:|" << sp << "tp:|" << tp << "| UPDATED" << std::endl);
     }
-  } else {
-    VERBOSE(3,"sp:|" << sp << "| NOT FOUND" << std::endl);
-    // p is not found
-    // create target collection
-    // we have to create new target collection age pair and add new entry to target collection age pair
-
-    TargetPhraseCollection::shared_ptr tpc(new TargetPhraseCollection);
-    AgeCollection* ac = new AgeCollection();
-    m_cacheTM.insert(make_pair(sp,make_pair(tpc,ac)));
-
-    //tp is not found
-    std::auto_ptr<TargetPhrase> targetPhrase(new TargetPhrase(tp));
-    targetPhrase->GetScoreBreakdown().Assign(this, GetPreComputedScores(age));
-    if (!waString.empty()) targetPhrase->SetAlignmentInfo(waString);
-
-    tpc->Add(targetPhrase.release());
-    ac->push_back(age);
-    m_entries++;
-    VERBOSE(3,"sp:|" << sp << "| tp:|" << tp << "| INSERTED" << std::endl);
+    return true;
   }
-}
+};
 
 void PhraseDictionaryDynamicCacheBased::Decay()
 {
 #ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> lock(m_cacheLock);
+  boost::unique_lock<boost::mutex> lock(m_updateLock);
 #endif
-  cacheMap::iterator it;
-  for(it = m_cacheTM.begin(); it!=m_cacheTM.end(); it++) {
-    Decay((*it).first);
+  // ages follow from the epoch at lookup time; entries that expired are
+  // skipped by lookups and erased here once every m_maxAge epochs
+  int64_t epoch = m_cacheTM.Decay();
+  if (epoch % std::max(m_maxAge, 1u) == 0) {
+    m_cacheTM.EraseIf(IsExpired(m_cacheTM));
+    VERBOSE(3,"entries left after erasing the expired ones:|" << m_cacheTM.Size() << "|" << std::endl);
   }
 }
 
-void PhraseDictionaryDynamicCacheBased::Decay(Phrase sp)
-{
-  VERBOSE(3,"void PhraseDictionaryDynamicCacheBased::Decay(Phrase sp) sp:|" << sp << "|" << std::endl);
-  cacheMap::iterator it = m_cacheTM.find(sp);
-  if (it != m_cacheTM.end()) {
-    VERBOSE(3,"found:|" << sp << "|" << std::endl);
-    //sp is found
-
-    TargetCollectionAgePair TgtCollAgePair = it->second;
-    TargetPhraseCollection::shared_ptr  tpc = TgtCollAgePair.first;
-    AgeCollection* ac = TgtCollAgePair.second;
-
-    //loop in inverted order to allow a correct deletion of std::vectors tpc and ac
-    for (int tp_pos = tpc->GetSize() - 1 ; tp_pos >= 0; tp_pos--) {
-      unsigned int tp_age = ac->at(tp_pos); //increase the age by 1
-      tp_age++; //increase the age by 1
-      VERBOSE(3,"sp:|" << sp << "| " << " new tp_age:|" << tp_age << "|" << std::endl);
-
-      TargetPhrase* tp_ptr = (TargetPhrase*) tpc->GetTargetPhrase(tp_pos);
-
-      if (tp_age > m_maxAge) {
-        VERBOSE(3,"tp_age:|" << tp_age << "| TOO BIG" << std::endl);
-        tpc->Remove(tp_pos); //delete entry in the Target Phrase Collection
-        ac->erase(ac->begin() + tp_pos); //delete entry in the Age Collection
-        m_entries--;
-      } else {
-        VERBOSE(3,"tp_age:|" << tp_age << "| STILL GOOD" << std::endl);
-        tp_ptr->GetScoreBreakdown().Assign(this, GetPreComputedScores(tp_age));
-        ac->at(tp_pos) = tp_age;
-      }
-    }
-    if (tpc->GetSize() == 0) {
-      // delete the entry from m_cacheTM in case it points to an empty TargetPhraseCollection and AgeCollection
-      (((*it).second).second)->clear();
-      delete ((*it).second).second;
-      ((*it).second).first.reset();
-      m_cacheTM.erase(sp);
-    }
-  } else {
-    //do nothing
-    VERBOSE(3,"sp:|" << sp << "| NOT FOUND" << std::endl);
-  }
 
-  //put here the removal of entries with age greater than m_maxAge
-}
 
 void PhraseDictionaryDynamicCacheBased::Execute(std::string command)
 {
@@ -703,16 +603,9 @@ void PhraseDictionaryDynamicCacheBased::Execute_Single_Command(std::string comma
 void PhraseDictionaryDynamicCacheBased::Clear()
 {
 #ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> lock(m_cacheLock);
+  boost::unique_lock<boost::mutex> lock(m_updateLock);
 #endif
-  cacheMap::iterator it;
-  for(it = m_cacheTM.begin(); it!=m_cacheTM.end(); it++) {
-    (((*it).second).second)->clear();
-    delete ((*it).second).second;
-    ((*it).second).first.reset();
-  }
-  m_cacheTM.clear();
-  m_entries = 0;
+  m_cacheTM.Clear();
 }
 
 
@@ -742,19 +635,18 @@ void PhraseDictionaryDynamicCacheBased::ExecuteDlt(std::map<std::string, std::st
 void PhraseDictionaryDynamicCacheBased::Print() const
 {
   VERBOSE(2,"PhraseDictionaryDynamicCacheBased::Print()" << std::endl);
-#ifdef WITH_THREADS
-  boost::shared_lock<boost::shared_mutex> read_lock(m_cacheLock);
-#endif
-  cacheMap::const_iterator it;
-  for(it = m_cacheTM.begin(); it!=m_cacheTM.end(); it++) {
-    std::string source = (it->first).ToString();
-    TargetPhraseCollection::shared_ptr  tpc = (it->second).first;
-    TargetPhraseCollection::iterator itr;
-    for(itr = tpc->begin(); itr != tpc->end(); itr++) {
-      std::string target = (*itr)->ToString();
+  std::vector<std::pair<Phrase, CacheEntryPtr> > entries;
+  m_cacheTM.GetEntries(entries);
+  for(size_t i = 0; i < entries.size(); i++) {
+    std::string source = entries[i].first.ToString();
+    const CacheEntry &entry = *entries[i].second;
+    for(size_t tp_pos = 0; tp_pos < entry.tpc->GetSize(); tp_pos++) {
+      if (m_cacheTM.IsExpired(entry.stamps[tp_pos])) {
+        continue;
+      }
+      std::string target = entry.tpc->GetTargetPhrase(tp_pos)->ToString();
       std::cout << source << " ||| " << target << std::endl;
     }
-    source.clear();
   }
 }
 
@@ -23,10 +23,11 @@
 #define moses_PhraseDictionaryDynamicCacheBased_H
 
 #include "moses/TypeDef.h"
+#include "moses/DecayingCache.h"
 #include "moses/TranslationModel/PhraseDictionary.h"
 
 #ifdef WITH_THREADS
-#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/thread/locks.hpp>
 #endif
 
@@ -52,24 +53,29 @@ class ChartRuleLookupManager;
 class PhraseDictionaryDynamicCacheBased : public PhraseDictionary
 {
 
-  typedef std::vector<unsigned int> AgeCollection;
-  typedef std::pair<TargetPhraseCollection::shared_ptr , AgeCollection*> TargetCollectionAgePair;
-  typedef std::map<Phrase, TargetCollectionAgePair> cacheMap;
+  // the target phrases of a source phrase and their age stamps; entries
+  // in the cache are never modified, updates store a modified copy
+  struct CacheEntry {
+    TargetPhraseCollection::shared_ptr tpc;
+    std::vector<DecayClock::Stamp> stamps;
+  };
+  typedef boost::shared_ptr<const CacheEntry> CacheEntryPtr;
+  typedef DecayingCache<Phrase, CacheEntryPtr> cacheMap;
+  struct IsExpired;
 
-  // data structure for the cache
+  // data structure for the cache; ages are computed at lookup time
   cacheMap m_cacheTM;
   std::vector<Scores> precomputedScores;
   unsigned int m_maxAge;
   size_t m_score_type; //scoring type of the match
-  size_t m_entries; //total number of entries in the cache
   float m_lower_score; //lower_bound_score for no match
   bool m_constant; //flag for setting a non-decaying cache
   std::string m_initfiles; // vector of files loaded in the initialization phase
   std::string m_name; // internal name to identify this instance of the Cache-based phrase table
 
 #ifdef WITH_THREADS
-  //multiple readers - single writer lock
-  mutable boost::shared_mutex m_cacheLock;
+  //serializes updates; lookups do not take it
+  mutable boost::mutex m_updateLock;
 #endif
 
   friend std::ostream& operator<<(std::ostream&, const PhraseDictionaryDynamicCacheBased&);
@@ -153,8 +159,8 @@ protected:
   float decaying_score(const int age);  // calculates the decay score given the age
   void Insert(std::vector<std::string> entries);
 
-  void Decay();   // traverse through the cache and decay each entry
-  void Decay(Phrase p);   // traverse through the cache and decay each entry for a given Phrase
+  void Decay();   // age all entries of the cache by one
+  CacheEntry *CopyLiveEntries(const CacheEntryPtr &entry, const Phrase *skip) const;
   void Update(std::vector<std::string> entries, std::string ageString);
   void Update(std::string sourceString, std::string targetString, std::string ageString, std::string waString="");
   void Update(Phrase p, TargetPhrase tp, int age, std::string waString="");
@@ -171,7 +177,7 @@ protected:
 
 
   void SetPreComputedScores(const unsigned int numScoreComponent);
-  Scores GetPreComputedScores(const unsigned int age);
+  Scores GetPreComputedScores(const unsigned int age) const;
 
   void Load_Multiple_Files(std::vector<std::string> files);
   void Load_Single_File(const std::string file);
@@ -76,6 +76,8 @@ protected:
 
   std::map<long, PhraseDictionaryNodeMemory> m_collection;
   std::vector<std::string> m_config;
+  bool m_useIndex; // retrieve matches with an n-gram index
+  size_t m_indexThreads; // threads for verifying retrieved matches
 
   tmmt::FuzzyMatchWrapper *m_FuzzyMatchWrapper;
 
@@ -93,6 +93,14 @@ namespace Moses
       }
     return ret;
   } // TPCollCache::get(...)
+
+  size_t
+  TPCollCache::
+  size() const
+  {
+    boost::shared_lock<boost::shared_mutex> lock(m_lock);
+    return m_cache.size();
+  }
   
   TPCollWrapper::
   TPCollWrapper(uint64_t key_, size_t revision_)
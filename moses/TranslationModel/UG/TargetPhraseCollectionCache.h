@@ -25,6 +25,10 @@ namespace Moses
     SPTR<TPCollWrapper>
     get(uint64_t key, size_t revision);
 
+    // number of cached collections
+    size_t
+    size() const;
+
   };
 
   // wrapper around TargetPhraseCollection with reference counting
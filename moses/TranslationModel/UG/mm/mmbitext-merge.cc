@@ -0,0 +1,94 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+// Appends word-aligned sentence pairs to a memory-mapped bitext without
+// rebuilding it from scratch: the new sentence pairs are indexed in
+// memory, as Mmsapt does for dynamic additions, and merged with the
+// existing suffix arrays into a new memory-mapped bitext.
+
+#include <boost/program_options.hpp>
+#include <fstream>
+#include <iostream>
+
+#include "ug_bitext.h"
+#include "ug_bitext_merge.h"
+
+using namespace std;
+using namespace sapt;
+namespace po = boost::program_options;
+
+typedef L2R_Token<SimpleWordId> Token;
+typedef mmBitext<Token> mmbitext;
+typedef imBitext<Token> imbitext;
+
+string bname, L1, L2, oname, file1, file2, afile;
+size_t batch;
+
+void
+interpret_args(int ac, char* av[])
+{
+  po::variables_map vm;
+  po::options_description o("Options");
+  o.add_options()
+    ("help,h", "print this message")
+    ("src,s", po::value<string>(&file1), "new L1 sentences, one per line")
+    ("trg,t", po::value<string>(&file2), "new L2 sentences, one per line")
+    ("aln,a", po::value<string>(&afile), "word alignments in symal format")
+    ("batch,b", po::value<size_t>(&batch)->default_value(100000),
+     "sentence pairs to index in memory at once")
+    ;
+
+  po::options_description h("Hidden Options");
+  h.add_options()
+    ("bname", po::value<string>(&bname), "base name of existing bitext")
+    ("L1", po::value<string>(&L1), "L1")
+    ("L2", po::value<string>(&L2), "L2")
+    ("oname", po::value<string>(&oname), "base name of the merged bitext")
+    ;
+  po::positional_options_description a;
+  a.add("bname",1);
+  a.add("L1",1);
+  a.add("L2",1);
+  a.add("oname",1);
+
+  po::store(po::command_line_parser(ac,av)
+            .options(h.add(o))
+            .positional(a)
+            .run(),vm);
+  po::notify(vm);
+  if (vm.count("help") || oname.empty() || file1.empty()
+      || file2.empty() || afile.empty())
+    {
+      cout << "usage:\n\t"
+           << av[0] << " <base name> <L1> <L2> <new base name> "
+           << "-s <L1 text> -t <L2 text> -a <alignments>\n"
+           << "\nThe word lexicon (.lex) of the new bitext must be "
+           << "rebuilt with mmlex-build.\n" << endl;
+      cout << o << endl;
+      exit(0);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+  interpret_args(argc, argv);
+  UTIL_THROW_IF2(bname == oname, "Refusing to overwrite the base bitext");
+  mmbitext B;
+  B.open(bname, L1, L2);
+
+  ifstream in1(file1.c_str()), in2(file2.c_str()), ina(afile.c_str());
+  UTIL_THROW_IF2(!in1 || !in2 || !ina, "Cannot read the new sentence pairs");
+  SPTR<imbitext> add(new imbitext(B.V1, B.V2));
+  vector<string> s1, s2, aln;
+  string l1, l2, la;
+  while (getline(in1, l1))
+    {
+      UTIL_THROW_IF2(!getline(in2, l2) || !getline(ina, la),
+                     "Files with new sentence pairs differ in length");
+      s1.push_back(l1); s2.push_back(l2); aln.push_back(la);
+      if (s1.size() < max<size_t>(batch, 1)) continue;
+      add = add->add(s1, s2, aln);
+      s1.clear(); s2.clear(); aln.clear();
+      cerr << add->T1->size() << " sentence pairs indexed" << endl;
+    }
+  if (s1.size()) add = add->add(s1, s2, aln);
+  write_merged_bitext<Token>(B, add.get(), oname, L1, L2, &cerr);
+}
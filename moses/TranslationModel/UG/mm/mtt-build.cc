@@ -43,6 +43,7 @@ int with_sfas;
 bool incremental = false; // build / grow vocabs automatically
 bool is_conll    = false; // text or conll format?
 bool quiet       = false; // no progress reporting
+size_t threads   = 0;     // for sorting suffix arrays; 0: all cores
 
 string vocabBase; // base name for existing vocabs that should be used
 string baseName;  // base name for all files
@@ -367,7 +368,7 @@ build_mmTSA(string infile, string outfile)
   boost::shared_ptr<mmTtrack<Token> > T(new mmTtrack<Token>(infile));
   bdBitset filter;
   filter.resize(T->size(),true);
-  imTSA<Token> S(T,&filter,(quiet?NULL:&cerr));
+  imTSA<Token> S(T,&filter,(quiet?NULL:&cerr),threads);
   S.save_as_mm_tsa(outfile);
   // exit(0);
 }
@@ -469,6 +470,9 @@ interpret_args(int ac, char* av[])
     ("unk,u", po::value<string>(&UNK)->default_value("UNK"),
      "label for unknown tokens")
 
+    ("threads,T", po::value<size_t>(&threads)->default_value(0),
+     "number of threads for sorting suffix arrays (0: one per core)")
+
     // ("map,m", po::value<string>(&vmap),
     // "map words to word classes for indexing")
 
@@ -66,6 +66,7 @@
 #include "ug_sampling_bias.h"
 #include "ug_phrasepair.h"
 #include "ug_bitext_phrase_extraction_record.h"
+#include "ug_bitext_sample_pool.h"
 #include "moses/TranslationModel/UG/generic/threading/ug_ref_counter.h"
 
 // Minimum source count for caching phrase lookup statistics.
@@ -110,6 +111,7 @@ namespace sapt
     typedef typename TSA<Token>::tree_iterator   iter;
     typedef typename std::vector<PhrasePair<Token> > vec_ppair;
     typedef typename lru_cache::LRU_Cache<uint64_t, vec_ppair> pplist_cache_t;
+    typedef lru_cache::LRU_Cache<uint64_t, SamplePool> pool_cache_t;
     typedef TSA<Token> tsa;
     friend class Moses::Mmsapt;
   protected:
@@ -131,6 +133,11 @@ namespace sapt
     // caches for unbiased sampling; biased sampling uses the caches that
     // are stored locally on the translation task
 
+    size_t m_sample_pool_size; // occurrences pooled per phrase; 0: no pooling
+    mutable pool_cache_t m_pool_cache1, m_pool_cache2;
+    // pools of extracted occurrences of frequent phrases, shared by all
+    // contexts (see ug_bitext_sample_pool.h)
+
   public:
     SPTR<Ttrack<char> >  Tx; // word alignments
     SPTR<Ttrack<Token> > T1; // token track
@@ -155,7 +162,8 @@ namespace sapt
       int& po_fwd, int& po_bwd, // phrase orientations
       std::vector<unsigned char> * core_alignment, // stores the core alignment
       bitvector* full_alignment, // stores full word alignment for this sent.
-      bool const flip) const;   // flip source and target (reverse lookup)
+      bool const flip,           // flip source and target (reverse lookup)
+      PhraseExtractionScratch* scratch = NULL) const; // reusable buffers
 
     // prep2 launches sampling and returns immediately.
     // lookup (below) waits for the job to finish before it returns
@@ -195,6 +203,11 @@ namespace sapt
     void   setDefaultSampleSize(size_t const max_samples);
     size_t getDefaultSampleSize() const;
 
+    // Let BitextSampler reuse up to /occurrences/ extracted occurrences
+    // for each of up to /phrases/ frequent source phrases per direction.
+    // Must be called before sampling starts.
+    void   setSamplePool(size_t const occurrences, size_t const phrases);
+
     std::string toString(uint64_t pid, int isL2) const;
 
     virtual size_t revision() const { return 0; }
@@ -333,6 +346,17 @@ namespace sapt
       }
   }
 
+  template<typename Token>
+  void
+  Bitext<Token>::
+  setSamplePool(size_t const occurrences, size_t const phrases)
+  {
+    boost::unique_lock<boost::shared_mutex> guard(m_lock);
+    m_sample_pool_size = phrases ? occurrences : 0;
+    m_pool_cache1.reserve(phrases);
+    m_pool_cache2.reserve(phrases);
+  }
+
   template<typename Token>
   Bitext<Token>::
   Bitext(size_t const max_sample, size_t const xnum_workers)
@@ -341,6 +365,7 @@ namespace sapt
     , m_pstats_cache_threshold(PSTATS_CACHE_THRESHOLD)
     , m_cache1(new pstats::cache_t)
     , m_cache2(new pstats::cache_t)
+    , m_sample_pool_size(0)
   { }
 
   template<typename Token>
@@ -359,6 +384,7 @@ namespace sapt
     , m_pstats_cache_threshold(PSTATS_CACHE_THRESHOLD)
     , m_cache1(new pstats::cache_t)
     , m_cache2(new pstats::cache_t)
+    , m_sample_pool_size(0)
     , Tx(tx), T1(t1), T2(t2), V1(v1), V2(v2), I1(i1), I2(i2)
   { }
 
@@ -388,7 +414,7 @@ namespace sapt
     return find_trg_phr_bounds(rec.sid, rec.start, rec.stop,
                                rec.s1, rec.s2, rec.e1, rec.e2,
                                rec.po_fwd, rec.po_bwd, 
-                               rec.aln, rec.full_aln, rec.flip);
+                               rec.aln, rec.full_aln, rec.flip, rec.scratch);
   }
 
   template<typename Token>
@@ -403,7 +429,8 @@ namespace sapt
     int& po_fwd, int& po_bwd, // phrase orientations
     std::vector<unsigned char> * core_alignment, // stores the core alignment
     bitvector* full_alignment, // stores full word alignment for this sent.
-    bool const flip) const     // flip source and target (reverse lookup)
+    bool const flip,           // flip source and target (reverse lookup)
+    PhraseExtractionScratch* scratch) const // reusable buffers
   {
     // if (core_alignment) cout << "HAVE CORE ALIGNMENT" << endl;
     // a word on the core_alignment (core_alignment):
@@ -428,7 +455,10 @@ namespace sapt
         slen1 = T1->sntLen(sid);
         slen2 = T2->sntLen(sid);
       }
-    bitvector forbidden(slen2);
+    PhraseExtractionScratch local;
+    if (!scratch) scratch = &local;
+    scratch->reset(slen1, slen2);
+    bitvector& forbidden = scratch->forbidden;
     if (full_alignment)
       {
         if (slen1*slen2 > full_alignment->size())
@@ -438,7 +468,8 @@ namespace sapt
     size_t src,trg;
     size_t lft = forbidden.size();
     size_t rgt = 0;
-    std::vector<std::vector<ushort> > aln1(slen1),aln2(slen2);
+    ushort_2d_table& aln1 = scratch->aln1;
+    ushort_2d_table& aln2 = scratch->aln2;
 
     // process word alignment for this sentence
     char const* p = Tx->sntStart(sid);
@@ -21,6 +21,7 @@ Bitext<Token>::agenda
   uint64_t sid=0, offset=0;       // sid and offset of source phrase
   size_t s1=0, s2=0, e1=0, e2=0;  // soft and hard boundaries of target phrase
   std::vector<unsigned char> aln; // stores phrase-pair-internal alignment
+  PhraseExtractionScratch buffers; // reused for each sampled sentence
   while(SPTR<job> j = ag.get_job())
     {
       j->stats->register_worker();
@@ -37,7 +38,8 @@ Bitext<Token>::agenda
 	  bool good = (ag.bt.find_trg_phr_bounds
 		       (sid, offset, offset + j->len,   // input parameters
 			s1, s2, e1, e2, po_fwd, po_bwd, // bounds & orientation
-			&aln, full_aln, !j->fwd));      // aln info / flip sides?
+			&aln, full_aln, !j->fwd,        // aln info / flip sides?
+			&buffers));
 
 	  if (!good)
 	    { // no good, probably because phrase is not coherent
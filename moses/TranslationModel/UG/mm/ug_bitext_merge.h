@@ -0,0 +1,140 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+#pragma once
+// Writes a static, memory-mapped bitext that holds the sentences of an
+// existing bitext followed by those of another one, typically the
+// in-memory bitext that collected dynamic additions on top of a
+// memory-mapped base. Neither suffix array is sorted again: sorting
+// only depends on the tokens from a position to the end of its
+// sentence, so the entries of both arrays keep their relative order in
+// the concatenated corpus and are merged range by range.
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ug_bitext.h"
+
+namespace sapt
+{
+  // Write the sentences of /A/ followed by those of /B/ to a new track
+  // file /fname/ in mmTtrack format.
+  template<typename TKN>
+  void
+  write_merged_ttrack(Ttrack<TKN> const& A, Ttrack<TKN> const* B,
+                      std::string const& fname)
+  {
+    std::ofstream out(fname.c_str());
+    UTIL_THROW_IF2(!out, "Cannot write '" << fname << "'");
+    mmTtrack<TKN>().write_blank_file_header(out);
+    std::vector<id_type> idx(1, 0);
+    idx.reserve(A.size() + (B ? B->size() : 0) + 1);
+    Ttrack<TKN> const* track[] = { &A, B };
+    for (size_t t = 0; t < 2 && track[t]; ++t)
+      {
+        for (size_t sid = 0; sid < track[t]->size(); ++sid)
+          {
+            TKN const* a = track[t]->sntStart(sid);
+            TKN const* z = track[t]->sntEnd(sid);
+            out.write(reinterpret_cast<char const*>(a), (z - a) * sizeof(TKN));
+            idx.push_back(idx.back() + (z - a));
+          }
+      }
+    mmTtrack<TKN>().write_index_and_finalize(out, idx, idx.back());
+  }
+
+  // Write the suffix array of the concatenated /corpus/ (as written by
+  // write_merged_ttrack) to /fname/ in mmTSA format, given the suffix
+  // array /A/ of its first part and /B/ of the sentences from /offset/
+  // on. /vsize/ is the size of the vocabulary of the merged corpus.
+  template<typename TKN>
+  void
+  write_merged_tsa(TSA<TKN> const& A, TSA<TKN> const* B, size_t const offset,
+                   Ttrack<TKN> const& corpus, size_t const vsize,
+                   std::string const& fname)
+  {
+    typedef ttrack::Position cpos;
+    cpos::LESS<Ttrack<TKN> > sorter(&corpus);
+    std::ofstream out(fname.c_str());
+    UTIL_THROW_IF2(!out, "Cannot write '" << fname << "'");
+    filepos_type idxStart(0);
+    id_type idxSize(vsize + 1);
+    tpt::numwrite(out, idxStart);
+    tpt::numwrite(out, idxSize);
+
+    TSA<TKN> const* tsa[] = { &A, B };
+    std::vector<cpos> part[2], merged;
+    std::vector<filepos_type> mmIndex;
+    for (id_type id = 0; id < vsize; ++id)
+      {
+        mmIndex.push_back(out.tellp());
+        for (size_t t = 0; t < 2; ++t)
+          {
+            part[t].clear();
+            char const *p, *q;
+            if (!tsa[t] || !tsa[t]->getTokenRange(id, p, q)) continue;
+            id_type sid; uint16_t off;
+            while (p < q)
+              {
+                p = tsa[t]->readSid(p, q, sid);
+                p = tsa[t]->readOffset(p, q, off);
+                part[t].push_back(cpos(t ? sid + offset : sid, off));
+              }
+          }
+        merged.resize(part[0].size() + part[1].size());
+        std::merge(part[0].begin(), part[0].end(), part[1].begin(), part[1].end(),
+                   merged.begin(), sorter);
+        BOOST_FOREACH(cpos const& x, merged)
+          {
+            tpt::tightwrite(out, x.sid, 0);
+            tpt::tightwrite(out, x.offset, 1);
+          }
+      }
+    mmIndex.push_back(out.tellp());
+    idxStart = out.tellp();
+    for (size_t i = 0; i < mmIndex.size(); i++)
+      tpt::numwrite(out, mmIndex[i] - mmIndex[0]);
+    out.seekp(0);
+    tpt::numwrite(out, idxStart);
+  }
+
+  // Write the bitext /A/ followed by /B/ (which may be NULL) as a
+  // memory-mapped bitext with base name /base/. /B/ must use the
+  // vocabularies of /A/, as Mmsapt's dynamic bitext does; words that
+  // were added to them dynamically become part of the new vocabulary
+  // files. The word lexicon (.lex) is not written; run mmlex-build on
+  // the new base.
+  template<typename TKN>
+  void
+  write_merged_bitext(Bitext<TKN> const& A, Bitext<TKN> const* B,
+                      std::string const& base,
+                      std::string const& L1, std::string const& L2,
+                      std::ostream* log = NULL)
+  {
+    if (B && !B->T1) B = NULL; // nothing was ever added
+    UTIL_THROW_IF2(B && (B->V1 != A.V1 || B->V2 != A.V2),
+                   "Bitexts to be merged must share their vocabularies");
+    size_t const offset = A.T1->size();
+    if (log) *log << "Merging " << offset << " and "
+                  << (B ? B->T1->size() : 0) << " sentence pairs" << std::endl;
+
+    A.V1->write(base + L1 + ".tdx");
+    A.V2->write(base + L2 + ".tdx");
+    write_merged_ttrack<char>(*A.Tx, B ? B->Tx.get() : NULL,
+                              base + L1 + "-" + L2 + ".mam");
+
+    std::string const L[] = { L1, L2 };
+    for (size_t i = 0; i < 2; ++i)
+      {
+        if (log) *log << "Writing " << base + L[i] << ".mct/.sfa" << std::endl;
+        Ttrack<TKN> const& T = *(i ? A.T2 : A.T1);
+        Ttrack<TKN> const* U = B ? (i ? B->T2 : B->T1).get() : NULL;
+        write_merged_ttrack<TKN>(T, U, base + L[i] + ".mct");
+        mmTtrack<TKN> corpus(base + L[i] + ".mct");
+        TSA<TKN> const* I = B ? (i ? B->I2 : B->I1).get() : NULL;
+        write_merged_tsa<TKN>(*(i ? A.I2 : A.I1), I, offset, corpus,
+                              (i ? A.V2 : A.V1)->tsize(), base + L[i] + ".sfa");
+      }
+  }
+}
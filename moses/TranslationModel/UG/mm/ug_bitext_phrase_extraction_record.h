@@ -1,25 +1,50 @@
 // -*- mode: c++; tab-width: 2; indent-tabs-mode: nil -*-
 #pragma once
+#include <algorithm>
 #include <vector>
 #include "ug_typedefs.h"
 
-namespace sapt 
+namespace sapt
 {
+  // Per-sentence work space of Bitext::find_trg_phr_bounds(). Sampling
+  // jobs keep one for all samples they extract, so that the word
+  // alignment of each sampled sentence pair is unpacked into buffers
+  // that are already allocated.
+  struct PhraseExtractionScratch
+  {
+    bitvector forbidden;   // L2 positions aligned outside the L1 phrase
+    ushort_2d_table aln1;  // alignment by L1 position
+    ushort_2d_table aln2;  // alignment by L2 position
+
+    void
+    reset(size_t const slen1, size_t const slen2)
+    {
+      forbidden.resize(slen2);
+      forbidden.reset();
+      // clear rather than reallocate the alignment lists we keep
+      for (size_t i = 0; i < std::min(slen1, aln1.size()); ++i) aln1[i].clear();
+      for (size_t i = 0; i < std::min(slen2, aln2.size()); ++i) aln2[i].clear();
+      aln1.resize(slen1);
+      aln2.resize(slen2);
+    }
+  };
+
   struct PhraseExtractionRecord
   {
     size_t const  sid, start, stop;
     bool   const        flip; // 'backward' lookup from L2
     size_t    s1, s2, e1, e2; // soft and hard boundaries of target phrase
-    int       po_fwd, po_bwd; // fwd and bwd phrase orientation 
+    int       po_fwd, po_bwd; // fwd and bwd phrase orientation
     std::vector<unsigned char>*  aln; // local alignments
     bitvector*      full_aln; // full word alignment for sentence
-    
-    PhraseExtractionRecord(size_t const xsid, size_t const xstart, 
+    PhraseExtractionScratch* scratch; // reusable buffers (optional)
+
+    PhraseExtractionRecord(size_t const xsid, size_t const xstart,
                            size_t const xstop, bool const xflip,
-                           std::vector<unsigned char>* xaln, 
-                           bitvector* xfull_aln = NULL)
-      : sid(xsid), start(xstart), stop(xstop), flip(xflip) 
-      , aln(xaln), full_aln(xfull_aln) { }
+                           std::vector<unsigned char>* xaln,
+                           bitvector* xfull_aln = NULL,
+                           PhraseExtractionScratch* xscratch = NULL)
+      : sid(xsid), start(xstart), stop(xstop), flip(xflip)
+      , aln(xaln), full_aln(xfull_aln), scratch(xscratch) { }
   };
 }
-
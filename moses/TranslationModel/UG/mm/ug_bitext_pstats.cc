@@ -1,4 +1,5 @@
 // -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+#include <algorithm>
 #include <boost/thread/locks.hpp>
 #include "ug_bitext_pstats.h"
 
@@ -82,6 +83,59 @@ namespace sapt
     return ret;
   }
 
+  size_t
+  pstats::
+  add_sample(int const docid, size_t const num_pairs,
+             int const po_fwd, int const po_bwd, float const b,
+             SamplePool::Pair const* pairs, size_t const n)
+  {
+    boost::lock_guard<boost::mutex> guard(this->lock);
+    return add_sample_locked(docid, num_pairs, po_fwd, po_bwd, b, pairs, n);
+  }
+
+  void
+  pstats::
+  add_samples(SamplePool const& pool, int const* docids, float const* biases)
+  {
+    boost::lock_guard<boost::mutex> guard(this->lock);
+    for (size_t i = 0; i < pool.occurrences.size(); ++i)
+      {
+        SamplePool::Occurrence const& o = pool.occurrences[i];
+        SamplePool::Pair const* pairs = o.stop > o.first ? &pool.pairs[o.first] : NULL;
+        add_sample_locked(docids[i], o.num_pairs, o.po_fwd, o.po_bwd,
+                          biases[i], pairs, o.stop - o.first);
+      }
+  }
+
+  size_t
+  pstats::
+  add_sample_locked(int const docid, size_t const num_pairs,
+                    int const po_fwd, int const po_bwd, float const b,
+                    SamplePool::Pair const* pairs, size_t const n)
+  {
+    ++sample_cnt;
+    if (num_pairs == 0) return 0;
+    ++good;
+    sum_pairs += num_pairs;
+    ++ofwd[po_fwd];
+    ++obwd[po_bwd];
+    if (docid >= 0) ++indoc[docid];
+
+    float const w = 1./num_pairs;
+    size_t ret = 0;
+    for (size_t i = 0; i < n; ++i)
+      {
+        SamplePool::Pair const& x = pairs[i];
+        jstats& entry = this->trg[x.pid];
+        size_t cnt = entry.add(w, b, x.aln, x.raw2, po_fwd, po_bwd, docid);
+        UTIL_THROW_IF2(this->good < entry.rcnt(),
+                       "more joint counts than good counts:"
+                       << entry.rcnt() << "/" << this->good << "!");
+        ret = std::max(ret, cnt);
+      }
+    return ret;
+  }
+
   void 
   pstats::
   wait() const
@@ -6,6 +6,7 @@
 
 #include "ug_typedefs.h"
 #include "ug_bitext_jstats.h"
+#include "ug_bitext_sample_pool.h"
 #include "moses/thread_safe_container.h"
 
 namespace sapt
@@ -56,7 +57,28 @@ namespace sapt
 		 size_t const num_pairs, // # of phrases extractable here
 		 int const po_fwd,       // fwd phrase orientation
 		 int const po_bwd);      // bwd phrase orientation
+
+    // count_sample() followed by add() for the /n/ distinct target
+    // phrases extracted at that sample, under a single lock; returns the
+    // largest joint count among them
+    size_t
+    add_sample(int const docid, size_t const num_pairs,
+               int const po_fwd, int const po_bwd, float const b,
+               SamplePool::Pair const* pairs, size_t const n);
+
+    // add_sample() for all occurrences in /pool/, in order, under a
+    // single lock; docids[i] and biases[i] belong to occurrence i
+    void
+    add_samples(SamplePool const& pool, int const* docids,
+                float const* biases);
     void wait() const;
+
+  private:
+    // add_sample() for callers that already hold the lock
+    size_t
+    add_sample_locked(int const docid, size_t const num_pairs,
+                      int const po_fwd, int const po_bwd, float const b,
+                      SamplePool::Pair const* pairs, size_t const n);
   };
 
 }
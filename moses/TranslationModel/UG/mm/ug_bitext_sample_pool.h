@@ -0,0 +1,47 @@
+// -*- mode: c++; tab-width: 2; indent-tabs-mode: nil -*-
+#pragma once
+#include <vector>
+#include "ug_typedefs.h"
+#include "ug_ttrack_position.h"
+
+namespace sapt
+{
+  // The phrase pairs extracted at a fixed set of occurrences of a
+  // source phrase: all of them or, for frequent phrases, a uniform
+  // random sample. Nothing in here depends on a sampling bias, so a
+  // pool is shared by all contexts; samplers choose among and weigh the
+  // pooled occurrences according to their bias instead of walking the
+  // suffix array and extracting the phrase pairs again.
+  struct
+  SamplePool
+  {
+    struct Pair
+    {
+      uint64_t pid;                   // target phrase id
+      uint32_t raw2;                  // raw target phrase count
+      std::vector<unsigned char> aln; // phrase-internal word alignment
+    };
+
+    struct Occurrence
+    {
+      ttrack::Position pos;
+      uint32_t num_pairs;   // number of phrase pairs extractable here; 0: none
+      int po_fwd, po_bwd;   // phrase orientations
+      uint32_t first, stop; // distinct pairs are pairs[first,stop)
+    };
+
+    size_t raw_cnt; // occurrences of the source phrase in the corpus
+    std::vector<Occurrence> occurrences;
+    std::vector<Pair> pairs;
+
+    SamplePool() : raw_cnt(0) { }
+
+    void
+    clear()
+    {
+      raw_cnt = 0;
+      occurrences.clear();
+      pairs.clear();
+    }
+  };
+}
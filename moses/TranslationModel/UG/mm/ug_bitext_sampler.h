@@ -4,6 +4,7 @@
 #include <algorithm>
 
 #include <boost/random.hpp>
+#include <boost/unordered_map.hpp>
 #include <boost/thread.hpp>
 #include <boost/thread/locks.hpp>
 #include <boost/intrusive_ptr.hpp>
@@ -14,6 +15,7 @@
 #include "ug_sampling_bias.h"
 #include "ug_tsa_array_entry.h"
 #include "ug_bitext_phrase_extraction_record.h"
+#include "ug_bitext_sample_pool.h"
 #include "moses/TranslationModel/UG/generic/threading/ug_ref_counter.h"
 #include "moses/TranslationModel/UG/generic/threading/ug_thread_safe_counter.h"
 #include "moses/TranslationModel/UG/generic/sorting/NBestList.h"
@@ -47,6 +49,9 @@ BitextSampler : public Moses::reference_counter
   typedef TSA<Token>       tsa;
   typedef SamplingBias    bias_t;
   typedef typename Bitext<Token>::iter tsa_iter;
+  // target phrase id and raw count, by the word ids of the target phrase
+  typedef std::pair<uint64_t, uint32_t> trg_phrase;
+  typedef boost::unordered_map<std::vector<id_type>, trg_phrase> trg_cache_t;
   mutable boost::condition_variable   m_ready; 
   mutable boost::mutex                 m_lock; 
   // const members
@@ -62,6 +67,7 @@ BitextSampler : public Moses::reference_counter
   SPTR<bias_t const> const         m_bias; // bias over candidates
   size_t             const      m_samples; // how many samples at most 
   size_t             const  m_min_samples;
+  uint64_t           const          m_pid; // id of lookup phrase
   // non-const members
   SPTR<pstats>                m_stats; // destination for phrase stats
   size_t                        m_ctr; // number of samples considered
@@ -70,11 +76,25 @@ BitextSampler : public Moses::reference_counter
   size_t m_num_occurrences; // estimated number of phrase occurrences in corpus
   boost::taus88 m_rnd;  // every job has its own pseudo random generator
   double m_bias_total;
+  size_t m_options; // number of occurrences to choose from
+  SamplePool m_scratch; // extraction results of the current sample
+  PhraseExtractionScratch m_buffers; // reused for each sampled sentence
+  trg_cache_t m_trg_cache; // target phrases looked up so far
+  std::vector<id_type> m_trg_key; // lookup key for m_trg_cache
 
   size_t consider_sample(TokenPosition const& p);
   size_t perform_random_sampling();
   size_t perform_full_phrase_extraction();
 
+  // bias-independent part of considering a sample
+  void extract(TokenPosition const& p, SamplePool& dest);
+  trg_phrase const& lookup_trg(Token const* o, size_t const start,
+                               size_t const stop, SPTR<tsa_iter>& b);
+  size_t count_sample(SamplePool const& pool, SamplePool::Occurrence const& o);
+
+  SPTR<SamplePool const> sample_pool();
+  size_t perform_pooled_sampling(SamplePool const& pool);
+
   int check_sample_distribution(uint64_t const& sid, uint64_t const& offset);
   bool flip_coin(id_type const& sid, ushort const& offset, SamplingBias const* bias);
     
@@ -166,7 +186,7 @@ flip_coin(id_type const& sid, ushort const& offset, bias_t const* bias)
   if (no_maybe_yes > 1)  return true;  // yes
   // ... maybe: flip a coin
   size_t options_chosen = m_stats->good;
-  size_t options_total  = std::max(m_stats->raw_cnt, m_ctr);
+  size_t options_total  = std::max(m_options, m_ctr);
   size_t options_left   = (options_total - m_ctr);
   size_t random_number  = options_left * (m_rnd()/(m_rnd.max()+1.));
   size_t threshold;
@@ -196,11 +216,14 @@ BitextSampler(SPTR<Bitext<Token> const> const& bitext,
   , m_bias(bias)
   , m_samples(max_samples)
   , m_min_samples(min_samples)
+  , m_pid(phrase.getPid())
   , m_ctr(0)
   , m_total_bias(0)
   , m_finished(false)
   , m_num_occurrences(phrase.ca())
   , m_rnd(0)
+  , m_bias_total(0)
+  , m_options(phrase.ca())
 {
   m_stats.reset(new pstats);
   m_stats->raw_cnt = phrase.ca();
@@ -220,6 +243,7 @@ BitextSampler(BitextSampler const& other)
   , m_bias(other.m_bias)
   , m_samples(other.m_samples)
   , m_min_samples(other.m_min_samples)
+  , m_pid(other.m_pid)
   , m_num_occurrences(other.m_num_occurrences)
   , m_rnd(0)
 {
@@ -232,6 +256,8 @@ BitextSampler(BitextSampler const& other)
   m_ctr = other.m_ctr; 
   m_total_bias = other.m_total_bias;
   m_finished = other.m_finished;
+  m_bias_total = other.m_bias_total;
+  m_options = other.m_options;
 }
 
 // Uniform sampling 
@@ -240,12 +266,28 @@ size_t
 BitextSampler<Token>::
 perform_full_phrase_extraction()
 {
+  // Every occurrence is a sample, so they are extracted in batches and
+  // each batch is added to the stats under a single lock.
+  size_t const batch_size = 1000;
   if (m_next == m_stop) return m_ctr;
-  for (sapt::tsa::ArrayEntry I(m_next); I.next < m_stop; ++m_ctr)
+  for (sapt::tsa::ArrayEntry I(m_next); I.next < m_stop;)
     {
-      ++m_ctr;
-      m_root->readEntry(I.next, I);
-      consider_sample(I);
+      m_scratch.clear();
+      for (; I.next < m_stop && m_scratch.occurrences.size() < batch_size; ++m_ctr)
+        {
+          ++m_ctr;
+          m_root->readEntry(I.next, I);
+          extract(I, m_scratch);
+        }
+      std::vector<int> docids(m_scratch.occurrences.size());
+      std::vector<float> biases(docids.size());
+      for (size_t i = 0; i < docids.size(); ++i)
+        {
+          id_type const sid = m_scratch.occurrences[i].pos.sid;
+          docids[i] = m_bias ? m_bias->GetClass(sid) : m_bitext->sid2did(sid);
+          biases[i] = m_bias ? (*m_bias)[sid] : 1;
+        }
+      m_stats->add_samples(m_scratch, &docids[0], &biases[0]);
     }
   return m_ctr;
 }
@@ -270,6 +312,7 @@ perform_random_sampling()
           m_bias_total += (*m_bias)[I.sid];
         }
       I.next = m_next;
+      m_options = m_stats->raw_cnt;
     }
       
   while (m_stats->good < m_samples && I.next < m_stop)
@@ -286,62 +329,184 @@ template<typename Token>
 size_t
 BitextSampler<Token>::
 consider_sample(TokenPosition const& p)
+{
+  m_scratch.clear();
+  extract(p, m_scratch);
+  return count_sample(m_scratch, m_scratch.occurrences.back());
+}
+
+// Extract the phrase pairs at occurrence /p/ and append them to /dest/.
+template<typename Token>
+void
+BitextSampler<Token>::
+extract(TokenPosition const& p, SamplePool& dest)
 {
   std::vector<unsigned char> aln; 
-  bitvector full_aln(100*100);
   PhraseExtractionRecord 
-    rec(p.sid, p.offset, p.offset + m_plen, !m_fwd, &aln, &full_aln);
-  int docid = m_bias ? m_bias->GetClass(p.sid) : m_bitext->sid2did(p.sid);
-  if (!m_bitext->find_trg_phr_bounds(rec))
+    rec(p.sid, p.offset, p.offset + m_plen, !m_fwd, &aln, NULL, &m_buffers);
+  SamplePool::Occurrence occ;
+  occ.pos = p;
+  occ.num_pairs = 0;
+  occ.first = occ.stop = dest.pairs.size();
+  bool const coherent = m_bitext->find_trg_phr_bounds(rec);
+  occ.po_fwd = rec.po_fwd;
+  occ.po_bwd = rec.po_bwd;
+  if (!coherent) 
     { // no good, probably because phrase is not coherent
-      m_stats->count_sample(docid, 0, rec.po_fwd, rec.po_bwd);
-      return 0;
+      dest.occurrences.push_back(occ);
+      return;
     }
     
-  // all good: register this sample as valid
-  size_t num_pairs = (rec.s2 - rec.s1 + 1) * (rec.e2 - rec.e1 + 1);
-  m_stats->count_sample(docid, num_pairs, rec.po_fwd, rec.po_bwd);
-    
-  float sample_weight = 1./num_pairs;
+  occ.num_pairs = (rec.s2 - rec.s1 + 1) * (rec.e2 - rec.e1 + 1);
   Token const* o = (m_fwd ? m_bitext->T2 : m_bitext->T1)->sntStart(rec.sid);
     
   // adjust offsets in phrase-internal aligment
   for (size_t k = 1; k < aln.size(); k += 2) 
     aln[k] += rec.s2 - rec.s1;
     
-  std::vector<uint64_t> seen; seen.reserve(10);
   // It is possible that the phrase extraction extracts the same
   // phrase twice, e.g., when word a co-occurs with sequence b b b but
   // is aligned only to the middle word. We can only count each phrase
   // pair once per source phrase occurrence, or else run the risk of
   // having more joint counts than marginal counts.
-    
-  size_t max_evidence = 0;
   for (size_t s = rec.s1; s <= rec.s2; ++s)
     {
-      TSA<Token> const& I = m_fwd ? *m_bitext->I2 : *m_bitext->I1;
-      SPTR<tsa_iter> b = I.find(o + s, rec.e1 - s);
-      UTIL_THROW_IF2(!b || b->size() < rec.e1 - s, "target phrase not found");
-	
+      SPTR<tsa_iter> b; // suffix array node of the target phrase, if needed
+      m_trg_key.clear();
+      for (size_t i = s; i < rec.e1; ++i)
+        m_trg_key.push_back(o[i].id());
       for (size_t i = rec.e1; i <= rec.e2; ++i)
         {
-          uint64_t tpid = b->getPid();
-          if (find(seen.begin(), seen.end(), tpid) != seen.end()) 
-            continue; // don't over-count
-          seen.push_back(tpid);
-          size_t raw2 = b->approxOccurrenceCount();
-          size_t evid = m_stats->add(tpid, sample_weight, 
-                                     m_bias ? (*m_bias)[p.sid] : 1, 
-                                     aln, raw2, rec.po_fwd, rec.po_bwd, docid);
-          max_evidence = std::max(max_evidence, evid);
-          bool ok = (i == rec.e2) || b->extend(o[i].id());
-          UTIL_THROW_IF2(!ok, "Could not extend target phrase.");
+          if (i > rec.e1) m_trg_key.push_back(o[i-1].id());
+          trg_phrase const& t = lookup_trg(o, s, i, b);
+          bool seen = false;
+          for (size_t k = occ.first; k < dest.pairs.size() && !seen; ++k)
+            seen = dest.pairs[k].pid == t.first;
+          if (!seen) // don't over-count
+            {
+              dest.pairs.push_back(SamplePool::Pair());
+              dest.pairs.back().pid  = t.first;
+              dest.pairs.back().raw2 = t.second;
+              dest.pairs.back().aln  = aln;
+            }
         }
       if (s < rec.s2) // shift phrase-internal alignments
         for (size_t k = 1; k < aln.size(); k += 2)
           --aln[k];
     }
-  return max_evidence;
+  occ.stop = dest.pairs.size();
+  dest.occurrences.push_back(occ);
+}
+
+// Id and raw count of the target phrase o[start,stop), whose word ids
+// are in m_trg_key. The same target phrases are extracted at many
+// occurrences of the source phrase, so they are looked up in the
+// suffix array only once per sampler. /b/ is the suffix array node of
+// o[start,stop-1) if the previous phrase was not in the cache and NULL
+// otherwise; it is moved on to o[start,stop) here.
+template<typename Token>
+typename BitextSampler<Token>::trg_phrase const&
+BitextSampler<Token>::
+lookup_trg(Token const* o, size_t const start, size_t const stop,
+           SPTR<tsa_iter>& b)
+{
+  typename trg_cache_t::iterator m = m_trg_cache.find(m_trg_key);
+  if (m != m_trg_cache.end())
+    {
+      b.reset(); // no longer in step with the phrase
+      return m->second;
+    }
+  if (b)
+    {
+      bool ok = b->extend(o[stop-1].id());
+      UTIL_THROW_IF2(!ok, "Could not extend target phrase.");
+    }
+  else
+    {
+      TSA<Token> const& I = m_fwd ? *m_bitext->I2 : *m_bitext->I1;
+      b = I.find(o + start, stop - start);
+      UTIL_THROW_IF2(!b || b->size() < stop - start, "target phrase not found");
+    }
+  trg_phrase const t(b->getPid(), b->approxOccurrenceCount());
+  return m_trg_cache.insert(std::make_pair(m_trg_key, t)).first->second;
+}
+
+// Register an extracted occurrence as a sample.
+template<typename Token>
+size_t
+BitextSampler<Token>::
+count_sample(SamplePool const& pool, SamplePool::Occurrence const& o)
+{
+  id_type const sid = o.pos.sid;
+  int docid = m_bias ? m_bias->GetClass(sid) : m_bitext->sid2did(sid);
+  float const bias = m_bias ? (*m_bias)[sid] : 1;
+  SamplePool::Pair const* pairs = o.stop > o.first ? &pool.pairs[o.first] : NULL;
+  return m_stats->add_sample(docid, o.num_pairs, o.po_fwd, o.po_bwd, bias,
+                             pairs, o.stop - o.first);
+}
+
+// The pool of extracted occurrences of the lookup phrase, built on
+// first use; NULL if pooling is off or not worth it for this phrase.
+template<typename Token>
+SPTR<SamplePool const>
+BitextSampler<Token>::
+sample_pool()
+{
+  size_t const size = m_bitext->m_sample_pool_size;
+  if (size == 0 || m_num_occurrences <= m_bitext->m_pstats_cache_threshold)
+    return SPTR<SamplePool const>();
+  typename bitext::pool_cache_t& cache 
+    = m_fwd ? m_bitext->m_pool_cache1 : m_bitext->m_pool_cache2;
+  SPTR<SamplePool> pool = cache.get(m_pid);
+  if (pool) return pool;
+
+  // Keep all occurrences or, if there are more, a uniform random
+  // sample of /size/ of them (selection sampling, Knuth's algorithm S).
+  // Two threads may build the same pool at the same time; the one that
+  // finishes last wins.
+  pool.reset(new SamplePool);
+  sapt::tsa::ArrayEntry I(m_next);
+  while (I.next < m_stop)
+    {
+      m_root->readEntry(I.next,I);
+      ++pool->raw_cnt;
+    }
+  size_t left = pool->raw_cnt;
+  pool->occurrences.reserve(std::min(size, left));
+  for (I.next = m_next; I.next < m_stop; --left)
+    {
+      m_root->readEntry(I.next,I);
+      size_t const wanted = size - pool->occurrences.size();
+      if (wanted && left * (m_rnd()/(m_rnd.max()+1.)) < wanted)
+        extract(I, *pool);
+    }
+  cache.set(m_pid, pool);
+  return pool;
+}
+
+// Random sampling among the pooled occurrences, with the same coin
+// flips as perform_random_sampling().
+template<typename Token>
+size_t
+BitextSampler<Token>::
+perform_pooled_sampling(SamplePool const& pool)
+{
+  m_stats->raw_cnt = pool.raw_cnt;
+  m_options = pool.occurrences.size();
+  m_bias_total = 0;
+  if (m_bias)
+    {
+      BOOST_FOREACH(SamplePool::Occurrence const& o, pool.occurrences)
+        m_bias_total += (*m_bias)[o.pos.sid];
+    }
+  for (size_t i = 0; m_stats->good < m_samples && i < pool.occurrences.size(); ++i)
+    {
+      SamplePool::Occurrence const& o = pool.occurrences[i];
+      ++m_ctr;
+      if (!flip_coin(o.pos.sid, o.pos.offset, m_bias.get())) continue;
+      count_sample(pool, o);
+    }
+  return m_ctr;
 }
   
 #ifndef MMT
@@ -355,7 +520,11 @@ operator()()
   if (m_method == full_coverage)
     perform_full_phrase_extraction(); // consider all occurrences 
   else if (m_method == random_sampling)
-    perform_random_sampling();
+    {
+      SPTR<SamplePool const> pool = sample_pool();
+      if (pool) perform_pooled_sampling(*pool);
+      else perform_random_sampling();
+    }
   else UTIL_THROW2("Unsupported sampling method.");
   m_finished = true;
   m_ready.notify_all();
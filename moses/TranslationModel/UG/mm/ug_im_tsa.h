@@ -3,9 +3,6 @@
 #ifndef _ug_im_tsa_h
 #define _ug_im_tsa_h
 
-// TO DO:
-// - multi-threaded sorting during TSA construction (currently painfully slow!)
-
 #include <iostream>
 
 #include <boost/iostreams/device/mapped_file.hpp>
@@ -37,7 +34,7 @@ namespace sapt
     iter m_begin;
     iter m_end;
   public:
-    TsaSorter(SORTER sorter, iter& begin, iter& end)
+    TsaSorter(SORTER sorter, iter begin, iter end)
       : m_sorter(sorter),
         m_begin(begin),
         m_end(end) { }
@@ -51,6 +48,96 @@ namespace sapt
     
   };
 
+  // merges the sorted ranges [begin,middle) and [middle,end)
+  template<typename TOKEN, typename SORTER>
+  class TsaMerger
+  {
+  public:
+    typedef typename Ttrack<TOKEN>::Position cpos;
+    typedef typename std::vector<cpos>::iterator iter;
+  private:
+    SORTER m_sorter;
+    iter m_begin;
+    iter m_middle;
+    iter m_end;
+  public:
+    TsaMerger(SORTER sorter, iter begin, iter middle, iter end)
+      : m_sorter(sorter),
+        m_begin(begin),
+        m_middle(middle),
+        m_end(end) { }
+
+    bool
+    operator()()
+    {
+      std::inplace_merge(m_begin, m_middle, m_end, m_sorter);
+      return true;
+    }
+  };
+
+  // Sorts the ranges [bounds[i],bounds[i+1]) of /sufa/ with /threads/
+  // threads. Token frequencies are Zipfian, so the ranges of the most
+  // frequent first tokens hold a large share of all positions and would
+  // keep one thread busy long after the others are done. Ranges larger
+  // than a fair share of the work are therefore sorted in chunks that
+  // are merged pairwise afterwards.
+  template<typename TOKEN, typename SORTER>
+  void
+  sort_tsa_ranges(std::vector<typename Ttrack<TOKEN>::Position>& sufa,
+                  std::vector<filepos_type> const& bounds,
+                  SORTER const& sorter, size_t const threads)
+  {
+    typedef typename std::vector<typename Ttrack<TOKEN>::Position>::iterator iter;
+    if (threads < 2 || sufa.size() < (1<<16))
+      { // not worth starting any threads (e.g. for dynamic additions)
+        for (size_t i = 0; i + 1 < bounds.size(); ++i)
+          std::sort(sufa.begin() + bounds[i], sufa.begin() + bounds[i+1], sorter);
+        return;
+      }
+    size_t const chunk = std::max<size_t>(sufa.size() / (4 * threads), 1<<16);
+    // chunk boundaries of the ranges that were split
+    std::vector<std::vector<filepos_type> > runs;
+    {
+      ug::ThreadPool tpool(threads);
+      for (size_t i = 0; i + 1 < bounds.size(); ++i)
+        {
+          if (bounds[i+1] - bounds[i] < 2) continue;
+          std::vector<filepos_type> r;
+          for (filepos_type k = bounds[i]; k < bounds[i+1]; k += chunk)
+            r.push_back(k);
+          r.push_back(bounds[i+1]);
+          for (size_t k = 1; k < r.size(); ++k)
+            {
+              TsaSorter<TOKEN,SORTER> job(sorter, sufa.begin() + r[k-1],
+                                          sufa.begin() + r[k]);
+              tpool.add(job);
+            }
+          if (r.size() > 2) runs.push_back(r);
+        }
+    } // the pool's destructor waits for all jobs to finish
+
+    while (runs.size())
+      {
+        std::vector<std::vector<filepos_type> > next;
+        {
+          ug::ThreadPool tpool(threads);
+          BOOST_FOREACH(std::vector<filepos_type> const& r, runs)
+            {
+              std::vector<filepos_type> m(1, r[0]);
+              for (size_t k = 2; k < r.size(); k += 2)
+                {
+                  iter b = sufa.begin();
+                  TsaMerger<TOKEN,SORTER> job(sorter, b + r[k-2], b + r[k-1], b + r[k]);
+                  tpool.add(job);
+                  m.push_back(r[k]);
+                }
+              if (r.size() % 2 == 0) m.push_back(r.back()); // odd one out
+              if (m.size() > 2) next.push_back(m);
+            }
+        }
+        runs.swap(next);
+      }
+  }
 
  //-----------------------------------------------------------------------
   template<typename TOKEN>
@@ -83,7 +170,8 @@ namespace sapt
 
     imTSA(imTSA<TOKEN> const& prior,
 	  boost::shared_ptr<imTtrack<TOKEN> const> const&   crp,
-	  std::vector<id_type> const& newsids, size_t const vsize);
+	  std::vector<id_type> const& newsids, size_t const vsize,
+	  size_t threads = 0);
 
     count_type
     sntCnt(char const* p, char const * const q) const;
@@ -230,30 +318,14 @@ namespace sapt
 #ifndef NO_MOSES
     double start_time = util::WallTime();
 #endif
-    boost::scoped_ptr<ug::ThreadPool> tpool;
-    tpool.reset(new ug::ThreadPool(threads));
-    
     index.resize(wcnt.size()+1,0);
-    typedef typename ttrack::Position::LESS<Ttrack<TOKEN> > sorter_t;
-    sorter_t sorter(c.get());
     for (size_t i = 0; i < wcnt.size(); i++)
       {
-        // if (log && wcnt[i] > 5000)
-        //   *log << "sorting " << wcnt[i]
-        //        << " entries starting with id " << i << "." << std::endl;
         index[i+1] = index[i]+wcnt[i];
         assert(index[i+1]==tmp[i]); // sanity check
-        if (wcnt[i]>1)
-	  {
-	    typename std::vector<cpos>::iterator b,e;
-	    b = sufa.begin()+index[i];
-	    e = sufa.begin()+index[i+1];
-	    TsaSorter<TOKEN,sorter_t> foo(sorter,b,e);
-	    tpool->add(foo);
-	    // sort(sufa.begin()+index[i],sufa.begin()+index[i+1],sorter);
-	  }
       }
-    tpool.reset();
+    typedef typename ttrack::Position::LESS<Ttrack<TOKEN> > sorter_t;
+    sort_tsa_ranges<TOKEN>(sufa, index, sorter_t(c.get()), threads);
 #ifndef NO_MOSES
     if (log) *log << "Done sorting after " << util::WallTime() - start_time
 		  << " seconds." << std::endl;
@@ -407,86 +479,63 @@ namespace sapt
   imTSA<TOKEN>::
   imTSA(imTSA<TOKEN> const& prior,
         boost::shared_ptr<imTtrack<TOKEN> const> const&   crp,
-        std::vector<id_type> const& newsids, size_t const vsize)
+        std::vector<id_type> const& newsids, size_t const vsize,
+        size_t threads)
   {
-    typename ttrack::Position::LESS<Ttrack<TOKEN> > sorter(crp.get());
-
-    // count how many tokens will be added to the TSA
-    // and index the new additions to the corpus
-    size_t newToks = 0;
-    BOOST_FOREACH(id_type sid, newsids)
-      newToks += crp->sntLen(sid);
-    std::vector<cpos> nidx(newToks); // new array entries
+    if (threads == 0)
+      threads = boost::thread::hardware_concurrency();
+    typedef typename ttrack::Position::LESS<Ttrack<TOKEN> > sorter_t;
+    sorter_t sorter(crp.get());
 
-    size_t n = 0;
+    // index the new additions to the corpus, placing them into one
+    // range per first token as in the constructor above
+    std::vector<filepos_type> nbounds(vsize+1, 0);
     BOOST_FOREACH(id_type sid, newsids)
       {
 	assert(sid < crp->size());
-  	for (size_t o = 0; o < (*crp)[sid].size(); ++o, ++n)
-  	  { nidx[n].offset = o; nidx[n].sid  = sid; }
+        for (TOKEN const* t = crp->sntStart(sid); t < crp->sntEnd(sid); ++t)
+          ++nbounds[t->id()+1];
       }
-    sort(nidx.begin(),nidx.end(),sorter);
+    for (size_t i = 1; i < nbounds.size(); ++i)
+      nbounds[i] += nbounds[i-1];
+    std::vector<cpos> nidx(nbounds.back()); // new array entries
+    std::vector<filepos_type> next(nbounds.begin(), nbounds.end() - 1);
+    BOOST_FOREACH(id_type sid, newsids)
+      {
+        TOKEN const* t = crp->sntStart(sid);
+        for (ushort o = 0; t < crp->sntEnd(sid); ++t, ++o)
+          {
+            cpos& p = nidx[next[t->id()]++];
+            p.sid = sid;
+            p.offset = o;
+          }
+      }
+    sort_tsa_ranges<TOKEN>(nidx, nbounds, sorter, threads);
 
-    // create the new suffix array
-    this->numTokens = newToks + prior.sufa.size();
+    // create the new suffix array, merging old and new entries range by range
+    this->numTokens = nidx.size() + prior.sufa.size();
     this->sufa.resize(this->numTokens);
+    this->index.assign(vsize+1, 0);
+    typename std::vector<cpos>::iterator k = this->sufa.begin();
+    for (size_t i = 0; i < vsize; ++i)
+      {
+        typename std::vector<cpos>::const_iterator a, z;
+        a = z = prior.sufa.begin();
+        if (i + 1 < prior.index.size())
+          {
+            a += prior.index[i];
+            z += prior.index[i+1];
+          }
+        k = std::merge(a, z, nidx.begin() + nbounds[i], nidx.begin() + nbounds[i+1],
+                       k, sorter);
+        this->index[i+1] = k - this->sufa.begin();
+      }
+    assert(k == this->sufa.end());
     this->startArray = reinterpret_cast<char const*>(&(*this->sufa.begin()));
     this->endArray   = reinterpret_cast<char const*>(&(*this->sufa.end()));
     this->corpusSize = crp->size();
     this->corpus     = crp;
-    this->index.resize(vsize+1);
-
-    size_t i = 0;
-    typename std::vector<cpos>::iterator k = this->sufa.begin();
-    // cerr << newToks << " new items at "
-    // << __FILE__ << ":" << __LINE__ << std::endl;
-    for (size_t n = 0; n < nidx.size();)
-      {
-  	id_type nid = crp->getToken(nidx[n])->id();
-  	assert(nid >= i);
-  	while (i < nid)
-  	  {
-  	    this->index[i] = k - this->sufa.begin();
-  	    if (++i < prior.index.size() && prior.index[i-1] < prior.index[i])
-  	      {
-  		k = copy(prior.sufa.begin() + prior.index[i-1],
-  			 prior.sufa.begin() + prior.index[i], k);
-  	      }
-  	  }
-	this->index[i] = k - this->sufa.begin();
-  	if (++i < prior.index.size() && prior.index[i] > prior.index[i-1])
-  	  {
-  	    size_t j = prior.index[i-1];
-  	    while (j < prior.index[i] && n < nidx.size()
-  		   && crp->getToken(nidx[n])->id() < i)
-  	      {
-  		assert(k < this->sufa.end());
-  		if (sorter(prior.sufa[j],nidx[n]))
-  		  *k++ = prior.sufa[j++];
-  		else
-  		  *k++ = nidx[n++];
-  	      }
-  	    while (j < prior.index[i])
-  	      {
-  		assert(k < this->sufa.end());
-  		*k++ = prior.sufa[j++];
-  	      }
-  	  }
-  	while (n < nidx.size() && this->corpus->getToken(nidx[n])->id() < i)
-  	  {
-  	    assert(k < this->sufa.end());
-  	    *k++ = nidx[n++];
-  	  }
-  	this->index[i] = k - this->sufa.begin();
-      }
-    this->index[i] = k - this->sufa.begin();
-    while (++i < this->index.size())
-      {
-  	if (i < prior.index.size() && prior.index[i-1] < prior.index[i])
-  	  k = copy(prior.sufa.begin() + prior.index[i-1],
-  		   prior.sufa.begin() + prior.index[i], k);
-  	this->index[i] = k - this->sufa.begin();
-      }
+    this->indexSize  = this->index.size();
 #if 0
     // sanity checks
     assert(this->sufa.size() == this->index.back());
@@ -197,7 +197,7 @@ namespace sapt
   boost::shared_ptr<imTtrack<TOKEN> >
   append(boost::shared_ptr<imTtrack<TOKEN> > const& crp, std::vector<TOKEN> const & snt)
   {
-#if 1
+#ifndef NDEBUG // linear in the size of the track
     if (crp) crp->m_check_token_count();
 #endif
     boost::shared_ptr<imTtrack<TOKEN> > ret;
@@ -210,13 +210,14 @@ namespace sapt
       {
   	ret.reset(new imTtrack<TOKEN>());
 	ret->myData->reserve(crp->size() + IMTTRACK_INCREMENT_SIZE);
-	copy(crp->myData->begin(),crp->myData->end(),ret->myData->begin());
+	ret->myData->assign(crp->myData->begin(),crp->myData->end());
+	ret->numToks = crp->numToks;
       }
     else ret = crp;
     ret->myData->push_back(snt);
     ret->numToks += snt.size();
 
-#if 1
+#ifndef NDEBUG
     ret->m_check_token_count();
 #endif
     return ret;
@@ -43,6 +43,9 @@ namespace sapt
     // plup: permissive lookup
     float plup_fwd(id_type const s,id_type const t, float const alpha) const;
     float plup_bwd(id_type const s,id_type const t, float const alpha) const;
+    // both of the above with a single table lookup
+    void  plup(id_type const s, id_type const t, float const alpha,
+               float& fwd, float& bwd) const;
     // to be done:
     // - on-the-fly smoothing ?
     // - better (than permissive-lookup) treatment of unknown combinations
@@ -67,16 +70,21 @@ namespace sapt
 	std::vector<some_int> const & aln, float const alpha,
 	float & fwd_score, float& bwd_score) const
   {
-    std::vector<float> p1(e1,0), p2(e2,0);
-    std::vector<int>   c1(e1,0), c2(e2,0);
+    // one buffer each for both sides
+    std::vector<float> p(e1+e2,0);
+    std::vector<int>   c(e1+e2,0);
+    float* p1 = &p[0]; float* p2 = p1 + e1;
+    int*   c1 = &c[0]; int*   c2 = c1 + e1;
     size_t i1=0,i2=0;
+    float fwd, bwd;
     for (size_t k = 0; k < aln.size(); ++k)
       {
 	i1 = aln[k]; i2 = aln[++k];
 	if (i1 < s1 || i1 >= e1 || i2 < s2 || i2 >= e2) continue;
-	p1[i1] += plup_fwd(snt1[i1].id(),snt2[i2].id(),alpha);
+	plup(snt1[i1].id(), snt2[i2].id(), alpha, fwd, bwd);
+	p1[i1] += fwd;
 	++c1[i1];
-	p2[i2] += plup_bwd(snt1[i1].id(),snt2[i2].id(),alpha);
+	p2[i2] += bwd;
 	++c2[i2];
       }
     fwd_score = 0;
@@ -133,6 +141,26 @@ namespace sapt
     return ret;
   }
 
+  template<typename TKN>
+  void
+  LexicalPhraseScorer2<TKN>::
+  plup(id_type const s, id_type const t, float const alpha,
+       float& fwd, float& bwd) const
+  {
+    uint32_t const m1 = COOC.m1(s), m2 = COOC.m2(t);
+    if (m1 == 0 || m2 == 0) { fwd = bwd = 1.0; return; }
+    UTIL_THROW_IF2(alpha < 0,"At " << __FILE__ << ":" << __LINE__
+		   << ": alpha parameter must be >= 0");
+    float ret = COOC[s][t]+alpha;
+    if (!ret) ret = 1.;
+    fwd = ret/(m1+alpha);
+    bwd = ret/(m2+alpha);
+    UTIL_THROW_IF2(fwd <= 0 || fwd > 1 || bwd <= 0 || bwd > 1,
+		   "At " << __FILE__ << ":" << __LINE__
+		   << ": result not > 0 and <= 1. alpha = " << alpha << "; "
+		   << COOC[s][t] << "/" << m1 << "/" << m2);
+  }
+
   template<typename TKN>
   void
   LexicalPhraseScorer2<TKN>::
@@ -141,16 +169,20 @@ namespace sapt
 	char const* const aln_start, char const* const aln_end,
 	float const alpha, float & fwd_score, float& bwd_score) const
   {
-    std::vector<float> p1(e1,0), p2(e2,0);
-    std::vector<int>   c1(e1,0), c2(e2,0);
+    std::vector<float> p(e1+e2,0);
+    std::vector<int>   c(e1+e2,0);
+    float* p1 = &p[0]; float* p2 = p1 + e1;
+    int*   c1 = &c[0]; int*   c2 = c1 + e1;
     size_t i1=0,i2=0;
+    float fwd, bwd;
     for (char const* x = aln_start; x < aln_end;)
       {
 	x = tpt::binread(tpt::binread(x,i1),i2);
 	if (i1 < s1 || i1 >= e1 || i2 < s2 || i2 >= e2) continue;
-	p1[i1] += plup_fwd(snt1[i1].id(), snt2[i2].id(),alpha);
+	plup(snt1[i1].id(), snt2[i2].id(), alpha, fwd, bwd);
+	p1[i1] += fwd;
 	++c1[i1];
-	p2[i2] += plup_bwd(snt1[i1].id(), snt2[i2].id(),alpha);
+	p2[i2] += bwd;
 	++c2[i2];
       }
     fwd_score = 0;
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <boost/shared_ptr.hpp>
 #include <boost/thread.hpp>
+#include <boost/unordered_map.hpp>
 #include <sys/time.h>
 
 
@@ -21,83 +22,86 @@ namespace lru_cache
   public:
     typedef boost::unordered_map<KEY,uint32_t> map_t;
   private:
+    static uint32_t const NIL = uint32_t(-1);
     struct Record
     {
-      uint32_t prev,next;
+      uint32_t prev,next; // neighbours in the queue
       KEY            key;
       // timeval      tstamp; // time stamp
       typename boost::shared_ptr<VAL> ptr; // cached shared ptr
     };
 
     mutable boost::shared_mutex m_lock;
-    uint32_t m_qfront, m_qback;
+    uint32_t m_qfront, m_qback; // least and most recently used record
     std::vector<Record> m_recs;
     map_t m_idx;
 
+    // CALLER MUST LOCK for the functions below!
     void
-    update_queue(KEY const& key, uint32_t const p)
+    unlink(uint32_t const p)
     {
-      // CALLER MUST LOCK!
-      // "remove" item in slot p from it's current position of the
-      // queue (which is different from the slot position) and move it
-      // to the end
       Record& r = m_recs[p];
-      if (m_recs.size() == 1)
-	r.next = r.prev = m_qback = m_qfront = 0;
-
-      if (r.key != key || p == m_qback) return;
+      if (r.prev == NIL) m_qfront = r.next;
+      else m_recs[r.prev].next = r.next;
+      if (r.next == NIL) m_qback = r.prev;
+      else m_recs[r.next].prev = r.prev;
+    }
 
-      if (m_qfront == p)
-	m_qfront = m_recs[r.next].prev = r.next;
-      else
-	{
-	  m_recs[r.prev].next = r.next;
-	  m_recs[r.next].prev = r.prev;
-	}
+    void
+    push_back(uint32_t const p)
+    {
+      Record& r = m_recs[p];
       r.prev = m_qback;
-      m_recs[r.prev].next = m_qback = r.next = p;
+      r.next = NIL;
+      if (m_qback == NIL) m_qfront = p;
+      else m_recs[m_qback].next = p;
+      m_qback = p;
     }
 
   public:
-    LRU_Cache(size_t capacity=1) : m_qfront(0), m_qback(0) { reserve(capacity); }
+    LRU_Cache(size_t capacity=1) : m_qfront(NIL), m_qback(NIL) { reserve(capacity); }
     size_t capacity() const { return m_recs.capacity(); }
-    size_t size() const { return m_idx.size(); }
+    size_t size() const
+    {
+      boost::shared_lock<boost::shared_mutex> rlock(m_lock);
+      return m_idx.size();
+    }
+    // must be called before the cache is used
     void reserve(size_t s) { m_recs.reserve(s); }
 
     SPTR<VAL>
     get(KEY const& key)
     {
-      uint32_t p;
-      { // brackets needed for lock scoping
-	boost::shared_lock<boost::shared_mutex> rlock(m_lock);
-	typename map_t::const_iterator i = m_idx.find(key);
-	if (i == m_idx.end()) return SPTR<VAL>();
-	p = i->second;
-      }
       boost::lock_guard<boost::shared_mutex> guard(m_lock);
-      update_queue(key,p);
-      return m_recs[p].ptr;
+      typename map_t::const_iterator i = m_idx.find(key);
+      if (i == m_idx.end()) return SPTR<VAL>();
+      unlink(i->second);
+      push_back(i->second);
+      return m_recs[i->second].ptr;
     }
 
     void
     set(KEY const& key, SPTR<VAL> const& ptr)
     {
       boost::lock_guard<boost::shared_mutex> lock(m_lock);
+      if (m_recs.capacity() == 0) return;
       std::pair<typename map_t::iterator,bool> foo;
-      foo = m_idx.insert(make_pair(key,m_recs.size()));
+      foo = m_idx.insert(std::make_pair(key,uint32_t(m_recs.size())));
       uint32_t p = foo.first->second;
       if (foo.second) // was not in the cache
 	{
 	  if (m_recs.size() < m_recs.capacity())
 	    m_recs.push_back(Record());
-	  else
+	  else // recycle the least recently used record
 	    {
 	      foo.first->second = p = m_qfront;
 	      m_idx.erase(m_recs[p].key);
+	      unlink(p);
 	    }
 	  m_recs[p].key = key;
 	}
-      update_queue(key,p);
+      else unlink(p);
+      push_back(p);
       m_recs[p].ptr = ptr;
     }
   };
@@ -142,6 +142,18 @@ namespace sapt
     char const* arrayStart() const { return startArray; }
     char const* arrayEnd()   const { return endArray;   }
 
+    /** set [lo,hi) to the range of entries that start with token /id/
+     *  @return false if there are none
+     */
+    bool
+    getTokenRange(id_type const id, char const*& lo, char const*& hi) const
+    {
+      if (id + 1 >= indexSize) return false;
+      lo = getLowerBound(id);
+      hi = getUpperBound(id);
+      return lo < hi;
+    }
+
     /** @return a pointer to the beginning of the index entry range covering
      *  [keyStart,keyStop)
      */
@@ -186,6 +186,15 @@ namespace Moses
     dflt = pair<string,string> ("min-sample","0");
     m_min_sample_size = atoi(param.insert(dflt).first->second.c_str());
 
+    // Pool up to this many extracted occurrences of frequent phrases
+    // and sample from the pools for every context and bias instead of
+    // from the suffix array. 0 (default): sample from the suffix array.
+    dflt = pair<string,string> ("sample-pool","0");
+    m_sample_pool_size = atoi(param.insert(dflt).first->second.c_str());
+
+    dflt = pair<string,string> ("sample-pool-phrases","10000");
+    m_sample_pool_phrases = atoi(param.insert(dflt).first->second.c_str());
+
     dflt = pair<string,string>("workers","0");
     m_workers = atoi(param.insert(dflt).first->second.c_str());
     if (m_workers == 0) m_workers = StaticData::Instance().ThreadCount();
@@ -310,6 +319,8 @@ namespace Moses
     known_parameters.push_back("prov");
     known_parameters.push_back("rare");
     known_parameters.push_back("sample");
+    known_parameters.push_back("sample-pool");
+    known_parameters.push_back("sample-pool-phrases");
     known_parameters.push_back("min-sample");
     known_parameters.push_back("smooth");
     known_parameters.push_back("table-limit");
@@ -501,6 +512,7 @@ namespace Moses
     btfix->m_num_workers = this->m_workers;
     btfix->open(m_bname, L1, L2);
     btfix->setDefaultSampleSize(m_default_sample_size);
+    btfix->setSamplePool(m_sample_pool_size, m_sample_pool_phrases);
 
     btdyn.reset(new imbitext(btfix->V1, btfix->V2, m_default_sample_size, m_workers));
     if (m_bias_file.size())
@@ -795,7 +807,30 @@ namespace Moses
   void
   Mmsapt::
   CleanUpAfterSentenceProcessing(ttasksptr const& ttask)
-  { }
+  {
+    // Report what the scope holds for this table, so that the server
+    // can bound the memory of its sessions. These are rough averages:
+    // a phrase's sampling statistics, a phrase's target phrase
+    // collection, and a document or sentence bias entry.
+    static size_t const pstats_bytes = 4096;
+    static size_t const tpcoll_bytes = 16384;
+    static size_t const bias_bytes = 16;
+
+    SPTR<ContextScope> const& scope = ttask->GetScope();
+    size_t bytes = 0;
+    SPTR<ContextForQuery> context = scope->get<ContextForQuery>(btfix.get());
+    if (context)
+      {
+        boost::shared_lock<boost::shared_mutex> ctxlock(context->lock);
+        if (context->bias) bytes += context->bias->size() * bias_bytes;
+        if (context->cache1) bytes += context->cache1->size() * pstats_bytes;
+        if (context->cache2) bytes += context->cache2->size() * pstats_bytes;
+      }
+    SPTR<TPCollCache> localcache = scope->get<TPCollCache>(cache_key);
+    if (localcache && localcache != m_cache)
+      bytes += localcache->size() * tpcoll_bytes;
+    scope->Charge(this, bytes);
+  }
 
 
   ChartRuleLookupManager*
@@ -82,6 +82,8 @@ namespace Moses
     // must be > 0 if dynamic
     size_t m_default_sample_size;
     size_t m_min_sample_size;
+    size_t m_sample_pool_size;    // occurrences pooled per frequent phrase
+    size_t m_sample_pool_phrases; // phrases pooled per direction
     size_t m_workers;  // number of worker threads for sampling the bitexts
     std::vector<std::string> m_feature_set_names; // one or more of: standard, datasource
     std::string m_bias_logfile;
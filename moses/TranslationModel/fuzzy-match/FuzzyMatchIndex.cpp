@@ -0,0 +1,224 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include "FuzzyMatchIndex.h"
+
+#ifdef WITH_THREADS
+#include <boost/shared_ptr.hpp>
+#include "moses/ThreadPool.h"
+#endif
+
+using namespace std;
+
+namespace tmmt
+{
+
+namespace
+{
+// stands for the sentence boundaries in bigrams
+const WORD_ID BOUNDARY = WORD_ID(-1);
+
+inline uint64_t bigram( WORD_ID a, WORD_ID b )
+{
+  return (uint64_t(a) << 32) | b;
+}
+
+/* distinct bigrams of a sentence, including those with the boundaries */
+void get_bigrams( const vector< WORD_ID > &sentence, vector< uint64_t > &bigrams )
+{
+  bigrams.clear();
+  WORD_ID prev = BOUNDARY;
+  for(size_t i=0; i<sentence.size(); i++) {
+    bigrams.push_back( bigram( prev, sentence[i] ) );
+    prev = sentence[i];
+  }
+  bigrams.push_back( bigram( prev, BOUNDARY ) );
+  sort( bigrams.begin(), bigrams.end() );
+  bigrams.erase( unique( bigrams.begin(), bigrams.end() ), bigrams.end() );
+}
+
+bool shorter( const vector< unsigned int > *a, const vector< unsigned int > *b )
+{
+  return a->size() < b->size();
+}
+}
+
+unsigned int word_sed( const vector< WORD_ID > &a, const vector< WORD_ID > &b )
+{
+  return WordPattern( a ).Distance( b );
+}
+
+FuzzyMatchIndex::FuzzyMatchIndex( const vector< vector< WORD_ID > > &corpus, size_t numThreads )
+  :m_corpus(corpus)
+  ,m_numThreads(max< size_t >(numThreads, 1))
+{
+#ifdef WITH_THREADS
+  if (m_numThreads > 1)
+    m_pool.reset( new Moses::ThreadPool( m_numThreads-1 ) );
+#endif
+  cerr << "indexing " << corpus.size() << " sentences for fuzzy matching" << endl;
+  vector< uint64_t > bigrams;
+  for(size_t s=0; s<corpus.size(); s++) {
+    get_bigrams( corpus[s], bigrams );
+    for(size_t i=0; i<bigrams.size(); i++) {
+      m_postings[ bigrams[i] ].push_back( s );
+    }
+    if (corpus[s].size() >= m_byLength.size())
+      m_byLength.resize( corpus[s].size()+1 );
+    m_byLength[ corpus[s].size() ].push_back( s );
+  }
+}
+
+FuzzyMatchIndex::~FuzzyMatchIndex()
+{
+}
+
+void FuzzyMatchIndex::GetCandidates( const vector< WORD_ID > &input, unsigned int max_cost, vector< unsigned int > &candidates ) const
+{
+  int input_length = input.size();
+  candidates.clear();
+
+  vector< uint64_t > bigrams;
+  get_bigrams( input, bigrams );
+  int min_shared = int(bigrams.size()) - 2 * int(max_cost);
+
+  // no filtering possible: all sentences of similar length
+  if (min_shared <= 0) {
+    int from = max( 0, input_length - int(max_cost) );
+    int to = min( int(m_byLength.size())-1, input_length + int(max_cost) );
+    for(int length=from; length<=to; length++) {
+      candidates.insert( candidates.end(), m_byLength[length].begin(), m_byLength[length].end() );
+    }
+    sort( candidates.begin(), candidates.end() );
+    return;
+  }
+
+  // Posting lists of the input bigrams, rarest first; bigrams that do
+  // not occur in the corpus count as empty lists. A sentence that
+  // shares min_shared bigrams with the input is in at least one of the
+  // first 2 * max_cost + 1 lists.
+  size_t missing = 0;
+  vector< const Postings* > lists;
+  for(size_t i=0; i<bigrams.size(); i++) {
+    PostingMap::const_iterator p = m_postings.find( bigrams[i] );
+    if (p == m_postings.end())
+      missing++;
+    else
+      lists.push_back( &p->second );
+  }
+  size_t max_missing = bigrams.size() - min_shared;
+  if (missing > max_missing)
+    return;
+  sort( lists.begin(), lists.end(), shorter );
+
+  size_t prefix = max_missing + 1 - missing;
+  for(size_t i=0; i<prefix && i<lists.size(); i++) {
+    candidates.insert( candidates.end(), lists[i]->begin(), lists[i]->end() );
+  }
+  sort( candidates.begin(), candidates.end() );
+  candidates.erase( unique( candidates.begin(), candidates.end() ), candidates.end() );
+
+  // length filter and count filter
+  size_t kept = 0;
+  for(size_t c=0; c<candidates.size(); c++) {
+    unsigned int s = candidates[c];
+    if (abs( int(m_corpus[s].size()) - input_length ) > int(max_cost))
+      continue;
+    size_t absent = missing;
+    for(size_t i=0; i<lists.size() && absent <= max_missing; i++) {
+      if (! binary_search( lists[i]->begin(), lists[i]->end(), s ))
+        absent++;
+    }
+    if (absent <= max_missing)
+      candidates[kept++] = s;
+  }
+  candidates.resize( kept );
+}
+
+void FuzzyMatchIndex::Verify( const WordPattern &input, size_t input_length, const vector< unsigned int > &candidates, size_t start, size_t end, Result &result ) const
+{
+  for(size_t c=start; c<end; c++) {
+    const vector< WORD_ID > &tm = m_corpus[ candidates[c] ];
+    if ((unsigned int) abs( int(tm.size()) - int(input_length) ) > result.cost)
+      continue;
+    unsigned int cost = input.Distance( tm );
+    if (cost < result.cost) {
+      result.cost = cost;
+      result.ids.clear();
+    }
+    if (cost == result.cost)
+      result.ids.push_back( candidates[c] );
+  }
+}
+
+#ifdef WITH_THREADS
+/* verifies one chunk of the candidates in the pool */
+class FuzzyMatchIndex::VerifyTask : public Moses::WaitableTask
+{
+public:
+  VerifyTask( const FuzzyMatchIndex &index, const WordPattern &input, size_t input_length, const vector< unsigned int > &candidates, size_t start, size_t end, Result &result )
+    :m_index(index), m_input(input), m_inputLength(input_length), m_candidates(candidates), m_start(start), m_end(end), m_result(result) {}
+
+protected:
+  void DoRun() {
+    m_index.Verify( m_input, m_inputLength, m_candidates, m_start, m_end, m_result );
+  }
+
+private:
+  const FuzzyMatchIndex &m_index;
+  const WordPattern &m_input;
+  size_t m_inputLength;
+  const vector< unsigned int > &m_candidates;
+  size_t m_start, m_end;
+  Result &m_result;
+};
+#endif
+
+unsigned int FuzzyMatchIndex::Retrieve( const vector< WORD_ID > &input, unsigned int max_cost, vector< int > &best ) const
+{
+  vector< unsigned int > candidates;
+  GetCandidates( input, max_cost, candidates );
+  WordPattern pattern( input );
+
+  // verify the candidates in contiguous chunks, one per thread
+  size_t numChunks = min( m_numThreads, max< size_t >(candidates.size(), 1) );
+  vector< Result > results( numChunks );
+  for(size_t t=0; t<numChunks; t++) {
+    results[t].cost = max_cost;
+  }
+  size_t chunkSize = (candidates.size() + numChunks - 1) / numChunks;
+#ifdef WITH_THREADS
+  if (numChunks > 1) {
+    // the calling thread takes the first chunk itself
+    vector< boost::shared_ptr< VerifyTask > > tasks;
+    for(size_t t=1; t<numChunks; t++) {
+      size_t start = t * chunkSize;
+      size_t end = min( start + chunkSize, candidates.size() );
+      tasks.push_back( boost::shared_ptr< VerifyTask >( new VerifyTask( *this, pattern, input.size(), candidates, start, end, results[t] ) ) );
+      m_pool->Submit( tasks.back() );
+    }
+    Verify( pattern, input.size(), candidates, 0, min( chunkSize, candidates.size() ), results[0] );
+    for(size_t t=0; t<tasks.size(); t++) {
+      tasks[t]->Wait();
+    }
+  } else
+#endif
+    for(size_t t=0; t<numChunks; t++) {
+      size_t start = t * chunkSize;
+      size_t end = min( start + chunkSize, candidates.size() );
+      Verify( pattern, input.size(), candidates, start, end, results[t] );
+    }
+
+  unsigned int best_cost = max_cost;
+  for(size_t t=0; t<numChunks; t++) {
+    best_cost = min( best_cost, results[t].cost );
+  }
+  best.clear();
+  for(size_t t=0; t<numChunks; t++) {
+    if (results[t].cost == best_cost)
+      best.insert( best.end(), results[t].ids.begin(), results[t].ids.end() );
+  }
+  return best_cost;
+}
+
+}
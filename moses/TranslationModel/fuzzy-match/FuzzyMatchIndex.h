@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include <boost/scoped_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include "util/levenshtein.hh"
+#include "Vocabulary.h"
+
+namespace Moses
+{
+class ThreadPool;
+}
+
+namespace tmmt
+{
+
+/* prepared for computing the word string edit distance of a sentence
+ to others */
+typedef util::LevenshteinMatcher< WORD_ID > WordPattern;
+
+unsigned int word_sed( const std::vector< WORD_ID > &a, const std::vector< WORD_ID > &b );
+
+/* retrieval index over the source side of a translation memory.
+ An inverted index of word bigrams (including the sentence boundaries)
+ yields the sentences that may be within a given word edit distance of
+ the input: each edit destroys at most two bigrams, so such a sentence
+ shares all but 2 * max_cost of the input's distinct bigrams. These
+ candidates are then verified with word_sed(), in several threads if
+ so configured: the calling thread and a pool kept by the index. */
+class FuzzyMatchIndex
+{
+public:
+  FuzzyMatchIndex( const std::vector< std::vector< WORD_ID > > &corpus, size_t numThreads = 1 );
+  ~FuzzyMatchIndex();
+
+  /* find the corpus sentences with the lowest word edit distance to the
+   input, if that is at most max_cost. Their ids are stored in best in
+   ascending order; returns their cost, or max_cost if there are none. */
+  unsigned int Retrieve( const std::vector< WORD_ID > &input, unsigned int max_cost, std::vector< int > &best ) const;
+
+protected:
+  typedef std::vector< unsigned int > Postings;
+  typedef boost::unordered_map< uint64_t, Postings > PostingMap;
+
+  struct Result {
+    unsigned int cost;
+    std::vector< int > ids;
+  };
+
+  const std::vector< std::vector< WORD_ID > > &m_corpus;
+  PostingMap m_postings; // bigram -> ids of the sentences that contain it
+  std::vector< Postings > m_byLength; // sentence ids by sentence length
+  size_t m_numThreads;
+#ifdef WITH_THREADS
+  class VerifyTask;
+  boost::scoped_ptr< Moses::ThreadPool > m_pool; // verifies all but one chunk
+#endif
+
+  void GetCandidates( const std::vector< WORD_ID > &input, unsigned int max_cost, std::vector< unsigned int > &candidates ) const;
+  void Verify( const WordPattern &input, size_t input_length, const std::vector< unsigned int > &candidates, size_t start, size_t end, Result &result ) const;
+};
+
+}
@@ -0,0 +1,174 @@
+/***********************************************************************
+Moses - factored phrase-based language decoder
+Copyright (C) 2015- University of Edinburgh
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+***********************************************************************/
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include "FuzzyMatchIndex.h"
+
+using namespace tmmt;
+using namespace std;
+
+namespace
+{
+// textbook dynamic programming, for reference
+unsigned int dp_sed(const vector<WORD_ID> &a, const vector<WORD_ID> &b)
+{
+  vector<vector<unsigned int> > cost(a.size()+1, vector<unsigned int>(b.size()+1));
+  for (size_t i = 0; i <= a.size(); ++i) cost[i][0] = i;
+  for (size_t j = 0; j <= b.size(); ++j) cost[0][j] = j;
+  for (size_t i = 1; i <= a.size(); ++i) {
+    for (size_t j = 1; j <= b.size(); ++j) {
+      unsigned int sub = cost[i-1][j-1] + (a[i-1] == b[j-1] ? 0 : 1);
+      cost[i][j] = min(sub, min(cost[i-1][j], cost[i][j-1]) + 1);
+    }
+  }
+  return cost[a.size()][b.size()];
+}
+
+// small linear congruential generator, so that results do not depend
+// on the standard library
+struct Random {
+  unsigned int state;
+  Random(unsigned int seed) : state(seed) { }
+  unsigned int operator()(unsigned int n) {
+    state = state * 1103515245u + 12345u;
+    return (state >> 16) % n;
+  }
+};
+
+vector<WORD_ID> random_sentence(Random &random, size_t length, unsigned int vocab)
+{
+  vector<WORD_ID> ret(length);
+  for (size_t i = 0; i < length; ++i) ret[i] = random(vocab);
+  return ret;
+}
+
+// copy of a sentence with a few random edits
+vector<WORD_ID> mutate(Random &random, vector<WORD_ID> s, unsigned int edits, unsigned int vocab)
+{
+  for (unsigned int e = 0; e < edits; ++e) {
+    size_t pos = random(s.size() + 1);
+    switch (random(3)) {
+    case 0:
+      s.insert(s.begin() + pos, random(vocab));
+      break;
+    case 1:
+      if (pos < s.size()) s.erase(s.begin() + pos);
+      break;
+    default:
+      if (pos < s.size()) s[pos] = random(vocab);
+    }
+  }
+  return s;
+}
+
+void check_retrieve(const FuzzyMatchIndex &index, const vector<vector<WORD_ID> > &corpus,
+                    const vector<WORD_ID> &input, unsigned int max_cost)
+{
+  unsigned int best_cost = max_cost;
+  vector<int> expected;
+  for (size_t s = 0; s < corpus.size(); ++s) {
+    unsigned int cost = dp_sed(input, corpus[s]);
+    if (cost < best_cost) {
+      best_cost = cost;
+      expected.clear();
+    }
+    if (cost == best_cost) expected.push_back(s);
+  }
+
+  vector<int> best;
+  BOOST_CHECK_EQUAL(index.Retrieve(input, max_cost, best), best_cost);
+  BOOST_CHECK_EQUAL_COLLECTIONS(best.begin(), best.end(), expected.begin(), expected.end());
+}
+}
+
+BOOST_AUTO_TEST_SUITE(fuzzy_match_index)
+
+BOOST_AUTO_TEST_CASE(word_sed_examples)
+{
+  vector<WORD_ID> a, b;
+  BOOST_CHECK_EQUAL(word_sed(a, b), 0);
+  b.push_back(1);
+  b.push_back(2);
+  BOOST_CHECK_EQUAL(word_sed(a, b), 2);
+  BOOST_CHECK_EQUAL(word_sed(b, a), 2);
+
+  // 1 2 3 4 -> 1 3 4 5: one deletion, one insertion
+  a.clear();
+  a.push_back(1);
+  a.push_back(2);
+  a.push_back(3);
+  a.push_back(4);
+  b.clear();
+  b.push_back(1);
+  b.push_back(3);
+  b.push_back(4);
+  b.push_back(5);
+  BOOST_CHECK_EQUAL(word_sed(a, b), 2);
+  BOOST_CHECK_EQUAL(word_sed(a, a), 0);
+}
+
+// the bit-parallel algorithm is used up to 64 words, DP beyond
+BOOST_AUTO_TEST_CASE(word_sed_matches_dp)
+{
+  Random random(42);
+  const size_t lengths[] = { 0, 1, 2, 31, 32, 33, 62, 63, 64, 65, 66, 100, 128, 129 };
+  const size_t num_lengths = sizeof(lengths) / sizeof(lengths[0]);
+  for (size_t i = 0; i < num_lengths; ++i) {
+    for (size_t j = 0; j < num_lengths; ++j) {
+      for (unsigned int vocab = 2; vocab <= 20; vocab += 9) {
+        vector<WORD_ID> a = random_sentence(random, lengths[i], vocab);
+        vector<WORD_ID> b = random_sentence(random, lengths[j], vocab);
+        BOOST_CHECK_EQUAL(word_sed(a, b), dp_sed(a, b));
+        vector<WORD_ID> c = mutate(random, a, 3, vocab);
+        BOOST_CHECK_EQUAL(word_sed(a, c), dp_sed(a, c));
+        BOOST_CHECK_EQUAL(word_sed(c, a), dp_sed(c, a));
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(retrieve_matches_exhaustive_search)
+{
+  Random random(7);
+  const unsigned int vocab = 30;
+  vector<vector<WORD_ID> > corpus;
+  for (size_t s = 0; s < 300; ++s) {
+    corpus.push_back(random_sentence(random, 1 + random(70), vocab));
+  }
+  // near-duplicates, so that there are close matches to find
+  for (size_t s = 0; s < 100; ++s) {
+    corpus.push_back(mutate(random, corpus[random(300)], random(4), vocab));
+  }
+
+  FuzzyMatchIndex index(corpus);
+  FuzzyMatchIndex threaded(corpus, 3);
+  for (size_t q = 0; q < 100; ++q) {
+    vector<WORD_ID> input = mutate(random, corpus[random(corpus.size())], random(6), vocab);
+    if (q % 10 == 0) input = random_sentence(random, random(70), vocab);
+    unsigned int max_cost = 1 + input.size() * (1 + random(4)) / 10;
+    check_retrieve(index, corpus, input, max_cost);
+    check_retrieve(threaded, corpus, input, max_cost);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -20,8 +20,10 @@ using namespace std;
 namespace tmmt
 {
 
-FuzzyMatchWrapper::FuzzyMatchWrapper(const std::string &sourcePath, const std::string &targetPath, const std::string &alignmentPath)
-  :basic_flag(false)
+FuzzyMatchWrapper::FuzzyMatchWrapper(const std::string &sourcePath, const std::string &targetPath, const std::string &alignmentPath,
+                                     bool useIndex, size_t numThreads)
+  :m_index(NULL)
+  ,basic_flag(false)
   ,lsed_flag(true)
   ,refined_flag(true)
   ,length_filter_flag(true)
@@ -46,9 +48,19 @@ FuzzyMatchWrapper::FuzzyMatchWrapper(const std::string &sourcePath, const std::s
   // create suffix array
   //load_corpus(m_config[0], input);
 
+  if (useIndex) {
+    m_index = new tmmt::FuzzyMatchIndex( suffixArray->GetCorpus(), numThreads );
+  }
+
   cerr << "loading completed" << endl;
 }
 
+FuzzyMatchWrapper::~FuzzyMatchWrapper()
+{
+  delete m_index;
+  delete suffixArray;
+}
+
 string FuzzyMatchWrapper::Extract(long translationId, const string &dirNameStr)
 {
   const Moses::StaticData &staticData = Moses::StaticData::Instance();
@@ -109,20 +121,109 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
   int input_length = input[sentenceInd].size();
   int best_cost = input_length * (100-min_match) / 100 + 1;
 
+  vector< int > best_tm;
+  if (m_index) {
+    best_cost = m_index->Retrieve( input[sentenceInd], best_cost, best_tm );
+  } else {
+    best_cost = suffix_array_match( wordIndex, translationId, input[sentenceInd], best_cost, best_tm );
+  }
+
+  // create xml and extract files
+  string inputStr, sourceStr;
+  for (size_t pos = 0; pos < input_length; ++pos) {
+    inputStr += GetVocabulary().GetWord(input[sentenceInd][pos]) + " ";
+  }
+
+  // do not try to find the best ... report multiple matches
+  if (multiple_flag) {
+    for(size_t si=0; si<best_tm.size(); si++) {
+      int s = best_tm[si];
+      string path;
+      sed( input[sentenceInd], source[s], path, true );
+      const vector<WORD_ID> &sourceSentence = source[s];
+      vector<SentenceAlignment> &targets = targetAndAlignment[s];
+      create_extract(sentenceInd, best_cost, sourceSentence, targets, inputStr, path, fuzzyMatchStream);
+
+    }
+  } // if (multiple_flag)
+  else {
+
+    // find the best matches according to letter sed
+    string best_path = "";
+    int best_match = -1;
+    unsigned int best_letter_cost;
+    if (lsed_flag) {
+      best_letter_cost = compute_length( input[sentenceInd] ) * min_match / 100 + 1;
+      for(size_t si=0; si<best_tm.size(); si++) {
+        int s = best_tm[si];
+        string path;
+        unsigned int letter_cost = sed( input[sentenceInd], source[s], path, true );
+        if (letter_cost < best_letter_cost) {
+          best_letter_cost = letter_cost;
+          best_path = path;
+          best_match = s;
+        }
+      }
+    }
+    // if letter sed turned off, just compute path for first match
+    else {
+      if (best_tm.size() > 0) {
+        string path;
+        sed( input[sentenceInd], source[best_tm[0]], path, false );
+        best_path = path;
+        best_match = best_tm[0];
+      }
+    }
+    cerr << "elapsed: " << (1000 * (clock()-start_clock) / CLOCKS_PER_SEC) << endl;
+    if (lsed_flag) {
+      //cout << best_letter_cost << "/" << compute_length( input[sentenceInd] ) << " (";
+    }
+    //cout << best_cost <<"/" << input_length;
+    if (lsed_flag) {
+      //cout << ")";
+    }
+    //cout << " ||| " << best_match << " ||| " << best_path << endl;
+
+    if (best_match == -1) {
+      UTIL_THROW_IF2(source.size() == 0, "Empty source phrase");
+      best_match = 0;
+    }
+
+    // creat xml & extracts
+    const vector<WORD_ID> &sourceSentence = source[best_match];
+    vector<SentenceAlignment> &targets = targetAndAlignment[best_match];
+    create_extract(sentenceInd, best_cost, sourceSentence, targets, inputStr, best_path, fuzzyMatchStream);
+
+  } // else if (multiple_flag)
+
+  fuzzyMatchStream.close();
+
+  return fuzzyMatchFile;
+}
+
+/* find the corpus sentences closest to the input via n-gram matches
+ in the suffix array and A* parsing of these matches */
+
+int FuzzyMatchWrapper::suffix_array_match(WordIndex &wordIndex, long translationId, const vector< WORD_ID > &input, int best_cost, vector< int > &best_tm)
+{
+  const std::vector< std::vector< WORD_ID > > &source = suffixArray->GetCorpus();
+  int input_length = input.size();
+  clock_t start_clock = clock();
+
   int match_count = 0; // how many substring matches to be considered
   //cerr << endl << "sentence " << i << ", length " << input_length << ", best_cost " << best_cost << endl;
 
   // find match ranges in suffix array
   vector< vector< pair< SuffixArray::INDEX, SuffixArray::INDEX > > > match_range;
-  for(int start=0; start<input[sentenceInd].size(); start++) {
+  for(int start=0; start<input.size(); start++) {
     SuffixArray::INDEX prior_first_match = 0;
     SuffixArray::INDEX prior_last_match = suffixArray->GetSize()-1;
     vector< string > substring;
     bool stillMatched = true;
     vector< pair< SuffixArray::INDEX, SuffixArray::INDEX > > matchedAtThisStart;
     //cerr << "start: " << start;
-    for(size_t word=start; stillMatched && word<input[sentenceInd].size(); word++) {
-      substring.push_back( GetVocabulary().GetWord( input[sentenceInd][word] ) );
+    for(size_t word=start; stillMatched && word<input.size(); word++) {
+      substring.push_back( GetVocabulary().GetWord( input[word] ) );
 
       // only look up, if needed (i.e. no unnecessary short gram lookups)
       //				if (! word-start+1 <= short_match_max_length( input_length ) )
@@ -149,14 +250,14 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
   map< int, int > sentence_match_word_count;
 
   // go through all matches, longest first
-  for(int length = input[sentenceInd].size(); length >= 1; length--) {
+  for(int length = input.size(); length >= 1; length--) {
     // do not create matches, if these are handled by the short match function
     if (length <= short_match_max_length( input_length ) ) {
       continue;
     }
 
     unsigned int count = 0;
-    for(int start = 0; start <= input[sentenceInd].size() - length; start++) {
+    for(int start = 0; start <= input.size() - length; start++) {
       if (match_range[start].size() >= length) {
         pair< SuffixArray::INDEX, SuffixArray::INDEX > &range = match_range[start][length-1];
         // cerr << " (" << range.first << "," << range.second << ")";
@@ -244,9 +345,8 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
   int tm_count_word_match2 = 0;
   int pruned_match_count = 0;
   if (short_match_max_length( input_length )) {
-    init_short_matches(wordIndex, translationId, input[sentenceInd] );
+    init_short_matches(wordIndex, translationId, input );
   }
-  vector< int > best_tm;
   typedef map< int, vector< Match > >::iterator I;
 
   clock_t clock_validation_sum = 0;
@@ -290,7 +390,7 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
     if (! parse_flag ||
         pruned.size()>=10) { // to prevent worst cases
       string path;
-      cost = sed( input[sentenceInd], source[tmID], path, false );
+      cost = sed( input, source[tmID], path, false );
       if (cost <  best_cost) {
         best_cost = cost;
       }
@@ -314,83 +414,11 @@ string FuzzyMatchWrapper::ExtractTM(WordIndex &wordIndex, long translationId, co
        << " best: " << best_tm.size() << endl;
 
   cerr << "pruned matches: " << ((float)pruned_match_count/(float)tm_count_word_match2) << endl;
-
-  // create xml and extract files
-  string inputStr, sourceStr;
-  for (size_t pos = 0; pos < input_length; ++pos) {
-    inputStr += GetVocabulary().GetWord(input[sentenceInd][pos]) + " ";
-  }
-
-  // do not try to find the best ... report multiple matches
-  if (multiple_flag) {
-    for(size_t si=0; si<best_tm.size(); si++) {
-      int s = best_tm[si];
-      string path;
-      sed( input[sentenceInd], source[s], path, true );
-      const vector<WORD_ID> &sourceSentence = source[s];
-      vector<SentenceAlignment> &targets = targetAndAlignment[s];
-      create_extract(sentenceInd, best_cost, sourceSentence, targets, inputStr, path, fuzzyMatchStream);
-
-    }
-  } // if (multiple_flag)
-  else {
-
-    // find the best matches according to letter sed
-    string best_path = "";
-    int best_match = -1;
-    unsigned int best_letter_cost;
-    if (lsed_flag) {
-      best_letter_cost = compute_length( input[sentenceInd] ) * min_match / 100 + 1;
-      for(size_t si=0; si<best_tm.size(); si++) {
-        int s = best_tm[si];
-        string path;
-        unsigned int letter_cost = sed( input[sentenceInd], source[s], path, true );
-        if (letter_cost < best_letter_cost) {
-          best_letter_cost = letter_cost;
-          best_path = path;
-          best_match = s;
-        }
-      }
-    }
-    // if letter sed turned off, just compute path for first match
-    else {
-      if (best_tm.size() > 0) {
-        string path;
-        sed( input[sentenceInd], source[best_tm[0]], path, false );
-        best_path = path;
-        best_match = best_tm[0];
-      }
-    }
-    cerr << "elapsed: " << (1000 * (clock()-start_clock) / CLOCKS_PER_SEC)
-         << " ( range: " << (1000 * (clock_range-start_clock) / CLOCKS_PER_SEC)
-         << " match: " << (1000 * (clock_matches-clock_range) / CLOCKS_PER_SEC)
-         << " tm: " << (1000 * (clock()-clock_matches) / CLOCKS_PER_SEC)
-         << " (validation: " << (1000 * (clock_validation_sum) / CLOCKS_PER_SEC) << ")"
-         << " )" << endl;
-    if (lsed_flag) {
-      //cout << best_letter_cost << "/" << compute_length( input[sentenceInd] ) << " (";
-    }
-    //cout << best_cost <<"/" << input_length;
-    if (lsed_flag) {
-      //cout << ")";
-    }
-    //cout << " ||| " << best_match << " ||| " << best_path << endl;
-
-    if (best_match == -1) {
-      UTIL_THROW_IF2(source.size() == 0, "Empty source phrase");
-      best_match = 0;
-    }
-
-    // creat xml & extracts
-    const vector<WORD_ID> &sourceSentence = source[best_match];
-    vector<SentenceAlignment> &targets = targetAndAlignment[best_match];
-    create_extract(sentenceInd, best_cost, sourceSentence, targets, inputStr, best_path, fuzzyMatchStream);
-
-  } // else if (multiple_flag)
-
-  fuzzyMatchStream.close();
-
-  return fuzzyMatchFile;
+  cerr << "range: " << (1000 * (clock_range-start_clock) / CLOCKS_PER_SEC)
+       << " match: " << (1000 * (clock_matches-clock_range) / CLOCKS_PER_SEC)
+       << " tm: " << (1000 * (clock()-clock_matches) / CLOCKS_PER_SEC)
+       << " (validation: " << (1000 * (clock_validation_sum) / CLOCKS_PER_SEC) << ")" << endl;
+  return best_cost;
 }
 
 void FuzzyMatchWrapper::load_corpus( const std::string &fileName, vector< vector< WORD_ID > > &corpus )
@@ -516,7 +544,7 @@ bool FuzzyMatchWrapper::GetLSEDCache(const std::pair< WORD_ID, WORD_ID > &key, u
 #ifdef WITH_THREADS
   boost::shared_lock<boost::shared_mutex> read_lock(m_accessLock);
 #endif
-  map< pair< WORD_ID, WORD_ID >, unsigned int >::const_iterator lookup = m_lsed.find( key );
+  boost::unordered_map< pair< WORD_ID, WORD_ID >, unsigned int >::const_iterator lookup = m_lsed.find( key );
   if (lookup != m_lsed.end()) {
     value = lookup->second;
     return true;
@@ -15,7 +15,9 @@
 
 #include <fstream>
 #include <string>
+#include <boost/unordered_map.hpp>
 #include "SuffixArray.h"
+#include "FuzzyMatchIndex.h"
 #include "Vocabulary.h"
 #include "Match.h"
 #include "moses/InputType.h"
@@ -28,7 +30,11 @@ struct SentenceAlignment;
 class FuzzyMatchWrapper
 {
 public:
-  FuzzyMatchWrapper(const std::string &source, const std::string &target, const std::string &alignment);
+  /* useIndex: retrieve matches with a FuzzyMatchIndex instead of the
+   suffix array, verifying candidates in numThreads threads */
+  FuzzyMatchWrapper(const std::string &source, const std::string &target, const std::string &alignment,
+                    bool useIndex = false, size_t numThreads = 1);
+  ~FuzzyMatchWrapper();
 
   std::string Extract(long translationId, const std::string &dirNameStr);
 
@@ -36,6 +42,7 @@ protected:
   // tm-mt
   std::vector< std::vector< tmmt::SentenceAlignment > > targetAndAlignment;
   tmmt::SuffixArray *suffixArray;
+  tmmt::FuzzyMatchIndex *m_index;
   int basic_flag;
   int lsed_flag;
   int refined_flag;
@@ -49,7 +56,7 @@ protected:
   typedef std::map< WORD_ID,std::vector< int > > WordIndex;
 
   // global cache for word pairs
-  std::map< std::pair< WORD_ID, WORD_ID >, unsigned int > m_lsed;
+  boost::unordered_map< std::pair< WORD_ID, WORD_ID >, unsigned int > m_lsed;
 #ifdef WITH_THREADS
   //reader-writer lock
   mutable boost::shared_mutex m_accessLock;
@@ -68,6 +75,7 @@ protected:
   unsigned int compute_length( const std::vector< tmmt::WORD_ID > &sentence );
   unsigned int letter_sed( WORD_ID aIdx, WORD_ID bIdx );
   unsigned int sed( const std::vector< WORD_ID > &a, const std::vector< WORD_ID > &b, std::string &best_path, bool use_letter_sed );
+  int suffix_array_match(WordIndex &wordIndex, long translationId, const std::vector< WORD_ID > &input, int best_cost, std::vector< int > &best_tm);
   void init_short_matches(WordIndex &wordIndex, long translationId, const std::vector< WORD_ID > &input );
   int short_match_max_length( int input_length );
   void add_short_matches(WordIndex &wordIndex, long translationId, std::vector< Match > &match, const std::vector< WORD_ID > &tm, int input_length, int best_cost );
@@ -75,7 +75,7 @@ TranslationTask
 TranslationTask
 ::TranslationTask(boost::shared_ptr<InputType> const& source,
                   boost::shared_ptr<IOWrapper> const& ioWrapper)
-  : m_source(source) , m_ioWrapper(ioWrapper)
+  : m_deadline(0), m_source(source) , m_ioWrapper(ioWrapper)
 {
   m_options = source->options();
 }
@@ -48,7 +48,8 @@ protected:
   boost::weak_ptr<TranslationTask> m_self; // weak ptr to myself
   boost::shared_ptr<ContextScope> m_scope; // sores local info
   // pointer to ContextScope, which stores context-specific information
-  TranslationTask() { } ;
+  double m_deadline; // wall clock time (util::WallTime) to stop searching; 0 = none
+  TranslationTask() : m_deadline(0) { } ;
   TranslationTask(boost::shared_ptr<Moses::InputType> const& source,
                   boost::shared_ptr<Moses::IOWrapper> const& ioWrapper);
   // Yes, the constructor is protected.
@@ -136,6 +137,16 @@ public:
 
   AllOptions::ptr const& options() const;
 
+  // The search gives up once the wall clock passes the deadline and
+  // returns the best hypothesis found so far, as with -time-out.
+  double GetDeadline() const {
+    return m_deadline;
+  }
+
+  void SetDeadline(double deadline) {
+    m_deadline = deadline;
+  }
+
 protected:
   boost::shared_ptr<Moses::InputType> m_source;
   boost::shared_ptr<Moses::IOWrapper> m_ioWrapper;
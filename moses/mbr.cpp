@@ -14,6 +14,9 @@
 #include "moses/Util.h"
 #include "mbr.h"
 
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
+
 using namespace std ;
 using namespace Moses;
 
@@ -35,21 +38,63 @@ using namespace Moses;
 int BLEU_ORDER = 4;
 int SMOOTH = 1;
 float min_interval = 1e-4;
-void extract_ngrams(const vector<const Factor* >& sentence, map < vector < const Factor* >, int >  & allngrams)
+namespace
+{
+
+//! Interns the n-grams of an n-best list to dense ids
+class NgramIds
 {
+public:
+  size_t GetId(const vector<const Factor*>& ngram) {
+    pair<boost::unordered_map<vector<const Factor*>, size_t>::iterator, bool> inserted =
+      m_ids.insert(make_pair(ngram, m_orders.size()));
+    if (inserted.second) {
+      m_orders.push_back(ngram.size());
+    }
+    return inserted.first->second;
+  }
+
+  const vector<size_t>& GetOrders() const {
+    return m_orders;
+  }
+
+private:
+  boost::unordered_map<vector<const Factor*>, size_t> m_ids;
+  vector<size_t> m_orders;
+};
+
+}
+
+void extract_ngrams(const vector<const Factor* >& sentence, NgramIds& ids, NgramCounts& allngrams)
+{
+  allngrams.clear();
   vector< const Factor* > ngram;
   for (int k = 0; k < BLEU_ORDER; k++) {
     for(int i =0; i < max((int)sentence.size()-k,0); i++) {
       for ( int j = i; j<= i+k; j++) {
         ngram.push_back(sentence[j]);
       }
-      ++allngrams[ngram];
+      allngrams.push_back(make_pair(ids.GetId(ngram), 1));
       ngram.clear();
     }
   }
+
+  // sort by id and merge repeats, so that two sentences can be matched
+  // with a single merge
+  sort(allngrams.begin(), allngrams.end());
+  size_t last = 0;
+  for (size_t i = 1; i < allngrams.size(); ++i) {
+    if (allngrams[i].first == allngrams[last].first) {
+      allngrams[last].second += allngrams[i].second;
+    } else {
+      allngrams[++last] = allngrams[i];
+    }
+  }
+  if (!allngrams.empty()) allngrams.resize(last + 1);
 }
 
-float calculate_score(const vector< vector<const Factor*> > & sents, int ref, int hyp,  vector < map < vector < const Factor *>, int > > & ngram_stats )
+float calculate_score(const vector< vector<const Factor*> > & sents, int ref, int hyp,
+                      const vector<NgramCounts> & ngram_stats, const vector<size_t>& ngram_orders)
 {
   int comps_n = 2*BLEU_ORDER+1;
   vector<int> comps(comps_n);
@@ -62,14 +107,20 @@ float calculate_score(const vector< vector<const Factor*> > & sents, int ref, in
     comps[2*i+1] = max(hyp_length-i,0);
   }
 
-  map< vector < const Factor * > ,int > & hyp_ngrams = ngram_stats[hyp] ;
-  map< vector < const Factor * >, int > & ref_ngrams = ngram_stats[ref] ;
-
-  for (map< vector< const Factor * >, int >::iterator it = hyp_ngrams.begin();
-       it != hyp_ngrams.end(); it++) {
-    map< vector< const Factor * >, int >::iterator ref_it = ref_ngrams.find(it->first);
-    if(ref_it != ref_ngrams.end()) {
-      comps[2* (it->first.size()-1)] += min(ref_it->second,it->second);
+  const NgramCounts & hyp_ngrams = ngram_stats[hyp] ;
+  const NgramCounts & ref_ngrams = ngram_stats[ref] ;
+
+  NgramCounts::const_iterator it = hyp_ngrams.begin();
+  NgramCounts::const_iterator ref_it = ref_ngrams.begin();
+  while (it != hyp_ngrams.end() && ref_it != ref_ngrams.end()) {
+    if (it->first < ref_it->first) {
+      ++it;
+    } else if (ref_it->first < it->first) {
+      ++ref_it;
+    } else {
+      comps[2* (ngram_orders[it->first]-1)] += min(ref_it->second,it->second);
+      ++it;
+      ++ref_it;
     }
   }
   comps[comps_n-1] = sents[ref].size();
@@ -96,7 +147,8 @@ const TrellisPath doMBR(const TrellisPathList& nBestList, AllOptions const& opts
   vector<float> joint_prob_vec;
   vector< vector<const Factor*> > translations;
   float joint_prob;
-  vector< map < vector <const Factor *>, int > > ngram_stats;
+  NgramIds ngram_ids;
+  vector<NgramCounts> ngram_stats;
 
   TrellisPathList::const_iterator iter;
 
@@ -121,10 +173,8 @@ const TrellisPath doMBR(const TrellisPathList& nBestList, AllOptions const& opts
     GetOutputFactors(path, oFactors[0], translation);
 
     // collect n-gram counts
-    map < vector < const Factor *>, int > counts;
-    extract_ngrams(translation,counts);
-
-    ngram_stats.push_back(counts);
+    ngram_stats.push_back(NgramCounts());
+    extract_ngrams(translation, ngram_ids, ngram_stats.back());
     translations.push_back(translation);
   }
 
@@ -140,7 +190,7 @@ const TrellisPath doMBR(const TrellisPathList& nBestList, AllOptions const& opts
     weightedLossCumul = 0;
     for (unsigned int j = 0; j < nBestList.GetSize(); j++) {
       if ( i != j) {
-        bleu = calculate_score(translations, j, i,ngram_stats );
+        bleu = calculate_score(translations, j, i, ngram_stats, ngram_ids.GetOrders());
         weightedLoss = ( 1 - bleu) * ( joint_prob_vec[j]/marginal);
         weightedLossCumul += weightedLoss;
         if (weightedLossCumul > minMBRLoss)
@@ -30,10 +30,13 @@ void
 GetOutputFactors(const Moses::TrellisPath &path, Moses::FactorType const f,
                  std::vector <const Moses::Factor*> &translation);
 
+//! (n-gram id, count) pairs of a sentence, sorted by id
+typedef std::vector<std::pair<size_t, int> > NgramCounts;
+
 float
 calculate_score(const std::vector< std::vector<const Moses::Factor*> > & sents,
                 int ref, int hyp,
-                std::vector<std::map<std::vector<const Moses::Factor*>,int> > &
-                ngram_stats );
+                const std::vector<NgramCounts> & ngram_stats,
+                const std::vector<size_t> & ngram_orders);
 
 #endif
@@ -11,6 +11,7 @@ namespace Moses {
     , ratio(0.6f)
     , map_weight(0.8f)
     , pruning_factor(30)
+    , threads(1)
   { }
 
   bool
@@ -23,6 +24,7 @@ namespace Moses {
     param.SetParameter(precision, "lmbr-p", 0.8f);
     param.SetParameter(map_weight, "lmbr-map-weight", 0.0f);
     param.SetParameter(pruning_factor, "lmbr-pruning-factor", size_t(30));
+    param.SetParameter(threads, "lmbr-threads", size_t(1));
     param.SetParameter(use_lattice_hyp_set, "lattice-hypo-set", false);
     
     PARAM_VEC const* params = param.GetParam("lmbr-thetas");
@@ -17,6 +17,7 @@ namespace Moses
     float ratio;     //! decaying factor for ngram thetas - see Tromble et al 08
     float map_weight; //! Weight given to the map solution. See Kumar et al 09 
     size_t pruning_factor; //! average number of nodes per word wanted in pruned lattice
+    size_t threads; //! threads used to compute the ngram posteriors of one lattice
     std::vector<float> theta; //! theta(s) for lattice mbr calculation
     bool init(Parameter const& param);
     LMBR_Options();
@@ -39,13 +39,19 @@ ServerOptions()
   : is_serial(false)
   , numThreads(15) // why 15?
   , sessionTimeout(1800) // = 30 min
-  , sessionCacheSize(25)
+  , sessionCacheSize(0) // no limit
+  , sessionMemory(0)
   , port(8080)
   , maxConn(15)
   , maxConnBacklog(15)
   , keepaliveTimeout(15)
   , keepaliveMaxConn(30)
   , timeout(15)
+  , numWorkers(15)
+  , queueSize(64)
+  , timeBudget(0)
+  , batchSize(4)
+  , batchMaxLength(10)
 { }
 
 ServerOptions::
@@ -72,11 +78,23 @@ init(Parameter const& P)
   P.SetParameter(this->keepaliveMaxConn,"server-keepalive-maxconn", 30);
   P.SetParameter(this->timeout,"server-timeout",15);
 
+  // the request queue between connection threads and translation workers
+  P.SetParameter(this->numWorkers, "server-workers", size_t(this->numThreads));
+  P.SetParameter(this->queueSize, "server-queue-size", size_t(64));
+  P.SetParameter(this->timeBudget, "server-time-budget", size_t(0));
+  P.SetParameter(this->batchSize, "server-batch-size", size_t(4));
+  P.SetParameter(this->batchMaxLength, "server-batch-max-length", size_t(10));
+
   // the stuff below is related to Moses translation sessions
   std::string timeout_spec;
   P.SetParameter(timeout_spec, "session-timeout",std::string("30m"));
   this->sessionTimeout = parse_timespec(timeout_spec);
-  P.SetParameter(this->sessionCacheSize, "session-cache_size", size_t(25));
+  // older configurations spell it session-cache_size
+  P.SetParameter(this->sessionCacheSize, "session-cache_size", size_t(0));
+  P.SetParameter(this->sessionCacheSize, "session-cache-size", this->sessionCacheSize);
+  size_t megabytes;
+  P.SetParameter(megabytes, "session-memory", size_t(0));
+  this->sessionMemory = megabytes << 20;
 
   return true;
 }
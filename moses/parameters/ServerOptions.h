@@ -13,6 +13,7 @@ namespace Moses
     
     size_t sessionTimeout;   // this is related to Moses translation sessions
     size_t sessionCacheSize; // this is related to Moses translation sessions
+    size_t sessionMemory;    // this is related to Moses translation sessions
 
     int port;              // this is for the abyss server
     std::string logfile;   // this is for the abyss server
@@ -21,6 +22,12 @@ namespace Moses
     int keepaliveTimeout;  // this is for the abyss server
     int keepaliveMaxConn;  // this is for the abyss server
     int timeout;           // this is for the abyss server
+
+    size_t numWorkers;     // threads translating queued requests
+    size_t queueSize;      // max. number of requests waiting for a worker
+    size_t timeBudget;     // default time budget of a request in ms, 0 = none
+    size_t batchSize;      // max. number of short requests taken at once
+    size_t batchMaxLength; // max. source length of a short request
     
     bool init(Parameter const& param);
     ServerOptions(Parameter const& param);
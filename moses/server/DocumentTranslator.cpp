@@ -0,0 +1,75 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width:2  -*-
+
+#include "DocumentTranslator.h"
+#include "TranslationRequest.h"
+#include "Server.h"
+#include <boost/foreach.hpp>
+
+namespace MosesServer
+{
+
+using namespace std;
+
+DocumentTranslator::
+DocumentTranslator(Server& server)
+  : Translator(server)
+{
+  this->_signature = "S:S";
+  this->_help = "Translates a document given as an array of sentences";
+}
+
+void
+DocumentTranslator::
+execute(xmlrpc_c::paramList const& paramList,
+        xmlrpc_c::value *   const  retvalP)
+{
+  typedef std::map<std::string, xmlrpc_c::value> params_t;
+  params_t const& params = paramList.getStruct(0);
+  params_t::const_iterator si = params.find("text");
+  if (si == params.end() || si->second.type() != xmlrpc_c::value::TYPE_ARRAY)
+    throw xmlrpc_c::fault("Missing source document",
+                          xmlrpc_c::fault::CODE_PARSE);
+  vector<xmlrpc_c::value> const sentences
+    = xmlrpc_c::value_array(si->second).vectorValueValue();
+  double const stop = deadline(params);
+
+  // all sentence requests report to the same condition variable
+  boost::condition_variable cond;
+  boost::mutex mut;
+  boost::shared_ptr<TranslationRequest> doc;
+  doc = TranslationRequest::create(this, paramList, cond, mut);
+  doc->ParseSettings();
+
+  vector<boost::shared_ptr<TranslationRequest> > tasks(sentences.size());
+  vector<size_t> lengths(sentences.size());
+  for (size_t i = 0; i < sentences.size(); ++i)
+    {
+      string const text = xmlrpc_c::value_string(sentences[i]);
+      tasks[i] = TranslationRequest::create(this, paramList, cond, mut);
+      tasks[i]->ShareSettings(*doc, text);
+      lengths[i] = count_words(text);
+    }
+  if (tasks.size() && !m_server.queue().submit(tasks, lengths, stop))
+    throw xmlrpc_c::fault("Server is busy, request refused",
+                          xmlrpc_c::fault::CODE_LIMIT_EXCEEDED);
+  {
+    boost::unique_lock<boost::mutex> lock(mut);
+    BOOST_FOREACH(boost::shared_ptr<TranslationRequest> const& t, tasks)
+      while (!t->IsDone()) cond.wait(lock);
+  }
+
+  vector<xmlrpc_c::value> translations;
+  translations.reserve(tasks.size());
+  BOOST_FOREACH(boost::shared_ptr<TranslationRequest> const& t, tasks)
+    {
+      if (t->GetError().size())
+        throw xmlrpc_c::fault(t->GetError(),
+                              xmlrpc_c::fault::code_t(t->GetErrorCode()));
+      translations.push_back(xmlrpc_c::value_struct(t->GetRetData()));
+    }
+  std::map<std::string, xmlrpc_c::value> ret;
+  ret["translations"] = xmlrpc_c::value_array(translations);
+  *retvalP = xmlrpc_c::value_struct(ret);
+}
+
+}
@@ -0,0 +1,26 @@
+// -*- c++ -*-
+#pragma once
+
+#include "Translator.h"
+
+namespace MosesServer
+{
+
+  // translate-batch: translates the sentences of a document (an array
+  // in "text") in parallel on the request queue workers and returns the
+  // results in document order under "translations". All other request
+  // parameters apply to the whole document; the session, options and
+  // context scope are set up once and shared by the sentences, so
+  // context-dependent models (e.g. the Mmsapt bias) are initialized
+  // only once per document.
+  class
+  DocumentTranslator : public Translator
+  {
+  public:
+    DocumentTranslator(Server& server);
+
+    void execute(xmlrpc_c::paramList const& paramList,
+		 xmlrpc_c::value *   const  retvalP);
+  };
+
+}
@@ -0,0 +1,27 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#include "Reloader.h"
+#include "Server.h"
+
+namespace MosesServer
+{
+  Reloader::
+  Reloader(Server& server)
+    : m_server(server)
+  {
+    this->_signature = "S:,S:S";
+    this->_help = "Experimental: reloads configuration and models without "
+      "downtime. Sessions, their context weights and phrase table updates "
+      "are lost; both generations are in memory while the new one loads.";
+  }
+
+  void
+  Reloader::
+  execute(xmlrpc_c::paramList const& paramList,
+	  xmlrpc_c::value *   const  retvalP)
+  {
+    std::map<std::string, xmlrpc_c::value> ret;
+    ret["pid"] = xmlrpc_c::value_int(m_server.reload());
+    *retvalP = xmlrpc_c::value_struct(ret);
+  }
+
+}
@@ -0,0 +1,27 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#pragma once
+#include <xmlrpc-c/base.hpp>
+#include <xmlrpc-c/registry.hpp>
+#include <xmlrpc-c/server_abyss.hpp>
+
+namespace MosesServer
+{
+  class Server;
+
+  // Starts a new server generation that reloads configuration and
+  // models, see Server::reload(). Returns at once; the current
+  // generation keeps serving until the new one is ready.
+  // Experimental; regression-testing/run-single-test.perl --reload
+  // translates under load across a reload.
+  class
+  Reloader : public xmlrpc_c::method
+  {
+    Server& m_server;
+  public:
+    Reloader(Server& server);
+
+    void execute(xmlrpc_c::paramList const& paramList,
+		 xmlrpc_c::value *   const  retvalP);
+  };
+
+}
@@ -0,0 +1,249 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#include "RequestQueue.h"
+#include "TranslationRequest.h"
+#include "moses/Util.h"
+#include "util/usage.hh"
+#include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <algorithm>
+#include <exception>
+
+namespace MosesServer
+{
+using namespace std;
+
+LogHistogram::
+LogHistogram(size_t const buckets)
+  : m_counts(buckets, 0), m_total(0), m_sum(0), m_max(0)
+{ }
+
+void
+LogHistogram::
+add(double const value)
+{
+  size_t b = 0;
+  for (double bound = 1; b + 1 < m_counts.size() && value >= bound; bound *= 2)
+    ++b;
+  ++m_counts[b];
+  ++m_total;
+  m_sum += value;
+  m_max = max(m_max, value);
+}
+
+double
+LogHistogram::
+quantile(double const q) const
+{
+  if (!m_total) return 0;
+  size_t const rank = max<size_t>(1, size_t(q * m_total + .5));
+  size_t seen = 0;
+  double bound = 1;
+  for (size_t b = 0; b + 1 < m_counts.size(); ++b, bound *= 2)
+    if ((seen += m_counts[b]) >= rank) return min(bound, m_max);
+  return m_max;
+}
+
+xmlrpc_c::value
+LogHistogram::
+pack() const
+{
+  map<string, xmlrpc_c::value> ret;
+  ret["count"] = xmlrpc_c::value_int(m_total);
+  ret["mean"]  = xmlrpc_c::value_double(m_total ? m_sum / m_total : 0);
+  ret["max"]   = xmlrpc_c::value_double(m_max);
+  ret["p50"]   = xmlrpc_c::value_double(quantile(.5));
+  ret["p90"]   = xmlrpc_c::value_double(quantile(.9));
+  ret["p99"]   = xmlrpc_c::value_double(quantile(.99));
+  // only up to the last non-empty bucket; bounds[i] is the exclusive
+  // upper bound of counts[i], the last bucket has none
+  size_t stop = m_counts.size();
+  while (stop && !m_counts[stop-1]) --stop;
+  vector<xmlrpc_c::value> bounds, counts;
+  double bound = 1;
+  for (size_t b = 0; b < stop; ++b, bound *= 2)
+    {
+      if (b + 1 < m_counts.size()) bounds.push_back(xmlrpc_c::value_double(bound));
+      counts.push_back(xmlrpc_c::value_int(m_counts[b]));
+    }
+  ret["bounds"] = xmlrpc_c::value_array(bounds);
+  ret["counts"] = xmlrpc_c::value_array(counts);
+  return xmlrpc_c::value_struct(ret);
+}
+
+RequestQueue::
+RequestQueue(Moses::ServerOptions const& options)
+  : m_options(options), m_stopped(false)
+  , m_running(0), m_accepted(0), m_refused(0)
+  , m_expired(0), m_failed(0), m_completed(0)
+{
+  size_t const n = max<size_t>(1, options.numWorkers);
+  for (size_t i = 0; i < n; ++i)
+    m_workers.create_thread(boost::bind(&RequestQueue::work, this));
+}
+
+RequestQueue::
+~RequestQueue()
+{
+  std::deque<Job> left;
+  {
+    boost::lock_guard<boost::mutex> lock(m_lock);
+    m_stopped = true;
+    left.swap(m_queue);
+  }
+  m_ready.notify_all();
+  BOOST_FOREACH(Job const& job, left)
+    job.request->Abort("Server is shutting down", xmlrpc_c::fault::CODE_INTERNAL);
+  m_workers.join_all();
+}
+
+bool
+RequestQueue::
+submit(boost::shared_ptr<TranslationRequest> const& request,
+       size_t const length, double const deadline)
+{
+  std::vector<boost::shared_ptr<TranslationRequest> > requests(1, request);
+  return submit(requests, std::vector<size_t>(1, length), deadline);
+}
+
+bool
+RequestQueue::
+submit(std::vector<boost::shared_ptr<TranslationRequest> > const& requests,
+       std::vector<size_t> const& lengths, double const deadline)
+{
+  size_t const n = requests.size();
+  {
+    boost::lock_guard<boost::mutex> lock(m_lock);
+    size_t const capacity = max<size_t>(1, m_options.queueSize);
+    if (m_stopped || (m_queue.size() && m_queue.size() + n > capacity))
+      {
+        m_refused += n;
+        return false;
+      }
+    double const now = util::WallTime();
+    for (size_t i = 0; i < n; ++i)
+      {
+        m_depth.add(m_queue.size());
+        Job job;
+        job.request  = requests[i];
+        job.length   = lengths[i];
+        job.enqueued = now;
+        job.deadline = deadline;
+        m_queue.push_back(job);
+      }
+    m_accepted += n;
+  }
+  if (n > 1) m_ready.notify_all();
+  else m_ready.notify_one();
+  return true;
+}
+
+void
+RequestQueue::
+take_batch(std::vector<Job>& batch)
+{
+  batch.clear();
+  batch.push_back(m_queue.front());
+  m_queue.pop_front();
+  size_t const short_length = m_options.batchMaxLength;
+  if (batch[0].length > short_length) return;
+  std::deque<Job>::iterator m = m_queue.begin();
+  while (batch.size() < m_options.batchSize && m != m_queue.end())
+    {
+      if (m->length > short_length) { ++m; continue; }
+      batch.push_back(*m);
+      m = m_queue.erase(m);
+    }
+}
+
+void
+RequestQueue::
+work()
+{
+  std::vector<Job> batch;
+  while (true)
+    {
+      {
+        boost::unique_lock<boost::mutex> lock(m_lock);
+        while (m_queue.empty() && !m_stopped) m_ready.wait(lock);
+        if (m_stopped) return;
+        take_batch(batch);
+        m_running += batch.size();
+        m_batches.add(batch.size());
+      }
+      BOOST_FOREACH(Job const& job, batch) process(job);
+      batch.clear(); // release the requests
+    }
+}
+
+void
+RequestQueue::
+process(Job const& job)
+{
+  double const start = util::WallTime();
+  bool expired = job.deadline && start > job.deadline;
+  bool failed = false;
+  if (expired)
+    {
+      job.request->Abort("Time budget exhausted while queued",
+                         xmlrpc_c::fault::CODE_TIMEOUT);
+    }
+  else
+    {
+      job.request->SetDeadline(job.deadline);
+      try
+        {
+          job.request->Run();
+        }
+      catch (xmlrpc_c::fault const& e)
+        {
+          failed = true;
+          job.request->Abort(e.getDescription(), e.getCode());
+        }
+      catch (std::exception const& e)
+        {
+          failed = true;
+          VERBOSE(1, "Translation request failed: " << e.what() << std::endl);
+          job.request->Abort(e.what(), xmlrpc_c::fault::CODE_INTERNAL);
+        }
+    }
+  double const stop = util::WallTime();
+
+  boost::lock_guard<boost::mutex> lock(m_lock);
+  --m_running;
+  if (expired) ++m_expired;
+  else if (failed) ++m_failed;
+  else ++m_completed;
+  m_waiting.add((start - job.enqueued) * 1000);
+  m_latency.add((stop - job.enqueued) * 1000);
+  if (!m_running && m_queue.empty()) m_idle.notify_all();
+}
+
+void
+RequestQueue::
+drain()
+{
+  boost::unique_lock<boost::mutex> lock(m_lock);
+  while (m_running || m_queue.size()) m_idle.wait(lock);
+}
+
+void
+RequestQueue::
+stats(std::map<std::string, xmlrpc_c::value>& dest) const
+{
+  boost::lock_guard<boost::mutex> lock(m_lock);
+  dest["workers"]     = xmlrpc_c::value_int(max<size_t>(1, m_options.numWorkers));
+  dest["capacity"]    = xmlrpc_c::value_int(max<size_t>(1, m_options.queueSize));
+  dest["queued"]      = xmlrpc_c::value_int(m_queue.size());
+  dest["running"]     = xmlrpc_c::value_int(m_running);
+  dest["accepted"]    = xmlrpc_c::value_int(m_accepted);
+  dest["refused"]     = xmlrpc_c::value_int(m_refused);
+  dest["expired"]     = xmlrpc_c::value_int(m_expired);
+  dest["failed"]      = xmlrpc_c::value_int(m_failed);
+  dest["completed"]   = xmlrpc_c::value_int(m_completed);
+  dest["queue-depth"] = m_depth.pack();
+  dest["queue-ms"]    = m_waiting.pack();
+  dest["latency-ms"]  = m_latency.pack();
+  dest["batch-size"]  = m_batches.pack();
+}
+
+}
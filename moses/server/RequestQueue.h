@@ -0,0 +1,108 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#pragma once
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include <xmlrpc-c/base.hpp>
+
+#include "moses/parameters/ServerOptions.h"
+
+namespace MosesServer
+{
+class TranslationRequest;
+
+// Counts of non-negative values in buckets with power-of-two upper
+// bounds: bucket 0 holds values below 1, bucket i values below 2^i,
+// the last bucket everything above.
+class
+LogHistogram
+{
+  std::vector<size_t> m_counts;
+  size_t m_total;
+  double m_sum, m_max;
+public:
+  LogHistogram(size_t const buckets = 20);
+
+  void
+  add(double const value);
+
+  // upper bound of the bucket holding quantile q (0 < q <= 1)
+  double
+  quantile(double const q) const;
+
+  xmlrpc_c::value
+  pack() const;
+};
+
+// Bounded queue of translation requests, served by a fixed number of
+// worker threads that are independent of the abyss connection threads.
+// Requests that do not fit into the queue are refused rather than
+// left to pile up, and a request that has spent its time budget in the
+// queue is failed without being translated. Workers take up to
+// ServerOptions::batchSize short requests at once and translate them
+// back to back, ahead of longer requests queued before them.
+class
+RequestQueue
+{
+  struct Job
+  {
+    boost::shared_ptr<TranslationRequest> request;
+    size_t length;   // source words, to tell short requests from long ones
+    double enqueued; // util::WallTime() at submission
+    double deadline; // 0 = none
+  };
+
+  Moses::ServerOptions const& m_options;
+  mutable boost::mutex m_lock;
+  boost::condition_variable m_ready;
+  boost::condition_variable m_idle; // queue empty, no request running
+  std::deque<Job> m_queue;
+  boost::thread_group m_workers;
+  bool m_stopped;
+
+  // statistics, guarded by m_lock
+  size_t m_running, m_accepted, m_refused, m_expired, m_failed, m_completed;
+  LogHistogram m_depth;     // queue depth seen by each submitted request
+  LogHistogram m_waiting;   // milliseconds from submission to start
+  LogHistogram m_latency;   // milliseconds from submission to completion
+  LogHistogram m_batches;   // requests taken by a worker at once
+
+  void
+  work();
+
+  void
+  take_batch(std::vector<Job>& batch);
+
+  void
+  process(Job const& job);
+
+public:
+  RequestQueue(Moses::ServerOptions const& options);
+  ~RequestQueue();
+
+  // Queue the request; false if the queue is full. The request signals
+  // its completion through its condition variable as before.
+  bool
+  submit(boost::shared_ptr<TranslationRequest> const& request,
+         size_t const length, double const deadline);
+
+  // Queue the sentences of a document, all or none. A document longer
+  // than the queue is admitted only when the queue is empty.
+  bool
+  submit(std::vector<boost::shared_ptr<TranslationRequest> > const& requests,
+         std::vector<size_t> const& lengths, double const deadline);
+
+  // wait until all queued and running requests are done
+  void
+  drain();
+
+  void
+  stats(std::map<std::string, xmlrpc_c::value>& dest) const;
+};
+
+}
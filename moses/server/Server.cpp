@@ -1,37 +1,180 @@
 // -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
 #include "Server.h"
+#include "util/exception.hh"
 #include <sstream>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
 
 namespace MosesServer
 {
+  namespace
+  {
+    // Environment of a new server generation, see Server::reload().
+    char const* const SOCKET_VAR = "MOSES_SERVER_FD";
+    char const* const READY_VAR = "MOSES_SERVER_READY_FD";
+    char const* const SESSION_VAR = "MOSES_SERVER_LAST_SESSION";
+
+    // The child of reload() passes the socket and the pipe to the new
+    // generation as these descriptors.
+    int const CHILD_SOCKET_FD = 3;
+    int const CHILD_READY_FD = 4;
+
+    // Only there to interrupt accept() in the main thread.
+    void wake_up(int) { }
+
+    // The environment of this process without the variables above, which
+    // belong to its own start.
+    void
+    copy_environment(std::vector<std::string>& env)
+    {
+      char const* const vars[] = { SOCKET_VAR, READY_VAR, SESSION_VAR };
+      for (char** e = environ; *e; ++e)
+        {
+          bool own = false;
+          for (size_t i = 0; i < 3 && !own; ++i)
+            {
+              size_t const n = strlen(vars[i]);
+              own = strncmp(*e, vars[i], n) == 0 && (*e)[n] == '=';
+            }
+          if (!own) env.push_back(*e);
+        }
+    }
+
+    // The file execvp() would run for name.
+    std::string
+    find_executable(std::string const& name)
+    {
+      if (name.find('/') != std::string::npos) return name;
+      char const* path = getenv("PATH");
+      std::string dirs = path ? path : "/usr/bin:/bin";
+      for (size_t start = 0; start <= dirs.size(); )
+        {
+          size_t end = dirs.find(':', start);
+          if (end == std::string::npos) end = dirs.size();
+          std::string dir = dirs.substr(start, end - start);
+          std::string file = (dir.empty() ? "." : dir) + "/" + name;
+          if (access(file.c_str(), X_OK) == 0) return file;
+          start = end + 1;
+        }
+      return name;
+    }
+
+    // Closes all descriptors from lowest up. Runs between fork() and
+    // exec(), so it only makes async-signal-safe calls: close_range()
+    // where the kernel has it, or else the entries of /proc/self/fd.
+    void
+    close_descriptors_from(int const lowest)
+    {
+#ifdef SYS_close_range
+      if (syscall(SYS_close_range, lowest, ~0U, 0) == 0) return;
+#endif
+#ifdef SYS_getdents64
+      int const dir = open("/proc/self/fd", O_RDONLY | O_DIRECTORY);
+      if (dir < 0) return;
+      uint64_t buffer[512];
+      long n;
+      while ((n = syscall(SYS_getdents64, dir, buffer, sizeof(buffer))) > 0)
+        {
+          // struct linux_dirent64: d_ino, d_off, d_reclen, d_type, d_name
+          char const* entry = reinterpret_cast<char const*>(buffer);
+          for (char const* end = entry + n; entry < end; )
+            {
+              unsigned short reclen;
+              memcpy(&reclen, entry + 16, sizeof(reclen));
+              char const* name = entry + 19;
+              int fd = 0;
+              for (; *name >= '0' && *name <= '9'; ++name)
+                fd = fd * 10 + (*name - '0');
+              if (!*name && name != entry + 19 && fd >= lowest && fd != dir)
+                close(fd);
+              entry += reclen;
+            }
+        }
+      close(dir);
+#endif
+    }
+  }
+
   Server::
   Server(Moses::Parameter& params)
     : m_server_options(params),
+      m_session_cache(m_server_options),
+      m_queue(m_server_options),
       m_updater(new Updater),
       m_optimizer(new Optimizer),
       m_translator(new Translator(*this)),
-      m_close_session(new CloseSession(*this))
+      m_document_translator(new DocumentTranslator(*this)),
+      m_close_session(new CloseSession(*this)),
+      m_stats(new ServerStats(*this)),
+      m_reloader(new Reloader(*this)),
+      m_command_line(params.GetCommandLine()),
+      m_socket(-1),
+      m_abyss(NULL),
+      m_successor(0),
+      m_handed_over(false)
   {
     m_registry.addMethod("translate", m_translator);
+    m_registry.addMethod("translate-batch", m_document_translator);
     m_registry.addMethod("updater",   m_updater);
     m_registry.addMethod("optimize",  m_optimizer);
     m_registry.addMethod("close_session", m_close_session);
+    m_registry.addMethod("stats", m_stats);
+    m_registry.addMethod("reload", m_reloader);
   }
 
   Server::
   ~Server()
   {
-    unlink(m_pidfile.c_str());
+    // the pid file belongs to the next generation now
+    if (!m_handed_over) unlink(m_pidfile.c_str());
+  }
+
+  int
+  Server::
+  open_socket()
+  {
+    // a new generation listens on the socket of the previous one
+    char const* inherited = getenv(SOCKET_VAR);
+    if (inherited) return atoi(inherited);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    UTIL_THROW_IF(fd < 0, util::ErrnoException, "Cannot create server socket");
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(m_server_options.port);
+    UTIL_THROW_IF(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0,
+                  util::ErrnoException,
+                  "Cannot bind to port " << m_server_options.port);
+    return fd;
   }
 
   int 
   Server::
   run()
   {
+    m_socket = open_socket();
+    char const* last_session = getenv(SESSION_VAR);
+    if (last_session) m_session_cache.skip_ids(strtoull(last_session, NULL, 10));
+
     xmlrpc_c::serverAbyss myAbyssServer
       (xmlrpc_c::serverAbyss::constrOpt()
        .registryP(&m_registry)
-       .portNumber(m_server_options.port) // TCP port on which to listen
+       .socketFd(m_socket) // bound to the TCP port on which to listen
        .logFileName(m_server_options.logfile)
        .allowOrigin("*")
        .maxConn(m_server_options.maxConn)
@@ -47,12 +190,39 @@ namespace MosesServer
     pidfile << getpid() << std::endl;
     pidfile.close();
     XVERBOSE(1,"Listening on port " << m_server_options.port << std::endl);
+
+    m_main_thread = pthread_self();
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = wake_up; // no SA_RESTART: accept() must return
+    sigaction(SIGUSR2, &action, NULL);
+    m_abyss = &myAbyssServer;
+
+    // tell the previous generation that we are ready to take over
+    char const* ready = getenv(READY_VAR);
+    if (ready)
+      {
+        int fd = atoi(ready);
+        if (write(fd, "1", 1) != 1)
+          std::cerr << "Cannot notify the previous server generation" << std::endl;
+        close(fd);
+      }
+
     if (m_server_options.is_serial) 
       {
         VERBOSE(1,"Running server in serial mode." << std::endl);
-        while(true) myAbyssServer.runOnce();
+        while(!m_handed_over) myAbyssServer.runOnce();
       }
     else myAbyssServer.run();
+
+    if (m_handed_over)
+      {
+        m_abyss = NULL;
+        VERBOSE(1,"Handed over to the next server generation; "
+                << "finishing queued requests." << std::endl);
+        m_queue.drain();
+        return 0;
+      }
     
     std::cerr << "xmlrpc_c::serverAbyss.run() returned but it should not." 
               << std::endl;
@@ -66,13 +236,126 @@ namespace MosesServer
     return m_server_options;
   }
 
-  Session const& 
+  Session
   Server::
   get_session(uint64_t session_id)
   {
     return m_session_cache[session_id];
   }
 
+  SessionCache&
+  Server::
+  sessions()
+  {
+    return m_session_cache;
+  }
+
+  RequestQueue&
+  Server::
+  queue()
+  {
+    return m_queue;
+  }
+
+  pid_t
+  Server::
+  reload()
+  {
+    boost::lock_guard<boost::mutex> lock(m_reload_lock);
+    if (m_successor || m_handed_over)
+      throw xmlrpc_c::fault("A reload is already in progress",
+                            xmlrpc_c::fault::CODE_INTERNAL);
+    if (m_socket < 0 || m_command_line.empty())
+      throw xmlrpc_c::fault("The server is not running",
+                            xmlrpc_c::fault::CODE_INTERNAL);
+    int ready[2];
+    if (pipe(ready) < 0)
+      throw xmlrpc_c::fault("Cannot create pipe for reload",
+                            xmlrpc_c::fault::CODE_INTERNAL);
+
+    // everything the child needs is prepared before fork(): only
+    // async-signal-safe calls are allowed between fork() and exec(), and
+    // other threads may use the environment of this process meanwhile
+    std::vector<std::string> env;
+    copy_environment(env);
+    std::ostringstream socket_var, ready_var, session_var;
+    socket_var << SOCKET_VAR << "=" << CHILD_SOCKET_FD;
+    ready_var << READY_VAR << "=" << CHILD_READY_FD;
+    session_var << SESSION_VAR << "=" << m_session_cache.last_id() + (1 << 20);
+    env.push_back(socket_var.str());
+    env.push_back(ready_var.str());
+    env.push_back(session_var.str());
+    std::vector<char*> envp;
+    for (size_t i = 0; i < env.size(); ++i)
+      envp.push_back(const_cast<char*>(env[i].c_str()));
+    envp.push_back(NULL);
+    std::string const executable = find_executable(m_command_line[0]);
+    std::vector<char*> argv;
+    for (size_t i = 0; i < m_command_line.size(); ++i)
+      argv.push_back(const_cast<char*>(m_command_line[i].c_str()));
+    argv.push_back(NULL);
+
+    pid_t pid = fork();
+    if (pid == 0)
+      {
+        // Move the socket and the pipe to where the new generation
+        // expects them, and don't hold on to this generation's
+        // connections and files. dup2() leaves the copies open on exec.
+        int socket_fd = m_socket;
+        int ready_fd = ready[1];
+        if (ready_fd == CHILD_SOCKET_FD) ready_fd = dup(ready_fd);
+        if (socket_fd != CHILD_SOCKET_FD)
+          dup2(socket_fd, CHILD_SOCKET_FD);
+        if (ready_fd != CHILD_READY_FD)
+          dup2(ready_fd, CHILD_READY_FD);
+        fcntl(CHILD_SOCKET_FD, F_SETFD, 0);
+        fcntl(CHILD_READY_FD, F_SETFD, 0);
+        close_descriptors_from(CHILD_READY_FD + 1);
+        execve(executable.c_str(), &argv[0], &envp[0]);
+        _exit(127);
+      }
+    close(ready[1]);
+    if (pid < 0)
+      {
+        close(ready[0]);
+        throw xmlrpc_c::fault("Cannot fork for reload",
+                              xmlrpc_c::fault::CODE_INTERNAL);
+      }
+    VERBOSE(1,"Loading new server generation in process " << pid << std::endl);
+    m_successor = pid;
+    boost::thread(&Server::await_successor, this, ready[0], pid).detach();
+    return pid;
+  }
+
+  void
+  Server::
+  await_successor(int const ready_fd, pid_t const pid)
+  {
+    char c;
+    ssize_t n;
+    do n = read(ready_fd, &c, 1); while (n < 0 && errno == EINTR);
+    close(ready_fd);
+
+    boost::lock_guard<boost::mutex> lock(m_reload_lock);
+    if (n == 1)
+      {
+        // The new generation accepts connections on the same socket
+        // now. Stop accepting here; run() then drains the queue.
+        VERBOSE(1,"Server generation " << pid << " is ready" << std::endl);
+        m_handed_over = true;
+        if (m_abyss) m_abyss->terminate();
+        pthread_kill(m_main_thread, SIGUSR2);
+      }
+    else
+      {
+        // the child exited before it was ready; keep serving
+        std::cerr << "New server generation " << pid
+                  << " failed to start" << std::endl;
+        waitpid(pid, NULL, 0);
+        m_successor = 0;
+      }
+  }
+
   void
   Server::
   delete_session(uint64_t const session_id)
@@ -11,12 +11,19 @@
 #include <xmlrpc-c/registry.hpp>
 #include <xmlrpc-c/server_abyss.hpp>
 #include "Translator.h"
+#include "DocumentTranslator.h"
 #include "Optimizer.h"
 #include "Updater.h"
 #include "CloseSession.h"
+#include "Reloader.h"
+#include "RequestQueue.h"
+#include "ServerStats.h"
 #include "Session.h"
 #include "moses/parameters/ServerOptions.h"
 #include <string>
+#include <vector>
+#include <pthread.h>
+#include <sys/types.h>
 
 namespace MosesServer
 {
@@ -24,12 +31,38 @@ namespace MosesServer
   {
     Moses::ServerOptions m_server_options;
     SessionCache   m_session_cache;
+    RequestQueue   m_queue;
     xmlrpc_c::registry m_registry;
     xmlrpc_c::methodPtr const m_updater;
     xmlrpc_c::methodPtr const m_optimizer;
     xmlrpc_c::methodPtr const m_translator;
+    xmlrpc_c::methodPtr const m_document_translator;
     xmlrpc_c::methodPtr const m_close_session;
+    xmlrpc_c::methodPtr const m_stats;
+    xmlrpc_c::methodPtr const m_reloader;
     std::string m_pidfile;
+
+    // Hot reload: a new server generation is a new process started with
+    // the same command line, which re-reads the configuration and the
+    // models. It inherits the listening socket and accepts connections
+    // alongside this process; once it signals that it is ready, this
+    // process stops accepting, drains its queue and exits. Model files
+    // that have not changed are mmapped from the same page cache pages;
+    // models loaded into memory are held twice until the handover.
+    // Nothing but the socket is passed on: the new generation starts
+    // without sessions, so their context weights and biases are lost,
+    // and so are phrase table updates sent to the "updater" method.
+    // Clients have to set these up again after a reload.
+    std::vector<std::string> const m_command_line;
+    int m_socket;
+    pthread_t m_main_thread;
+    xmlrpc_c::serverAbyss* m_abyss; // while run() is running
+    boost::mutex m_reload_lock;
+    pid_t m_successor;              // 0 if no reload is in progress
+    bool m_handed_over;
+
+    int open_socket();
+    void await_successor(int const ready_fd, pid_t const pid);
   public:
     Server(Moses::Parameter& params);
     ~Server();
@@ -39,8 +72,19 @@ namespace MosesServer
     Moses::ServerOptions const& 
     options() const;
     
-    Session const& 
+    Session
     get_session(uint64_t session_id);
 
+    SessionCache&
+    sessions();
+
+    RequestQueue&
+    queue();
+
+    // start a new server generation; returns its process id
+    // (experimental, see Reloader)
+    pid_t
+    reload();
+
   };
 }
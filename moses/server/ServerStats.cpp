@@ -0,0 +1,26 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#include "ServerStats.h"
+#include "Server.h"
+
+namespace MosesServer
+{
+  ServerStats::
+  ServerStats(Server& server)
+    : m_server(server)
+  {
+    this->_signature = "S:,S:S";
+    this->_help = "Reports request queue statistics";
+  }
+
+  void
+  ServerStats::
+  execute(xmlrpc_c::paramList const& paramList,
+	  xmlrpc_c::value *   const  retvalP)
+  {
+    std::map<std::string, xmlrpc_c::value> ret;
+    m_server.queue().stats(ret);
+    m_server.sessions().stats(ret);
+    *retvalP = xmlrpc_c::value_struct(ret);
+  }
+
+}
@@ -0,0 +1,25 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#pragma once
+#include <xmlrpc-c/base.hpp>
+#include <xmlrpc-c/registry.hpp>
+#include <xmlrpc-c/server_abyss.hpp>
+
+namespace MosesServer
+{
+  class Server;
+
+  // Reports the state of the request queue (counters, queue depth,
+  // and histograms of queueing time and latency in milliseconds) and
+  // of the session cache.
+  class
+  ServerStats : public xmlrpc_c::method
+  {
+    Server& m_server;
+  public:
+    ServerStats(Server& server);
+
+    void execute(xmlrpc_c::paramList const& paramList,
+		 xmlrpc_c::value *   const  retvalP);
+  };
+
+}
@@ -0,0 +1,196 @@
+// -*- mode: c++; indent-tabs-mode: nil; tab-width: 2 -*-
+#include "Session.h"
+#include "moses/StaticData.h"
+#include <xmlrpc-c/base.hpp>
+#include <boost/foreach.hpp>
+#include <algorithm>
+
+namespace MosesServer
+{
+  using namespace std;
+
+  SessionCache::
+  SessionCache(Moses::ServerOptions const& options)
+    : m_options(options), m_session_counter(1), m_next_sweep(0)
+    , m_memory(0), m_expired(0), m_evicted(0)
+  { }
+
+  Session
+  SessionCache::
+  operator[](uint64_t id)
+  {
+    sweep();
+    if (id > 1)
+      {
+        Shard& S = shard(id);
+        boost::lock_guard<boost::mutex> lock(S.lock);
+        map_t::iterator m = S.sessions.find(id);
+        if (m != S.sessions.end())
+          {
+            m->second->last_access = time(NULL);
+            return *m->second;
+          }
+      }
+    {
+      boost::lock_guard<boost::mutex> lock(m_counter_lock);
+      id = ++m_session_counter;
+    }
+    SPTR<Session> ret(new Session(id));
+    Shard& S = shard(id);
+    boost::lock_guard<boost::mutex> lock(S.lock);
+    S.sessions[id] = ret;
+    return *ret;
+  }
+
+  void
+  SessionCache::
+  erase(uint64_t const id)
+  {
+    vector<SPTR<Session> > gone;
+    {
+      Shard& S = shard(id);
+      boost::lock_guard<boost::mutex> lock(S.lock);
+      map_t::iterator m = S.sessions.find(id);
+      if (m == S.sessions.end()) return;
+      gone.push_back(m->second);
+      S.sessions.erase(m);
+    }
+    release(gone);
+  }
+
+  void
+  SessionCache::
+  skip_ids(uint64_t const last_id)
+  {
+    boost::lock_guard<boost::mutex> lock(m_counter_lock);
+    m_session_counter = std::max(m_session_counter, last_id);
+  }
+
+  uint64_t
+  SessionCache::
+  last_id() const
+  {
+    boost::lock_guard<boost::mutex> lock(m_counter_lock);
+    return m_session_counter;
+  }
+
+  void
+  SessionCache::
+  on_evict(callback_t const& callback)
+  {
+    boost::lock_guard<boost::mutex> lock(m_sweep_lock);
+    m_callbacks.push_back(callback);
+  }
+
+  void
+  SessionCache::
+  sweep()
+  {
+    boost::unique_lock<boost::mutex> lock(m_sweep_lock, boost::try_to_lock);
+    if (!lock.owns_lock()) return; // another request is sweeping
+    time_t const now = time(NULL);
+    if (now < m_next_sweep) return;
+    m_next_sweep = now + 1;
+
+    // expire idle sessions, take stock of the others
+    typedef pair<time_t, pair<uint64_t, size_t> > candidate_t;
+    vector<candidate_t> lru;
+    vector<SPTR<Session> > gone;
+    size_t memory = 0, expired = 0;
+    for (size_t i = 0; i < num_shards; ++i)
+      {
+        boost::lock_guard<boost::mutex> slock(m_shards[i].lock);
+        map_t& M = m_shards[i].sessions;
+        for (map_t::iterator m = M.begin(); m != M.end();)
+          {
+            Session const& s = *m->second;
+            if (m_options.sessionTimeout
+                && size_t(now - s.last_access) > m_options.sessionTimeout)
+              {
+                gone.push_back(m->second);
+                m = M.erase(m);
+                ++expired;
+                continue;
+              }
+            size_t const bytes = s.memory_usage();
+            memory += bytes;
+            lru.push_back(candidate_t(s.last_access, make_pair(s.id, bytes)));
+            ++m;
+          }
+      }
+
+    // evict least recently used sessions while over budget
+    size_t const max_sessions = m_options.sessionCacheSize;
+    size_t const max_memory = m_options.sessionMemory;
+    size_t evicted = 0;
+    if ((max_sessions && lru.size() > max_sessions)
+        || (max_memory && memory > max_memory))
+      {
+        sort(lru.begin(), lru.end());
+        size_t size = lru.size();
+        for (size_t k = 0; k < lru.size(); ++k)
+          {
+            if ((!max_sessions || size <= max_sessions)
+                && (!max_memory || memory <= max_memory))
+              break;
+            uint64_t const id = lru[k].second.first;
+            Shard& S = shard(id);
+            boost::lock_guard<boost::mutex> slock(S.lock);
+            map_t::iterator m = S.sessions.find(id);
+            if (m == S.sessions.end()) continue;
+            gone.push_back(m->second);
+            S.sessions.erase(m);
+            memory -= min(memory, lru[k].second.second);
+            --size;
+            ++evicted;
+          }
+      }
+    m_memory = memory;
+    m_expired += expired;
+    m_evicted += evicted;
+    lock.unlock();
+
+    if (expired || evicted)
+      VERBOSE(1, "Session cache: " << expired << " sessions expired, "
+              << evicted << " evicted" << std::endl);
+    release(gone);
+  }
+
+  void
+  SessionCache::
+  release(vector<SPTR<Session> > const& gone)
+  {
+    if (gone.empty()) return;
+    vector<callback_t> callbacks;
+    {
+      boost::lock_guard<boost::mutex> lock(m_sweep_lock);
+      callbacks = m_callbacks;
+    }
+    BOOST_FOREACH(SPTR<Session> const& s, gone)
+      {
+        BOOST_FOREACH(callback_t const& f, callbacks) f(*s);
+        // A request that is still running keeps the scope alive and
+        // releases it when it is done.
+        if (s->scope.unique()) s->scope->Clear();
+      }
+  }
+
+  void
+  SessionCache::
+  stats(std::map<std::string, xmlrpc_c::value>& dest) const
+  {
+    size_t live = 0;
+    for (size_t i = 0; i < num_shards; ++i)
+      {
+        boost::lock_guard<boost::mutex> lock(m_shards[i].lock);
+        live += m_shards[i].sessions.size();
+      }
+    boost::lock_guard<boost::mutex> lock(m_sweep_lock);
+    std::map<std::string, xmlrpc_c::value> ret;
+    ret["count"]   = xmlrpc_c::value_int(live);
+    ret["memory"]  = xmlrpc_c::value_double(m_memory); // at the last sweep
+    ret["expired"] = xmlrpc_c::value_int(m_expired);
+    ret["evicted"] = xmlrpc_c::value_int(m_evicted);
+    dest["sessions"] = xmlrpc_c::value_struct(ret);
+  }
+}
@@ -3,15 +3,18 @@
 #include "moses/Util.h"
 #include "moses/ContextScope.h"
 #include "moses/parameters/AllOptions.h"
+#include "moses/parameters/ServerOptions.h"
 #include <sys/time.h>
+#include <vector>
+#include <boost/function.hpp>
 #include <boost/unordered_map.hpp>
 
 #ifdef WITH_THREADS
-#include <boost/thread/shared_mutex.hpp>
+#include <boost/thread/mutex.hpp>
 #include <boost/thread/locks.hpp>
 #endif
 namespace MosesServer{
-  
+
   struct Session
   {
     uint64_t const id;
@@ -20,55 +23,87 @@ namespace MosesServer{
     boost::shared_ptr<Moses::ContextScope> const scope; // stores local info
     SPTR<std::map<std::string,float> > m_context_weights;
 
-    
-    Session(uint64_t const session_id) 
+
+    Session(uint64_t const session_id)
       : id(session_id)
-      , scope(new Moses::ContextScope) 
-    { 
-      last_access = start_time = time(NULL); 
+      , scope(new Moses::ContextScope)
+    {
+      last_access = start_time = time(NULL);
     }
 
     bool is_new() const { return last_access == start_time; }
 
+    // estimated memory held by the session, mostly by its scope
+    size_t memory_usage() const { return sizeof(*this) + scope->GetMemoryUsage(); }
+
     void setup(std::map<std::string, xmlrpc_c::value> const& params);
   };
 
+  // Sessions, sharded by id so that requests of different sessions
+  // rarely contend for a lock. Sessions that have not been used for
+  // ServerOptions::sessionTimeout seconds expire; beyond
+  // sessionCacheSize sessions or sessionMemory bytes, least recently
+  // used sessions are evicted. Expiry and eviction are done at most
+  // once a second by whichever request comes along. Evicted sessions
+  // are passed to the eviction callbacks, and their scope is cleared
+  // unless a request still uses it.
   class SessionCache
   {
-    mutable boost::shared_mutex m_lock;
+  public:
+    typedef boost::function<void (Session const&)> callback_t;
+
+  private:
+    typedef boost::unordered_map<uint64_t, SPTR<Session> > map_t;
+    struct Shard
+    {
+      mutable boost::mutex lock;
+      map_t sessions;
+    };
+    static size_t const num_shards = 16;
+
+    Moses::ServerOptions const& m_options;
+    Shard m_shards[num_shards];
+    mutable boost::mutex m_counter_lock;
     uint64_t m_session_counter;
-    boost::unordered_map<uint64_t,Session> m_cache;
+
+    // guards the sweep and the fields below
+    mutable boost::mutex m_sweep_lock;
+    time_t m_next_sweep;
+    size_t m_memory; // as of the last sweep
+    size_t m_expired, m_evicted;
+    std::vector<callback_t> m_callbacks;
+
+    Shard& shard(uint64_t const id) { return m_shards[id % num_shards]; }
+
+    void sweep();
+    void release(std::vector<SPTR<Session> > const& gone);
+
   public:
 
-    SessionCache() : m_session_counter(1) {}
+    SessionCache(Moses::ServerOptions const& options);
 
-    Session const& 
-    operator[](uint32_t id)
-    {
-      boost::upgrade_lock<boost::shared_mutex> lock(m_lock);
-      if (id > 1) 
-        {
-          boost::unordered_map<uint64_t, Session>::iterator m = m_cache.find(id);
-          if (m != m_cache.end()) 
-            {
-              m->second.last_access = time(NULL);
-              return m->second;
-            }
-        }
-      boost::upgrade_to_unique_lock<boost::shared_mutex> xlock(lock);
-      id = ++m_session_counter;
-      std::pair<uint64_t, Session> foo(id, Session(id));
-      return m_cache.insert(foo).first->second;
-    }
+    // The session with the given id, or a new one if there is no such
+    // session. Returns a copy: the session may be evicted at any time.
+    Session
+    operator[](uint64_t id);
 
     void
-    erase(uint32_t const id)
-    {
-      boost::unique_lock<boost::shared_mutex> lock(m_lock);
-      m_cache.erase(id);
-    }
+    erase(uint64_t const id);
 
+    // Ids of new sessions will be larger than this, so that they do not
+    // collide with those of a previous server generation.
+    void
+    skip_ids(uint64_t const last_id);
+
+    uint64_t
+    last_id() const;
 
+    // called for each expired, evicted or closed session
+    void
+    on_evict(callback_t const& callback);
+
+    void
+    stats(std::map<std::string, xmlrpc_c::value>& dest) const;
   };
 
 
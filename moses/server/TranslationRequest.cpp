@@ -54,29 +54,38 @@ void
 TranslationRequest::
 Run()
 {
-  typedef std::map<std::string,xmlrpc_c::value> param_t;
-  param_t const& params = m_paramList.getStruct(0);
-  parse_request(params);
+  if (m_shared_settings)
+    parse_source();
+  else
+    parse_request(m_paramList.getStruct(0));
   // cerr << "SESSION ID" << ret->m_session_id << endl;
 
-
-  // settings within the session scope
-  param_t::const_iterator si = params.find("context-weights");
-  if (si != params.end()) SetContextWeights(*m_scope, si->second);
-  
-  Moses::StaticData const& SD = Moses::StaticData::Instance();
-
   if (is_syntax(m_options->search.algo))
     run_chart_decoder();
   else
     run_phrase_decoder();
 
-  {
-    boost::lock_guard<boost::mutex> lock(m_mutex);
-    m_done = true;
-  }
-  m_cond.notify_one();
+  finish();
+}
+
+void
+TranslationRequest::
+Abort(std::string const& error, int const code)
+{
+  m_error = error;
+  m_error_code = code;
+  finish();
+}
 
+void
+TranslationRequest::
+finish()
+{
+  // Notify while holding the lock: the waiting connection thread owns
+  // the condition variable and may return as soon as it sees m_done.
+  boost::lock_guard<boost::mutex> lock(m_mutex);
+  m_done = true;
+  m_cond.notify_one();
 }
 
 /// add phrase alignment information from a Hypothesis
@@ -223,8 +232,8 @@ insertTranslationOptions(Moses::Manager& manager,
 TranslationRequest::
 TranslationRequest(xmlrpc_c::paramList const& paramList,
                    boost::condition_variable& cond, boost::mutex& mut)
-  : m_cond(cond), m_mutex(mut), m_done(false), m_paramList(paramList)
-  , m_session_id(0)
+  : m_cond(cond), m_mutex(mut), m_done(false), m_error_code(0)
+  , m_paramList(paramList), m_session_id(0), m_shared_settings(false)
 { 
 
 }
@@ -247,6 +256,42 @@ check(std::map<std::string, xmlrpc_c::value> const& param,
 void
 TranslationRequest::
 parse_request(std::map<std::string, xmlrpc_c::value> const& params)
+{
+  parse_settings(params);
+
+  // source text must be given, or we don't know what to translate
+  std::map<std::string, xmlrpc_c::value>::const_iterator si = params.find("text");
+  if (si == params.end())
+    throw xmlrpc_c::fault("Missing source text", xmlrpc_c::fault::CODE_PARSE);
+  m_source_string = xmlrpc_c::value_string(si->second);
+  parse_source();
+}
+
+void
+TranslationRequest::
+ParseSettings()
+{
+  parse_settings(m_paramList.getStruct(0));
+}
+
+void
+TranslationRequest::
+ShareSettings(TranslationRequest const& doc, std::string const& text)
+{
+  m_shared_settings    = true;
+  m_scope              = doc.m_scope;
+  m_options            = doc.m_options;
+  m_context            = doc.m_context;
+  m_session_id         = doc.m_session_id;
+  m_withGraphInfo      = doc.m_withGraphInfo;
+  m_withTopts          = doc.m_withTopts;
+  m_withScoreBreakdown = doc.m_withScoreBreakdown;
+  m_source_string      = text;
+}
+
+void
+TranslationRequest::
+parse_settings(std::map<std::string, xmlrpc_c::value> const& params)
 {
   // parse XMLRPC request
   m_paramList.verifyEnd(1); // ??? UG
@@ -279,13 +324,10 @@ parse_request(std::map<std::string, xmlrpc_c::value> const& params)
 
   m_options = opts;
 
-  // source text must be given, or we don't know what to translate
-  si = params.find("text");
-  if (si == params.end())
-    throw xmlrpc_c::fault("Missing source text", xmlrpc_c::fault::CODE_PARSE);
-  m_source_string = xmlrpc_c::value_string(si->second);
-  XVERBOSE(1,"Input: " << m_source_string << endl);
-  
+  // settings within the session scope
+  si = params.find("context-weights");
+  if (si != params.end()) SetContextWeights(*m_scope, si->second);
+
   m_withTopts           = check(params, "topt");
   m_withScoreBreakdown  = check(params, "add-score-breakdown");
   si = params.find("lambda");
@@ -323,6 +365,13 @@ parse_request(std::map<std::string, xmlrpc_c::value> const& params)
   // 	for (size_t i = 1; i < tmp.size(); i += 2)
   // 	  m_bias[xmlrpc_c::value_int(tmp[i-1])] = xmlrpc_c::value_double(tmp[i]);
   //   }
+} // end of TranslationRequest::parse_settings()
+
+void
+TranslationRequest::
+parse_source()
+{
+  XVERBOSE(1,"Input: " << m_source_string << endl);
   if (is_syntax(m_options->search.algo)) {
     m_source.reset(new TreeInput(m_options));
     istringstream in(m_source_string + "\n");
@@ -330,7 +379,7 @@ parse_request(std::map<std::string, xmlrpc_c::value> const& params)
   } else {
     m_source.reset(new Sentence(m_options,0,m_source_string));
   }
-} // end of Translationtask::parse_request()
+} // end of TranslationRequest::parse_source()
 
 
 void
@@ -31,6 +31,8 @@ TranslationRequest : public virtual Moses::TranslationTask
   boost::condition_variable& m_cond;
   boost::mutex& m_mutex;
   bool m_done;
+  std::string m_error; // fault to report instead of a translation
+  int m_error_code;
 
   xmlrpc_c::paramList const& m_paramList;
   std::map<std::string, xmlrpc_c::value> m_retData;
@@ -44,13 +46,24 @@ TranslationRequest : public virtual Moses::TranslationTask
   bool m_withTopts;
   bool m_withScoreBreakdown;
   uint64_t m_session_id; // 0 means none, 1 means new
+  bool m_shared_settings; // settings come from a document, see ShareSettings()
 
   void
   parse_request();
 
+  void
+  finish();
+
   void
   parse_request(std::map<std::string, xmlrpc_c::value> const& req);
 
+  // everything but the source text: session, options, context
+  void
+  parse_settings(std::map<std::string, xmlrpc_c::value> const& req);
+
+  void
+  parse_source();
+
   virtual void
   run_chart_decoder();
 
@@ -119,6 +132,28 @@ public:
     return m_retData;
   }
 
+  // the request failed or was not translated at all
+  std::string const&
+  GetError() const {
+    return m_error;
+  }
+
+  int
+  GetErrorCode() const {
+    return m_error_code;
+  }
+
+  void
+  Abort(std::string const& error, int const code);
+
+  // Parse session, options and context of a document once (this may
+  // throw), then hand them to the request of each of its sentences.
+  void
+  ParseSettings();
+
+  void
+  ShareSettings(TranslationRequest const& doc, std::string const& text);
+
   void
   Run();
 
@@ -3,6 +3,8 @@
 #include "Translator.h"
 #include "TranslationRequest.h"
 #include "Server.h"
+#include "util/usage.hh"
+#include <sstream>
 
 namespace MosesServer
 {
@@ -12,8 +14,7 @@ using namespace Moses;
 
 Translator::
 Translator(Server& server)
-  : m_server(server),
-    m_threadPool(server.options().numThreads)
+  : m_server(server)
 {
   // signature and help strings are documentation -- the client
   // can query this information with a system.methodSignature and
@@ -22,23 +23,59 @@ Translator(Server& server)
   this->_help = "Does translation";
 }
 
+size_t
+Translator::
+count_words(std::string const& text)
+{
+  std::istringstream buf(text);
+  std::string w;
+  size_t n = 0;
+  while (buf >> w) ++n;
+  return n;
+}
+
+double
+Translator::
+deadline(std::map<std::string, xmlrpc_c::value> const& params) const
+{
+  // time budget in milliseconds, counted from now, queueing included
+  size_t budget = m_server.options().timeBudget;
+  std::map<std::string, xmlrpc_c::value>::const_iterator si;
+  si = params.find("time-budget");
+  if (si != params.end()) budget = xmlrpc_c::value_int(si->second);
+  return budget ? util::WallTime() + budget / 1000. : 0;
+}
+
 void
 Translator::
 execute(xmlrpc_c::paramList const& paramList,
         xmlrpc_c::value *   const  retvalP)
 {
+  typedef std::map<std::string, xmlrpc_c::value> params_t;
+  params_t const& params = paramList.getStruct(0);
+  double const stop = deadline(params);
+  size_t length = 0;
+  params_t::const_iterator si = params.find("text");
+  if (si != params.end() && si->second.type() == xmlrpc_c::value::TYPE_STRING)
+    length = count_words(xmlrpc_c::value_string(si->second));
+
   boost::condition_variable cond;
   boost::mutex mut;
   boost::shared_ptr<TranslationRequest> task;
   task = TranslationRequest::create(this, paramList,cond,mut);
-  m_threadPool.Submit(task);
+  if (!m_server.queue().submit(task, length, stop))
+    throw xmlrpc_c::fault("Server is busy, request refused",
+                          xmlrpc_c::fault::CODE_LIMIT_EXCEEDED);
   boost::unique_lock<boost::mutex> lock(mut);
   while (!task->IsDone())
     cond.wait(lock);
+  if (task->GetError().size())
+    throw xmlrpc_c::fault(task->GetError(),
+                          xmlrpc_c::fault::code_t(task->GetErrorCode()));
   *retvalP = xmlrpc_c::value_struct(task->GetRetData());
 }
 
-Session const& 
+Session
 Translator::
 get_session(uint64_t const id)
 {
@@ -19,17 +19,23 @@ namespace MosesServer
   class
   Translator : public xmlrpc_c::method
   {
+  protected:
     Server& m_server;
     // Moses::ServerOptions m_server_options;
+
+    // wall clock deadline of a request from its time budget, 0 = none
+    double deadline(std::map<std::string, xmlrpc_c::value> const& params) const;
+
+    // number of words, to tell short requests from long ones before
+    // the request is parsed
+    static size_t count_words(std::string const& text);
   public:
     Translator(Server& server);
     
     void execute(xmlrpc_c::paramList const& paramList,
 		 xmlrpc_c::value *   const  retvalP);
     
-    Session const& get_session(uint64_t session_id);
-  private:
-    Moses::ThreadPool m_threadPool;
+    Session get_session(uint64_t session_id);
   };
 
 }
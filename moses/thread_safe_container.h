@@ -133,6 +133,13 @@ public:
     boost::unique_lock< boost::shared_mutex > lock(m_lock);
     return m_container.erase(key);
   }
+
+  size_t
+  size() const
+  {
+    boost::shared_lock< boost::shared_mutex > lock(m_lock);
+    return m_container.size();
+  }
 };
 }
 #endif
@@ -0,0 +1,93 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2009 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#pragma once
+
+#include <cmath>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace MosesTraining
+{
+
+/** Merges the direct and the sorted indirect half phrase tables into the
+ * final phrase table, as the consolidate binary does.
+ */
+class Consolidator
+{
+public:
+  Consolidator();
+
+  // Parses the command line of consolidate (direct indirect consolidated
+  // [options]).  Throws on errors.
+  void Configure(int argc, char* argv[]);
+
+  // Good Turing and Kneser Ney discounting need the count of counts.
+  bool NeedsCountOfCounts() const {
+    return goodTuringFlag || kneserNeyFlag;
+  }
+  void LoadCountOfCounts(std::istream &in);
+
+  // Consolidates the files named on the command line.
+  void ProcessFiles();
+
+  // Consolidates the half tables, which must be in the same order.
+  void Process(std::istream &fileDirect, std::istream &fileIndirect, std::ostream &fileConsolidated);
+
+private:
+  float maybeLogProb( float a ) const {
+    return logProbFlag ? std::log(a) : a;
+  }
+
+  static void breakdownCoreAndSparse( const std::string &combined, std::string &core, std::string &sparse );
+  static bool getLine( std::istream &file, std::vector< std::string > &item );
+
+  std::string fileNameDirect;
+  std::string fileNameIndirect;
+  std::string fileNameConsolidated;
+  std::string fileNameCountOfCounts;
+  std::string fileNameSourceLabelSet;
+  std::string fileNamePartsOfSpeechVocabulary;
+  std::string fileNameTargetSyntacticPreferencesLabelSet;
+
+  bool countsProperty;
+  bool goodTuringFlag;
+  bool hierarchicalFlag;
+  bool kneserNeyFlag;
+  bool logProbFlag;
+  bool lowCountFlag;
+  bool onlyDirectFlag;
+  bool partsOfSpeechFlag;
+  bool phraseCountFlag;
+  bool sourceLabelsFlag;
+  bool targetSyntacticPreferencesFlag;
+  bool sparseCountBinFeatureFlag;
+
+  std::vector< int > countBin;
+  float minScore0;
+  float minScore2;
+
+  std::vector< float > countOfCounts;
+  std::vector< float > goodTuringDiscount;
+  float kneserNey_D1, kneserNey_D2, kneserNey_D3, totalCount;
+};
+
+}
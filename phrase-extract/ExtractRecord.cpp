@@ -0,0 +1,226 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2009 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#include "ExtractRecord.h"
+
+#include <cstring>
+
+#include "util/exception.hh"
+
+namespace MosesTraining
+{
+
+const char kBinaryExtractMagic[8] = {'\0', 'm', 'o', 's', 'e', 'x', 't', '1'};
+
+namespace
+{
+
+enum TokenCode {
+  kNewWord = 0,
+  kAlignmentPoint = 1,
+  kCount = 2,
+  kKnownWord = 3
+};
+
+// Decimal without leading zeros that fits comfortably in 64 bits.
+bool ParseNumber(const char *begin, const char *end, uint64_t &value)
+{
+  if (begin == end || end - begin > 18) return false;
+  if (*begin == '0' && end - begin > 1) return false;
+  value = 0;
+  for (; begin != end; ++begin) {
+    if (*begin < '0' || *begin > '9') return false;
+    value = value * 10 + (*begin - '0');
+  }
+  return true;
+}
+
+bool ParseAlignmentPoint(const StringPiece &token, uint64_t &first, uint64_t &second)
+{
+  const char *dash = static_cast<const char*>(memchr(token.data(), '-', token.size()));
+  if (!dash) return false;
+  return ParseNumber(token.data(), dash, first) && ParseNumber(dash + 1, token.data() + token.size(), second);
+}
+
+// Tokens can be rebuilt with single spaces.
+bool SingleSpaced(const StringPiece &line)
+{
+  if (line.empty() || line[0] == ' ' || line[line.size() - 1] == ' ') return false;
+  for (size_t i = 1; i < line.size(); ++i) {
+    if (line[i] == ' ' && line[i - 1] == ' ') return false;
+  }
+  return true;
+}
+
+void AppendNumber(uint64_t value, std::string &to)
+{
+  char buf[20];
+  char *end = buf + sizeof(buf), *p = end;
+  do {
+    *--p = '0' + (value % 10);
+    value /= 10;
+  } while (value);
+  to.append(p, end - p);
+}
+
+} // namespace
+
+ExtractRecordWriter::ExtractRecordWriter(std::ostream &out) : m_out(out)
+{
+  m_out.write(kBinaryExtractMagic, sizeof(kBinaryExtractMagic));
+}
+
+void ExtractRecordWriter::WriteVarint(uint64_t value)
+{
+  while (value >= 0x80) {
+    m_buffer += static_cast<char>((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  m_buffer += static_cast<char>(value);
+}
+
+void ExtractRecordWriter::Write(const StringPiece &line)
+{
+  m_buffer.clear();
+  if (!SingleSpaced(line)) {
+    WriteVarint(0);
+    WriteVarint(line.size());
+    m_buffer.append(line.data(), line.size());
+    m_out.write(m_buffer.data(), m_buffer.size());
+    return;
+  }
+  uint64_t tokens = 1;
+  for (size_t i = 0; i < line.size(); ++i) {
+    tokens += (line[i] == ' ');
+  }
+  WriteVarint(tokens);
+  const char *begin = line.data(), *end = line.data() + line.size();
+  while (begin != end) {
+    const char *space = static_cast<const char*>(memchr(begin, ' ', end - begin));
+    if (!space) space = end;
+    StringPiece token(begin, space - begin);
+    uint64_t first, second;
+    if (ParseNumber(token.data(), token.data() + token.size(), first)) {
+      WriteVarint(kCount);
+      WriteVarint(first);
+    } else if (ParseAlignmentPoint(token, first, second)) {
+      WriteVarint(kAlignmentPoint);
+      WriteVarint(first);
+      WriteVarint(second);
+    } else {
+      std::pair<boost::unordered_map<std::string, uint64_t>::iterator, bool> found(
+        m_vocab.insert(std::make_pair(std::string(token.data(), token.size()), m_vocab.size())));
+      if (found.second) {
+        WriteVarint(kNewWord);
+        WriteVarint(token.size());
+        m_buffer.append(token.data(), token.size());
+      } else {
+        WriteVarint(kKnownWord + found.first->second);
+      }
+    }
+    begin = (space == end) ? end : space + 1;
+  }
+  m_out.write(m_buffer.data(), m_buffer.size());
+}
+
+void ExtractRecordWriter::WriteLines(const std::string &lines)
+{
+  const char *begin = lines.data(), *end = lines.data() + lines.size();
+  while (begin != end) {
+    const char *newline = static_cast<const char*>(memchr(begin, '\n', end - begin));
+    if (!newline) newline = end;
+    Write(StringPiece(begin, newline - begin));
+    begin = (newline == end) ? end : newline + 1;
+  }
+}
+
+ExtractRecordReader::ExtractRecordReader(std::istream &in) : m_in(in), m_binary(false)
+{
+  // Text extract files never start with a null byte.
+  if (m_in.peek() != kBinaryExtractMagic[0]) return;
+  char magic[sizeof(kBinaryExtractMagic)];
+  ReadBytes(magic, sizeof(magic));
+  UTIL_THROW_IF(memcmp(magic, kBinaryExtractMagic, sizeof(magic)), util::Exception,
+                "Extract file starts with a null byte but is not a binary extract file");
+  m_binary = true;
+}
+
+// Byte at a time: gzfilebuf::xsgetn skips whatever underflow has buffered.
+void ExtractRecordReader::ReadBytes(char *to, size_t size)
+{
+  std::streambuf *buf = m_in.rdbuf();
+  for (char *end = to + size; to != end; ++to) {
+    int got = buf->sbumpc();
+    UTIL_THROW_IF(got == std::char_traits<char>::eof(), util::Exception, "Truncated binary extract file");
+    *to = static_cast<char>(got);
+  }
+}
+
+uint64_t ExtractRecordReader::ReadVarint()
+{
+  std::streambuf *buf = m_in.rdbuf();
+  uint64_t value = 0;
+  for (unsigned shift = 0; ; shift += 7) {
+    int got = buf->sbumpc();
+    UTIL_THROW_IF(got == std::char_traits<char>::eof() || shift > 63, util::Exception,
+                  "Truncated or corrupt binary extract file");
+    value |= static_cast<uint64_t>(got & 0x7f) << shift;
+    if (!(got & 0x80)) return value;
+  }
+}
+
+bool ExtractRecordReader::ReadLine(std::string &line)
+{
+  if (!m_binary) return static_cast<bool>(getline(m_in, line));
+  if (m_in.rdbuf()->sgetc() == std::char_traits<char>::eof()) return false;
+  line.clear();
+  uint64_t tokens = ReadVarint();
+  if (!tokens) {
+    line.resize(ReadVarint());
+    ReadBytes(&line[0], line.size());
+    return true;
+  }
+  for (uint64_t i = 0; i < tokens; ++i) {
+    if (i) line += ' ';
+    uint64_t code = ReadVarint();
+    switch (code) {
+    case kNewWord: {
+      std::string word(ReadVarint(), '\0');
+      ReadBytes(&word[0], word.size());
+      line += word;
+      m_vocab.push_back(word);
+      break;
+    }
+    case kAlignmentPoint:
+      AppendNumber(ReadVarint(), line);
+      line += '-';
+      AppendNumber(ReadVarint(), line);
+      break;
+    case kCount:
+      AppendNumber(ReadVarint(), line);
+      break;
+    default:
+      UTIL_THROW_IF(code - kKnownWord >= m_vocab.size(), util::Exception, "Bad word id in binary extract file");
+      line += m_vocab[code - kKnownWord];
+    }
+  }
+  return true;
+}
+
+}
@@ -0,0 +1,94 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2009 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include <boost/unordered_map.hpp>
+
+#include "util/string_piece.hh"
+
+namespace MosesTraining
+{
+
+/** Binary extract files.  A file starts with kBinaryExtractMagic, then each
+ * line is a varint token count n followed by n tokens.  Lines that are not
+ * single-space separated tokens are stored as n = 0 followed by the raw line
+ * (varint length and bytes).  A token is a varint code:
+ *   0       a word seen for the first time: varint length and bytes.  It gets
+ *           the next vocabulary id.
+ *   1       an alignment point i-j: two varints.
+ *   2       a count: a varint.
+ *   3 + id  a word that has been seen before.
+ * The vocabulary is built up while reading, so a file is self-contained, but
+ * binary files cannot simply be concatenated.  Decoding gives back the text
+ * line byte for byte.
+ */
+extern const char kBinaryExtractMagic[8];
+
+class ExtractRecordWriter
+{
+public:
+  // Writes the header.
+  explicit ExtractRecordWriter(std::ostream &out);
+
+  // Write one line, without the newline.
+  void Write(const StringPiece &line);
+
+  // Write newline-terminated lines as produced by the extractors.
+  void WriteLines(const std::string &lines);
+
+private:
+  void WriteVarint(uint64_t value);
+
+  std::ostream &m_out;
+  boost::unordered_map<std::string, uint64_t> m_vocab;
+  std::string m_buffer;
+};
+
+/** Reads an extract file line by line, whether it is binary or text.
+ */
+class ExtractRecordReader
+{
+public:
+  explicit ExtractRecordReader(std::istream &in);
+
+  bool IsBinary() const {
+    return m_binary;
+  }
+
+  // Like getline.
+  bool ReadLine(std::string &line);
+
+private:
+  uint64_t ReadVarint();
+  void ReadBytes(char *to, size_t size);
+
+  std::istream &m_in;
+  bool m_binary;
+  std::vector<std::string> m_vocab;
+};
+
+}
@@ -0,0 +1,180 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2009 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#pragma once
+
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "ExtractionPhrasePair.h"
+#include "ScoreFeature.h"
+#include "score.h"
+#include "tables-core.h"
+
+#define COC_MAX 10
+
+namespace MosesTraining
+{
+
+class ExtractRecordReader;
+
+/** Scores a sorted extract file into a half phrase table, as the score binary
+ * does.  A copy shares the lexical translation table, the configuration and
+ * the words known after Configure() but has its own statistics and its own
+ * vocabulary for new words, so copies taken before scoring can score
+ * different source phrases of the same extract file in parallel.
+ */
+class ExtractScorer
+{
+public:
+  ExtractScorer();
+
+  // Parses the command line of score (extract lex phrase-table [options]) and
+  // loads the lexical table and the other files the options name.  Prints
+  // the usage and exits on errors, as score does.
+  void Configure(int argc, char* argv[]);
+
+  const std::string &GetExtractFileName() const {
+    return fileNameExtract;
+  }
+  const std::string &GetPhraseTableFileName() const {
+    return fileNamePhraseTable;
+  }
+
+  // Scores the extract lines, which must be sorted, into phraseTableFile.
+  void Score(ExtractRecordReader &extractReader, std::ostream &phraseTableFile);
+
+  // Count of counts for Good Turing and Kneser Ney discounting.
+  bool HasCountOfCounts() const {
+    return goodTuringFlag || kneserNeyFlag;
+  }
+  void AddCountOfCounts(const ExtractScorer &other);
+  void WriteCountOfCounts(std::ostream &out) const;
+
+  // Writes the count of counts and label sets next to the phrase table.
+  void WriteStatistics();
+
+private:
+  void processLine( std::string line,
+                    int lineID, bool includeSentenceIdFlag, int &sentenceId,
+                    PHRASE *phraseSource, PHRASE *phraseTarget, ALIGNMENT *targetToSourceAlignment,
+                    std::string &additionalPropertiesString,
+                    float &count, float &pcfgSum );
+  void writeCountOfCounts( const std::string &fileNameCountOfCounts );
+  void writeLeftHandSideLabelCounts( const boost::unordered_map<std::string,float> &countsLabelLHS,
+                                     const boost::unordered_map<std::string, boost::unordered_map<std::string,float>* > &jointCountsLabelLHS,
+                                     const std::string &fileNameLeftHandSideSourceLabelCounts,
+                                     const std::string &fileNameLeftHandSideTargetSourceLabelCounts );
+  void writeLabelSet( const std::set<std::string> &labelSet, const std::string &fileName );
+  void processPhrasePairs( std::vector< ExtractionPhrasePair* > &phrasePairsWithSameSource, std::ostream &phraseTableFile,
+                           const ScoreFeatureManager& featureManager, const MaybeLog& maybeLogProb );
+  void outputPhrasePair(const ExtractionPhrasePair &phrasePair, float, int, std::ostream &phraseTableFile, const ScoreFeatureManager &featureManager, const MaybeLog &maybeLog );
+  double computeLexicalTranslation( const PHRASE *phraseSource, const PHRASE *phraseTarget, const ALIGNMENT *alignmentTargetToSource );
+  double computeUnalignedPenalty( const ALIGNMENT *alignmentTargetToSource );
+  void loadOrientationPriors(const std::string &fileNamePhraseOrientationPriors, std::vector<float> &orientationClassPriorsL2R, std::vector<float> &orientationClassPriorsR2L);
+  void loadFunctionWords( const std::string &fileNameFunctionWords );
+  double computeUnalignedFWPenalty( const PHRASE *phraseTarget, const ALIGNMENT *alignmentTargetToSource );
+  bool calcCrossedNonTerm( size_t targetPos, size_t sourcePos, const ALIGNMENT *alignmentTargetToSource );
+  int calcCrossedNonTerm( const PHRASE *phraseTarget, const ALIGNMENT *alignmentTargetToSource );
+  void printSourcePhrase( const PHRASE *phraseSource, const PHRASE *phraseTarget, const ALIGNMENT *targetToSourceAlignment, std::ostream &out );
+  void printTargetPhrase( const PHRASE *phraseSource, const PHRASE *phraseTarget, const ALIGNMENT *targetToSourceAlignment, std::ostream &out );
+  void invertAlignment( const PHRASE *phraseSource, const PHRASE *phraseTarget, const ALIGNMENT *inTargetToSourceAlignment, ALIGNMENT *outSourceToTargetAlignment );
+  size_t NumNonTerminal(const PHRASE *phraseSource);
+  static void shareVocabulary(Vocabulary &vcb);
+
+  std::string fileNameExtract;
+  std::string fileNameLex;
+  std::string fileNamePhraseTable;
+  std::string fileNameSourceLabelSet;
+  std::string fileNamePartsOfSpeechSet;
+  std::string fileNameCountOfCounts;
+  std::string fileNameFunctionWords;
+  std::string fileNameLeftHandSideSourceLabelCounts;
+  std::string fileNameLeftHandSideTargetSourceLabelCounts;
+  std::string fileNameTargetSyntacticPreferencesLabelSet;
+  std::string fileNameLeftHandSideTargetSyntacticPreferencesLabelCounts;
+  std::string fileNameLeftHandSideRuleTargetTargetSyntacticPreferencesLabelCounts;
+  std::string fileNamePhraseOrientationPriors;
+
+  ScoreFeatureManager featureManager;
+  MaybeLog maybeLogProb;
+
+  boost::shared_ptr<LexicalTable> lexTable;
+  bool inverseFlag;
+  bool hierarchicalFlag;
+  bool pcfgFlag;
+  bool phraseOrientationFlag;
+  bool treeFragmentsFlag;
+  bool partsOfSpeechFlag;
+  bool sourceSyntaxLabelsFlag;
+  bool sourceSyntaxLabelCountsLHSFlag;
+  bool targetSyntacticPreferencesFlag;
+  bool unpairedExtractFormatFlag;
+  bool conditionOnTargetLhsFlag;
+  bool wordAlignmentFlag;
+  bool goodTuringFlag;
+  bool kneserNeyFlag;
+  bool logProbFlag;
+  int negLogProb;
+  bool lexFlag;
+  bool unalignedFlag;
+  bool unalignedFWFlag;
+  bool crossedNonTerm;
+  bool spanLength;
+  bool ruleLength;
+  bool nonTermContext;
+  bool nonTermContextTarget;
+  bool targetConstituentBoundariesFlag;
+
+  int countOfCounts[COC_MAX+1];
+  int totalDistinct;
+  float minCount;
+  float minCountHierarchical;
+  bool phraseOrientationPriorsFlag;
+
+  boost::unordered_map<std::string,float> sourceLHSCounts;
+  boost::unordered_map<std::string, boost::unordered_map<std::string,float>* > targetLHSAndSourceLHSJointCounts;
+  std::set<std::string> sourceLabelSet;
+  std::map<std::string,size_t> sourceLabels;
+  std::vector<std::string> sourceLabelsByIndex;
+
+  std::set<std::string> partsOfSpeechSet;
+
+  boost::unordered_map<std::string,float> targetSyntacticPreferencesLHSCounts;
+  boost::unordered_map<std::string, boost::unordered_map<std::string,float>* > ruleTargetLHSAndTargetSyntacticPreferencesLHSJointCounts;
+  std::set<std::string> targetSyntacticPreferencesLabelSet;
+  std::map<std::string,size_t> targetSyntacticPreferencesLabels;
+  std::vector<std::string> targetSyntacticPreferencesLabelsByIndex;
+
+  std::vector<float> orientationClassPriorsL2R; // mono swap dleft dright
+  std::vector<float> orientationClassPriorsR2L; // mono swap dleft dright
+
+  std::set<std::string> functionWordList;
+
+  Vocabulary vcbT;
+  Vocabulary vcbS;
+};
+
+}
@@ -0,0 +1,112 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2009 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#pragma once
+
+#include <map>
+#include <ostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "PhraseExtractionOptions.h"
+#include "SentenceAlignmentWithSyntax.h"
+
+namespace MosesTraining
+{
+
+// HPhraseVertex represents a point in the alignment matrix
+typedef std::pair <int, int> HPhraseVertex;
+
+// Phrase represents a bi-phrase; each bi-phrase is defined by two points in the alignment matrix:
+// bottom-left and top-right
+typedef std::pair<HPhraseVertex, HPhraseVertex> HPhrase;
+
+// HPhraseVector is a vector of HPhrases
+typedef std::vector < HPhrase > HPhraseVector;
+
+// SentenceVertices represents, from all extracted phrases, all vertices that have the same positioning
+// The key of the map is the English index and the value is a set of the source ones
+typedef std::map <int, std::set<int> > HSentenceVertices;
+
+/** Extracts the phrase pairs of one sentence pair and writes them to the
+ * given streams.  Shared by extract and build-phrase-table.
+ */
+class ExtractTask
+{
+public:
+  ExtractTask(
+    size_t id, SentenceAlignmentWithSyntax &sentence,
+    PhraseExtractionOptions &initoptions,
+    std::ostream &extractFile,
+    std::ostream &extractFileInv,
+    std::ostream &extractFileOrientation,
+    std::ostream &extractFileContext,
+    std::ostream &extractFileContextInv):
+    m_sentence(sentence),
+    m_options(initoptions),
+    m_extractFile(extractFile),
+    m_extractFileInv(extractFileInv),
+    m_extractFileOrientation(extractFileOrientation),
+    m_extractFileContext(extractFileContext),
+    m_extractFileContextInv(extractFileContextInv) {}
+  void Run();
+private:
+  std::vector< std::string > m_extractedPhrases;
+  std::vector< std::string > m_extractedPhrasesInv;
+  std::vector< std::string > m_extractedPhrasesOri;
+  std::vector< std::string > m_extractedPhrasesSid;
+  std::vector< std::string > m_extractedPhrasesContext;
+  std::vector< std::string > m_extractedPhrasesContextInv;
+  void extractBase();
+  void extract();
+  void addPhrase(int, int, int, int, const std::string &);
+  void writePhrasesToFile();
+  bool checkPlaceholders(int startE, int endE, int startF, int endF) const;
+  bool isPlaceholder(const std::string &word) const;
+  bool checkTargetConstituentBoundaries(int startE, int endE, int startF, int endF,
+                                        std::ostringstream &outextractstrPhraseProperties) const;
+  void getOrientationInfo(int startE, int endE, int startF, int endF,
+                          const HSentenceVertices& inTopLeft,
+                          const HSentenceVertices& inTopRight,
+                          const HSentenceVertices& inBottomLeft,
+                          const HSentenceVertices& inBottomRight,
+                          const HSentenceVertices& outTopLeft,
+                          const HSentenceVertices& outTopRight,
+                          const HSentenceVertices& outBottomLeft,
+                          const HSentenceVertices& outBottomRight,
+                          std::string &orientationInfo) const;
+
+  SentenceAlignmentWithSyntax &m_sentence;
+  const PhraseExtractionOptions &m_options;
+  std::ostream &m_extractFile;
+  std::ostream &m_extractFileInv;
+  std::ostream &m_extractFileOrientation;
+  std::ostream &m_extractFileContext;
+  std::ostream &m_extractFileContextInv;
+};
+
+/** Parse the extraction switch at argv[i], advancing i past its arguments.
+ * Returns false if argv[i] is not an extraction switch.
+ */
+bool ParseExtractOption(int argc, char* argv[], int &i, PhraseExtractionOptions &options, int &sentenceOffset);
+
+}
@@ -32,12 +32,6 @@ namespace MosesTraining
 {
 
 
-extern Vocabulary vcbT;
-extern Vocabulary vcbS;
-
-extern bool hierarchicalFlag;
-
-
 ExtractionPhrasePair::ExtractionPhrasePair( const PHRASE *phraseSource,
     const PHRASE *phraseTarget,
     ALIGNMENT *targetToSourceAlignment,
@@ -120,7 +114,9 @@ void ExtractionPhrasePair::IncrementPrevious( float count, float pcfgSum )
 // and in case of SCFG rules for equal non-terminal alignment.
 bool ExtractionPhrasePair::Matches( const PHRASE *otherPhraseSource,
                                     const PHRASE *otherPhraseTarget,
-                                    ALIGNMENT *otherTargetToSourceAlignment ) const
+                                    ALIGNMENT *otherTargetToSourceAlignment,
+                                    bool hierarchical,
+                                    Vocabulary &vcbT ) const
 {
   if (*otherPhraseTarget != *m_phraseTarget) {
     return false;
@@ -129,7 +125,7 @@ bool ExtractionPhrasePair::Matches( const PHRASE *otherPhraseSource,
     return false;
   }
 
-  return MatchesAlignment( otherTargetToSourceAlignment );
+  return MatchesAlignment( otherTargetToSourceAlignment, hierarchical, vcbT );
 }
 
 // Check for lexical match
@@ -142,7 +138,9 @@ bool ExtractionPhrasePair::Matches( const PHRASE *otherPhraseSource,
                                     ALIGNMENT *otherTargetToSourceAlignment,
                                     bool &sourceMatch,
                                     bool &targetMatch,
-                                    bool &alignmentMatch ) const
+                                    bool &alignmentMatch,
+                                    bool hierarchical,
+                                    Vocabulary &vcbT ) const
 {
   if (*otherPhraseSource != *m_phraseSource) {
     sourceMatch = false;
@@ -156,7 +154,7 @@ bool ExtractionPhrasePair::Matches( const PHRASE *otherPhraseSource,
   } else {
     targetMatch = true;
   }
-  if ( !MatchesAlignment(otherTargetToSourceAlignment) ) {
+  if ( !MatchesAlignment(otherTargetToSourceAlignment, hierarchical, vcbT) ) {
     alignmentMatch = false;
     return false;
   } else {
@@ -167,9 +165,11 @@ bool ExtractionPhrasePair::Matches( const PHRASE *otherPhraseSource,
 
 // Check for equal non-terminal alignment in case of SCFG rules.
 // Precondition: otherTargetToSourceAlignment has the same size as m_targetToSourceAlignments.begin()->first
-bool ExtractionPhrasePair::MatchesAlignment( ALIGNMENT *otherTargetToSourceAlignment ) const
+bool ExtractionPhrasePair::MatchesAlignment( ALIGNMENT *otherTargetToSourceAlignment,
+    bool hierarchical,
+    Vocabulary &vcbT ) const
 {
-  if (!hierarchicalFlag) return true;
+  if (!hierarchical) return true;
 
   // all or none of the phrasePair's word alignment matrices match, so just pick one
   const ALIGNMENT *thisTargetToSourceAlignment = m_targetToSourceAlignments.begin()->first;
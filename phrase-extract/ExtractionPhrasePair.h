@@ -73,16 +73,24 @@ public:
 
   bool Matches( const PHRASE *otherPhraseSource,
                 const PHRASE *otherPhraseTarget,
-                ALIGNMENT *otherTargetToSourceAlignment ) const;
+                ALIGNMENT *otherTargetToSourceAlignment,
+                bool hierarchical,
+                Vocabulary &vcbT ) const;
 
   bool Matches( const PHRASE *otherPhraseSource,
                 const PHRASE *otherPhraseTarget,
                 ALIGNMENT *otherTargetToSourceAlignment,
                 bool &sourceMatch,
                 bool &targetMatch,
-                bool &alignmentMatch ) const;
-
-  bool MatchesAlignment( ALIGNMENT *otherTargetToSourceAlignment ) const;
+                bool &alignmentMatch,
+                bool hierarchical,
+                Vocabulary &vcbT ) const;
+
+  // Non-terminal alignments only matter for hierarchical rules, whose
+  // non-terminals are looked up in the target vocabulary vcbT.
+  bool MatchesAlignment( ALIGNMENT *otherTargetToSourceAlignment,
+                         bool hierarchical,
+                         Vocabulary &vcbT ) const;
 
   void Clear();
 
@@ -0,0 +1,243 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2009 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/iostreams/device/file_descriptor.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "util/file.hh"
+#include "util/file_piece.hh"
+#include "util/file_stream.hh"
+#include "util/scoped.hh"
+#include "util/string_piece.hh"
+
+namespace MosesTraining
+{
+
+// Byte order, as LC_ALL=C sort uses.
+struct LineLess {
+  bool operator()(const StringPiece &a, const StringPiece &b) const {
+    int cmp = memcmp(a.data(), b.data(), std::min(a.size(), b.size()));
+    return cmp ? (cmp < 0) : (a.size() < b.size());
+  }
+};
+
+// Temporary files hold gzip text at the fastest level.  The descriptor stays
+// open when the stream is closed, so the file can be rewound and read back.
+inline void CompressTo(boost::iostreams::filtering_ostream &out, int fd)
+{
+  out.push(boost::iostreams::gzip_compressor(boost::iostreams::gzip_params(boost::iostreams::gzip::best_speed)));
+  out.push(boost::iostreams::file_descriptor_sink(fd, boost::iostreams::never_close_handle));
+}
+
+inline void DecompressFrom(boost::iostreams::filtering_istream &in, int fd)
+{
+  in.push(boost::iostreams::gzip_decompressor());
+  in.push(boost::iostreams::file_descriptor_source(fd, boost::iostreams::never_close_handle));
+}
+
+// Source of sorted lines for the merge.
+class SortedLines
+{
+public:
+  virtual ~SortedLines() {}
+  virtual bool Next(StringPiece &line) = 0;
+};
+
+class SortedMemory : public SortedLines
+{
+public:
+  explicit SortedMemory(const std::vector<StringPiece> &lines) : m_lines(lines), m_next(0) {}
+
+  bool Next(StringPiece &line) {
+    if (m_next == m_lines.size()) return false;
+    line = m_lines[m_next++];
+    return true;
+  }
+
+private:
+  const std::vector<StringPiece> &m_lines;
+  size_t m_next;
+};
+
+class SortedRun : public SortedLines
+{
+public:
+  // Takes ownership of fd.  FilePiece detects the compression.
+  explicit SortedRun(int fd) : m_file(fd, "sorted run") {}
+
+  bool Next(StringPiece &line) {
+    return m_file.ReadLineOrEOF(line, '\n', false);
+  }
+
+private:
+  util::FilePiece m_file;
+};
+
+/** Sorts newline-terminated lines in the order of LC_ALL=C sort.  Lines may
+ * be added concurrently, into one of two buffers, each half of the memory
+ * budget.  A full buffer is sorted and written to a compressed temporary file
+ * while the other one keeps filling up.  Only one buffer is spilled at a
+ * time: Add() blocks while the other buffer is full and still being written.
+ */
+class LineSorter
+{
+public:
+  LineSorter(size_t budget, const std::string &tempPrefix)
+    : m_budget(std::max<size_t>(budget / 2, 1)), m_tempPrefix(tempPrefix), m_spilling(false) {}
+
+  void Add(const std::string &lines) {
+    if (lines.empty()) return;
+    std::string full;
+    {
+      boost::mutex::scoped_lock lock(m_mutex);
+      while (!m_buffer.empty() && m_buffer.size() + lines.size() > m_budget) {
+        if (!m_spilling) {
+          full.swap(m_buffer);
+          m_buffer.reserve(m_budget);
+          m_spilling = true;
+          break;
+        }
+        m_spilled.wait(lock);
+      }
+      m_buffer += lines;
+    }
+    if (full.empty()) return;
+    try {
+      Spill(full);
+    } catch (...) {
+      SpillDone();
+      throw;
+    }
+    std::string().swap(full);
+    SpillDone();
+  }
+
+  // Merge everything in sorted order into out, which has Line(StringPiece).
+  template <class Out> void Output(Out &out) {
+    std::vector<StringPiece> lines;
+    SplitSort(m_buffer, lines);
+    boost::ptr_vector<SortedLines> sources;
+    sources.push_back(new SortedMemory(lines));
+    for (size_t i = 0; i < m_runs.size(); ++i) {
+      sources.push_back(new SortedRun(m_runs[i]));
+    }
+    m_runs.clear();
+
+    typedef std::pair<StringPiece, SortedLines*> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, EntryGreater> queue;
+    StringPiece line;
+    for (size_t i = 0; i < sources.size(); ++i) {
+      if (sources[i].Next(line)) queue.push(Entry(line, &sources[i]));
+    }
+    while (!queue.empty()) {
+      Entry top(queue.top());
+      queue.pop();
+      out.Line(top.first);
+      if (top.second->Next(line)) queue.push(Entry(line, top.second));
+    }
+    std::string().swap(m_buffer);
+  }
+
+private:
+  struct EntryGreater {
+    bool operator()(const std::pair<StringPiece, SortedLines*> &a, const std::pair<StringPiece, SortedLines*> &b) const {
+      return LineLess()(b.first, a.first);
+    }
+  };
+
+  static void SplitSort(const std::string &buffer, std::vector<StringPiece> &lines) {
+    const char *begin = buffer.data(), *end = buffer.data() + buffer.size();
+    while (begin != end) {
+      const char *newline = static_cast<const char*>(memchr(begin, '\n', end - begin));
+      if (!newline) newline = end;
+      lines.push_back(StringPiece(begin, newline - begin));
+      begin = (newline == end) ? end : newline + 1;
+    }
+    std::sort(lines.begin(), lines.end(), LineLess());
+  }
+
+  void Spill(const std::string &buffer) {
+    std::vector<StringPiece> lines;
+    SplitSort(buffer, lines);
+    util::scoped_fd file(util::MakeTemp(m_tempPrefix));
+    {
+      boost::iostreams::filtering_ostream out;
+      CompressTo(out, file.get());
+      for (std::vector<StringPiece>::const_iterator i = lines.begin(); i != lines.end(); ++i) {
+        out.write(i->data(), i->size());
+        out.put('\n');
+      }
+    }
+    util::SeekOrThrow(file.get(), 0);
+    boost::mutex::scoped_lock lock(m_runsMutex);
+    m_runs.push_back(file.release());
+  }
+
+  void SpillDone() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_spilling = false;
+    m_spilled.notify_all();
+  }
+
+  const size_t m_budget;
+  const std::string m_tempPrefix;
+
+  boost::mutex m_mutex;
+  boost::condition_variable m_spilled;
+  std::string m_buffer;
+  bool m_spilling;
+
+  boost::mutex m_runsMutex;
+  std::vector<int> m_runs;
+};
+
+// Sinks for LineSorter::Output.
+struct StreamSink {
+  explicit StreamSink(std::ostream &out) : m_out(out) {}
+  void Line(const StringPiece &line) {
+    m_out.write(line.data(), line.size());
+    m_out.put('\n');
+  }
+  std::ostream &m_out;
+};
+
+struct FileSink {
+  explicit FileSink(int fd) : m_out(fd) {}
+  void Line(const StringPiece &line) {
+    m_out.write(line.data(), line.size());
+    m_out.write("\n", 1);
+  }
+  util::FileStream m_out;
+};
+
+}
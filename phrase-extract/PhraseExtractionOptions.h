@@ -49,6 +49,7 @@ private:
   bool includeSentenceIdFlag; //include sentence id in extract file
   bool onlyOutputSpanInfo;
   bool gzOutput;
+  bool binaryOutput;
   std::string instanceWeightsFile; //weights for each sentence
   bool targetConstituentConstrainedFlag;
   bool targetConstituentBoundariesFlag;
@@ -75,6 +76,7 @@ public:
     includeSentenceIdFlag(false),
     onlyOutputSpanInfo(false),
     gzOutput(false),
+    binaryOutput(false),
     targetConstituentConstrainedFlag(false),
     targetConstituentBoundariesFlag(false),
     flexScoreFlag(false),
@@ -119,6 +121,9 @@ public:
   void initGzOutput (const bool initgzOutput) {
     gzOutput= initgzOutput;
   }
+  void initBinaryOutput (const bool initbinaryOutput) {
+    binaryOutput= initbinaryOutput;
+  }
   void initInstanceWeightsFile(const char* initInstanceWeightsFile) {
     instanceWeightsFile = std::string(initInstanceWeightsFile);
   }
@@ -172,6 +177,9 @@ public:
   bool isGzOutput () const {
     return gzOutput;
   }
+  bool isBinaryOutput () const {
+    return binaryOutput;
+  }
   std::string getInstanceWeightsFile() const {
     return instanceWeightsFile;
   }
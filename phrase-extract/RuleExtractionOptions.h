@@ -49,6 +49,7 @@ public:
   bool fractionalCounting;
   bool pcfgScore;
   bool gzOutput;
+  bool binaryOutput;
   bool unpairedExtractFormat;
   bool conditionOnTargetLhs;
   bool boundaryRules;
@@ -84,6 +85,7 @@ public:
     , fractionalCounting(true)
     , pcfgScore(false)
     , gzOutput(false)
+    , binaryOutput(false)
     , unpairedExtractFormat(false)
     , conditionOnTargetLhs(false)
     , boundaryRules(false)
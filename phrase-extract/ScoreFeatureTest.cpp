@@ -32,14 +32,6 @@
 using namespace MosesTraining;
 using namespace std;
 
-//pesky global variables
-namespace MosesTraining
-{
-bool hierarchicalFlag = false;
-Vocabulary vcbT;
-Vocabulary vcbS;
-}
-
 
 const char *DomainFileLocation()
 {
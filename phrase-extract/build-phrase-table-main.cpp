@@ -0,0 +1,549 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2009 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+/* Runs extract, LC_ALL=C sort, score (direct and inverse), sort and
+ * consolidate in one process, replacing the temporary files that
+ * train-model.perl writes between those steps.  Phrase pairs are extracted by
+ * a pool of threads and sorted in memory, spilling compressed sorted runs to
+ * temporary files only when the memory budget is exceeded.  The sorted
+ * streams are cut into chunks at source phrase boundaries and the chunks are
+ * scored in the same pool with the code of the score binary, so the output is
+ * the same as the step by step pipeline.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#ifdef WITH_THREADS
+#include <boost/thread/thread.hpp>
+#endif
+
+#include "Consolidator.h"
+#include "ExtractRecord.h"
+#include "ExtractScorer.h"
+#include "ExtractTask.h"
+#include "InputFileStream.h"
+#include "LineSorter.h"
+#include "OutputFileStream.h"
+#include "PhraseExtractionOptions.h"
+#include "SentenceAlignmentWithSyntax.h"
+#include "moses/ThreadPool.h"
+#include "moses/Util.h"
+#include "util/exception.hh"
+#include "util/file.hh"
+#include "util/scoped.hh"
+#include "util/string_piece.hh"
+
+using namespace std;
+using namespace MosesTraining;
+
+#ifndef WITH_THREADS
+namespace Moses
+{
+class ThreadPool;
+}
+#endif
+
+namespace MosesTraining
+{
+
+/** Extracts a batch of sentence pairs and hands the phrase pairs to the
+ * sorters.
+ */
+class ExtractBatch : public Moses::Task
+{
+public:
+  ExtractBatch(PhraseExtractionOptions &options, int firstId,
+               LineSorter &extract, LineSorter &extractInv, LineSorter *extractOrientation)
+    : m_options(options), m_firstId(firstId),
+      m_extract(extract), m_extractInv(extractInv), m_extractOrientation(extractOrientation) {}
+
+  void Add(const std::string &e, const std::string &f, const std::string &a, const std::string &w) {
+    m_english.push_back(e);
+    m_foreign.push_back(f);
+    m_alignment.push_back(a);
+    m_weight.push_back(w);
+  }
+
+  size_t Size() const {
+    return m_english.size();
+  }
+
+  void Run() {
+    // Label collections are only used for syntax, but create() fills them in.
+    set< string > targetLabelCollection, sourceLabelCollection;
+    map< string, int > targetTopLabelCollection, sourceTopLabelCollection;
+    ostringstream extractStream, extractInvStream, extractOrientationStream, unused;
+    for (size_t i = 0; i < m_english.size(); ++i) {
+      SentenceAlignmentWithSyntax sentence
+      (targetLabelCollection, sourceLabelCollection,
+       targetTopLabelCollection, sourceTopLabelCollection,
+       true, false);
+      if (sentence.create(m_english[i].c_str(),
+                          m_foreign[i].c_str(),
+                          m_alignment[i].c_str(),
+                          m_weight[i].c_str(),
+                          m_firstId + i, false)) {
+        if (m_options.placeholders.size()) {
+          sentence.invertAlignment();
+        }
+        ExtractTask(m_firstId + i - 1, sentence, m_options, extractStream, extractInvStream, extractOrientationStream, unused, unused).Run();
+      }
+    }
+    m_extract.Add(extractStream.str());
+    m_extractInv.Add(extractInvStream.str());
+    if (m_extractOrientation) m_extractOrientation->Add(extractOrientationStream.str());
+  }
+
+private:
+  PhraseExtractionOptions &m_options;
+  const int m_firstId;
+  LineSorter &m_extract, &m_extractInv, *m_extractOrientation;
+  std::vector<std::string> m_english, m_foreign, m_alignment, m_weight;
+};
+
+/** One scorer per chunk being scored at a time.  The copies are taken from
+ * the configured scorer before any scoring, so they share its lexical table
+ * and the vocabulary it was loaded with.
+ */
+class ScorerCopies
+{
+public:
+  ScorerCopies(const ExtractScorer &prototype, size_t copies) : m_scorers(copies, prototype) {
+    for (size_t i = 0; i < m_scorers.size(); ++i) {
+      m_free.push_back(&m_scorers[i]);
+    }
+  }
+
+  ExtractScorer *Acquire() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    UTIL_THROW_IF2(m_free.empty(), "more chunks scored at a time than scorers");
+    ExtractScorer *scorer = m_free.back();
+    m_free.pop_back();
+    return scorer;
+  }
+
+  void Release(ExtractScorer *scorer) {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_free.push_back(scorer);
+  }
+
+  // Sums the statistics of the copies into to.
+  void AddCountOfCounts(ExtractScorer &to) const {
+    for (size_t i = 0; i < m_scorers.size(); ++i) {
+      to.AddCountOfCounts(m_scorers[i]);
+    }
+  }
+
+private:
+  std::vector<ExtractScorer> m_scorers;
+  std::vector<ExtractScorer*> m_free;
+  boost::mutex m_mutex;
+};
+
+/** Scores a chunk of sorted extract lines that holds every line of its source
+ * phrases.  The scored lines go to the sorter if there is one, or are kept
+ * for the caller to write in order.
+ */
+class ScoreChunk : public Moses::WaitableTask
+{
+public:
+  ScoreChunk(ScorerCopies &scorers, LineSorter *collect)
+    : m_scorers(scorers), m_collect(collect) {}
+
+  std::string &Lines() {
+    return m_lines;
+  }
+
+  const std::string &Scored() const {
+    return m_scored;
+  }
+
+protected:
+  void DoRun() {
+    std::ostringstream out;
+    {
+      std::istringstream in(m_lines);
+      std::string().swap(m_lines);
+      ExtractRecordReader reader(in);
+      ExtractScorer *scorer = m_scorers.Acquire();
+      scorer->Score(reader, out);
+      m_scorers.Release(scorer);
+    }
+    if (m_collect) {
+      m_collect->Add(out.str());
+    } else {
+      m_scored = out.str();
+    }
+  }
+
+private:
+  ScorerCopies &m_scorers;
+  LineSorter *m_collect;
+  std::string m_lines, m_scored;
+};
+
+/** Sink for LineSorter::Output that cuts the sorted extract into chunks at
+ * changes of the first field and scores them, in the pool if there is one.
+ * Without a sorter to collect them, the scored chunks are written to out in
+ * the order of the extract.
+ */
+class ChunkScorer
+{
+public:
+  ChunkScorer(Moses::ThreadPool *pool, size_t maxPending, ScorerCopies &scorers, std::ostream *out, LineSorter *collect)
+    : m_pipeline(pool, maxPending, boost::bind(&ChunkScorer::Write, this, _1))
+    , m_scorers(scorers), m_out(out), m_collect(collect) {}
+
+  void Line(const StringPiece &line) {
+    static const char kSeparator[] = " ||| ";
+    const char *end = std::search(line.data(), line.data() + line.size(), kSeparator, kSeparator + 5);
+    StringPiece first(line.data(), end - line.data());
+    if (first != m_lastFirst) {
+      if (m_chunk.size() >= kChunkSize) Submit();
+      m_lastFirst.assign(first.data(), first.size());
+    }
+    m_chunk.append(line.data(), line.size());
+    m_chunk += '\n';
+  }
+
+  // Scores the last chunk and waits for every chunk.
+  void Finish() {
+    Submit();
+    m_pipeline.Finish();
+  }
+
+private:
+  static const size_t kChunkSize = 1 << 20;
+
+  void Submit() {
+    if (m_chunk.empty()) return;
+    boost::shared_ptr<ScoreChunk> chunk(new ScoreChunk(m_scorers, m_collect));
+    chunk->Lines().swap(m_chunk);
+    m_pipeline.Submit(chunk);
+  }
+
+  void Write(ScoreChunk &chunk) {
+    if (!m_collect) *m_out << chunk.Scored();
+  }
+
+  Moses::OrderedPipeline<ScoreChunk> m_pipeline;
+  ScorerCopies &m_scorers;
+  std::ostream *m_out;
+  LineSorter *m_collect;
+  std::string m_chunk, m_lastFirst;
+};
+
+void ScoreSorted(LineSorter *sorted, ChunkScorer *scorer)
+{
+  sorted->Output(*scorer);
+  scorer->Finish();
+}
+
+// Builds the command line that score or consolidate would get.
+class Arguments
+{
+public:
+  explicit Arguments(const char *program) {
+    Add(program);
+  }
+
+  void Add(const std::string &arg) {
+    m_args.push_back(arg);
+  }
+
+  void Add(const std::vector<std::string> &args) {
+    m_args.insert(m_args.end(), args.begin(), args.end());
+  }
+
+  int Argc() const {
+    return m_args.size();
+  }
+
+  char **Argv() {
+    m_argv.clear();
+    for (size_t i = 0; i < m_args.size(); ++i) {
+      m_argv.push_back(const_cast<char*>(m_args[i].c_str()));
+    }
+    m_argv.push_back(NULL);
+    return &m_argv[0];
+  }
+
+private:
+  std::vector<std::string> m_args;
+  std::vector<char*> m_argv;
+};
+
+void SplitOptions(const std::string &from, std::vector<std::string> &to)
+{
+  std::vector<std::string> tokens = Moses::Tokenize(from);
+  to.insert(to.end(), tokens.begin(), tokens.end());
+}
+
+} // namespace MosesTraining
+
+int main(int argc, char* argv[])
+{
+  cerr << "build-phrase-table: extract, sort, score and consolidate in one process" << endl;
+
+  if (argc < 8) {
+    cerr << "syntax: build-phrase-table en de align lex.f2e lex.e2f phrase-table max-length [extract options] "
+         << "[--Threads n] [--MemoryBudget MB] [--TempDir dir] [--OrientationFile extract.o.sorted] "
+         << "[--DirectScoreOptions \"...\"] [--InverseScoreOptions \"...\"] [--ConsolidateOptions \"...\"]" << endl;
+    exit(1);
+  }
+
+  const std::string fileNameE = argv[1];
+  const std::string fileNameF = argv[2];
+  const std::string fileNameA = argv[3];
+  const std::string fileNameLexF2E = argv[4];
+  const std::string fileNameLexE2F = argv[5];
+  const std::string fileNamePhraseTable = argv[6];
+  PhraseExtractionOptions options(atoi(argv[7]));
+
+  int sentenceOffset = 0;
+  size_t threads = 1;
+  size_t memoryBudget = 1024;
+  const char *tmpdir = getenv("TMPDIR");
+  std::string tempDir = tmpdir ? tmpdir : "/tmp";
+  std::string fileNameOrientation;
+  std::vector<std::string> directOptions, inverseOptions, consolidateOptions;
+
+  for (int i = 8; i < argc; i++) {
+    if (strcmp(argv[i], "--Threads") == 0 && i + 1 < argc) {
+      threads = std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--MemoryBudget") == 0 && i + 1 < argc) {
+      memoryBudget = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--TempDir") == 0 && i + 1 < argc) {
+      tempDir = argv[++i];
+    } else if (strcmp(argv[i], "--OrientationFile") == 0 && i + 1 < argc) {
+      fileNameOrientation = argv[++i];
+    } else if (strcmp(argv[i], "--DirectScoreOptions") == 0 && i + 1 < argc) {
+      SplitOptions(argv[++i], directOptions);
+    } else if (strcmp(argv[i], "--InverseScoreOptions") == 0 && i + 1 < argc) {
+      SplitOptions(argv[++i], inverseOptions);
+    } else if (strcmp(argv[i], "--ConsolidateOptions") == 0 && i + 1 < argc) {
+      SplitOptions(argv[++i], consolidateOptions);
+    } else if (!ParseExtractOption(argc, argv, i, options, sentenceOffset)) {
+      cerr << "build-phrase-table: syntax error, unknown option '" << argv[i] << "'" << endl;
+      exit(1);
+    }
+  }
+
+#ifndef WITH_THREADS
+  if (threads > 1) {
+    cerr << "build-phrase-table: --Threads needs a build with threads" << endl;
+    exit(1);
+  }
+#endif
+  if (options.isOnlyOutputSpanInfo() || options.isFlexScoreFlag() || !options.isTranslationFlag()) {
+    cerr << "build-phrase-table: --OnlyOutputSpanInfo, --FlexibilityScore and --NoTTable are not supported, use extract" << endl;
+    exit(1);
+  }
+  if (options.isOrientationFlag() && !options.isAllModelsOutputFlag()) {
+    options.initWordModel(true);
+    options.initWordType(REO_MSD);
+  }
+  if (options.isOrientationFlag() && fileNameOrientation.empty()) {
+    cerr << "build-phrase-table: orientation requires --OrientationFile for the sorted orientation extract" << endl;
+    exit(1);
+  }
+
+  // The scorers read the same options as score, on the merged extract streams.
+  ExtractScorer directScorer, inverseScorer;
+  {
+    Arguments direct("score");
+    direct.Add("-");
+    direct.Add(fileNameLexF2E);
+    direct.Add("-");
+    direct.Add(directOptions);
+    directScorer.Configure(direct.Argc(), direct.Argv());
+    Arguments inverse("score");
+    inverse.Add("-");
+    inverse.Add(fileNameLexE2F);
+    inverse.Add("-");
+    inverse.Add("--Inverse");
+    inverse.Add(inverseOptions);
+    inverseScorer.Configure(inverse.Argc(), inverse.Argv());
+  }
+  Consolidator consolidator;
+  {
+    Arguments consolidate("consolidate");
+    consolidate.Add("(direct half)");
+    consolidate.Add("(inverse half)");
+    consolidate.Add(fileNamePhraseTable);
+    consolidate.Add(consolidateOptions);
+    // The count of counts comes from the direct scorers rather than a file.
+    for (size_t i = 0; i < directOptions.size(); ++i) {
+      if (directOptions[i] == "--GoodTuring" || directOptions[i] == "--KneserNey") {
+        consolidate.Add(directOptions[i]);
+        consolidate.Add("(count of counts)");
+      }
+    }
+    consolidator.Configure(consolidate.Argc(), consolidate.Argv());
+  }
+
+  std::string tempPrefix(tempDir);
+  util::NormalizeTempPrefix(tempPrefix);
+  tempPrefix += "build-phrase-table";
+  const size_t sorterBudget = (memoryBudget << 20) / (options.isOrientationFlag() ? 4 : 3);
+  LineSorter extract(sorterBudget, tempPrefix);
+  LineSorter extractInv(sorterBudget, tempPrefix);
+  LineSorter extractOrientation(sorterBudget, tempPrefix);
+  LineSorter halfE2F(sorterBudget, tempPrefix);
+
+  // Extraction: read the corpus in batches and extract them in the pool.
+  {
+    Moses::InputFileStream eFile(fileNameE);
+    Moses::InputFileStream fFile(fileNameF);
+    Moses::InputFileStream aFile(fileNameA);
+    boost::scoped_ptr<Moses::InputFileStream> iwFile;
+    if (options.getInstanceWeightsFile().length()) {
+      iwFile.reset(new Moses::InputFileStream(options.getInstanceWeightsFile()));
+    }
+
+#ifdef WITH_THREADS
+    boost::scoped_ptr<Moses::ThreadPool> pool;
+    if (threads > 1) {
+      pool.reset(new Moses::ThreadPool(threads));
+      pool->SetQueueLimit(threads * 2);
+    }
+#endif
+    const size_t kBatchSize = 1000;
+    int i = sentenceOffset;
+    std::string englishString, foreignString, alignmentString, weightString;
+    boost::shared_ptr<ExtractBatch> batch;
+    while (getline(eFile, englishString)) {
+      i++;
+      if (i%10000 == 0) cerr << "." << flush;
+      getline(fFile, foreignString);
+      getline(aFile, alignmentString);
+      if (iwFile.get()) {
+        getline(*iwFile, weightString);
+      }
+      if (!batch) {
+        batch.reset(new ExtractBatch(options, i, extract, extractInv, options.isOrientationFlag() ? &extractOrientation : NULL));
+      }
+      batch->Add(englishString, foreignString, alignmentString, weightString);
+      if (batch->Size() == kBatchSize) {
+#ifdef WITH_THREADS
+        if (pool) {
+          pool->Submit(batch);
+          batch.reset();
+          continue;
+        }
+#endif
+        batch->Run();
+        batch.reset();
+      }
+    }
+    if (batch) {
+#ifdef WITH_THREADS
+      if (pool) {
+        pool->Submit(batch);
+      } else
+#endif
+        batch->Run();
+    }
+#ifdef WITH_THREADS
+    if (pool) pool->Stop(true);
+#endif
+    cerr << endl;
+  }
+
+  // Scoring: both directions are cut into chunks that are scored at the same
+  // time, the direct ones written in order to a compressed temporary file and
+  // the inverse ones sorted for consolidation.
+  util::scoped_fd halfF2EFile(util::MakeTemp(tempPrefix));
+  {
+#ifdef WITH_THREADS
+    boost::scoped_ptr<Moses::ThreadPool> pool;
+    if (threads > 1) {
+      pool.reset(new Moses::ThreadPool(threads));
+      pool->SetQueueLimit(threads * 2);
+    }
+    Moses::ThreadPool *scorePool = pool.get();
+#else
+    Moses::ThreadPool *scorePool = NULL;
+#endif
+    ScorerCopies directScorers(directScorer, threads);
+    ScorerCopies inverseScorers(inverseScorer, threads);
+    {
+      boost::iostreams::filtering_ostream halfF2E;
+      CompressTo(halfF2E, halfF2EFile.get());
+      ChunkScorer direct(scorePool, threads * 2, directScorers, &halfF2E, NULL);
+      ChunkScorer inverse(scorePool, threads * 2, inverseScorers, NULL, &halfE2F);
+#ifdef WITH_THREADS
+      if (pool) {
+        boost::thread scoreInverse(ScoreSorted, &extractInv, &inverse);
+        ScoreSorted(&extract, &direct);
+        scoreInverse.join();
+        pool->Stop(true);
+      } else
+#endif
+      {
+        ScoreSorted(&extract, &direct);
+        ScoreSorted(&extractInv, &inverse);
+      }
+    }
+    directScorers.AddCountOfCounts(directScorer);
+  }
+  if (options.isOrientationFlag()) {
+    Moses::OutputFileStream out(fileNameOrientation);
+    StreamSink sink(out);
+    extractOrientation.Output(sink);
+  }
+
+  // Consolidation of the direct half with the sorted inverse half.
+  {
+    util::scoped_fd halfE2FFile(util::MakeTemp(tempPrefix));
+    {
+      boost::iostreams::filtering_ostream out;
+      CompressTo(out, halfE2FFile.get());
+      StreamSink sink(out);
+      halfE2F.Output(sink);
+    }
+    if (consolidator.NeedsCountOfCounts()) {
+      std::stringstream countOfCounts;
+      directScorer.WriteCountOfCounts(countOfCounts);
+      consolidator.LoadCountOfCounts(countOfCounts);
+    }
+    util::SeekOrThrow(halfF2EFile.get(), 0);
+    util::SeekOrThrow(halfE2FFile.get(), 0);
+    boost::iostreams::filtering_istream direct, indirect;
+    DecompressFrom(direct, halfF2EFile.get());
+    DecompressFrom(indirect, halfE2FFile.get());
+    Moses::OutputFileStream out;
+    UTIL_THROW_IF2(!out.Open(fileNamePhraseTable), "could not open output file " << fileNamePhraseTable);
+    consolidator.Process(direct, indirect, out);
+    out.Close();
+  }
+  return 0;
+}
@@ -28,12 +28,22 @@
 #include <sstream>
 #include <vector>
 
+#include <boost/bind.hpp>
 #include <boost/program_options.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#ifdef WITH_THREADS
+#include <boost/thread.hpp>
+#endif
 
 #include "syntax-common/exception.h"
 #include "syntax-common/xml_tree_parser.h"
 
 #include "InputFileStream.h"
+#ifdef WITH_THREADS
+#include "LineSorter.h"
+#endif
 #include "OutputFileStream.h"
 #include "SyntaxNode.h"
 #include "SyntaxNodeCollection.h"
@@ -41,6 +51,7 @@
 #include "tables-core.h"
 #include "XmlException.h"
 #include "XmlTree.h"
+#include "moses/ThreadPool.h"
 
 #include "Alignment.h"
 #include "AlignmentGraph.h"
@@ -55,107 +66,173 @@
 
 namespace MosesTraining
 {
+#ifndef WITH_THREADS
+class LineSorter;
+#endif
+
 namespace Syntax
 {
 namespace GHKM
 {
 
-int ExtractGHKM::Main(int argc, char *argv[])
-{
-  using Moses::InputFileStream;
-  using Moses::OutputFileStream;
-
-  // Process command-line options.
-  Options options;
-  ProcessOptions(argc, argv, options);
-
-  // Open input files.
-  //
-  // The GHKM algorithm is neutral about whether the model is string-to-tree or
-  // tree-to-string.  This implementation assumes the model to be
-  // string-to-tree, but if the -t2s option is given then the source and target
-  // input files are switched prior to extraction and then the source and
-  // target of the extracted rules are switched on output.
-  std::string effectiveTargetFile = options.t2s ? options.sourceFile
-                                    : options.targetFile;
-  std::string effectiveSourceFile = options.t2s ? options.targetFile
-                                    : options.sourceFile;
-  InputFileStream targetStream(effectiveTargetFile);
-  InputFileStream sourceStream(effectiveSourceFile);
-  InputFileStream alignmentStream(options.alignmentFile);
+/** Counts needed for the glue grammar, unknown word labels and phrase
+ * orientation priors.  Every chunk collects its own and they are appended to
+ * the totals in input order, so the result does not depend on the number of
+ * threads.
+ */
+struct ExtractGHKM::Statistics {
+  Statistics()
+    : l2rPriorCounts(PhraseOrientation::REO_CLASS_UNKNOWN + 1, 0.0f)
+    , r2lPriorCounts(PhraseOrientation::REO_CLASS_UNKNOWN + 1, 0.0f) {}
+
+  // Add the statistics of the sentences that follow these.
+  void Append(const Statistics &later) {
+    targetLabelSet.insert(later.targetLabelSet.begin(),
+                          later.targetLabelSet.end());
+    for (std::map<std::string, int>::const_iterator p =
+           later.targetTopLabelSet.begin();
+         p != later.targetTopLabelSet.end(); ++p) {
+      targetTopLabelSet[p->first] += p->second;
+    }
+    sourceLabelSet.insert(later.sourceLabelSet.begin(),
+                          later.sourceLabelSet.end());
+    AppendWordCounts(later.targetWordCount, later.targetWordLabel,
+                     targetWordCount, targetWordLabel);
+    AppendWordCounts(later.sourceWordCount, later.sourceWordLabel,
+                     sourceWordCount, sourceWordLabel);
+    for (size_t i = 0; i < l2rPriorCounts.size(); ++i) {
+      l2rPriorCounts[i] += later.l2rPriorCounts[i];
+      r2lPriorCounts[i] += later.r2lPriorCounts[i];
+    }
+  }
 
-  // Open output files.
-  OutputFileStream fwdExtractStream;
-  OutputFileStream invExtractStream;
-  OutputFileStream glueGrammarStream;
-  OutputFileStream targetUnknownWordStream;
-  OutputFileStream sourceUnknownWordStream;
-  OutputFileStream sourceLabelSetStream;
-  OutputFileStream unknownWordSoftMatchesStream;
+  std::set<std::string> targetLabelSet;
+  std::map<std::string, int> targetTopLabelSet;
+  std::set<std::string> sourceLabelSet;
+  WordCountMap targetWordCount;
+  WordLabelMap targetWordLabel;
+  WordCountMap sourceWordCount;
+  WordLabelMap sourceWordLabel;
+  std::vector<float> l2rPriorCounts;
+  std::vector<float> r2lPriorCounts;
+
+private:
+  static void AppendWordCounts(const WordCountMap &fromCount,
+                               const WordLabelMap &fromLabel,
+                               WordCountMap &toCount, WordLabelMap &toLabel) {
+    for (WordCountMap::const_iterator p = fromCount.begin();
+         p != fromCount.end(); ++p) {
+      toCount[p->first] += p->second;
+    }
+    // A word keeps the label of its last occurrence.
+    for (WordLabelMap::const_iterator p = fromLabel.begin();
+         p != fromLabel.end(); ++p) {
+      toLabel[p->first] = p->second;
+    }
+  }
+};
+
+/** A run of consecutive sentences that one thread extracts with its own
+ * parsers.  The rules are held as text until the chunk is written out in
+ * input order, unless the output is sorted, in which case they go straight
+ * to the sorters.
+ */
+class ExtractGHKM::Chunk : public Moses::WaitableTask
+{
+public:
+  Chunk(const ExtractGHKM &tool, const Options &options, size_t firstLineNum,
+        LineSorter *fwdSorter, LineSorter *invSorter)
+    : m_tool(tool)
+    , m_options(options)
+    , m_firstLineNum(firstLineNum)
+    , m_fwdSorter(fwdSorter)
+    , m_invSorter(invSorter) {}
+
+  void Add(const std::string &target, const std::string &source,
+           const std::string &alignment) {
+    m_targetLines.push_back(target);
+    m_sourceLines.push_back(source);
+    m_alignmentLines.push_back(alignment);
+  }
 
-  std::string fwdFileName = options.extractFile;
-  std::string invFileName = options.extractFile + std::string(".inv");
-  if (options.gzOutput) {
-    fwdFileName += ".gz";
-    invFileName += ".gz";
+  size_t Size() const {
+    return m_targetLines.size();
   }
-  OpenOutputFileOrDie(fwdFileName, fwdExtractStream);
-  OpenOutputFileOrDie(invFileName, invExtractStream);
 
-  if (!options.glueGrammarFile.empty()) {
-    OpenOutputFileOrDie(options.glueGrammarFile, glueGrammarStream);
+  const std::string &GetForward() const {
+    return m_fwd;
   }
-  if (!options.targetUnknownWordFile.empty()) {
-    OpenOutputFileOrDie(options.targetUnknownWordFile, targetUnknownWordStream);
+  const std::string &GetInverse() const {
+    return m_inv;
   }
-  if (!options.sourceUnknownWordFile.empty()) {
-    OpenOutputFileOrDie(options.sourceUnknownWordFile, sourceUnknownWordStream);
+  const std::string &GetLog() const {
+    return m_log;
   }
-  if (!options.sourceLabelSetFile.empty()) {
-    if (!options.sourceLabels) {
-      Error("SourceLabels should be active if SourceLabelSet is supposed to be written to a file");
-    }
-    OpenOutputFileOrDie(options.sourceLabelSetFile, sourceLabelSetStream); // note that this is not a global source label set if extraction is parallelized
+  const Statistics &GetStatistics() const {
+    return m_statistics;
   }
-  if (!options.unknownWordSoftMatchesFile.empty()) {
-    OpenOutputFileOrDie(options.unknownWordSoftMatchesFile, unknownWordSoftMatchesStream);
+  // Message for the first input error, if any.  Extraction stops there; the
+  // error is reported by the thread that finishes the chunk.
+  const std::string &GetError() const {
+    return m_error;
   }
 
-  // Word count statistics for producing unknown word labels.
-  std::map<std::string, int> targetWordCount;
-  std::map<std::string, std::string> targetWordLabel;
+protected:
+  void DoRun();
 
-  // Word count statistics for producing unknown word labels: source side.
-  std::map<std::string, int> sourceWordCount;
-  std::map<std::string, std::string> sourceWordLabel;
+private:
+  void Extract();
 
-  std::string targetLine;
-  std::string sourceLine;
-  std::string alignmentLine;
-  Alignment alignment;
-  XmlTreeParser targetXmlTreeParser;
-  XmlTreeParser sourceXmlTreeParser;
-  ScfgRuleWriter scfgWriter(fwdExtractStream, invExtractStream, options);
-  StsgRuleWriter stsgWriter(fwdExtractStream, invExtractStream, options);
-  size_t lineNum = options.sentenceOffset;
-  while (true) {
-    std::getline(targetStream, targetLine);
-    std::getline(sourceStream, sourceLine);
-    std::getline(alignmentStream, alignmentLine);
+  const ExtractGHKM &m_tool;
+  const Options &m_options;
+  const size_t m_firstLineNum;
+  LineSorter *m_fwdSorter;
+  LineSorter *m_invSorter;
 
-    if (targetStream.eof() && sourceStream.eof() && alignmentStream.eof()) {
-      break;
-    }
+  std::vector<std::string> m_targetLines;
+  std::vector<std::string> m_sourceLines;
+  std::vector<std::string> m_alignmentLines;
 
-    if (targetStream.eof() || sourceStream.eof() || alignmentStream.eof()) {
-      Error("Files must contain same number of lines");
-    }
+  std::string m_fwd;
+  std::string m_inv;
+  std::string m_log;
+  std::string m_error;
+  Statistics m_statistics;
+};
+
+void ExtractGHKM::Chunk::DoRun()
+{
+  Extract();
+#ifdef WITH_THREADS
+  if (m_fwdSorter && m_error.empty()) {
+    m_fwdSorter->Add(m_fwd);
+    m_invSorter->Add(m_inv);
+    std::string().swap(m_fwd);
+    std::string().swap(m_inv);
+  }
+#endif
+}
 
-    ++lineNum;
+void ExtractGHKM::Chunk::Extract()
+{
+  std::ostringstream fwdExtractStream;
+  std::ostringstream invExtractStream;
+  std::ostringstream log;
+
+  Alignment alignment;
+  XmlTreeParser targetXmlTreeParser;
+  XmlTreeParser sourceXmlTreeParser;
+  ScfgRuleWriter scfgWriter(fwdExtractStream, invExtractStream, m_options);
+  StsgRuleWriter stsgWriter(fwdExtractStream, invExtractStream, m_options);
+  for (size_t i = 0; i < m_targetLines.size(); ++i) {
+    const std::string &targetLine = m_targetLines[i];
+    const std::string &sourceLine = m_sourceLines[i];
+    const std::string &alignmentLine = m_alignmentLines[i];
+    const size_t lineNum = m_firstLineNum + i;
 
     // Parse target tree.
     if (targetLine.size() == 0) {
-      std::cerr << "skipping line " << lineNum << " with empty target tree\n";
+      log << "skipping line " << lineNum << " with empty target tree\n";
       continue;
     }
     std::auto_ptr<SyntaxTree> targetParseTree;
@@ -168,14 +245,15 @@ int ExtractGHKM::Main(int argc, char *argv[])
       if (!e.msg().empty()) {
         oss << ": " << e.msg();
       }
-      Error(oss.str());
+      m_error = oss.str();
+      break;
     }
 
     // Read source tokens (and parse tree if using source labels).
     std::vector<std::string> sourceTokens;
     std::auto_ptr<SyntaxTree> sourceParseTree;
-    if (!options.sourceLabels) {
-      sourceTokens = ReadTokens(sourceLine);
+    if (!m_options.sourceLabels) {
+      sourceTokens = m_tool.ReadTokens(sourceLine);
     } else {
       try {
         sourceParseTree = sourceXmlTreeParser.Parse(sourceLine);
@@ -186,7 +264,8 @@ int ExtractGHKM::Main(int argc, char *argv[])
         if (!e.msg().empty()) {
           oss << ": " << e.msg();
         }
-        Error(oss.str());
+        m_error = oss.str();
+        break;
       }
       sourceTokens = sourceXmlTreeParser.words();
     }
@@ -198,26 +277,29 @@ int ExtractGHKM::Main(int argc, char *argv[])
       std::ostringstream oss;
       oss << "Failed to read alignment at line " << lineNum << ": ";
       oss << e.msg();
-      Error(oss.str());
+      m_error = oss.str();
+      break;
     }
     if (alignment.size() == 0) {
-      std::cerr << "skipping line " << lineNum << " without alignment points\n";
+      log << "skipping line " << lineNum << " without alignment points\n";
       continue;
     }
-    if (options.t2s) {
+    if (m_options.t2s) {
       FlipAlignment(alignment);
     }
 
     // Record word counts.
-    if (!options.targetUnknownWordFile.empty()) {
-      CollectWordLabelCounts(*targetParseTree, options, targetWordCount,
-                             targetWordLabel);
+    if (!m_options.targetUnknownWordFile.empty()) {
+      m_tool.CollectWordLabelCounts(*targetParseTree, m_options,
+                                    m_statistics.targetWordCount,
+                                    m_statistics.targetWordLabel);
     }
 
     // Record word counts: source side.
-    if (options.sourceLabels && !options.sourceUnknownWordFile.empty()) {
-      CollectWordLabelCounts(*sourceParseTree, options, sourceWordCount,
-                             sourceWordLabel);
+    if (m_options.sourceLabels && !m_options.sourceUnknownWordFile.empty()) {
+      m_tool.CollectWordLabelCounts(*sourceParseTree, m_options,
+                                    m_statistics.sourceWordCount,
+                                    m_statistics.sourceWordLabel);
     }
 
     // Form an alignment graph from the target tree, source words, and
@@ -225,11 +307,11 @@ int ExtractGHKM::Main(int argc, char *argv[])
     AlignmentGraph graph(targetParseTree.get(), sourceTokens, alignment);
 
     // Extract minimal rules, adding each rule to its root node's rule set.
-    graph.ExtractMinimalRules(options);
+    graph.ExtractMinimalRules(m_options);
 
     // Extract composed rules.
-    if (!options.minimal) {
-      graph.ExtractComposedRules(options);
+    if (!m_options.minimal) {
+      graph.ExtractComposedRules(m_options);
     }
 
     // Initialize phrase orientation scoring object
@@ -244,7 +326,7 @@ int ExtractGHKM::Main(int argc, char *argv[])
       const std::vector<const Subgraph *> &rules = (*p)->GetRules();
 
       PhraseOrientation::REO_CLASS l2rOrientation=PhraseOrientation::REO_CLASS_UNKNOWN, r2lOrientation=PhraseOrientation::REO_CLASS_UNKNOWN;
-      if (options.phraseOrientation && !rules.empty()) {
+      if (m_options.phraseOrientation && !rules.empty()) {
         int sourceSpanBegin = *((*p)->GetSpan().begin());
         int sourceSpanEnd   = *((*p)->GetSpan().rbegin());
         l2rOrientation = phraseOrientation.GetOrientationInfo(sourceSpanBegin,sourceSpanEnd,PhraseOrientation::REO_DIR_L2R);
@@ -256,51 +338,216 @@ int ExtractGHKM::Main(int argc, char *argv[])
       for (std::vector<const Subgraph *>::const_iterator q = rules.begin();
            q != rules.end(); ++q) {
         // STSG output.
-        if (options.stsg) {
+        if (m_options.stsg) {
           StsgRule rule(**q);
-          if (rule.Scope() <= options.maxScope) {
+          if (rule.Scope() <= m_options.maxScope) {
             stsgWriter.Write(rule);
           }
           continue;
         }
         // SCFG output.
         ScfgRule *r = 0;
-        if (options.sourceLabels) {
+        if (m_options.sourceLabels) {
           r = new ScfgRule(**q, &sourceXmlTreeParser.node_collection());
         } else {
           r = new ScfgRule(**q);
         }
         // TODO Can scope pruning be done earlier?
-        if (r->Scope() <= options.maxScope) {
+        if (r->Scope() <= m_options.maxScope) {
           scfgWriter.Write(*r,lineNum,false);
-          if (options.treeFragments) {
+          if (m_options.treeFragments) {
             fwdExtractStream << " {{Tree ";
             (*q)->PrintTree(fwdExtractStream);
             fwdExtractStream << "}}";
           }
-          if (options.partsOfSpeech) {
+          if (m_options.partsOfSpeech) {
             fwdExtractStream << " {{POS";
             (*q)->PrintPartsOfSpeech(fwdExtractStream);
             fwdExtractStream << "}}";
           }
-          if (options.phraseOrientation) {
+          if (m_options.phraseOrientation) {
             fwdExtractStream << " {{Orientation ";
             phraseOrientation.WriteOrientation(fwdExtractStream,l2rOrientation);
             fwdExtractStream << " ";
             phraseOrientation.WriteOrientation(fwdExtractStream,r2lOrientation);
             fwdExtractStream << "}}";
-            phraseOrientation.IncrementPriorCount(PhraseOrientation::REO_DIR_L2R,l2rOrientation,1);
-            phraseOrientation.IncrementPriorCount(PhraseOrientation::REO_DIR_R2L,r2lOrientation,1);
+            m_statistics.l2rPriorCounts[l2rOrientation] += 1;
+            m_statistics.r2lPriorCounts[r2lOrientation] += 1;
           }
-          fwdExtractStream << std::endl;
-          invExtractStream << std::endl;
+          fwdExtractStream << '\n';
+          invExtractStream << '\n';
         }
         delete r;
       }
     }
   }
 
+  m_statistics.targetLabelSet = targetXmlTreeParser.label_set();
+  m_statistics.targetTopLabelSet = targetXmlTreeParser.top_label_set();
+  m_statistics.sourceLabelSet = sourceXmlTreeParser.label_set();
+  m_fwd = fwdExtractStream.str();
+  m_inv = invExtractStream.str();
+  m_log = log.str();
+
+  std::vector<std::string>().swap(m_targetLines);
+  std::vector<std::string>().swap(m_sourceLines);
+  std::vector<std::string>().swap(m_alignmentLines);
+}
+
+int ExtractGHKM::Main(int argc, char *argv[])
+{
+  using Moses::InputFileStream;
+  using Moses::OutputFileStream;
+
+  // Process command-line options.
+  Options options;
+  ProcessOptions(argc, argv, options);
+
+  // Open input files.
+  //
+  // The GHKM algorithm is neutral about whether the model is string-to-tree or
+  // tree-to-string.  This implementation assumes the model to be
+  // string-to-tree, but if the -t2s option is given then the source and target
+  // input files are switched prior to extraction and then the source and
+  // target of the extracted rules are switched on output.
+  std::string effectiveTargetFile = options.t2s ? options.sourceFile
+                                    : options.targetFile;
+  std::string effectiveSourceFile = options.t2s ? options.targetFile
+                                    : options.sourceFile;
+  InputFileStream targetStream(effectiveTargetFile);
+  InputFileStream sourceStream(effectiveSourceFile);
+  InputFileStream alignmentStream(options.alignmentFile);
+
+  // Open output files.
+  OutputFileStream fwdExtractStream;
+  OutputFileStream invExtractStream;
+  OutputFileStream glueGrammarStream;
+  OutputFileStream targetUnknownWordStream;
+  OutputFileStream sourceUnknownWordStream;
+  OutputFileStream sourceLabelSetStream;
+  OutputFileStream unknownWordSoftMatchesStream;
+
+  std::string fwdFileName = options.extractFile;
+  std::string invFileName = options.extractFile + std::string(".inv");
+  if (options.gzOutput) {
+    fwdFileName += ".gz";
+    invFileName += ".gz";
+  }
+  OpenOutputFileOrDie(fwdFileName, fwdExtractStream);
+  OpenOutputFileOrDie(invFileName, invExtractStream);
+
+  if (!options.glueGrammarFile.empty()) {
+    OpenOutputFileOrDie(options.glueGrammarFile, glueGrammarStream);
+  }
+  if (!options.targetUnknownWordFile.empty()) {
+    OpenOutputFileOrDie(options.targetUnknownWordFile, targetUnknownWordStream);
+  }
+  if (!options.sourceUnknownWordFile.empty()) {
+    OpenOutputFileOrDie(options.sourceUnknownWordFile, sourceUnknownWordStream);
+  }
+  if (!options.sourceLabelSetFile.empty()) {
+    if (!options.sourceLabels) {
+      Error("SourceLabels should be active if SourceLabelSet is supposed to be written to a file");
+    }
+    OpenOutputFileOrDie(options.sourceLabelSetFile, sourceLabelSetStream); // note that this is not a global source label set if extraction is parallelized
+  }
+  if (!options.unknownWordSoftMatchesFile.empty()) {
+    OpenOutputFileOrDie(options.unknownWordSoftMatchesFile, unknownWordSoftMatchesStream);
+  }
+
+  // Label sets, word count statistics for producing unknown word labels, and
+  // phrase orientation priors.
+  Statistics statistics;
+
+  LineSorter *fwdSorter = 0;
+  LineSorter *invSorter = 0;
+#ifdef WITH_THREADS
+  // Sorted output is merged from the runs that the chunks spill as they
+  // finish, which saves sorting the extract files afterwards.
+  boost::scoped_ptr<LineSorter> fwdSorted;
+  boost::scoped_ptr<LineSorter> invSorted;
+  if (options.sortedOutput) {
+    std::string tempPrefix(options.tempDir);
+    util::NormalizeTempPrefix(tempPrefix);
+    tempPrefix += "extract-ghkm";
+    const size_t sorterBudget = (static_cast<size_t>(options.memoryBudget) << 20) / 2;
+    fwdSorted.reset(new LineSorter(sorterBudget, tempPrefix));
+    invSorted.reset(new LineSorter(sorterBudget, tempPrefix));
+    fwdSorter = fwdSorted.get();
+    invSorter = invSorted.get();
+  }
+
+  // With one thread, chunks are extracted inline, sorted output or not.
+  boost::scoped_ptr<Moses::ThreadPool> pool;
+  if (options.threads > 1) {
+    pool.reset(new Moses::ThreadPool(options.threads));
+  }
+  Moses::ThreadPool *chunkPool = pool.get();
+#else
+  Moses::ThreadPool *chunkPool = NULL;
+#endif
+  // Limit the number of extracted chunks waiting to be written.
+  Moses::OrderedPipeline<Chunk> chunks(
+    chunkPool, 2 * static_cast<size_t>(options.threads),
+    boost::bind(&ExtractGHKM::FinishChunk, this, _1, chunkPool,
+                boost::ref(fwdExtractStream), boost::ref(invExtractStream),
+                boost::ref(statistics)));
+
+  const size_t chunkSize = 100;
+  std::string targetLine;
+  std::string sourceLine;
+  std::string alignmentLine;
+  boost::shared_ptr<Chunk> chunk;
+  size_t lineNum = options.sentenceOffset;
+  while (true) {
+    std::getline(targetStream, targetLine);
+    std::getline(sourceStream, sourceLine);
+    std::getline(alignmentStream, alignmentLine);
+
+    const bool end = targetStream.eof() && sourceStream.eof() &&
+                     alignmentStream.eof();
+
+    if (!end) {
+      if (targetStream.eof() || sourceStream.eof() || alignmentStream.eof()) {
+        Error("Files must contain same number of lines");
+      }
+      ++lineNum;
+      if (!chunk) {
+        chunk.reset(new Chunk(*this, options, lineNum, fwdSorter, invSorter));
+      }
+      chunk->Add(targetLine, sourceLine, alignmentLine);
+    }
+
+    if (chunk && (end || chunk->Size() == chunkSize)) {
+      chunks.Submit(chunk);
+      chunk.reset();
+    }
+
+    if (end) {
+      break;
+    }
+  }
+
+  chunks.Finish();
+#ifdef WITH_THREADS
+  if (pool) {
+    pool->Stop(true);
+  }
+  if (options.sortedOutput) {
+    StreamSink fwdSink(fwdExtractStream);
+    fwdSorter->Output(fwdSink);
+    StreamSink invSink(invExtractStream);
+    invSorter->Output(invSink);
+  }
+#endif
+
   if (options.phraseOrientation) {
+    PhraseOrientation priors;
+    for (size_t i = 0; i < statistics.l2rPriorCounts.size(); ++i) {
+      PhraseOrientation::REO_CLASS orient = static_cast<PhraseOrientation::REO_CLASS>(i);
+      priors.IncrementPriorCount(PhraseOrientation::REO_DIR_L2R, orient, statistics.l2rPriorCounts[i]);
+      priors.IncrementPriorCount(PhraseOrientation::REO_DIR_R2L, orient, statistics.r2lPriorCounts[i]);
+    }
     std::string phraseOrientationPriorsFileName = options.extractFile + std::string(".phraseOrientationPriors");
     OutputFileStream phraseOrientationPriorsStream;
     OpenOutputFileOrDie(phraseOrientationPriorsFileName, phraseOrientationPriorsStream);
@@ -309,7 +556,7 @@ int ExtractGHKM::Main(int argc, char *argv[])
 
   std::map<std::string,size_t> sourceLabels;
   if (options.sourceLabels && !options.sourceLabelSetFile.empty()) {
-    std::set<std::string> extendedLabelSet = sourceXmlTreeParser.label_set();
+    std::set<std::string> extendedLabelSet = statistics.sourceLabelSet;
     extendedLabelSet.insert("XLHS"); // non-matching label (left-hand side)
     extendedLabelSet.insert("XRHS"); // non-matching label (right-hand side)
     extendedLabelSet.insert("TOPLABEL");  // as used in the glue grammar
@@ -326,8 +573,8 @@ int ExtractGHKM::Main(int argc, char *argv[])
   std::map<std::string, int> strippedTargetTopLabelSet;
   if (options.stripBitParLabels &&
       (!options.glueGrammarFile.empty() || !options.unknownWordSoftMatchesFile.empty())) {
-    StripBitParLabels(targetXmlTreeParser.label_set(),
-                      targetXmlTreeParser.top_label_set(),
+    StripBitParLabels(statistics.targetLabelSet,
+                      statistics.targetTopLabelSet,
                       strippedTargetLabelSet, strippedTargetTopLabelSet);
   }
 
@@ -335,25 +582,25 @@ int ExtractGHKM::Main(int argc, char *argv[])
     if (options.stripBitParLabels) {
       WriteGlueGrammar(strippedTargetLabelSet, strippedTargetTopLabelSet, sourceLabels, options, glueGrammarStream);
     } else {
-      WriteGlueGrammar(targetXmlTreeParser.label_set(),
-                       targetXmlTreeParser.top_label_set(),
+      WriteGlueGrammar(statistics.targetLabelSet,
+                       statistics.targetTopLabelSet,
                        sourceLabels, options, glueGrammarStream);
     }
   }
 
   if (!options.targetUnknownWordFile.empty()) {
-    WriteUnknownWordLabel(targetWordCount, targetWordLabel, options, targetUnknownWordStream);
+    WriteUnknownWordLabel(statistics.targetWordCount, statistics.targetWordLabel, options, targetUnknownWordStream);
   }
 
   if (options.sourceLabels && !options.sourceUnknownWordFile.empty()) {
-    WriteUnknownWordLabel(sourceWordCount, sourceWordLabel, options, sourceUnknownWordStream, true);
+    WriteUnknownWordLabel(statistics.sourceWordCount, statistics.sourceWordLabel, options, sourceUnknownWordStream, true);
   }
 
   if (!options.unknownWordSoftMatchesFile.empty()) {
     if (options.stripBitParLabels) {
       WriteUnknownWordSoftMatches(strippedTargetLabelSet, unknownWordSoftMatchesStream);
     } else {
-      WriteUnknownWordSoftMatches(targetXmlTreeParser.label_set(),
+      WriteUnknownWordSoftMatches(statistics.targetLabelSet,
                                   unknownWordSoftMatchesStream);
     }
   }
@@ -361,6 +608,26 @@ int ExtractGHKM::Main(int argc, char *argv[])
   return 0;
 }
 
+void ExtractGHKM::FinishChunk(Chunk &chunk, Moses::ThreadPool *pool,
+                              std::ostream &fwd, std::ostream &inv,
+                              Statistics &statistics) const
+{
+  std::cerr << chunk.GetLog();
+  if (!chunk.GetError().empty()) {
+#ifdef WITH_THREADS
+    // Let the workers finish before exiting with the error, so that none
+    // of them is still writing to the sorters.
+    if (pool) {
+      pool->Stop(true);
+    }
+#endif
+    Error(chunk.GetError());
+  }
+  fwd << chunk.GetForward();
+  inv << chunk.GetInverse();
+  statistics.Append(chunk.GetStatistics());
+}
+
 void ExtractGHKM::ProcessOptions(int argc, char *argv[],
                                  Options &options) const
 {
@@ -440,6 +707,9 @@ void ExtractGHKM::ProcessOptions(int argc, char *argv[],
   ("MaxScope",
    po::value(&options.maxScope)->default_value(options.maxScope),
    "set maximum allowed scope")
+  ("MemoryBudget",
+   po::value(&options.memoryBudget)->default_value(options.memoryBudget),
+   "set memory in MB for sorting extract files with --SortedOutput")
   ("Minimal",
    "extract minimal rules only")
   ("PartsOfSpeech",
@@ -466,6 +736,14 @@ void ExtractGHKM::ProcessOptions(int argc, char *argv[],
   ("SentenceOffset",
    po::value(&options.sentenceOffset)->default_value(options.sentenceOffset),
    "set sentence number offset if processing split corpus")
+  ("SortedOutput",
+   "write extract files in LC_ALL=C sort order")
+  ("TempDir",
+   po::value(&options.tempDir)->default_value(options.tempDir),
+   "set directory for temporary files of --SortedOutput")
+  ("Threads",
+   po::value(&options.threads)->default_value(options.threads),
+   "set number of extraction threads")
   ("UnknownWordLabel",
    po::value(&options.targetUnknownWordFile),
    "write unknown word labels to named file")
@@ -581,6 +859,9 @@ void ExtractGHKM::ProcessOptions(int argc, char *argv[],
   if (vm.count("TreeFragments")) {
     options.treeFragments = true;
   }
+  if (vm.count("SortedOutput")) {
+    options.sortedOutput = true;
+  }
   if (vm.count("SourceLabels")) {
     options.sourceLabels = true;
   }
@@ -591,6 +872,15 @@ void ExtractGHKM::ProcessOptions(int argc, char *argv[],
     options.unpairedExtractFormat = true;
   }
 
+  if (options.threads < 1) {
+    Error("Threads must be at least 1");
+  }
+#ifndef WITH_THREADS
+  if (options.threads > 1 || options.sortedOutput) {
+    Error("Threads and SortedOutput need a build with threads");
+  }
+#endif
+
   // Workaround for extract-parallel issue.
   if (options.sentenceOffset > 0) {
     options.targetUnknownWordFile.clear();
@@ -767,8 +1057,8 @@ void ExtractGHKM::WriteSourceLabelSet(
 void ExtractGHKM::CollectWordLabelCounts(
   SyntaxTree &root,
   const Options &options,
-  std::map<std::string, int> &wordCount,
-  std::map<std::string, std::string> &wordLabel)
+  WordCountMap &wordCount,
+  WordLabelMap &wordLabel) const
 {
   for (SyntaxTree::ConstLeafIterator p(root);
        p != SyntaxTree::ConstLeafIterator(); ++p) {
@@ -804,8 +1094,8 @@ std::vector<std::string> ExtractGHKM::ReadTokens(const SyntaxTree &root) const
 }
 
 void ExtractGHKM::WriteUnknownWordLabel(
-  const std::map<std::string, int> &wordCount,
-  const std::map<std::string, std::string> &wordLabel,
+  const WordCountMap &wordCount,
+  const WordLabelMap &wordLabel,
   const Options &options,
   std::ostream &out,
   bool writeCounts) const
@@ -817,11 +1107,11 @@ void ExtractGHKM::WriteUnknownWordLabel(
 
   std::map<std::string, int> labelCount;
   int total = 0;
-  for (std::map<std::string, int>::const_iterator p = wordCount.begin();
+  for (WordCountMap::const_iterator p = wordCount.begin();
        p != wordCount.end(); ++p) {
     // Only consider singletons.
     if (p->second == 1) {
-      std::map<std::string, std::string>::const_iterator q =
+      WordLabelMap::const_iterator q =
         wordLabel.find(p->first);
       assert(q != wordLabel.end());
       if (options.stripBitParLabels) {
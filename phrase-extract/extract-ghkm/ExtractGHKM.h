@@ -25,11 +25,18 @@
 #include <string>
 #include <vector>
 
+#include <boost/unordered_map.hpp>
+
 #include "OutputFileStream.h"
 #include "SyntaxTree.h"
 
 #include "syntax-common/tool.h"
 
+namespace Moses
+{
+class ThreadPool;
+}
+
 namespace MosesTraining
 {
 namespace Syntax
@@ -47,13 +54,22 @@ public:
   virtual int Main(int argc, char *argv[]);
 
 private:
+  typedef boost::unordered_map<std::string, int> WordCountMap;
+  typedef boost::unordered_map<std::string, std::string> WordLabelMap;
+
+  struct Statistics;
+  class Chunk;
+
+  void FinishChunk(Chunk &, Moses::ThreadPool *, std::ostream &,
+                   std::ostream &, Statistics &) const;
+
   void RecordTreeLabels(const SyntaxTree &, std::set<std::string> &);
   void CollectWordLabelCounts(SyntaxTree &,
                               const Options &,
-                              std::map<std::string, int> &,
-                              std::map<std::string, std::string> &);
-  void WriteUnknownWordLabel(const std::map<std::string, int> &,
-                             const std::map<std::string, std::string> &,
+                              WordCountMap &,
+                              WordLabelMap &) const;
+  void WriteUnknownWordLabel(const WordCountMap &,
+                             const WordLabelMap &,
                              const Options &,
                              std::ostream &,
                              bool writeCounts=false) const;
@@ -39,16 +39,20 @@ public:
     , maxRuleDepth(3)
     , maxRuleSize(3)
     , maxScope(3)
+    , memoryBudget(1024)
     , minimal(false)
     , partsOfSpeech(false)
     , partsOfSpeechFactor(false)
     , pcfg(false)
     , phraseOrientation(false)
     , sentenceOffset(0)
+    , sortedOutput(false)
     , sourceLabels(false)
     , stripBitParLabels(false)
     , stsg(false)
     , t2s(false)
+    , tempDir("/tmp")
+    , threads(1)
     , treeFragments(false)
     , unknownWordMinRelFreq(0.03f)
     , unknownWordUniform(false)
@@ -70,12 +74,14 @@ public:
   int maxRuleDepth;
   int maxRuleSize;
   int maxScope;
+  int memoryBudget;
   bool minimal;
   bool partsOfSpeech;
   bool partsOfSpeechFactor;
   bool pcfg;
   bool phraseOrientation;
   int sentenceOffset;
+  bool sortedOutput;
   bool sourceLabels;
   std::string sourceLabelSetFile;
   std::string sourceUnknownWordFile;
@@ -83,6 +89,8 @@ public:
   bool stsg;
   bool t2s;
   std::string targetUnknownWordFile;
+  std::string tempDir;
+  int threads;
   bool treeFragments;
   float unknownWordMinRelFreq;
   std::string unknownWordSoftMatchesFile;
@@ -36,7 +36,10 @@
 //#include <vld.h>
 #endif
 
+#include <boost/scoped_ptr.hpp>
+
 #include "ExtractedRule.h"
+#include "ExtractRecord.h"
 #include "Hole.h"
 #include "HoleCollection.h"
 #include "RuleExist.h"
@@ -59,10 +62,10 @@ class ExtractTask
 private:
   SentenceAlignmentWithSyntax &m_sentence;
   const RuleExtractionOptions &m_options;
-  Moses::OutputFileStream& m_extractFile;
-  Moses::OutputFileStream& m_extractFileInv;
-  Moses::OutputFileStream& m_extractFileContext;
-  Moses::OutputFileStream& m_extractFileContextInv;
+  std::ostream& m_extractFile;
+  std::ostream& m_extractFileInv;
+  std::ostream& m_extractFileContext;
+  std::ostream& m_extractFileContextInv;
   PhraseOrientation m_phraseOrientation;
 
   vector< ExtractedRule > m_extractedRules;
@@ -97,7 +100,7 @@ private:
   }
 
 public:
-  ExtractTask(SentenceAlignmentWithSyntax &sentence, const RuleExtractionOptions &options, Moses::OutputFileStream &extractFile, Moses::OutputFileStream &extractFileInv, Moses::OutputFileStream &extractFileContext, Moses::OutputFileStream &extractFileContextInv):
+  ExtractTask(SentenceAlignmentWithSyntax &sentence, const RuleExtractionOptions &options, std::ostream &extractFile, std::ostream &extractFileInv, std::ostream &extractFileContext, std::ostream &extractFileContextInv):
     m_sentence(sentence),
     m_options(options),
     m_extractFile(extractFile),
@@ -147,7 +150,9 @@ int main(int argc, char* argv[])
          << " | --ConditionOnTargetLHS ]"
          << " | --BoundaryRules[" << options.boundaryRules << "]"
          << " | --FlexibilityScore"
-         << " | --PhraseOrientation\n";
+         << " | --PhraseOrientation"
+         << " | --BinaryOutput\n"
+         << "  --BinaryOutput: write varint-coded records, sort them with extract-sort\n";
 
     exit(1);
   }
@@ -222,6 +227,8 @@ int main(int argc, char* argv[])
       }
     } else if (strcmp(argv[i], "--GZOutput") == 0) {
       options.gzOutput = true;
+    } else if (strcmp(argv[i], "--BinaryOutput") == 0) {
+      options.binaryOutput = true;
     }
     // allow consecutive non-terminals (X Y | X Y)
     else if (strcmp(argv[i],"--TargetSyntax") == 0) {
@@ -329,6 +336,13 @@ int main(int argc, char* argv[])
     }
   }
 
+  // binary output is encoded from the text of each sentence
+  boost::scoped_ptr<ExtractRecordWriter> binaryExtract, binaryExtractInv;
+  if (options.binaryOutput) {
+    binaryExtract.reset(new ExtractRecordWriter(extractFile));
+    if (!options.onlyDirectFlag) binaryExtractInv.reset(new ExtractRecordWriter(extractFileInv));
+  }
+
   // stats on labels for glue grammar and unknown word label probabilities
   set< string > targetLabelCollection, sourceLabelCollection;
   map< string, int > targetTopLabelCollection, sourceTopLabelCollection;
@@ -361,9 +375,17 @@ int main(int argc, char* argv[])
       if (options.unknownWordLabelFlag) {
         collectWordLabelCounts(sentence);
       }
-      ExtractTask *task = new ExtractTask(sentence, options, extractFile, extractFileInv, extractFileContext, extractFileContextInv);
-      task->Run();
-      delete task;
+      if (options.binaryOutput) {
+        ostringstream rules, rulesInv;
+        ExtractTask task(sentence, options, rules, rulesInv, extractFileContext, extractFileContextInv);
+        task.Run();
+        binaryExtract->WriteLines(rules.str());
+        if (binaryExtractInv) binaryExtractInv->WriteLines(rulesInv.str());
+      } else {
+        ExtractTask *task = new ExtractTask(sentence, options, extractFile, extractFileInv, extractFileContext, extractFileContextInv);
+        task->Run();
+        delete task;
+      }
     }
     if (options.onlyOutputSpanInfo) cout << "LOG: PHRASES_END:" << endl; //az: mark end of phrases
   }
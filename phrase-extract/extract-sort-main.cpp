@@ -0,0 +1,132 @@
+/***********************************************************************
+  Moses - factored phrase-based language decoder
+  Copyright (C) 2009 University of Edinburgh
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ ***********************************************************************/
+
+/* Sorts text or binary extract files in the order of LC_ALL=C sort, which is
+ * what score expects.  This is the sort step for binary extract files, which
+ * the sort command cannot handle.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/scoped_ptr.hpp>
+
+#include "ExtractRecord.h"
+#include "InputFileStream.h"
+#include "OutputFileStream.h"
+
+#ifdef WITH_THREADS
+#include "LineSorter.h"
+#endif
+
+using namespace std;
+using namespace MosesTraining;
+
+#ifdef WITH_THREADS
+
+namespace
+{
+
+struct BinarySink {
+  explicit BinarySink(ExtractRecordWriter &out) : m_out(out) {}
+  void Line(const StringPiece &line) {
+    m_out.Write(line);
+  }
+  ExtractRecordWriter &m_out;
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  size_t memoryBudget = 1024;
+  const char *tmpdir = getenv("TMPDIR");
+  std::string tempDir = tmpdir ? tmpdir : "/tmp";
+  bool binaryOutput = false;
+
+  int i = 1;
+  for (; i < argc && !strncmp(argv[i], "--", 2); ++i) {
+    if (strcmp(argv[i], "--MemoryBudget") == 0 && i + 1 < argc) {
+      memoryBudget = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--TempDir") == 0 && i + 1 < argc) {
+      tempDir = argv[++i];
+    } else if (strcmp(argv[i], "--BinaryOutput") == 0) {
+      binaryOutput = true;
+    } else {
+      cerr << "extract-sort: unknown option '" << argv[i] << "'" << endl;
+      exit(1);
+    }
+  }
+  if (argc - i < 2) {
+    cerr << "syntax: extract-sort [--MemoryBudget MB] [--TempDir dir] [--BinaryOutput] output input..." << endl;
+    cerr << "  inputs may be text or binary extract files; --BinaryOutput writes binary records" << endl;
+    exit(1);
+  }
+
+  std::string tempPrefix(tempDir);
+  util::NormalizeTempPrefix(tempPrefix);
+  tempPrefix += "extract-sort";
+  LineSorter sorter(memoryBudget << 20, tempPrefix);
+
+  const std::string fileNameOutput = argv[i++];
+  for (; i < argc; ++i) {
+    // Each file has its own vocabulary, so binary files are decoded one at a time.
+    Moses::InputFileStream in(argv[i]);
+    ExtractRecordReader reader(in);
+    std::string batch, line;
+    while (reader.ReadLine(line)) {
+      batch += line;
+      batch += '\n';
+      if (batch.size() >= (1 << 20)) {
+        sorter.Add(batch);
+        batch.clear();
+      }
+    }
+    sorter.Add(batch);
+  }
+
+  Moses::OutputFileStream out;
+  if (!out.Open(fileNameOutput)) {
+    cerr << "extract-sort: could not open " << fileNameOutput << endl;
+    exit(1);
+  }
+  if (binaryOutput) {
+    ExtractRecordWriter writer(out);
+    BinarySink sink(writer);
+    sorter.Output(sink);
+  } else {
+    StreamSink sink(out);
+    sorter.Output(sink);
+  }
+  out.Close();
+  return 0;
+}
+
+#else // WITH_THREADS
+
+int main(int argc, char* argv[])
+{
+  cerr << "extract-sort: compiled without threads, decode and use sort instead" << endl;
+  return 1;
+}
+
+#endif // WITH_THREADS
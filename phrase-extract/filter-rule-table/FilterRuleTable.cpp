@@ -9,13 +9,19 @@
 #include <sstream>
 #include <vector>
 
+#include <boost/bind.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/program_options.hpp>
 
+#ifdef WITH_THREADS
+#include <boost/thread.hpp>
+#endif
+
 #include "syntax-common/exception.h"
 #include "syntax-common/xml_tree_parser.h"
 
 #include "InputFileStream.h"
+#include "moses/ThreadPool.h"
 
 #include "ForestTsgFilter.h"
 #include "Options.h"
@@ -32,6 +38,90 @@ namespace Syntax
 namespace FilterRuleTable
 {
 
+namespace
+{
+
+// Filters one block of whole lines from the rule table.
+template<typename FilterType>
+class FilterBlockTask : public Moses::WaitableTask
+{
+public:
+  // Takes the contents of block.
+  FilterBlockTask(const FilterType &filter, std::string &block)
+    : m_filter(filter) {
+    m_block.swap(block);
+  }
+
+  // The rules that were kept.
+  const std::string &GetOutput() const {
+    return m_output;
+  }
+
+protected:
+  void DoRun() {
+    std::istringstream in(m_block);
+    std::ostringstream out;
+    m_filter.Filter(in, out);
+    std::string().swap(m_block);
+    m_output = out.str();
+  }
+
+private:
+  const FilterType &m_filter;
+  std::string m_block;
+  std::string m_output;
+};
+
+template<typename TaskType>
+void WriteOutput(std::ostream &out, TaskType &task)
+{
+  out << task.GetOutput();
+}
+
+// Filter the rule table from 'in' to 'out'.  With more than one thread, the
+// table is cut into blocks of whole lines that are filtered concurrently
+// against the same test set structures and written out in input order.  A
+// block boundary only costs the reuse of the previous rule's decision.
+template<typename FilterType>
+void RunFilter(const FilterType &filter, int threads, std::istream &in,
+               std::ostream &out)
+{
+#ifdef WITH_THREADS
+  if (threads > 1) {
+    typedef FilterBlockTask<FilterType> Task;
+    const std::size_t blockSize = 1 << 22;
+    Moses::ThreadPool pool(threads);
+    // Limit the number of blocks held in memory.
+    Moses::OrderedPipeline<Task> blocks(
+      &pool, 2 * static_cast<std::size_t>(threads),
+      boost::bind(&WriteOutput<Task>, boost::ref(out), _1));
+    std::string block;
+    std::string line;
+    while (in) {
+      block.resize(blockSize);
+      in.read(&block[0], blockSize);
+      block.resize(in.gcount());
+      // Complete the last line.
+      if (!block.empty() && block[block.size()-1] != '\n' &&
+          std::getline(in, line)) {
+        block += line;
+        block += '\n';
+      }
+      if (block.empty()) {
+        break;
+      }
+      blocks.Submit(boost::shared_ptr<Task>(new Task(filter, block)));
+    }
+    blocks.Finish();
+    pool.Stop(true);
+    return;
+  }
+#endif
+  filter.Filter(in, out);
+}
+
+}  // namespace
+
 int FilterRuleTable::Main(int argc, char *argv[])
 {
   enum TestSentenceFormat {
@@ -80,7 +170,7 @@ int FilterRuleTable::Main(int argc, char *argv[])
     std::vector<boost::shared_ptr<std::string> > testStrings;
     ReadTestSet(testStream, testStrings);
     StringCfgFilter filter(testStrings);
-    filter.Filter(std::cin, std::cout);
+    RunFilter(filter, options.threads, std::cin, std::cout);
   } else if (testSentenceFormat == kTree) {
     std::vector<boost::shared_ptr<SyntaxTree> > testTrees;
     ReadTestSet(testStream, testTrees);
@@ -88,10 +178,10 @@ int FilterRuleTable::Main(int argc, char *argv[])
       // TODO Implement TreeCfgFilter
       Warn("tree/cfg filtering algorithm not implemented: input will be copied unchanged to output");
       TreeCfgFilter filter(testTrees);
-      filter.Filter(std::cin, std::cout);
+      RunFilter(filter, options.threads, std::cin, std::cout);
     } else if (sourceSideRuleFormat == kTsg) {
       TreeTsgFilter filter(testTrees);
-      filter.Filter(std::cin, std::cout);
+      RunFilter(filter, options.threads, std::cin, std::cout);
     } else {
       assert(false);
     }
@@ -100,7 +190,7 @@ int FilterRuleTable::Main(int argc, char *argv[])
     ReadTestSet(testStream, testForests);
     assert(sourceSideRuleFormat == kTsg);
     ForestTsgFilter filter(testForests);
-    filter.Filter(std::cin, std::cout);
+    RunFilter(filter, options.threads, std::cin, std::cout);
   }
 
   return 0;
@@ -179,6 +269,11 @@ void FilterRuleTable::ProcessOptions(int argc, char *argv[],
 
   // Declare the command line options that are visible to the user.
   po::options_description visible(usageTop.str());
+  visible.add_options()
+  ("Threads",
+   po::value(&options.threads)->default_value(options.threads),
+   "filter blocks of the rule table on this many threads")
+  ;
 
   // Declare the command line options that are hidden from the user
   // (these are used as positional options).
@@ -224,6 +319,15 @@ void FilterRuleTable::ProcessOptions(int argc, char *argv[],
     std::cerr << visible << usageBottom.str() << std::endl;
     std::exit(1);
   }
+
+  if (options.threads < 1) {
+    Error("Threads must be at least 1");
+  }
+#ifndef WITH_THREADS
+  if (options.threads > 1) {
+    Error("Threads needs a build with threads");
+  }
+#endif
 }
 
 }  // namespace FilterRuleTable
@@ -50,7 +50,7 @@ StringCfgFilter::StringCfgFilter(
   }
 }
 
-void StringCfgFilter::Filter(std::istream &in, std::ostream &out)
+void StringCfgFilter::Filter(std::istream &in, std::ostream &out) const
 {
   const util::MultiCharacter fieldDelimiter("|||");
   const util::AnyCharacter symbolDelimiter(" \t");
@@ -75,7 +75,7 @@ void StringCfgFilter::Filter(std::istream &in, std::ostream &out)
     // (which is the case in the standard Moses training pipeline).
     if (*it == source) {
       if (keep) {
-        out << line << std::endl;
+        out << line << '\n';
       }
       continue;
     }
@@ -94,7 +94,7 @@ void StringCfgFilter::Filter(std::istream &in, std::ostream &out)
     // test set vocabulary) and attempt to match it against the test sentences.
     keep = GeneratePattern(symbols, pattern) && MatchPattern(pattern);
     if (keep) {
-      out << line << std::endl;
+      out << line << '\n';
     }
 
     // Retain line for the next iteration (in order that the source StringPiece
@@ -16,12 +16,12 @@ TreeCfgFilter::TreeCfgFilter(
 {
 }
 
-void TreeCfgFilter::Filter(std::istream &in, std::ostream &out)
+void TreeCfgFilter::Filter(std::istream &in, std::ostream &out) const
 {
   // TODO Implement filtering!
   std::string line;
   while (std::getline(in, line)) {
-    out << line << std::endl;
+    out << line << '\n';
   }
 }
 
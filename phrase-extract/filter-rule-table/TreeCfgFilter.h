@@ -32,7 +32,7 @@ public:
   // Initialize the filter for a given set of test sentences.
   TreeCfgFilter(const std::vector<boost::shared_ptr<SyntaxTree> > &);
 
-  void Filter(std::istream &in, std::ostream &out);
+  void Filter(std::istream &in, std::ostream &out) const;
 };
 
 }  // namespace FilterRuleTable
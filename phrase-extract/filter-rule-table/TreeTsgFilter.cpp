@@ -51,7 +51,7 @@ void TreeTsgFilter::AddNodesToMap(const IdTree &tree)
 }
 
 bool TreeTsgFilter::MatchFragment(const IdTree &fragment,
-                                  const std::vector<IdTree *> &leaves)
+                                  const std::vector<IdTree *> &leaves) const
 {
   typedef std::vector<const IdTree *> TreeVec;
 
@@ -76,7 +76,7 @@ bool TreeTsgFilter::MatchFragment(const IdTree &fragment,
 
   // Try to match the rule fragment against the test set subtrees where a
   // leaf match was found.
-  TreeVec &nodes = m_labelToTree[rarestLeaf->value()];
+  const TreeVec &nodes = m_labelToTree[rarestLeaf->value()];
   for (TreeVec::const_iterator p = nodes.begin(); p != nodes.end(); ++p) {
     // Navigate 'depth' positions up the subtree to find the root of the
     // potential match site.
@@ -97,7 +97,7 @@ bool TreeTsgFilter::MatchFragment(const IdTree &fragment,
   return false;
 }
 
-bool TreeTsgFilter::MatchFragment(const IdTree &fragment, const IdTree &tree)
+bool TreeTsgFilter::MatchFragment(const IdTree &fragment, const IdTree &tree) const
 {
   if (fragment.value() != tree.value()) {
     return false;
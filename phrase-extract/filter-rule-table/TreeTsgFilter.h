@@ -37,10 +37,10 @@ private:
   void AddNodesToMap(const IdTree &);
 
   // Tree-specific implementation of virtual function.
-  bool MatchFragment(const IdTree &, const std::vector<IdTree *> &);
+  bool MatchFragment(const IdTree &, const std::vector<IdTree *> &) const;
 
   // Try to match a fragment against a specific subtree of a test tree.
-  bool MatchFragment(const IdTree &, const IdTree &);
+  bool MatchFragment(const IdTree &, const IdTree &) const;
 
   // Convert a SyntaxTree to an IdTree (wrt m_testVocab).  Inserts symbols into
   // m_testVocab.
@@ -47,7 +47,7 @@ namespace FilterRuleTable
 // 24.1M    Number of rules requiring full tree matching test
 //  6.7M    Number of rules retained after filtering
 //
-void TsgFilter::Filter(std::istream &in, std::ostream &out)
+void TsgFilter::Filter(std::istream &in, std::ostream &out) const
 {
   const util::MultiCharacter delimiter("|||");
 
@@ -71,7 +71,7 @@ void TsgFilter::Filter(std::istream &in, std::ostream &out)
     // (which is the case in the standard Moses training pipeline).
     if (*it == source) {
       if (keep) {
-        out << line << std::endl;
+        out << line << '\n';
       }
       continue;
     }
@@ -97,7 +97,7 @@ void TsgFilter::Filter(std::istream &in, std::ostream &out)
     boost::scoped_ptr<IdTree> fragment(BuildTree(tokens, i, leaves));
     keep = fragment.get() && MatchFragment(*fragment, leaves);
     if (keep) {
-      out << line << std::endl;
+      out << line << '\n';
     }
 
     // Retain line for the next iteration (in order that the source StringPiece
@@ -108,7 +108,7 @@ void TsgFilter::Filter(std::istream &in, std::ostream &out)
 
 TsgFilter::IdTree *TsgFilter::BuildTree(
   const std::vector<TreeFragmentToken> &tokens, int &i,
-  std::vector<IdTree *> &leaves)
+  std::vector<IdTree *> &leaves) const
 {
   // The subtree starting at tokens[i] is either:
   // 1. a single non-variable symbol (like NP or dog), or
@@ -13,6 +13,7 @@
 #include <sstream>
 #include <cstdlib>
 #include <cstring>
+#include <memory>
 
 #include "util/exception.hh"
 #include "util/file_piece.hh"
@@ -21,6 +22,7 @@
 
 #include "InputFileStream.h"
 #include "reordering_classes.h"
+#include "../ExtractRecord.h"
 
 using namespace std;
 
@@ -36,6 +38,29 @@ public:
   ~FileFormatException() throw() {}
 };
 
+// Reads binary extract files through ExtractRecordReader and text ones
+// through FilePiece, which also handles bzip2 and xz.
+class ExtractLines
+{
+public:
+  explicit ExtractLines(const char *fileName) : binaryFile_(fileName), binary_(binaryFile_) {
+    if (!binary_.IsBinary()) text_.reset(new util::FilePiece(fileName));
+  }
+
+  bool ReadLine(StringPiece &line) {
+    if (text_.get()) return text_->ReadLineOrEOF(line);
+    if (!binary_.ReadLine(buffer_)) return false;
+    line = buffer_;
+    return true;
+  }
+
+private:
+  Moses::InputFileStream binaryFile_;
+  MosesTraining::ExtractRecordReader binary_;
+  std::auto_ptr<util::FilePiece> text_;
+  std::string buffer_;
+};
+
 int main(int argc, char* argv[])
 {
 
@@ -51,7 +76,7 @@ int main(int argc, char* argv[])
   double smoothingValue = atof(argv[2]);
   string filepath = argv[3];
 
-  util::FilePiece eFile(extractFileName);
+  ExtractLines eFile(extractFileName);
 
   bool smoothWithCounts = false;
   map<string,ModelScore*> modelScores;
@@ -105,14 +130,9 @@ int main(int argc, char* argv[])
   ////////////////////////////////////
   //calculate smoothing
   if (smoothWithCounts) {
-    util::FilePiece eFileForCounts(extractFileName);
-    while (true) {
-      StringPiece line;
-      try {
-        line = eFileForCounts.ReadLine();
-      } catch (util::EndOfFileException &e) {
-        break;
-      }
+    ExtractLines eFileForCounts(extractFileName);
+    StringPiece line;
+    while (eFileForCounts.ReadLine(line)) {
       float weight = 1;
       split_line(line,e,f,w,p,h,weight);
       if (hier) {
@@ -145,13 +165,8 @@ int main(int argc, char* argv[])
   //calculate scores for reordering table
   string f_current,e_current;
   bool first = true;
-  while (true) {
-    StringPiece line;
-    try {
-      line = eFile.ReadLine();
-    } catch (util::EndOfFileException &e) {
-      break;
-    }
+  StringPiece line;
+  while (eFile.ReadLine(line)) {
     float weight = 1;
     split_line(line,f,e,w,p,h,weight);
 
@@ -11,14 +11,29 @@ using namespace std;
 namespace MosesTraining
 {
 
-WORD_ID Vocabulary::storeIfNew( const WORD& word )
+Vocabulary::Vocabulary( const boost::shared_ptr<const Vocabulary> &base_ )
+  : base( base_ ), baseSize( base_->baseSize + base_->vocab.size() )
 {
-  map<WORD, WORD_ID>::iterator i = lookup.find( word );
+}
 
-  if( i != lookup.end() )
-    return i->second;
+bool Vocabulary::find( const WORD& word, WORD_ID &id ) const
+{
+  if( base && base->find( word, id ) )
+    return true;
+  map<WORD, WORD_ID>::const_iterator i = lookup.find( word );
+  if( i == lookup.end() )
+    return false;
+  id = i->second;
+  return true;
+}
+
+WORD_ID Vocabulary::storeIfNew( const WORD& word )
+{
+  WORD_ID id;
+  if( find( word, id ) )
+    return id;
 
-  WORD_ID id = vocab.size();
+  id = baseSize + vocab.size();
   vocab.push_back( word );
   lookup[ word ] = id;
   return id;
@@ -26,10 +41,18 @@ WORD_ID Vocabulary::storeIfNew( const WORD& word )
 
 WORD_ID Vocabulary::getWordID( const WORD& word )
 {
-  map<WORD, WORD_ID>::iterator i = lookup.find( word );
-  if( i == lookup.end() )
+  WORD_ID id;
+  if( !find( word, id ) )
     return 0;
-  return i->second;
+  return id;
+}
+
+void Vocabulary::swap( Vocabulary &other )
+{
+  lookup.swap( other.lookup );
+  vocab.swap( other.vocab );
+  base.swap( other.base );
+  std::swap( baseSize, other.baseSize );
 }
 
 PHRASE_ID PhraseTable::storeIfNew( const PHRASE& phrase )
@@ -12,6 +12,8 @@
 #include <map>
 #include <cmath>
 
+#include <boost/shared_ptr.hpp>
+
 namespace MosesTraining
 {
 
@@ -21,13 +23,22 @@ typedef unsigned int WORD_ID;
 class Vocabulary
 {
 public:
+  Vocabulary() : baseSize(0) {}
+  // Starts with the words of base, which must not change any more, so that
+  // vocabularies used by different threads can share it.
+  explicit Vocabulary( const boost::shared_ptr<const Vocabulary> &base );
   std::map<WORD, WORD_ID>  lookup;
   std::vector< WORD > vocab;
   WORD_ID storeIfNew( const WORD& );
   WORD_ID getWordID( const WORD& );
-  inline WORD &getWord( const WORD_ID id ) {
-    return vocab[ id ];
+  inline const WORD &getWord( const WORD_ID id ) const {
+    return id < baseSize ? base->getWord( id ) : vocab[ id - baseSize ];
   }
+  void swap( Vocabulary &other );
+private:
+  bool find( const WORD&, WORD_ID& ) const;
+  boost::shared_ptr<const Vocabulary> base;
+  WORD_ID baseSize;
 };
 
 typedef std::vector< WORD_ID > PHRASE;
@@ -106,6 +106,7 @@ my $___BATCH_MIRA = 0; # flg to enable batch MIRA
 
 # Hypergraph mira
 my $___HG_MIRA = 0;
+my $___HG_FORMAT = "gz"; # gz, txt, bz2 or bin (binary, read without parsing)
 
 # Train phrase model mixture weights with PRO (Haddow, NAACL 2012)
 my $__PROMIX_TRAINING = undef; # Location of main script (contrib/promix/main.py)
@@ -227,6 +228,7 @@ GetOptions(
   "historic-interpolation=f" => \$___HISTORIC_INTERPOLATION,
   "batch-mira" => \$___BATCH_MIRA,
   "hg-mira" => \$___HG_MIRA,
+  "hg-format=s" => \$___HG_FORMAT,
   "batch-mira-args=s" => \$batch_mira_args,
   "promix-training=s" => \$__PROMIX_TRAINING,
   "promix-table=s" => \@__PROMIX_TABLES,
@@ -320,6 +322,8 @@ Options:
   --pro-starting-point      ... Use PRO to get a starting point for MERT
   --batch-mira              ... Use Batch MIRA for optimisation (Cherry and Foster, NAACL 2012)
   --hg-mira                 ... Use hypergraph MIRA, ie batch mira with hypergraphs instead of kbests.
+  --hg-format=STRING        ... Format of the hypergraphs for hypergraph MIRA: gz (default), txt, bz2,
+                                or bin, which is larger than gz but much faster to read.
   --batch-mira-args=STRING  ... args to pass through to batch/hg MIRA. This flag is useful to
                                 change MIRA's hyperparameters such as regularization parameter C,
                                 BLEU decay factor, and the number of iterations of MIRA.
@@ -1308,7 +1312,7 @@ sub run_decoder {
       my $nbest_list_cmd = "-n-best-list $filename $___N_BEST_LIST_SIZE distinct";
       if ($___HG_MIRA) {
         safesystem("rm -rf $hypergraph_dir");
-        $nbest_list_cmd = "-output-search-graph-hypergraph true gz";
+        $nbest_list_cmd = "-output-search-graph-hypergraph true $___HG_FORMAT";
       }
       $decoder_cmd = "$___DECODER $___DECODER_FLAGS  -config $___CONFIG";
       $decoder_cmd .= " -inputtype $___INPUTTYPE" if defined($___INPUTTYPE);
@@ -26,6 +26,9 @@
 #elif !defined(_WIN32) && !defined(_WIN64)
 #include <arpa/nameser_compat.h>
 #endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 #include <stdint.h>
 #include <cstring>
@@ -147,6 +150,26 @@ inline void WriteNonPositiveFloat31(void *base, uint64_t bit_off, float value) {
   WriteInt57(base, bit_off, 31, encoded.i);
 }
 
+// Number of set bits in a word.
+inline unsigned PopCount64(uint64_t value) {
+#ifdef _MSC_VER
+  return static_cast<unsigned>(__popcnt64(value));
+#else
+  return __builtin_popcountll(value);
+#endif
+}
+
+// Index of the lowest set bit.  value must not be zero.
+inline unsigned LowestBit64(uint64_t value) {
+#ifdef _MSC_VER
+  unsigned long ret;
+  _BitScanForward64(&ret, value);
+  return ret;
+#else
+  return __builtin_ctzll(value);
+#endif
+}
+
 void BitPackingSanity();
 
 // Return bits required to store integers upto max_value.  Not the most
@@ -11,10 +11,12 @@
 #include <unistd.h>
 #endif
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <limits>
 #include <string>
@@ -91,6 +93,21 @@ StringPiece FilePiece::ReadLine(char delim, bool strip_cr) {
   }
 }
 
+void FilePiece::Read(void *to, std::size_t amount) {
+  char *out = static_cast<char*>(to);
+  while (amount) {
+    if (position_ == position_end_) {
+      Shift();
+      if (position_ == position_end_) throw EndOfFileException();
+    }
+    std::size_t have = std::min<std::size_t>(amount, position_end_ - position_);
+    std::memcpy(out, position_, have);
+    position_ += have;
+    out += have;
+    amount -= have;
+  }
+}
+
 bool FilePiece::ReadLineOrEOF(StringPiece &to, char delim, bool strip_cr) {
   try {
     to = ReadLine(delim, strip_cr);
@@ -44,11 +44,15 @@ class FilePiece {
     char get() {
       if (position_ == position_end_) {
         Shift();
-        if (at_end_) throw EndOfFileException();
+        // at_end_ only says the file is fully mapped; there may be bytes left.
+        if (position_ == position_end_) throw EndOfFileException();
       }
       return *(position_++);
     }
 
+    // Copy the next amount bytes to to.  Throws EndOfFileException if the file ends first.
+    void Read(void *to, std::size_t amount);
+
     // Leaves the delimiter, if any, to be returned by get().  Delimiters defined by isspace().
     StringPiece ReadDelimited(const bool *delim = kSpaces) {
       SkipSpaces(delim);
@@ -0,0 +1,100 @@
+#ifndef UTIL_LEVENSHTEIN_H
+#define UTIL_LEVENSHTEIN_H
+
+#include <boost/unordered_map.hpp>
+
+#include <cstddef>
+#include <vector>
+
+#include <stdint.h>
+
+namespace util {
+
+/* Levenshtein distance between a fixed pattern and any number of texts, over
+ * words of type Word (e.g. vocabulary ids), with unit insertion, deletion and
+ * substitution costs.
+ *
+ * This is the bit-vector algorithm of Myers (1999), in the multi-word form
+ * of Hyyrö (2003): a column of the dynamic programming matrix is kept as
+ * bit vectors of its vertical differences, so each text word costs a few
+ * word operations per 64 pattern words.
+ */
+template <class Word> class LevenshteinMatcher {
+  public:
+    LevenshteinMatcher() : length_(0), blocks_(0) {}
+
+    explicit LevenshteinMatcher(const std::vector<Word> &pattern)
+      : length_(pattern.size()),
+        blocks_((pattern.size() + kWordBits - 1) / kWordBits),
+        // Offset 0 holds the empty masks of words missing from the pattern.
+        masks_(blocks_, 0) {
+      for (std::size_t i = 0; i < pattern.size(); ++i) {
+        typename Offsets::iterator it = offsets_.find(pattern[i]);
+        if (it == offsets_.end()) {
+          it = offsets_.insert(std::make_pair(pattern[i], masks_.size())).first;
+          masks_.resize(masks_.size() + blocks_, 0);
+        }
+        masks_[it->second + i / kWordBits] |= uint64_t(1) << (i % kWordBits);
+      }
+    }
+
+    std::size_t Distance(const std::vector<Word> &text) const {
+      return Distance(text.empty() ? NULL : &text[0], text.size());
+    }
+
+    std::size_t Distance(const Word *text, std::size_t length) const {
+      if (length_ == 0) return length;
+
+      // Vertical differences of the current column: +1 everywhere at first.
+      std::vector<uint64_t> positive(blocks_, ~uint64_t(0));
+      std::vector<uint64_t> negative(blocks_, 0);
+      const std::size_t last_bit = (length_ - 1) % kWordBits;
+      long score = length_;
+
+      for (std::size_t j = 0; j < length; ++j) {
+        typename Offsets::const_iterator it = offsets_.find(text[j]);
+        const uint64_t *match = &masks_[it == offsets_.end() ? 0 : it->second];
+        // Horizontal difference entering the block from above; the first row
+        // is the distance from the empty pattern, so it grows by one per word.
+        int carry = 1;
+        for (std::size_t b = 0; b < blocks_; ++b) {
+          const uint64_t pv = positive[b];
+          const uint64_t mv = negative[b];
+          const uint64_t carry_neg = carry < 0 ? 1 : 0;
+          const uint64_t carry_pos = carry > 0 ? 1 : 0;
+          const uint64_t eq = match[b] | carry_neg;
+          const uint64_t xv = match[b] | mv;
+          const uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+          uint64_t ph = mv | ~(xh | pv);
+          uint64_t mh = pv & xh;
+          if (b + 1 == blocks_) {
+            score += static_cast<long>((ph >> last_bit) & 1) - static_cast<long>((mh >> last_bit) & 1);
+          } else {
+            carry = static_cast<int>(ph >> (kWordBits - 1)) - static_cast<int>(mh >> (kWordBits - 1));
+          }
+          ph = (ph << 1) | carry_pos;
+          mh = (mh << 1) | carry_neg;
+          positive[b] = mh | ~(xv | ph);
+          negative[b] = ph & xv;
+        }
+      }
+      return score;
+    }
+
+    std::size_t PatternLength() const { return length_; }
+
+  private:
+    static const std::size_t kWordBits = 64;
+
+    // Word to the offset of its match bit vectors in masks_.
+    typedef boost::unordered_map<Word, std::size_t> Offsets;
+
+    std::size_t length_;
+    std::size_t blocks_;
+    Offsets offsets_;
+    std::vector<uint64_t> masks_;
+};
+
+} // namespace util
+
+#endif // UTIL_LEVENSHTEIN_H
@@ -0,0 +1,62 @@
+#include "util/levenshtein.hh"
+
+#define BOOST_TEST_MODULE LevenshteinTest
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace util { namespace {
+
+std::size_t SimpleLevenshtein(const std::vector<int> &a, const std::vector<int> &b) {
+  std::vector<std::size_t> row(b.size() + 1), next(b.size() + 1);
+  for (std::size_t j = 0; j <= b.size(); ++j) row[j] = j;
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    next[0] = i + 1;
+    for (std::size_t j = 0; j < b.size(); ++j) {
+      next[j + 1] = std::min(std::min(row[j + 1], next[j]) + 1, row[j] + (a[i] == b[j] ? 0 : 1));
+    }
+    row.swap(next);
+  }
+  return row[b.size()];
+}
+
+std::vector<int> RandomSentence(std::size_t length, int vocabulary) {
+  std::vector<int> sentence(length);
+  for (std::size_t i = 0; i < length; ++i) sentence[i] = std::rand() % vocabulary;
+  return sentence;
+}
+
+BOOST_AUTO_TEST_CASE(basic) {
+  int a[] = {1, 2, 3, 4};
+  int b[] = {1, 3, 4, 5, 6};
+  LevenshteinMatcher<int> matcher(std::vector<int>(a, a + 4));
+  BOOST_CHECK_EQUAL(3, matcher.Distance(std::vector<int>(b, b + 5)));
+  BOOST_CHECK_EQUAL(0, matcher.Distance(std::vector<int>(a, a + 4)));
+  BOOST_CHECK_EQUAL(4, matcher.Distance(std::vector<int>()));
+  BOOST_CHECK_EQUAL(5, LevenshteinMatcher<int>(std::vector<int>()).Distance(std::vector<int>(b, b + 5)));
+}
+
+BOOST_AUTO_TEST_CASE(unsigned_words) {
+  unsigned int a[] = {7, 8, 9};
+  unsigned int b[] = {7, 9};
+  LevenshteinMatcher<unsigned int> matcher(std::vector<unsigned int>(a, a + 3));
+  BOOST_CHECK_EQUAL(1, matcher.Distance(std::vector<unsigned int>(b, b + 2)));
+}
+
+BOOST_AUTO_TEST_CASE(random) {
+  std::srand(1234);
+  // Lengths around and beyond one 64 bit block
+  const std::size_t lengths[] = {1, 7, 63, 64, 65, 130, 200};
+  for (std::size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i) {
+    for (std::size_t j = 0; j < sizeof(lengths) / sizeof(lengths[0]); ++j) {
+      for (int vocabulary = 2; vocabulary <= 50; vocabulary *= 5) {
+        std::vector<int> pattern = RandomSentence(lengths[i], vocabulary);
+        std::vector<int> text = RandomSentence(lengths[j], vocabulary);
+        BOOST_CHECK_EQUAL(SimpleLevenshtein(pattern, text), LevenshteinMatcher<int>(pattern).Distance(text));
+      }
+    }
+  }
+}
+
+}} // namespaces
@@ -10,8 +10,11 @@
 #include "util/scoped.hh"
 
 #include <iostream>
+#include <vector>
 
 #include <cassert>
+#include <cerrno>
+#include <cstdio>
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -25,6 +28,10 @@
 #include <unistd.h>
 #endif
 
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
 namespace util {
 
 std::size_t SizePage() {
@@ -159,14 +166,27 @@ bool AnonymousMap(std::size_t size, int flags, bool populate, util::scoped_memor
   return true;
 }
 
-bool TryHuge(std::size_t size, uint8_t alignment_bits, bool populate, util::scoped_memory &to) {
-  // Don't bother with these cases.
-  if (size < (1ULL << alignment_bits) || (1ULL << alignment_bits) < SizePage())
-    return false;
+// Size of the huge pages that MAP_HUGETLB without a size picks, from the
+// Hugepagesize line of /proc/meminfo, or 0 if unknown.
+std::size_t DefaultHugePageSize() {
+  std::FILE *f = std::fopen("/proc/meminfo", "r");
+  if (!f) return 0;
+  char line[256];
+  unsigned long kb = 0;
+  while (std::fgets(line, sizeof(line), f)) {
+    if (std::sscanf(line, "Hugepagesize: %lu kB", &kb) == 1) break;
+  }
+  std::fclose(f);
+  return static_cast<std::size_t>(kb) << 10;
+}
 
+// Only pages from the hugetlb pool configured by the sysadmin.  munmap of
+// hugetlb pages needs a multiple of the huge page size, so the mapping is
+// rounded up and recorded with the rounded size.
+bool TryHugeTLB(std::size_t size, uint8_t alignment_bits, bool populate, util::scoped_memory &to) {
   // First try: Linux >= 3.8 with manually configured hugetlb pages available.
 #ifdef MAP_HUGE_SHIFT
-  if (AnonymousMap(size, MAP_HUGETLB | (alignment_bits << MAP_HUGE_SHIFT), populate, to))
+  if (AnonymousMap(RoundUpPow2(size, static_cast<std::size_t>(1) << alignment_bits), MAP_HUGETLB | (alignment_bits << MAP_HUGE_SHIFT), populate, to))
     return true;
 #endif
 
@@ -174,9 +194,21 @@ bool TryHuge(std::size_t size, uint8_t alignment_bits, bool populate, util::scop
   // pick size or not available.  This might pick the wrong size huge pages,
   // but the sysadmin must have made them available in the first place.
 #ifdef MAP_HUGETLB
-  if (AnonymousMap(size, MAP_HUGETLB, populate, to))
+  std::size_t page = DefaultHugePageSize();
+  if (!page) page = static_cast<std::size_t>(1) << alignment_bits;
+  if (AnonymousMap(RoundUpPow2(size, page), MAP_HUGETLB, populate, to))
     return true;
 #endif
+  return false;
+}
+
+bool TryHuge(std::size_t size, uint8_t alignment_bits, bool populate, util::scoped_memory &to) {
+  // Don't bother with these cases.
+  if (size < (1ULL << alignment_bits) || (1ULL << alignment_bits) < SizePage())
+    return false;
+
+  if (TryHugeTLB(size, alignment_bits, populate, to))
+    return true;
 
   // Third try: align to a multiple of the huge page size by overallocating.
   // I feel bad about doing this, but it's also how posix_memalign is
@@ -236,6 +268,82 @@ void HugeMalloc(std::size_t size, bool zeroed, scoped_memory &to) {
   UTIL_THROW_IF(!to.get(), ErrnoException, "Failed to allocate " << size << " bytes");
 }
 
+void HugeTLBMalloc(std::size_t size, scoped_memory &to) {
+  to.reset();
+#ifdef __linux__
+  // Populate so that a shortage of reserved pages shows up here as an error,
+  // not later as SIGBUS.
+  if (size >= (1ULL << 30) && TryHugeTLB(size, 30, true, to))
+    return;
+  if (size >= (1ULL << 21) && TryHugeTLB(size, 21, true, to))
+    return;
+  // Less than a huge page: not worth one of the reserved pages.
+  if (size < (1ULL << 21)) {
+    HugeMalloc(size, false, to);
+    return;
+  }
+  UTIL_THROW(ErrnoException, "Failed to allocate " << size << " bytes of hugetlb pages.  Reserve more with sysctl vm.nr_hugepages or use another load method");
+#else
+  UTIL_THROW(Exception, "hugetlb pages are only supported on Linux");
+#endif // __linux__
+}
+
+#if defined(__linux__) && defined(SYS_mbind)
+namespace {
+// Nodes the kernel could ever bring online, listed in sysfs as e.g. "0-3" or
+// "0,2-5".  Asking mbind for more nodes than the kernel was built for fails
+// with EINVAL, so the mask holds exactly these.
+bool PossibleNUMANodes(std::vector<unsigned long> &mask) {
+  std::FILE *f = std::fopen("/sys/devices/system/node/possible", "r");
+  if (!f) return false;
+  char line[4096];
+  bool read = std::fgets(line, sizeof(line), f);
+  std::fclose(f);
+  if (!read) return false;
+  const std::size_t kBits = sizeof(unsigned long) * 8;
+  mask.clear();
+  for (char *pos = line; *pos && *pos != '\n';) {
+    char *end;
+    unsigned long first = std::strtoul(pos, &end, 10), last = first;
+    if (end == pos) return false;
+    if (*end == '-') {
+      pos = end + 1;
+      last = std::strtoul(pos, &end, 10);
+      if (end == pos || last < first) return false;
+    }
+    for (unsigned long node = first; node <= last; ++node) {
+      if (mask.size() <= node / kBits) mask.resize(node / kBits + 1, 0);
+      mask[node / kBits] |= 1UL << (node % kBits);
+    }
+    pos = (*end == ',') ? end + 1 : end;
+  }
+  return !mask.empty();
+}
+} // namespace
+#endif
+
+bool InterleaveNUMA(void *base, std::size_t size) {
+#if defined(__linux__) && defined(SYS_mbind)
+  // Value from linux/mempolicy.h, which is not always installed.
+  const int kMPolInterleave = 3;
+  if (reinterpret_cast<uintptr_t>(base) % SizePage()) {
+    errno = EINVAL;
+    return false;
+  }
+  std::vector<unsigned long> nodes;
+  if (!PossibleNUMANodes(nodes)) {
+    errno = ENOSYS;
+    return false;
+  }
+  // The kernel ignores the last bit of maxnode, hence the + 1.
+  unsigned long max_node = nodes.size() * sizeof(unsigned long) * 8 + 1;
+  return !syscall(SYS_mbind, base, size, kMPolInterleave, &nodes[0], max_node, 0);
+#else
+  errno = ENOSYS;
+  return false;
+#endif
+}
+
 #ifdef __linux__
 const std::size_t kTransitionHuge = std::max<std::size_t>(1ULL << 21, SizePage());
 #endif // __linux__
@@ -320,6 +428,28 @@ void MapRead(LoadMethod method, int fd, uint64_t offset, std::size_t size, scope
       HugeMalloc(size, false, out);
       ParallelRead(fd, out.get(), size, offset);
       break;
+    case HUGE_READ:
+      HugeTLBMalloc(size, out);
+      SeekOrThrow(fd, offset);
+      ReadOrThrow(fd, out.get(), size);
+      break;
+    case INTERLEAVE_READ:
+      HugeMalloc(size, false, out);
+#ifdef __linux__
+      if (size) {
+        // The policy applies to whole pages, which malloc shares with
+        // unrelated heap data.  Use pages of our own.
+        if (out.source() == scoped_memory::MALLOC_ALLOCATED) {
+          out.reset();
+          UTIL_THROW_IF(!AnonymousMap(size, 0, false, out), ErrnoException, "Failed to mmap " << size << " bytes");
+        }
+        // Reading is the first touch, so pages are placed according to the policy.
+        UTIL_THROW_IF(!InterleaveNUMA(out.get(), size), ErrnoException, "Failed to interleave " << size << " bytes across NUMA nodes.  Use another load method");
+      }
+#endif
+      SeekOrThrow(fd, offset);
+      ReadOrThrow(fd, out.get(), size);
+      break;
   }
 }
 
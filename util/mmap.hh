@@ -128,6 +128,19 @@ void HugeMalloc(std::size_t size, bool zeroed, scoped_memory &to);
 // this.
 void HugeRealloc(std::size_t size, bool new_zeroed, scoped_memory &mem);
 
+// Like HugeMalloc, but only succeeds with pages from the hugetlb pool.  Throws
+// an ErrnoException if none of the appropriate size are free.  The size is
+// rounded up to a multiple of the huge page size.  Requests smaller than a 2 MB
+// page are served by HugeMalloc instead.
+void HugeTLBMalloc(std::size_t size, scoped_memory &to);
+
+// Request that pages in [base, base + size) be interleaved across all possible
+// NUMA nodes.  Call before the pages are first touched.  base must be page
+// aligned and the pages should be mapped by the caller: the policy applies to
+// whole pages.  Returns false with errno set if the kernel refused or does not
+// support NUMA policy.
+bool InterleaveNUMA(void *base, std::size_t size);
+
 typedef enum {
   // mmap with no prepopulate
   LAZY,
@@ -139,6 +152,15 @@ typedef enum {
   READ,
   // malloc and read in parallel (recommended for Lustre)
   PARALLEL_READ,
+  // malloc from hugetlb pages reserved by the administrator (vm.nr_hugepages)
+  // then read.  1 GB pages are preferred for large files, then 2 MB.  Unlike
+  // READ, which quietly falls back to transparent huge pages or small pages,
+  // this throws if no reserved pages are available.  Linux only.
+  HUGE_READ,
+  // Like READ, but interleave the pages across all NUMA nodes so that lookups
+  // from threads on every socket see the same average latency.  Throws if the
+  // kernel refuses the policy.  Same as READ on non-Linux.
+  INTERLEAVE_READ,
 } LoadMethod;
 
 void MapRead(LoadMethod method, int fd, uint64_t offset, std::size_t size, scoped_memory &out);
@@ -1,19 +1,122 @@
 #include "util/pcqueue.hh"
+#include "util/ring_queue.hh"
+#include "util/usage.hh"
 
 #define BOOST_TEST_MODULE PCQueueTest
 #include <boost/test/unit_test.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include <iostream>
+
+#include <stdint.h>
 
 namespace util {
 namespace {
 
-BOOST_AUTO_TEST_CASE(SingleThread) {
-  PCQueue<int> queue(10);
+template <class Queue> void CheckSingleThread() {
+  Queue queue(10);
   for (int i = 0; i < 10; ++i) {
     queue.Produce(i);
   }
   for (int i = 0; i < 10; ++i) {
     BOOST_CHECK_EQUAL(i, queue.Consume());
   }
+  // Go around the ring again.
+  for (int i = 0; i < 25; ++i) {
+    queue.Produce(i);
+    BOOST_CHECK_EQUAL(i, queue.Consume());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(SingleThread) {
+  CheckSingleThread<PCQueue<int> >();
+  CheckSingleThread<SPSCQueue<int> >();
+  CheckSingleThread<MPMCQueue<int> >();
+}
+
+// Values are 1..count so that 0 can signal the end.
+template <class Queue> struct Producer {
+  void operator()() {
+    for (uint64_t i = 1; i <= count; ++i) {
+      queue->Produce(i);
+    }
+  }
+  Queue *queue;
+  uint64_t count;
+};
+
+template <class Queue> struct Consumer {
+  void operator()() {
+    uint64_t got;
+    while (queue->Consume(got)) {
+      *sum += got;
+    }
+  }
+  Queue *queue;
+  uint64_t *sum;
+};
+
+// Pushes count values from each producer through consumers, checks the sum,
+// and returns the number of values per second.
+template <class Queue> double Run(std::size_t producers, std::size_t consumers, uint64_t count) {
+  Queue queue(64);
+  std::vector<uint64_t> sums(consumers);
+  double start = WallTime();
+  {
+    boost::ptr_vector<boost::thread> consuming;
+    for (std::size_t i = 0; i < consumers; ++i) {
+      Consumer<Queue> c;
+      c.queue = &queue;
+      c.sum = &sums[i];
+      consuming.push_back(new boost::thread(c));
+    }
+    {
+      boost::ptr_vector<boost::thread> producing;
+      for (std::size_t i = 0; i < producers; ++i) {
+        Producer<Queue> p;
+        p.queue = &queue;
+        p.count = count;
+        producing.push_back(new boost::thread(p));
+      }
+      for (std::size_t i = 0; i < producers; ++i) {
+        producing[i].join();
+      }
+    }
+    for (std::size_t i = 0; i < consumers; ++i) {
+      queue.Produce(0);
+    }
+    for (std::size_t i = 0; i < consumers; ++i) {
+      consuming[i].join();
+    }
+  }
+  double elapsed = WallTime() - start;
+  uint64_t total = 0;
+  for (std::size_t i = 0; i < consumers; ++i) {
+    total += sums[i];
+  }
+  BOOST_CHECK_EQUAL(producers * count * (count + 1) / 2, total);
+  return static_cast<double>(producers * count) / elapsed;
+}
+
+BOOST_AUTO_TEST_CASE(SPSC) {
+  Run<PCQueue<uint64_t> >(1, 1, 10000);
+  Run<SPSCQueue<uint64_t> >(1, 1, 10000);
+}
+
+BOOST_AUTO_TEST_CASE(MPMC) {
+  Run<PCQueue<uint64_t> >(3, 2, 10000);
+  Run<MPMCQueue<uint64_t> >(3, 2, 10000);
+}
+
+// Not a real benchmark, but gives a rough comparison in the test log.
+BOOST_AUTO_TEST_CASE(Throughput) {
+  const uint64_t kCount = 100000;
+  std::cerr << "Values per second, 1 producer 1 consumer: PCQueue " << Run<PCQueue<uint64_t> >(1, 1, kCount)
+    << " SPSCQueue " << Run<SPSCQueue<uint64_t> >(1, 1, kCount)
+    << " MPMCQueue " << Run<MPMCQueue<uint64_t> >(1, 1, kCount) << std::endl;
+  std::cerr << "Values per second, 2 producers 2 consumers: PCQueue " << Run<PCQueue<uint64_t> >(2, 2, kCount)
+    << " MPMCQueue " << Run<MPMCQueue<uint64_t> >(2, 2, kCount) << std::endl;
 }
 
 }
@@ -0,0 +1,177 @@
+#ifndef UTIL_RING_QUEUE_H
+#define UTIL_RING_QUEUE_H
+
+#include <boost/atomic.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/utility.hpp>
+
+#include <cstddef>
+
+#include <stdint.h>
+
+namespace util {
+
+/* Lock-free alternatives to PCQueue with the same Produce/Consume interface.
+ * Produce blocks while the queue is full and Consume blocks while it is empty,
+ * but waiting is done by spinning then yielding instead of with semaphores, so
+ * an uncontended operation is a handful of atomic instructions rather than two
+ * semaphore round trips.  The price is burning CPU while waiting, so these are
+ * best for queues that are rarely empty or full for long.
+ */
+
+namespace detail {
+
+// Keep producer and consumer indices on separate cache lines.
+const std::size_t kRingCacheLine = 64;
+
+// Spin briefly, then give up the time slice.
+class RingBackoff {
+  public:
+    RingBackoff() : count_(0) {}
+
+    void Wait() {
+      if (++count_ < 64) return;
+      boost::this_thread::yield();
+    }
+
+  private:
+    unsigned int count_;
+};
+
+} // namespace detail
+
+/**
+ * Bounded queue for exactly one producing thread and one consuming thread at a
+ * time.  Handing over either role is fine as long as the handover itself
+ * synchronizes, e.g. by joining the old thread.
+ * T must be default constructable and have operator=.
+ */
+template <class T> class SPSCQueue : boost::noncopyable {
+  public:
+    explicit SPSCQueue(std::size_t size)
+      : size_(size + 1), storage_(new T[size + 1]), produce_at_(0), consume_at_(0) {}
+
+    void Produce(const T &val) {
+      std::size_t at = produce_at_.load(boost::memory_order_relaxed);
+      std::size_t next = Next(at);
+      for (detail::RingBackoff backoff; next == consume_at_.load(boost::memory_order_acquire); backoff.Wait()) {}
+      storage_[at] = val;
+      produce_at_.store(next, boost::memory_order_release);
+    }
+
+    T& Consume(T &out) {
+      std::size_t at = consume_at_.load(boost::memory_order_relaxed);
+      for (detail::RingBackoff backoff; at == produce_at_.load(boost::memory_order_acquire); backoff.Wait()) {}
+      out = storage_[at];
+      consume_at_.store(Next(at), boost::memory_order_release);
+      return out;
+    }
+
+    T Consume() {
+      T ret;
+      Consume(ret);
+      return ret;
+    }
+
+  private:
+    std::size_t Next(std::size_t index) const {
+      return (index + 1 == size_) ? 0 : index + 1;
+    }
+
+    // One slot is always left empty to distinguish full from empty.
+    const std::size_t size_;
+    boost::scoped_array<T> storage_;
+
+    char pad0_[detail::kRingCacheLine];
+    boost::atomic<std::size_t> produce_at_;
+    char pad1_[detail::kRingCacheLine];
+    boost::atomic<std::size_t> consume_at_;
+    char pad2_[detail::kRingCacheLine];
+};
+
+/**
+ * Bounded queue safe for multiple producers and multiple consumers.  This is
+ * Dmitry Vyukov's array queue: each slot carries a sequence number that tells
+ * producers and consumers whether it is their turn, so threads only contend
+ * on a compare and swap of the index they are advancing.
+ * T must be default constructable and have operator=.  Unlike PCQueue, if
+ * operator= throws the queue is left unusable.
+ */
+template <class T> class MPMCQueue : boost::noncopyable {
+  public:
+    explicit MPMCQueue(std::size_t size)
+      : size_(size), slots_(new Slot[size]), produce_at_(0), consume_at_(0) {
+      for (std::size_t i = 0; i < size; ++i) {
+        slots_[i].sequence.store(i, boost::memory_order_relaxed);
+      }
+    }
+
+    void Produce(const T &val) {
+      Slot *slot;
+      uint64_t at = produce_at_.load(boost::memory_order_relaxed);
+      for (detail::RingBackoff backoff; ; ) {
+        slot = &slots_[at % size_];
+        uint64_t sequence = slot->sequence.load(boost::memory_order_acquire);
+        if (sequence == at) {
+          if (produce_at_.compare_exchange_weak(at, at + 1, boost::memory_order_relaxed)) break;
+        } else if (sequence < at) {
+          // Full: the consumer has not yet freed this slot.
+          backoff.Wait();
+          at = produce_at_.load(boost::memory_order_relaxed);
+        } else {
+          // Another producer got here first.
+          at = produce_at_.load(boost::memory_order_relaxed);
+        }
+      }
+      slot->value = val;
+      slot->sequence.store(at + 1, boost::memory_order_release);
+    }
+
+    T& Consume(T &out) {
+      Slot *slot;
+      uint64_t at = consume_at_.load(boost::memory_order_relaxed);
+      for (detail::RingBackoff backoff; ; ) {
+        slot = &slots_[at % size_];
+        uint64_t sequence = slot->sequence.load(boost::memory_order_acquire);
+        if (sequence == at + 1) {
+          if (consume_at_.compare_exchange_weak(at, at + 1, boost::memory_order_relaxed)) break;
+        } else if (sequence < at + 1) {
+          // Empty.
+          backoff.Wait();
+          at = consume_at_.load(boost::memory_order_relaxed);
+        } else {
+          at = consume_at_.load(boost::memory_order_relaxed);
+        }
+      }
+      out = slot->value;
+      // Ready for the producer that comes around the ring next.
+      slot->sequence.store(at + size_, boost::memory_order_release);
+      return out;
+    }
+
+    T Consume() {
+      T ret;
+      Consume(ret);
+      return ret;
+    }
+
+  private:
+    struct Slot {
+      boost::atomic<uint64_t> sequence;
+      T value;
+    };
+
+    const std::size_t size_;
+    boost::scoped_array<Slot> slots_;
+
+    char pad0_[detail::kRingCacheLine];
+    boost::atomic<uint64_t> produce_at_;
+    char pad1_[detail::kRingCacheLine];
+    boost::atomic<uint64_t> consume_at_;
+    char pad2_[detail::kRingCacheLine];
+};
+
+} // namespace util
+
+#endif // UTIL_RING_QUEUE_H
@@ -0,0 +1,41 @@
+#include "util/stream/block_queue.hh"
+
+#include "util/exception.hh"
+#include "util/pcqueue.hh"
+#include "util/ring_queue.hh"
+
+namespace util {
+namespace stream {
+
+namespace {
+template <class Queue> class BlockQueueImpl : public BlockQueue {
+  public:
+    explicit BlockQueueImpl(std::size_t size) : queue_(size) {}
+
+    void Produce(const Block &block) {
+      queue_.Produce(block);
+    }
+
+    Block &Consume(Block &out) {
+      return queue_.Consume(out);
+    }
+
+  private:
+    Queue queue_;
+};
+} // namespace
+
+BlockQueue *BlockQueue::Make(QueueType type, std::size_t size) {
+  switch (type) {
+    case LOCKING_QUEUE:
+      return new BlockQueueImpl<PCQueue<Block> >(size);
+    case SPSC_QUEUE:
+      return new BlockQueueImpl<SPSCQueue<Block> >(size);
+    case MPMC_QUEUE:
+      return new BlockQueueImpl<MPMCQueue<Block> >(size);
+  }
+  UTIL_THROW(Exception, "Unknown queue type " << type);
+}
+
+} // namespace stream
+} // namespace util
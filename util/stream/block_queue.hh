@@ -0,0 +1,48 @@
+#ifndef UTIL_STREAM_BLOCK_QUEUE_H
+#define UTIL_STREAM_BLOCK_QUEUE_H
+
+#include "util/stream/block.hh"
+#include "util/stream/config.hh"
+
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+
+namespace util {
+namespace stream {
+
+/**
+ * Queue of @ref Block "blocks" between two adjacent workers in a @ref Chain "chain".
+ *
+ * The implementation is picked at runtime from ChainConfig::queue_type.  Each
+ * queue has exactly one producing and one consuming thread at a time (the
+ * Chain's own thread counts when it fills or drains the loop), so SPSC_QUEUE
+ * is always safe.  A virtual call per block is cheap next to processing it.
+ */
+class BlockQueue : boost::noncopyable {
+  public:
+    /**
+     * Creates a queue of the given type with room for size blocks.
+     */
+    static BlockQueue *Make(QueueType type, std::size_t size);
+
+    virtual ~BlockQueue() {}
+
+    /** Adds a block, waiting while the queue is full. */
+    virtual void Produce(const Block &block) = 0;
+
+    /** Removes a block into out, waiting while the queue is empty. */
+    virtual Block &Consume(Block &out) = 0;
+
+    /** Convenience version of Consume that copies the block to return. */
+    Block Consume() {
+      Block ret;
+      Consume(ret);
+      return ret;
+    }
+};
+
+} // namespace stream
+} // namespace util
+
+#endif // UTIL_STREAM_BLOCK_QUEUE_H
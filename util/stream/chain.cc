@@ -3,7 +3,6 @@
 #include "util/stream/io.hh"
 
 #include "util/exception.hh"
-#include "util/pcqueue.hh"
 
 #include <cstdlib>
 #include <new>
@@ -47,8 +46,8 @@ Chain::~Chain() {
 
 ChainPosition Chain::Add() {
   if (!Running()) Start();
-  PCQueue<Block> &in = queues_.back();
-  queues_.push_back(new PCQueue<Block>(config_.block_count));
+  BlockQueue &in = queues_.back();
+  queues_.push_back(BlockQueue::Make(config_.queue_type, config_.block_count));
   return ChainPosition(in, queues_.back(), this, progress_);
 }
 
@@ -91,7 +90,7 @@ void Chain::Start() {
     memory_.reset(MallocOrThrow(malloc_size));
   }
   // This queue can accomodate all blocks.
-  queues_.push_back(new PCQueue<Block>(config_.block_count));
+  queues_.push_back(BlockQueue::Make(config_.queue_type, config_.block_count));
   // Populate the lead queue with blocks.
   uint8_t *base = static_cast<uint8_t*>(memory_.get());
   for (std::size_t i = 0; i < config_.block_count; ++i) {
@@ -2,6 +2,7 @@
 #define UTIL_STREAM_CHAIN_H
 
 #include "util/stream/block.hh"
+#include "util/stream/block_queue.hh"
 #include "util/stream/config.hh"
 #include "util/stream/multi_progress.hh"
 #include "util/scoped.hh"
@@ -13,7 +14,6 @@
 #include <cassert>
 
 namespace util {
-template <class T> class PCQueue;
 namespace stream {
 
 class ChainConfigException : public Exception {
@@ -26,7 +26,7 @@ class Chain;
 class RewindableStream;
 
 /**
- * Encapsulates a @ref PCQueue "producer queue" and a @ref PCQueue "consumer queue" within a @ref Chain "chain".
+ * Encapsulates a @ref BlockQueue "producer queue" and a @ref BlockQueue "consumer queue" within a @ref Chain "chain".
  *
  * Specifies position in chain for Link constructor.
  */
@@ -37,10 +37,10 @@ class ChainPosition {
     friend class Chain;
     friend class Link;
     friend class RewindableStream;
-    ChainPosition(PCQueue<Block> &in, PCQueue<Block> &out, Chain *chain, MultiProgress &progress)
+    ChainPosition(BlockQueue &in, BlockQueue &out, Chain *chain, MultiProgress &progress)
       : in_(&in), out_(&out), chain_(chain), progress_(progress.Add()) {}
 
-    PCQueue<Block> *in_, *out_;
+    BlockQueue *in_, *out_;
 
     Chain *chain_;
 
@@ -236,7 +236,7 @@ class Chain {
 
     scoped_malloc memory_;
 
-    boost::ptr_vector<PCQueue<Block> > queues_;
+    boost::ptr_vector<BlockQueue> queues_;
 
     bool complete_called_;
 
@@ -269,7 +269,7 @@ class Link {
     Link();
 
     /**
-     * Initializes the link with the input @ref PCQueue "consumer queue" and output @ref PCQueue "producer queue" at a given @ref ChainPosition "position" in the @ref Chain "chain".
+     * Initializes the link with the input @ref BlockQueue "consumer queue" and output @ref BlockQueue "producer queue" at a given @ref ChainPosition "position" in the @ref Chain "chain".
      *
      * @see Link()
      */
@@ -279,7 +279,7 @@ class Link {
      * Destructs the link object.
      *
      * If necessary, this method will pass a poison block
-     * to this link's output @ref PCQueue "producer queue".
+     * to this link's output @ref BlockQueue "producer queue".
      *
      * @see Block::SetToPoison()
      */
@@ -321,7 +321,7 @@ class Link {
 
     /**
      * @ref Block::SetToPoison() "Poisons" the @ref Block "block" at this link,
-     * and passes this now-poisoned block to this link's output @ref PCQueue "producer queue".
+     * and passes this now-poisoned block to this link's output @ref BlockQueue "producer queue".
      *
      * @see Block::SetToPoison()
      */
@@ -329,7 +329,7 @@ class Link {
 
   private:
     Block current_;
-    PCQueue<Block> *in_, *out_;
+    BlockQueue *in_, *out_;
 
     bool poisoned_;
 
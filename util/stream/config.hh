@@ -6,13 +6,25 @@
 
 namespace util { namespace stream {
 
+/**
+ * Selects the queue that passes blocks between adjacent workers in a chain.
+ */
+typedef enum {
+  /** util::PCQueue: a mutex and semaphores.  Waiting threads sleep. */
+  LOCKING_QUEUE,
+  /** util::SPSCQueue: lock-free.  Waiting threads spin then yield. */
+  SPSC_QUEUE,
+  /** util::MPMCQueue: lock-free and safe for any number of threads. */
+  MPMC_QUEUE
+} QueueType;
+
 /**
  * Represents how a chain should be configured.
  */
 struct ChainConfig {
 
   /** Constructs an configuration with underspecified (or default) parameters. */
-  ChainConfig() {}
+  ChainConfig() : queue_type(LOCKING_QUEUE) {}
 
   /**
    * Constructs a chain configuration object.
@@ -23,7 +35,7 @@ struct ChainConfig {
    *             This value will be divided amongst the blocks in the chain.
    */
   ChainConfig(std::size_t in_entry_size, std::size_t in_block_count, std::size_t in_total_memory)
-    : entry_size(in_entry_size), block_count(in_block_count), total_memory(in_total_memory) {}
+    : entry_size(in_entry_size), block_count(in_block_count), total_memory(in_total_memory), queue_type(LOCKING_QUEUE) {}
 
   /**
    * Number of bytes in each record.
@@ -41,6 +53,12 @@ struct ChainConfig {
    * Chain's constructor will make this a multiple of entry_size.
    */
   std::size_t total_memory;
+
+  /**
+   * Queue implementation used between workers.
+   * Lock-free queues help when blocks are small and there are spare cores.
+   */
+  QueueType queue_type;
 };
 
 
@@ -1,5 +1,4 @@
 #include "util/stream/rewindable_stream.hh"
-#include "util/pcqueue.hh"
 
 #include <iostream>
 
@@ -112,7 +112,7 @@ class RewindableStream : boost::noncopyable {
     uint8_t *marked_, *current_;
     const uint8_t *block_end_;
 
-    PCQueue<Block> *in_, *out_;
+    BlockQueue *in_, *out_;
 
     // Have we hit poison at the end of the stream, even if rewinding?
     bool hit_poison_;
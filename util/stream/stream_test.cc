@@ -10,7 +10,7 @@
 
 namespace util { namespace stream { namespace {
 
-BOOST_AUTO_TEST_CASE(StreamTest) {
+void CheckStream(QueueType queue_type) {
   scoped_fd in(MakeTemp("io_test_temp"));
   for (uint64_t i = 0; i < 100000; ++i) {
     WriteOrThrow(in.get(), &i, sizeof(uint64_t));
@@ -21,6 +21,7 @@ BOOST_AUTO_TEST_CASE(StreamTest) {
   config.entry_size = 8;
   config.total_memory = 100;
   config.block_count = 12;
+  config.queue_type = queue_type;
 
   Stream s;
   Chain chain(config);
@@ -32,4 +33,13 @@ BOOST_AUTO_TEST_CASE(StreamTest) {
   BOOST_CHECK_EQUAL(100000ULL, i);
 }
 
+BOOST_AUTO_TEST_CASE(StreamTest) {
+  CheckStream(LOCKING_QUEUE);
+}
+
+BOOST_AUTO_TEST_CASE(LockFreeStreamTest) {
+  CheckStream(SPSC_QUEUE);
+  CheckStream(MPMC_QUEUE);
+}
+
 }}} // namespaces
@@ -12,12 +12,13 @@
 
 namespace util {
 
-template <class HandlerT> class Worker : boost::noncopyable {
+template <class HandlerT, class QueueT = PCQueue<typename HandlerT::Request> > class Worker : boost::noncopyable {
   public:
     typedef HandlerT Handler;
     typedef typename Handler::Request Request;
+    typedef QueueT Queue;
 
-    template <class Construct> Worker(PCQueue<Request> &in, Construct &construct, const Request &poison)
+    template <class Construct> Worker(Queue &in, Construct &construct, const Request &poison)
       : in_(in), handler_(construct), poison_(poison), thread_(boost::ref(*this)) {}
 
     // Only call from thread.
@@ -45,7 +46,7 @@ template <class HandlerT> class Worker : boost::noncopyable {
     }
 
   private:
-    PCQueue<Request> &in_;
+    Queue &in_;
 
     boost::optional<Handler> handler_;
 
@@ -54,14 +55,17 @@ template <class HandlerT> class Worker : boost::noncopyable {
     boost::thread thread_;
 };
 
-template <class HandlerT> class ThreadPool : boost::noncopyable {
+// QueueT may be any queue with PCQueue's interface that allows multiple
+// consumers, such as MPMCQueue from util/ring_queue.hh.
+template <class HandlerT, class QueueT = PCQueue<typename HandlerT::Request> > class ThreadPool : boost::noncopyable {
   public:
     typedef HandlerT Handler;
     typedef typename Handler::Request Request;
+    typedef QueueT Queue;
 
     template <class Construct> ThreadPool(size_t queue_length, size_t workers, Construct handler_construct, Request poison) : in_(queue_length), poison_(poison) {
       for (size_t i = 0; i < workers; ++i) {
-        workers_.push_back(new Worker<Handler>(in_, handler_construct, poison));
+        workers_.push_back(new Worker<Handler, Queue>(in_, handler_construct, poison));
       }
     }
 
@@ -69,7 +73,7 @@ template <class HandlerT> class ThreadPool : boost::noncopyable {
       for (size_t i = 0; i < workers_.size(); ++i) {
         Produce(poison_);
       }
-      for (typename boost::ptr_vector<Worker<Handler> >::iterator i = workers_.begin(); i != workers_.end(); ++i) {
+      for (typename boost::ptr_vector<Worker<Handler, Queue> >::iterator i = workers_.begin(); i != workers_.end(); ++i) {
         i->Join();
       }
     }
@@ -79,12 +83,12 @@ template <class HandlerT> class ThreadPool : boost::noncopyable {
     }
 
     // For adding to the queue.
-    PCQueue<Request> &In() { return in_; }
+    Queue &In() { return in_; }
 
   private:
-    PCQueue<Request> in_;
+    Queue in_;
 
-    boost::ptr_vector<Worker<Handler> > workers_;
+    boost::ptr_vector<Worker<Handler, Queue> > workers_;
 
     Request poison_;
 };